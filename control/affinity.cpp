@@ -8,11 +8,28 @@
        @author Raffaele Solca
 
 */
-#ifndef MAGMA_NOAFFINITY
+#include <algorithm>
 
 #include "affinity.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "magma_internal.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef MAGMA_NOAFFINITY
+
+#include <dirent.h>
+#include <unistd.h>
+
+#if defined(HAVE_HWLOC)
+#include <hwloc.h>
+#endif
 
 affinity_set::affinity_set()
 {
@@ -33,6 +50,23 @@ void affinity_set::add(int cpu)
 }
 
 
+bool affinity_set::contains(int cpu) const
+{
+    return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+}
+
+
+int affinity_set::count() const
+{
+    int cnt = 0;
+    for (int icpu=0; icpu < CPU_SETSIZE; ++icpu) {
+        if ( CPU_ISSET( icpu, &set ))
+            ++cnt;
+    }
+    return cnt;
+}
+
+
 int affinity_set::get_affinity()
 {
     return sched_getaffinity( 0, sizeof(set), &set);
@@ -80,4 +114,492 @@ void affinity_set::print_set(int id, const char* s)
 #endif
 }
 
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Returns the topology of the machine, discovered on first use.
+
+    Threads are placed according to $MAGMA_AFFINITY:
+    -     physical: one thread per physical core, filling socket after socket;
+                    SMT siblings (hyperthreads) get threads only once every core
+                    has one. This is the default.
+    -     compact:  all SMT siblings of a core before the next core.
+    -     scatter:  round robin over the sockets, physical cores first.
+    -     none:     threads are not bound.
+
+    Only CPUs in the affinity mask of the calling thread are used, so cores
+    reserved by taskset, cgroups, or the OpenMP runtime of the caller
+    (e.g., OMP_PLACES) are respected.
+
+    @ingroup magma_thread
+*******************************************************************************/
+const magma_topology& magma_topology::instance()
+{
+    static magma_topology topology;
+    return topology;
+}
+
+
+/******************************************************************************/
+magma_topology::magma_topology():
+    ncpus   ( 0 ),
+    ncores  ( 0 ),
+    nsockets( 0 ),
+    policy_ ( MagmaAffinityPhysical ),
+    policy_given_( false )
+{
+    const char* policy_str = getenv( "MAGMA_AFFINITY" );
+    if ( policy_str != NULL && policy_str[0] != '\0' ) {
+        policy_given_ = true;
+        if ( strcmp( policy_str, "none" ) == 0 )
+            policy_ = MagmaAffinityNone;
+        else if ( strcmp( policy_str, "physical" ) == 0 )
+            policy_ = MagmaAffinityPhysical;
+        else if ( strcmp( policy_str, "compact" ) == 0 )
+            policy_ = MagmaAffinityCompact;
+        else if ( strcmp( policy_str, "scatter" ) == 0 )
+            policy_ = MagmaAffinityScatter;
+        else
+            fprintf( stderr, "$MAGMA_AFFINITY='%s' is invalid; using physical.\n",
+                     policy_str );
+    }
+
+    discover_hwloc();
+    if ( ncpus == 0 ) {
+        discover_sys();
+    }
+    finish();
+}
+
+
+/******************************************************************************/
+// Fills cpus from hwloc: socket and core are logical indices, node is the
+// OS index of the first NUMA node of the PU.
+void magma_topology::discover_hwloc()
+{
+#if defined(HAVE_HWLOC)
+    hwloc_topology_t topology;
+    hwloc_topology_init( &topology );
+    hwloc_topology_load( topology );
+    int npu = hwloc_get_nbobjs_by_type( topology, HWLOC_OBJ_PU );
+    for (int i=0; i < npu && ncpus < CPU_SETSIZE; ++i) {
+        hwloc_obj_t pu   = hwloc_get_obj_by_type( topology, HWLOC_OBJ_PU, i );
+        hwloc_obj_t core = hwloc_get_ancestor_obj_by_type( topology, HWLOC_OBJ_CORE,    pu );
+        hwloc_obj_t pkg  = hwloc_get_ancestor_obj_by_type( topology, HWLOC_OBJ_PACKAGE, pu );
+        cpu_info& c = cpus[ ncpus++ ];
+        c.cpu    = pu->os_index;
+        c.socket = (pkg  != NULL ? pkg->logical_index  : 0);
+        c.core   = (core != NULL ? core->logical_index : pu->logical_index);
+        c.node   = (pu->nodeset != NULL ? hwloc_bitmap_first( pu->nodeset ) : -1);
+    }
+    hwloc_topology_destroy( topology );
+#endif
+}
+
+
+/******************************************************************************/
+// Reads an integer from a file in /sys, -1 if it cannot be read.
+static int read_sys_int( int cpu, const char* file )
+{
+    char path[128];
+    snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, file );
+    int value = -1;
+    FILE* f = fopen( path, "r" );
+    if ( f != NULL ) {
+        if ( fscanf( f, "%d", &value ) != 1 )
+            value = -1;
+        fclose( f );
+    }
+    return value;
+}
+
+
+/******************************************************************************/
+// Fills cpus from /sys/devices/system/cpu. Without /sys, each online CPU
+// is taken as its own core on socket 0.
+void magma_topology::discover_sys()
+{
+    // physical_package_id, core_id per CPU; core_id is unique only per socket
+    int sys_core[ CPU_SETSIZE ];
+    int ncpu_conf = (int) sysconf( _SC_NPROCESSORS_CONF );
+    for (int cpu=0; cpu < CPU_SETSIZE && ncpus < ncpu_conf; ++cpu) {
+        char path[64];
+        snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu );
+        DIR* dir = opendir( path );
+        if ( dir == NULL ) {
+            if ( cpu >= ncpu_conf )
+                break;
+            continue;
+        }
+        if ( read_sys_int( cpu, "online" ) == 0 ) {
+            closedir( dir );
+            continue;
+        }
+        cpu_info& c = cpus[ ncpus ];
+        c.cpu    = cpu;
+        c.socket = max( 0, read_sys_int( cpu, "topology/physical_package_id" ));
+        sys_core[ ncpus ] = read_sys_int( cpu, "topology/core_id" );
+        if ( sys_core[ ncpus ] < 0 )
+            sys_core[ ncpus ] = cpu;
+        c.node = -1;
+        struct dirent* entry;
+        while( (entry = readdir( dir )) != NULL ) {
+            if ( strncmp( entry->d_name, "node", 4 ) == 0
+                 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9' ) {
+                c.node = atoi( entry->d_name + 4 );
+                break;
+            }
+        }
+        closedir( dir );
+        ++ncpus;
+    }
+
+    if ( ncpus == 0 ) {
+        for (int cpu=0; cpu < ncpu_conf && cpu < CPU_SETSIZE; ++cpu) {
+            cpus[ ncpus ].cpu    = cpu;
+            cpus[ ncpus ].socket = 0;
+            cpus[ ncpus ].node   = -1;
+            sys_core[ ncpus ] = cpu;
+            ++ncpus;
+        }
+    }
+
+    // number the (socket, core_id) pairs consecutively
+    for (int i=0; i < ncpus; ++i) {
+        cpus[i].core = i;
+        for (int j=0; j < i; ++j) {
+            if ( cpus[j].socket == cpus[i].socket && sys_core[j] == sys_core[i] ) {
+                cpus[i].core = cpus[j].core;
+                break;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+// Renumbers sockets and cores consecutively, ranks cores within sockets and
+// CPUs within cores, and sorts the CPUs in the order of the policy.
+void magma_topology::finish()
+{
+    // sort by socket, core, OS index
+    std::sort( cpus, cpus + ncpus, []( const cpu_info& a, const cpu_info& b ) {
+        if ( a.socket != b.socket ) return a.socket < b.socket;
+        if ( a.core   != b.core   ) return a.core   < b.core;
+        return a.cpu < b.cpu;
+    });
+
+    int last_socket = -1, last_core = -1;
+    for (int i=0; i < ncpus; ++i) {
+        cpu_info& c = cpus[i];
+        if ( c.socket != last_socket ) {
+            last_socket = c.socket;
+            c.socket = nsockets++;
+            last_core = -1;
+            c.rank = -1;
+        }
+        else {
+            c.socket = cpus[i-1].socket;
+            c.rank   = cpus[i-1].rank;
+        }
+        if ( c.core != last_core ) {
+            last_core = c.core;
+            c.core = ncores++;
+            c.rank += 1;
+            c.smt  = 0;
+        }
+        else {
+            c.core = cpus[i-1].core;
+            c.smt  = cpus[i-1].smt + 1;
+        }
+    }
+
+    for (int i=0; i < ncpus; ++i) {
+        order[i] = i;
+    }
+    const cpu_info* c = cpus;
+    switch ( policy_ ) {
+        case MagmaAffinityCompact:
+            // already in order socket, core, smt
+            break;
+
+        case MagmaAffinityScatter:
+            std::stable_sort( order, order + ncpus, [c]( int a, int b ) {
+                if ( c[a].smt  != c[b].smt  ) return c[a].smt  < c[b].smt;
+                if ( c[a].rank != c[b].rank ) return c[a].rank < c[b].rank;
+                return c[a].socket < c[b].socket;
+            });
+            break;
+
+        default:
+            std::stable_sort( order, order + ncpus, [c]( int a, int b ) {
+                return c[a].smt < c[b].smt;
+            });
+            break;
+    }
+}
+
+
+/******************************************************************************/
+// NUMA node of the given CPU, -1 if unknown.
+int magma_topology::node_of_cpu( int cpu ) const
+{
+    for (int i=0; i < ncpus; ++i) {
+        if ( cpus[i].cpu == cpu )
+            return cpus[i].node;
+    }
+    return -1;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Returns the CPU for thread tid of a team of nthread threads, according
+    to the placement policy, or -1 if threads are not bound.
+    The CPUs are taken from the allowed set, typically the affinity of the
+    thread that creates the team. If it has fewer CPUs than the team
+    (e.g., the caller is an OpenMP thread bound to a single core), all CPUs
+    of the machine are used instead.
+
+    @param[in] tid      Thread index, 0 <= tid.
+    @param[in] nthread  Number of threads of the team.
+    @param[in] allowed  CPUs the team may use.
+*******************************************************************************/
+int magma_topology::cpu_for_thread( int tid, int nthread, const affinity_set& allowed ) const
+{
+    if ( policy_ == MagmaAffinityNone || ncpus == 0 ) {
+        return -1;
+    }
+    int nallowed = 0;
+    for (int i=0; i < ncpus; ++i) {
+        if ( allowed.contains( cpus[ order[i] ].cpu ))
+            ++nallowed;
+    }
+    bool all = (nallowed < nthread);
+    int n = (all ? ncpus : nallowed);
+    int k = tid % n;
+    for (int i=0; i < ncpus; ++i) {
+        int cpu = cpus[ order[i] ].cpu;
+        if ( all || allowed.contains( cpu )) {
+            if ( k == 0 )
+                return cpu;
+            --k;
+        }
+    }
+    return -1;
+}
+
+
+/***************************************************************************//**
+    Binds the calling thread to the CPUs of the given NUMA node that are in
+    its affinity mask, saving the previous mask in original.
+    @return 0 on success, -1 if the node has no such CPU or binding failed.
+*******************************************************************************/
+int magma_topology::bind_to_node( int node, affinity_set* original ) const
+{
+    if ( original->get_affinity() != 0 ) {
+        return -1;
+    }
+    affinity_set node_set;
+    bool empty = true;
+    for (int i=0; i < ncpus; ++i) {
+        if ( cpus[i].node == node && original->contains( cpus[i].cpu )) {
+            node_set.add( cpus[i].cpu );
+            empty = false;
+        }
+    }
+    if ( empty || node_set.set_affinity() != 0 ) {
+        return -1;
+    }
+    return 0;
+}
+
+
+/******************************************************************************/
+affinity_bind::affinity_bind( int tid, int nthread, bool always ):
+    cpu_( -1 )
+{
+    const magma_topology& topology = magma_topology::instance();
+    if ( ! always && ! topology.policy_given() ) {
+        return;
+    }
+    if ( original.get_affinity() != 0 ) {
+        printf("Error in sched_getaffinity\n");
+        return;
+    }
+    int cpu = topology.cpu_for_thread( tid, nthread, original );
+    if ( cpu < 0 ) {
+        return;
+    }
+    affinity_set new_set( cpu );
+    if ( new_set.set_affinity() != 0 ) {
+        printf("Error in sched_setaffinity (single cpu)\n");
+        return;
+    }
+    cpu_ = cpu;
+}
+
+
+/******************************************************************************/
+affinity_bind::~affinity_bind()
+{
+    if ( cpu_ >= 0 && original.set_affinity() != 0 ) {
+        printf("Error in sched_setaffinity (restore cpu list)\n");
+    }
+}
+
+
+/******************************************************************************/
+int affinity_bind::node() const
+{
+    return magma_topology::instance().node_of_cpu( cpu_ );
+}
+
+
+/******************************************************************************/
+// Saved affinity of OpenMP threads bound by magma_affinity_omp_bind.
+static thread_local affinity_bind* omp_original = NULL;
+
 #endif  // MAGMA_NOAFFINITY
+
+
+/***************************************************************************//**
+    @return NUMA node of the CPU the calling thread runs on, -1 if unknown.
+    @ingroup magma_thread
+*******************************************************************************/
+int magma_affinity_current_node()
+{
+#ifndef MAGMA_NOAFFINITY
+    int cpu = sched_getcpu();
+    if ( cpu >= 0 ) {
+        return magma_topology::instance().node_of_cpu( cpu );
+    }
+#endif
+    return -1;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Binds each thread of the OpenMP thread team to the CPU chosen by the
+    placement policy for its thread number, if $MAGMA_AFFINITY is set;
+    otherwise the placement is left to the OpenMP runtime (OMP_PROC_BIND).
+    Call magma_affinity_omp_restore with the same number of OpenMP threads
+    to restore the previous affinity.
+    Since OpenMP keeps its threads, the binding holds for all parallel
+    regions in between.
+
+    @ingroup magma_thread
+*******************************************************************************/
+void magma_affinity_omp_bind()
+{
+#if ! defined(MAGMA_NOAFFINITY) && defined(_OPENMP)
+    if ( ! magma_topology::instance().policy_given() ) {
+        return;
+    }
+    #pragma omp parallel
+    {
+        if ( omp_original == NULL ) {
+            omp_original = new affinity_bind( omp_get_thread_num(),
+                                              omp_get_num_threads() );
+        }
+    }
+#endif
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Restores the affinity of the OpenMP threads bound by
+    magma_affinity_omp_bind.
+
+    @ingroup magma_thread
+*******************************************************************************/
+void magma_affinity_omp_restore()
+{
+#if ! defined(MAGMA_NOAFFINITY) && defined(_OPENMP)
+    if ( ! magma_topology::instance().policy_given() ) {
+        return;
+    }
+    #pragma omp parallel
+    {
+        delete omp_original;
+        omp_original = NULL;
+    }
+#endif
+}
+
+
+/******************************************************************************/
+// Slots of the calling thread for the OpenMP teams it creates;
+// nthread = 0 if not set.
+static thread_local int team_first   = 0;
+static thread_local int team_nthread = 0;
+
+affinity_team::affinity_team( int first, int nthread ):
+    prev_first( team_first ),
+    prev_nthread( team_nthread )
+{
+    team_first   = first;
+    team_nthread = nthread;
+}
+
+affinity_team::~affinity_team()
+{
+    team_first   = prev_first;
+    team_nthread = prev_nthread;
+}
+
+int affinity_team::first()   { return team_first;   }
+int affinity_team::nthread() { return team_nthread; }
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Allocates memory on the host, like magma_malloc_cpu, and places its pages
+    on the given NUMA node by first touch: the pages are zeroed by the
+    calling thread while it is temporarily bound to the CPUs of that node.
+    Use it for buffers that are mostly accessed by threads on one node.
+    Small allocations may reuse pages that were already touched and stay
+    where they are.
+
+    Arguments
+    ---------
+    @param[out]
+    ptr     On output, set to the pointer that was allocated.
+            NULL on failure.
+
+    @param[in]
+    size    Size in bytes to allocate. If size = 0, allocates some minimal size.
+
+    @param[in]
+    node    NUMA node. If node < 0 or unknown, the pages are placed on the
+            node of the calling thread.
+
+    @ingroup magma_thread
+*******************************************************************************/
+magma_int_t
+magma_malloc_cpu_first_touch( void** ptr, size_t size, int node )
+{
+    magma_int_t info = magma_malloc_cpu( ptr, size );
+    if ( info != MAGMA_SUCCESS ) {
+        return info;
+    }
+#ifndef MAGMA_NOAFFINITY
+    affinity_set original;
+    if ( node >= 0 && magma_topology::instance().bind_to_node( node, &original ) == 0 ) {
+        memset( *ptr, 0, size );
+        if ( original.set_affinity() != 0 ) {
+            printf("Error in sched_setaffinity (restore cpu list)\n");
+        }
+        return info;
+    }
+#endif
+    memset( *ptr, 0, size );
+    return info;
+}
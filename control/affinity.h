@@ -12,6 +12,8 @@
 #ifndef MAGMA_AFFINITY_H
 #define MAGMA_AFFINITY_H
 
+#include "magma_types.h"
+
 #ifndef MAGMA_NOAFFINITY
 
 #ifndef _GNU_SOURCE
@@ -31,6 +33,10 @@ public:
 
     void add(int cpu);
 
+    bool contains(int cpu) const;
+
+    int count() const;
+
     int get_affinity();
 
     int set_affinity();
@@ -44,10 +50,131 @@ private:
     cpu_set_t set;
 };
 
+
+/******************************************************************************/
+// Placement policies for MAGMA's CPU threads, set by $MAGMA_AFFINITY.
+typedef enum {
+    MagmaAffinityNone,      // do not bind threads
+    MagmaAffinityPhysical,  // one thread per physical core, socket after socket;
+                            // SMT siblings only once all cores have a thread
+    MagmaAffinityCompact,   // all SMT siblings of a core before the next core
+    MagmaAffinityScatter    // round robin over the sockets, physical cores first
+} magma_affinity_policy_t;
+
+
+/******************************************************************************/
+// Sockets, cores, SMT siblings, and NUMA nodes of the logical CPUs,
+// discovered once from hwloc when compiled with HAVE_HWLOC, else from /sys.
+class magma_topology
+{
+public:
+    static const magma_topology& instance();
+
+    int ncpu()    const { return ncpus;    }
+    int ncore()   const { return ncores;   }
+    int nsocket() const { return nsockets; }
+    int node_of_cpu( int cpu ) const;
+
+    magma_affinity_policy_t policy() const { return policy_; }
+    bool policy_given() const { return policy_given_; }
+
+    int cpu_for_thread( int tid, int nthread, const affinity_set& allowed ) const;
+    int bind_to_node( int node, affinity_set* original ) const;
+
+private:
+    struct cpu_info {
+        int cpu;      // OS index of the logical CPU
+        int socket;   // 0, ..., nsockets-1
+        int core;     // 0, ..., ncores-1, unique over all sockets
+        int rank;     // rank of the core within its socket
+        int smt;      // rank of the CPU within its core
+        int node;     // NUMA node, -1 if unknown
+    };
+
+    magma_topology();
+    void discover_hwloc();
+    void discover_sys();
+    void finish();
+
+    cpu_info cpus[ CPU_SETSIZE ];
+    int order[ CPU_SETSIZE ];    // indices into cpus, in placement order
+    int ncpus;
+    int ncores;
+    int nsockets;
+    magma_affinity_policy_t policy_;
+    bool policy_given_;
+};
+
+
+/******************************************************************************/
+// Binds the calling thread, thread tid of nthread, to the CPU chosen by
+// the placement policy, and restores its previous affinity when destroyed.
+// MAGMA's own threads bind always (default policy physical);
+// with always = false, e.g., in OpenMP regions and in the thread pool,
+// threads bind only if $MAGMA_AFFINITY is set.
+class affinity_bind
+{
+public:
+    affinity_bind( int tid, int nthread, bool always=true );
+    ~affinity_bind();
+
+    int cpu()  const { return cpu_; }
+    int node() const;
+
+private:
+    affinity_set original;
+    int cpu_;
+};
+
 #else
 #error "Affinity requires Linux glibc version >= 2.3.3, which isn't available. Please add -DMAGMA_NOAFFINITY to the CFLAGS in make.inc."
 #endif
 
+#else  // MAGMA_NOAFFINITY
+
+/******************************************************************************/
+// Without affinity support, binding does nothing.
+class affinity_bind
+{
+public:
+    affinity_bind( int tid, int nthread, bool always=true ) {}
+
+    int cpu()  const { return -1; }
+    int node() const { return -1; }
+};
+
 #endif  // MAGMA_NOAFFINITY
 
+
+/******************************************************************************/
+// Placement slots first, ..., first + nthread - 1 for the OpenMP teams that
+// the calling thread creates, while the object is alive. Callers that run
+// several teams concurrently, e.g., the merge tasks of dlaex0 on the thread
+// pool, give each team its own slots so the teams bind to disjoint CPUs.
+// The previous slots are restored when destroyed.
+class affinity_team
+{
+public:
+    affinity_team( int first, int nthread );
+    ~affinity_team();
+
+    static int first();
+    static int nthread();
+
+private:
+    int prev_first;
+    int prev_nthread;
+};
+
+
+/******************************************************************************/
+int magma_affinity_current_node();
+
+void magma_affinity_omp_bind();
+
+void magma_affinity_omp_restore();
+
+magma_int_t
+magma_malloc_cpu_first_touch( void** ptr, size_t size, int node );
+
 #endif  // MAGMA_AFFINITY_H
@@ -11,6 +11,7 @@
 */
 
 #include "magma_internal.h"
+#include "magma_bulge.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -1418,7 +1419,12 @@ magma_int_t magma_get_zbulge_nb( magma_int_t n, magma_int_t nbthreads )
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
-    magma_int_t size;
+    magma_int_t size, colblktile, nthread;
+    // on-host tuned value, see testing_ssytrd_sb2st_tune
+    if ( magma_bulge_get_tuning( "ssytrd_sb2st", n, nb, &size, &colblktile, &nthread ) == MAGMA_SUCCESS
+         && size > 0 ) {
+        return min( nb, size );
+    }
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
         size = min(nb, 128);
@@ -1432,7 +1438,12 @@ magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
-    magma_int_t size;
+    magma_int_t size, colblktile, nthread;
+    // on-host tuned value, see testing_dsytrd_sb2st_tune
+    if ( magma_bulge_get_tuning( "dsytrd_sb2st", n, nb, &size, &colblktile, &nthread ) == MAGMA_SUCCESS
+         && size > 0 ) {
+        return min( nb, size );
+    }
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
         size = min(nb, 64);
@@ -1446,7 +1457,12 @@ magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
-    magma_int_t size;
+    magma_int_t size, colblktile, nthread;
+    // on-host tuned value, see testing_chetrd_hb2st_tune
+    if ( magma_bulge_get_tuning( "chetrd_hb2st", n, nb, &size, &colblktile, &nthread ) == MAGMA_SUCCESS
+         && size > 0 ) {
+        return min( nb, size );
+    }
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
         if ( nbthreads > 14 )
@@ -1463,7 +1479,12 @@ magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_zbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
-    magma_int_t size;
+    magma_int_t size, colblktile, nthread;
+    // on-host tuned value, see testing_zhetrd_hb2st_tune
+    if ( magma_bulge_get_tuning( "zhetrd_hb2st", n, nb, &size, &colblktile, &nthread ) == MAGMA_SUCCESS
+         && size > 0 ) {
+        return min( nb, size );
+    }
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
         if ( nbthreads > 14 )
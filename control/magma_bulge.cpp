@@ -10,7 +10,11 @@
        @author Raffaele Solca
 */
 
+#include <pthread.h>
+#include <vector>
+
 #include "magma_internal.h"
+#include "magma_bulge.h"
 
 #define applyQver 113
 
@@ -197,6 +201,230 @@ return n*lda2[0];
 }
 
 
+// =============================================================================
+// Stage-2 tuning table
+//
+// Holds on-host tuned parameters of the bulge chasing, one entry per
+// routine (e.g., "zhetrd_hb2st"), n, and nb. The table is loaded lazily from
+// the file named by $MAGMA_BULGE_TUNING, which testing_zhetrd_hb2st_tune
+// writes. Each non-comment line of the file is
+//
+//     routine  n  nb  Vblksiz  colblktile  nthread  time
+//
+// where 0 for Vblksiz, colblktile, or nthread means use the heuristic.
+
+typedef struct magma_bulge_tuning_s {
+    char        routine[32];
+    magma_int_t n, nb, Vblksiz, colblktile, nthread;
+    double      time;
+} magma_bulge_tuning_t;
+
+static std::vector< magma_bulge_tuning_t > g_bulge_tuning;
+static bool g_bulge_tuning_loaded = false;
+static pthread_mutex_t g_bulge_tuning_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/******************************************************************************/
+// Returns index of entry for routine, n, nb, or -1. Caller holds the mutex.
+static magma_int_t
+magma_bulge_tuning_find( const char* routine, magma_int_t n, magma_int_t nb )
+{
+    for (size_t i = 0; i < g_bulge_tuning.size(); ++i) {
+        const magma_bulge_tuning_t& t = g_bulge_tuning[i];
+        if (t.n == n && t.nb == nb && strcmp( t.routine, routine ) == 0)
+            return magma_int_t( i );
+    }
+    return -1;
+}
+
+
+/******************************************************************************/
+// Adds or replaces an entry. Caller holds the mutex.
+static void
+magma_bulge_tuning_insert( const magma_bulge_tuning_t& entry )
+{
+    magma_int_t i = magma_bulge_tuning_find( entry.routine, entry.n, entry.nb );
+    if (i >= 0)
+        g_bulge_tuning[i] = entry;
+    else
+        g_bulge_tuning.push_back( entry );
+}
+
+
+/******************************************************************************/
+// Reads $MAGMA_BULGE_TUNING on first use. Caller holds the mutex.
+static void
+magma_bulge_tuning_load()
+{
+    if (g_bulge_tuning_loaded)
+        return;
+    g_bulge_tuning_loaded = true;
+
+    const char* filename = getenv( "MAGMA_BULGE_TUNING" );
+    if (filename == NULL || filename[0] == '\0')
+        return;
+
+    FILE* file = fopen( filename, "r" );
+    if (file == NULL)
+        return;
+
+    char line[256];
+    while (fgets( line, sizeof(line), file ) != NULL) {
+        magma_bulge_tuning_t t;
+        long long n, nb, Vblksiz, colblktile, nthread;
+        if (line[0] == '#')
+            continue;
+        if (sscanf( line, "%31s %lld %lld %lld %lld %lld %lf", t.routine,
+                    &n, &nb, &Vblksiz, &colblktile, &nthread, &t.time ) != 7)
+            continue;
+        if (n < 1 || nb < 1 || Vblksiz < 0 || Vblksiz > nb
+            || colblktile < 0 || nthread < 0)
+            continue;
+        t.n          = magma_int_t( n );
+        t.nb         = magma_int_t( nb );
+        t.Vblksiz    = magma_int_t( Vblksiz );
+        t.colblktile = magma_int_t( colblktile );
+        t.nthread    = magma_int_t( nthread );
+        magma_bulge_tuning_insert( t );
+    }
+    fclose( file );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Looks up tuned stage-2 parameters for the bulge chasing of the given
+    routine, e.g., "zhetrd_hb2st" or "dsytrd_sb2st". Entries tuned for the
+    same nb are considered, and the one with the nearest n is used, provided
+    it is within a factor of 2 of n.
+
+    Arguments
+    ---------
+    @param[in]
+    routine     Name of the bulge chasing routine.
+
+    @param[in]
+    n           The order of the matrix.
+
+    @param[in]
+    nb          The bandwidth of the band matrix.
+
+    @param[out]
+    Vblksiz     On success, tuned Vblksiz, or 0 to use the heuristic.
+
+    @param[out]
+    colblktile  On success, tuned number of consecutive tiles per core,
+                or 0 to use the heuristic.
+
+    @param[out]
+    nthread     On success, tuned maximum number of threads,
+                or 0 to use the heuristic.
+
+    @return MAGMA_SUCCESS, or MAGMA_ERR_NOT_FOUND if there is no entry;
+            then the outputs are not changed.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+magma_int_t
+magma_bulge_get_tuning(
+    const char* routine, magma_int_t n, magma_int_t nb,
+    magma_int_t *Vblksiz, magma_int_t *colblktile, magma_int_t *nthread )
+{
+    magma_int_t info = MAGMA_ERR_NOT_FOUND;
+    double best = 0;
+
+    pthread_mutex_lock( &g_bulge_tuning_mutex );
+    magma_bulge_tuning_load();
+    for (size_t i = 0; i < g_bulge_tuning.size(); ++i) {
+        const magma_bulge_tuning_t& t = g_bulge_tuning[i];
+        if (t.nb != nb || strcmp( t.routine, routine ) != 0)
+            continue;
+        double dist = fabs( log( double(t.n) / double(n) ));
+        if (dist <= log( 2. ) && (info != MAGMA_SUCCESS || dist < best)) {
+            best = dist;
+            info = MAGMA_SUCCESS;
+            *Vblksiz    = t.Vblksiz;
+            *colblktile = t.colblktile;
+            *nthread    = t.nthread;
+        }
+    }
+    pthread_mutex_unlock( &g_bulge_tuning_mutex );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Adds or replaces the tuned stage-2 parameters for routine, n, and nb.
+    The tuner uses this to try candidates, since the entry is seen by
+    subsequent calls to magma_bulge_get_tuning.
+    See magma_bulge_get_tuning for the arguments; time is the measured
+    stage-2 time in seconds, kept for reference in the tuning file.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+void
+magma_bulge_set_tuning(
+    const char* routine, magma_int_t n, magma_int_t nb,
+    magma_int_t Vblksiz, magma_int_t colblktile, magma_int_t nthread,
+    double time )
+{
+    magma_bulge_tuning_t t;
+    strncpy( t.routine, routine, sizeof(t.routine)-1 );
+    t.routine[ sizeof(t.routine)-1 ] = '\0';
+    t.n          = n;
+    t.nb         = nb;
+    t.Vblksiz    = Vblksiz;
+    t.colblktile = colblktile;
+    t.nthread    = nthread;
+    t.time       = time;
+
+    pthread_mutex_lock( &g_bulge_tuning_mutex );
+    magma_bulge_tuning_load();
+    magma_bulge_tuning_insert( t );
+    pthread_mutex_unlock( &g_bulge_tuning_mutex );
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Writes all entries of the stage-2 tuning table to filename, in the
+    format read from $MAGMA_BULGE_TUNING.
+
+    @param[in]
+    filename    Name of the tuning file.
+
+    @return MAGMA_SUCCESS, or MAGMA_ERR_NOT_FOUND if the file cannot be opened.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+magma_int_t
+magma_bulge_write_tuning( const char* filename )
+{
+    FILE* file = fopen( filename, "w" );
+    if (file == NULL)
+        return MAGMA_ERR_NOT_FOUND;
+
+    pthread_mutex_lock( &g_bulge_tuning_mutex );
+    magma_bulge_tuning_load();
+    fprintf( file, "# MAGMA stage-2 tuning; 0 means use the heuristic\n" );
+    fprintf( file, "# routine              n     nb  Vblksiz  colblktile  nthread       time\n" );
+    for (size_t i = 0; i < g_bulge_tuning.size(); ++i) {
+        const magma_bulge_tuning_t& t = g_bulge_tuning[i];
+        fprintf( file, "%-16s  %6lld  %5lld  %7lld  %10lld  %7lld  %9.4f\n",
+                 t.routine, (long long) t.n, (long long) t.nb, (long long) t.Vblksiz,
+                 (long long) t.colblktile, (long long) t.nthread, t.time );
+    }
+    pthread_mutex_unlock( &g_bulge_tuning_mutex );
+
+    fclose( file );
+    return MAGMA_SUCCESS;
+}
+
+
 // =============================================================================
 // Old functions
 
@@ -66,7 +66,8 @@
 #include "magma_threadsetting.h"
 
 /***************************************************************************//**
-    Define magma_queue structure, which wraps around CUDA and OpenCL queues.
+    Define magma_queue structure, which wraps around CUDA, HIP, and OpenCL
+    queues, or the host streams of the CPU backend.
     In C, this is a simple struct.
     In C++, it is a class with getter member functions.
     For both C/C++, use magma_queue_create() and magma_queue_destroy()
@@ -119,6 +120,11 @@ public:
         }
     }
     
+    #ifdef MAGMA_HAVE_CPU
+    /// @return host stream executing this queue's operations; requires the CPU backend.
+    struct magma_host_stream* host_stream() { return stream__; }
+    #endif
+
     #ifdef MAGMA_HAVE_HIP
     
     hipStream_t      hip_stream()      { return stream__; };
@@ -202,6 +208,10 @@ protected:
     cusparseHandle_t cusparse__;    // associated cuSparse handle
     #endif // MAGMA_HAVE_CUDA
 
+    #ifdef MAGMA_HAVE_CPU
+    struct magma_host_stream* stream__;  // tasks on the thread pool, executed in order
+    #endif
+
     #ifdef MAGMA_HAVE_HIP
     hipStream_t      stream__;
     //rocblas_handle rocblas__;
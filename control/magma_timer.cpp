@@ -6,7 +6,27 @@
        @date
 */
 
+// STL headers before magma_internal.h, which defines min and max
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
 #include "magma_internal.h"
+#include "magma_timer.h"
+
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#if defined(HAVE_PAPI)
+#  include <pthread.h>
+#  include <papi.h>
+#endif
 
 #if defined( _WIN32 ) || defined( _WIN64 )
 #  include <time.h>
@@ -116,3 +136,472 @@ void magmaf_wtime(double *time)
 {
     *time = magma_wtime();
 }
+
+
+
+/***************************************************************************//**
+    @page timers Timers inside routines
+
+    Routines time their phases with timer_start(), timer_stop(), and
+    timer_record() from control/magma_timer.h, e.g., the "panel", "update",
+    "transfer", and "cpu wait" phases of magma_zgetrf_gpu. Timers are off
+    by default, and cost one relaxed load of a flag each; no rebuild with
+    ENABLE_TIMER is needed. They are turned on by magma_timer_set_mode()
+    or by $MAGMA_TIMER at startup:
+
+        MAGMA_TIMER=on      record phases, for magma_timer_query()
+        MAGMA_TIMER=print   also print routines' timer_printf output,
+                            as building with ENABLE_TIMER did
+
+    Each phase accumulates its time, number of calls, and a hardware
+    counter of the threads recording it, selected by
+    magma_timer_set_counter() or $MAGMA_TIMER_COUNTER:
+    "cycles" or "instructions" (Linux perf_event hardware counters),
+    "task-clock" (nanoseconds the thread ran, so time not spent waiting;
+    available in most VMs, which lack hardware counters), or
+    "flops" (PAPI_FP_OPS, if MAGMA was built with HAVE_PAPI).
+
+    A service can read the totals with magma_timer_count() and
+    magma_timer_get(), or magma_timer_query() for one phase,
+    and clear them with magma_timer_reset().
+*******************************************************************************/
+
+std::atomic<int> g_magma_timer_mode( MagmaTimerOff );
+
+namespace {
+
+enum timer_counter_kind {
+    counter_none = 0,
+    counter_cycles,
+    counter_instructions,
+    counter_task_clock,
+    counter_flops
+};
+
+const char* counter_names[] = { "", "cycles", "instructions", "task-clock", "flops" };
+
+
+/******************************************************************************/
+// Totals of one phase. Entries are never removed, so names stay valid.
+struct timer_entry
+{
+    std::string routine;
+    std::string phase;
+    double      seconds;
+    magma_int_t calls;
+    long long   count;
+};
+
+struct timer_registry
+{
+    std::mutex                    mutex;
+    std::deque< timer_entry >     entries;
+    std::map< std::pair< std::string, std::string >, size_t > index;
+};
+
+timer_registry& registry()
+{
+    static timer_registry r;
+    return r;
+}
+
+// counter kind, and generation, so threads reopen theirs when it changes
+std::atomic<int> g_counter_kind( counter_none );
+std::atomic<int> g_counter_generation( 0 );
+
+
+/******************************************************************************/
+// Hardware counter of the calling thread.
+struct timer_thread_counter
+{
+    int generation = -1;
+    int kind       = counter_none;
+    int fd         = -1;   // perf_event file descriptor
+    #if defined(HAVE_PAPI)
+    int eventset   = PAPI_NULL;
+    #endif
+
+    ~timer_thread_counter() { close(); }
+
+    void close()
+    {
+        #if defined(__linux__)
+        if ( fd >= 0 ) {
+            ::close( fd );
+        }
+        #endif
+        fd = -1;
+        #if defined(HAVE_PAPI)
+        if ( eventset != PAPI_NULL ) {
+            long long value;
+            PAPI_stop( eventset, &value );
+            PAPI_cleanup_eventset( eventset );
+            PAPI_destroy_eventset( &eventset );
+        }
+        #endif
+    }
+
+    // returns whether the counter could be opened
+    bool open( int in_kind )
+    {
+        close();
+        kind = in_kind;
+        if ( kind == counter_cycles || kind == counter_instructions
+             || kind == counter_task_clock ) {
+            #if defined(__linux__)
+            struct perf_event_attr attr;
+            memset( &attr, 0, sizeof(attr) );
+            attr.size           = sizeof(attr);
+            if ( kind == counter_task_clock ) {
+                attr.type       = PERF_TYPE_SOFTWARE;
+                attr.config     = PERF_COUNT_SW_TASK_CLOCK;
+            }
+            else {
+                attr.type       = PERF_TYPE_HARDWARE;
+                attr.config     = (kind == counter_cycles
+                                   ? PERF_COUNT_HW_CPU_CYCLES
+                                   : PERF_COUNT_HW_INSTRUCTIONS);
+            }
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            // this thread, on any CPU
+            fd = int( syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 ));
+            return fd >= 0;
+            #endif
+        }
+        else if ( kind == counter_flops ) {
+            #if defined(HAVE_PAPI)
+            static std::once_flag papi_once;
+            std::call_once( papi_once, []() {
+                PAPI_library_init( PAPI_VER_CURRENT );
+                PAPI_thread_init( (unsigned long (*)(void)) pthread_self );
+            });
+            if ( PAPI_create_eventset( &eventset ) == PAPI_OK
+                 && PAPI_add_event( eventset, PAPI_FP_OPS ) == PAPI_OK
+                 && PAPI_start( eventset ) == PAPI_OK ) {
+                return true;
+            }
+            if ( eventset != PAPI_NULL ) {
+                PAPI_cleanup_eventset( eventset );
+                PAPI_destroy_eventset( &eventset );
+            }
+            #endif
+        }
+        return kind == counter_none;
+    }
+
+    long long read()
+    {
+        int gen = g_counter_generation.load( std::memory_order_acquire );
+        if ( gen != generation ) {
+            generation = gen;
+            open( g_counter_kind.load( std::memory_order_relaxed ));
+        }
+        long long value = 0;
+        #if defined(__linux__)
+        if ( fd >= 0 && ::read( fd, &value, sizeof(value) ) != sizeof(value) ) {
+            value = 0;
+        }
+        #endif
+        #if defined(HAVE_PAPI)
+        if ( eventset != PAPI_NULL ) {
+            PAPI_read( eventset, &value );
+        }
+        #endif
+        return value;
+    }
+};
+
+thread_local timer_thread_counter t_counter;
+
+
+/******************************************************************************/
+// Sets mode and counter from the environment at startup.
+struct timer_environment
+{
+    timer_environment()
+    {
+        const char* mode = getenv( "MAGMA_TIMER" );
+        if ( mode != NULL ) {
+            if ( strcmp( mode, "print" ) == 0 ) {
+                magma_timer_set_mode( MagmaTimerPrint );
+            }
+            else if ( strcmp( mode, "on" ) == 0
+                      || strcmp( mode, "1" ) == 0 ) {
+                magma_timer_set_mode( MagmaTimerOn );
+            }
+        }
+        const char* counter = getenv( "MAGMA_TIMER_COUNTER" );
+        if ( counter != NULL && counter[0] != '\0'
+             && magma_timer_set_counter( counter ) != MAGMA_SUCCESS ) {
+            fprintf( stderr, "MAGMA timer: counter '%s' is unknown or cannot be"
+                     " opened; counters are cycles, instructions, task-clock,"
+                     " and flops (with PAPI).\n", counter );
+        }
+    }
+};
+
+timer_environment g_timer_environment;
+
+}  // namespace
+
+
+/******************************************************************************/
+magma_flops_t timer_counter_read()
+{
+    return t_counter.read();
+}
+
+
+/******************************************************************************/
+void timer_record_impl( const char* routine, const char* phase,
+                        magma_timer_t time, magma_flops_t count )
+{
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    auto key = std::make_pair( std::string( routine ), std::string( phase ));
+    auto iter = r.index.find( key );
+    if ( iter == r.index.end() ) {
+        iter = r.index.insert( std::make_pair( key, r.entries.size() )).first;
+        r.entries.push_back( timer_entry{ routine, phase, 0, 0, 0 } );
+    }
+    timer_entry& e = r.entries[ iter->second ];
+    e.seconds += time;
+    e.calls   += 1;
+    e.count   += count;
+}
+
+
+/***************************************************************************//**
+    Turns timers inside routines on or off.
+
+    @param[in]
+    mode    MagmaTimerOff:   timers do nothing.
+            MagmaTimerOn:    phases are recorded, for magma_timer_query().
+            MagmaTimerPrint: also routines' timer_printf output is printed.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" void
+magma_timer_set_mode( magma_timer_mode_t mode )
+{
+    g_magma_timer_mode.store( mode, std::memory_order_relaxed );
+}
+
+
+/***************************************************************************//**
+    @return Current mode; see magma_timer_set_mode().
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" magma_timer_mode_t
+magma_timer_get_mode( void )
+{
+    return magma_timer_mode_t( g_magma_timer_mode.load( std::memory_order_relaxed ));
+}
+
+
+/***************************************************************************//**
+    Selects the hardware counter that phases accumulate, for all threads.
+    The calling thread opens it, to check that it is available.
+
+    @param[in]
+    name    "cycles" or "instructions", Linux perf_event hardware counters;
+            "task-clock", nanoseconds the thread ran, from perf_event;
+            "flops", PAPI_FP_OPS, if MAGMA was built with HAVE_PAPI;
+            or "" or NULL for none.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_NOT_SUPPORTED if the counter is unknown or cannot be
+            opened, e.g., /proc/sys/kernel/perf_event_paranoid forbids it.
+            The counter is then none.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" magma_int_t
+magma_timer_set_counter( const char* name )
+{
+    int kind = -1;
+    if ( name == NULL || name[0] == '\0' ) {
+        kind = counter_none;
+    }
+    for ( int k = counter_cycles; k <= counter_flops && name != NULL; ++k ) {
+        if ( strcmp( name, counter_names[k] ) == 0 ) {
+            kind = k;
+        }
+    }
+
+    magma_int_t info = MAGMA_SUCCESS;
+    if ( kind < 0 || ! timer_thread_counter().open( kind )) {
+        kind = counter_none;
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    g_counter_kind.store( kind, std::memory_order_relaxed );
+    g_counter_generation.fetch_add( 1, std::memory_order_release );
+    return info;
+}
+
+
+/***************************************************************************//**
+    @return Name of the selected hardware counter, or "" for none;
+            see magma_timer_set_counter().
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" const char*
+magma_timer_get_counter( void )
+{
+    return counter_names[ g_counter_kind.load( std::memory_order_relaxed ) ];
+}
+
+
+/***************************************************************************//**
+    Sets the totals of all phases to zero. Phases stay registered,
+    so names returned by magma_timer_get() remain valid.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" void
+magma_timer_reset( void )
+{
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    for ( auto& e : r.entries ) {
+        e.seconds = 0;
+        e.calls   = 0;
+        e.count   = 0;
+    }
+}
+
+
+/***************************************************************************//**
+    @return Number of phases registered, for magma_timer_get().
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" magma_int_t
+magma_timer_count( void )
+{
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    return magma_int_t( r.entries.size() );
+}
+
+
+/***************************************************************************//**
+    Gets the totals of a phase, in the order phases were first recorded.
+    Any output pointer may be NULL.
+
+    @param[in]
+    index   Phase index, 0 <= index < magma_timer_count().
+
+    @param[out]
+    routine Routine name, e.g., "zgetrf_gpu". Valid until the program exits.
+
+    @param[out]
+    phase   Phase name, e.g., "panel". Valid until the program exits.
+
+    @param[out]
+    seconds Total time.
+
+    @param[out]
+    calls   Number of times the phase was recorded.
+
+    @param[out]
+    count   Total of the hardware counter; see magma_timer_set_counter().
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if index is out of range.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" magma_int_t
+magma_timer_get(
+    magma_int_t index, const char** routine, const char** phase,
+    double* seconds, magma_int_t* calls, long long* count )
+{
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    if ( index < 0 || index >= magma_int_t( r.entries.size() )) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    const timer_entry& e = r.entries[ index ];
+    if ( routine ) *routine = e.routine.c_str();
+    if ( phase   ) *phase   = e.phase.c_str();
+    if ( seconds ) *seconds = e.seconds;
+    if ( calls   ) *calls   = e.calls;
+    if ( count   ) *count   = e.count;
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Gets the totals of one phase, e.g.,
+    magma_timer_query( "zgetrf_gpu", "panel", &seconds, NULL, NULL ).
+    Any output pointer may be NULL.
+
+    @param[in]
+    routine Routine name.
+
+    @param[in]
+    phase   Phase name.
+
+    @param[out]
+    seconds Total time.
+
+    @param[out]
+    calls   Number of times the phase was recorded.
+
+    @param[out]
+    count   Total of the hardware counter; see magma_timer_set_counter().
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_NOT_FOUND if the phase was never recorded;
+            outputs are set to zero.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" magma_int_t
+magma_timer_query(
+    const char* routine, const char* phase,
+    double* seconds, magma_int_t* calls, long long* count )
+{
+    if ( seconds ) *seconds = 0;
+    if ( calls   ) *calls   = 0;
+    if ( count   ) *count   = 0;
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    auto iter = r.index.find( std::make_pair( std::string( routine ), std::string( phase )));
+    if ( iter == r.index.end() ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    const timer_entry& e = r.entries[ iter->second ];
+    if ( seconds ) *seconds = e.seconds;
+    if ( calls   ) *calls   = e.calls;
+    if ( count   ) *count   = e.count;
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Prints the totals of all phases with calls, as comment lines.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C" void
+magma_timer_print( void )
+{
+    timer_registry& r = registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+    const char* counter = magma_timer_get_counter();
+    printf( "%% %-20s  %-16s  %12s  %8s  %14s\n",
+            "routine", "phase", "seconds", "calls",
+            (counter[0] != '\0' ? counter : "counter") );
+    for ( auto& e : r.entries ) {
+        if ( e.calls > 0 ) {
+            printf( "%% %-20s  %-16s  %12.6f  %8lld  %14lld\n",
+                    e.routine.c_str(), e.phase.c_str(), e.seconds,
+                    (long long) e.calls, e.count );
+        }
+    }
+}
@@ -6,46 +6,94 @@
        @date
        
        @author Mark Gates
+
+       Timers inside routines. They are off unless enabled at run time by
+       $MAGMA_TIMER or magma_timer_set_mode(); see magma_timer.cpp. While
+       off, each call below is one relaxed load of a flag.
 */
 
 #ifndef MAGMA_TIMER_H
 #define MAGMA_TIMER_H
 
 #include <stdio.h>
+#include <stdarg.h>
+
+#include <atomic>
 
 #include "magma_v2.h"
 
 typedef double    magma_timer_t;
 typedef long long magma_flops_t;
 
-#if defined(ENABLE_TIMER)
-    #include <stdio.h>
-    #include <stdarg.h>
-    
-    #if defined(HAVE_PAPI)
-        #include <papi.h>
-        extern int gPAPI_flops_set;  // defined in testing/magma_util.cpp
-    #endif
-#endif
-
 // If we're not using GNU C, elide __attribute__
 #ifndef __GNUC__
   #define  __attribute__(x)  /*NOTHING*/
 #endif
 
+// implementation, in magma_timer.cpp
+extern std::atomic<int> g_magma_timer_mode;
+
+magma_flops_t timer_counter_read();
+
+
+/***************************************************************************//**
+    @return whether timers are on, i.e., mode is MagmaTimerOn or MagmaTimerPrint.
+    @ingroup magma_timer
+*******************************************************************************/
+static inline bool timer_enabled()
+{
+    return g_magma_timer_mode.load( std::memory_order_relaxed ) != MagmaTimerOff;
+}
+
+
+/***************************************************************************//**
+    @return whether timer_printf and friends print, i.e., mode is MagmaTimerPrint.
+    @ingroup magma_timer
+*******************************************************************************/
+static inline bool timer_printing()
+{
+    return g_magma_timer_mode.load( std::memory_order_relaxed ) == MagmaTimerPrint;
+}
+
+
+/***************************************************************************//**
+    Adds a phase's time and hardware counter to the registry, which
+    magma_timer_query() and magma_timer_get() read.
+    Phases common to routines are "panel", "update", "transfer", and
+    "cpu wait", so services can compare them across routines.
+
+    @param[in] routine  Routine name, e.g., "zgetrf_gpu".
+    @param[in] phase    Phase name, e.g., "panel".
+    @param[in] time     Seconds, from timer_stop().
+    @param[in] count    Hardware counter, from flops_stop().
+
+    If timers are off, does nothing.
+
+    @ingroup magma_timer
+*******************************************************************************/
+void timer_record_impl( const char* routine, const char* phase,
+                        magma_timer_t time, magma_flops_t count );
+
+static inline void timer_record( const char* routine, const char* phase,
+                                 magma_timer_t time, magma_flops_t count=0 )
+{
+    if ( timer_enabled() ) {
+        timer_record_impl( routine, phase, time, count );
+    }
+}
+
+
 /***************************************************************************//**
     @param[out]
     t       On output, set to current time.
     
-    If ENABLE_TIMER is not defined, does nothing.
+    If timers are off, sets t = 0.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline void timer_start( magma_timer_t &t )
 {
-    #if defined(ENABLE_TIMER)
-    t = magma_wtime();
-    #endif
+    t = (timer_enabled() ? magma_wtime() : 0);
 }
 
 
@@ -56,16 +104,17 @@ static inline void timer_start( magma_timer_t &t )
     @param[in]
     queue  Queue to sync with, before getting time.
     
-    If ENABLE_TIMER is not defined, does nothing.
+    If timers are off, sets t = 0, without syncing.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline void timer_sync_start( magma_timer_t &t, magma_queue_t queue )
 {
-    #if defined(ENABLE_TIMER)
-    magma_queue_sync( queue );
-    t = magma_wtime();
-    #endif
+    t = 0;
+    if ( timer_enabled() ) {
+        magma_queue_sync( queue );
+        t = magma_wtime();
+    }
 }
 
 
@@ -85,18 +134,14 @@ static inline void timer_sync_start( magma_timer_t &t, magma_queue_t queue )
             ...do other operations...
         }
     
-    If ENABLE_TIMER is not defined, returns 0.
+    If timers are off, or were off at timer_start(), sets t = 0 and returns 0.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline magma_timer_t timer_stop( magma_timer_t &t )
 {
-    #if defined(ENABLE_TIMER)
-    t = magma_wtime() - t;
+    t = (timer_enabled() && t > 0 ? magma_wtime() - t : 0);
     return t;
-    #else
-    return 0;
-    #endif
 }
 
 
@@ -119,39 +164,39 @@ static inline magma_timer_t timer_stop( magma_timer_t &t )
             ...do other operations...
         }
     
-    If ENABLE_TIMER is not defined, returns 0.
+    If timers are off, or were off at timer_sync_start(), sets t = 0 and
+    returns 0, without syncing.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline magma_timer_t timer_sync_stop( magma_timer_t &t, magma_queue_t queue )
 {
-    #if defined(ENABLE_TIMER)
-    magma_queue_sync( queue );
-    t = magma_wtime() - t;
+    if ( timer_enabled() && t > 0 ) {
+        magma_queue_sync( queue );
+        t = magma_wtime() - t;
+    }
+    else {
+        t = 0;
+    }
     return t;
-    #else
-    return 0;
-    #endif
 }
 
 
 /***************************************************************************//**
     @param[out]
-    flops   On output, set to current flop counter.
-    
-    Requires global gPAPI_flops_set to be setup by testing/magma_util.cpp
-    Note that newer CPUs may not support flop counts; see
-    https://icl.cs.utk.edu/projects/papi/wiki/PAPITopics:SandyFlops
+    flops   On output, set to the calling thread's hardware counter,
+            selected by $MAGMA_TIMER_COUNTER or magma_timer_set_counter(),
+            e.g., PAPI flops or perf_event cycles.
+            Note that newer CPUs may not support flop counts; see
+            https://icl.cs.utk.edu/projects/papi/wiki/PAPITopics:SandyFlops
     
-    If ENABLE_TIMER and HAVE_PAPI are not both defined, does nothing.
+    If timers are off or no counter is selected, sets flops = 0.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline void flops_start( magma_flops_t &flops )
 {
-    #if defined(ENABLE_TIMER) && defined(HAVE_PAPI)
-    PAPI_read( gPAPI_flops_set, &flops );
-    #endif
+    flops = (timer_enabled() ? timer_counter_read() : 0);
 }
 
 
@@ -162,25 +207,19 @@ static inline void flops_start( magma_flops_t &flops )
     
     @return flops, so you can sum up; see timer_stop().
     
-    If ENABLE_TIMER and HAVE_PAPI are not both defined, returns 0.
+    If timers are off or no counter is selected, sets flops = 0 and returns 0.
     
     @ingroup magma_timer
 *******************************************************************************/
 static inline magma_flops_t flops_stop( magma_flops_t &flops )
 {
-    #if defined(ENABLE_TIMER) && defined(HAVE_PAPI)
-    magma_flops_t end;
-    PAPI_read( gPAPI_flops_set, &end );
-    flops = end - flops;
+    flops = (timer_enabled() ? timer_counter_read() - flops : 0);
     return flops;
-    #else
-    return 0;
-    #endif
 }
 
 
 /***************************************************************************//**
-    If ENABLE_TIMER is defined, same as printf;
+    If mode is MagmaTimerPrint, same as printf;
     else does nothing (returns 0).
     
     @ingroup magma_timer
@@ -191,18 +230,18 @@ static inline int timer_printf( const char* format, ... )
 static inline int timer_printf( const char* format, ... )
 {
     int len = 0;
-    #if defined(ENABLE_TIMER)
-    va_list ap;
-    va_start( ap, format );
-    len = vprintf( format, ap );
-    va_end( ap );
-    #endif
+    if ( timer_printing() ) {
+        va_list ap;
+        va_start( ap, format );
+        len = vprintf( format, ap );
+        va_end( ap );
+    }
     return len;
 }
 
 
 /***************************************************************************//**
-    If ENABLE_TIMER is defined, same as fprintf;
+    If mode is MagmaTimerPrint, same as fprintf;
     else does nothing (returns 0).
     
     @ingroup magma_timer
@@ -213,18 +252,18 @@ static inline int timer_fprintf( FILE* stream, const char* format, ... )
 static inline int timer_fprintf( FILE* stream, const char* format, ... )
 {
     int len = 0;
-    #if defined(ENABLE_TIMER)
-    va_list ap;
-    va_start( ap, format );
-    len = vfprintf( stream, format, ap );
-    va_end( ap );
-    #endif
+    if ( timer_printing() ) {
+        va_list ap;
+        va_start( ap, format );
+        len = vfprintf( stream, format, ap );
+        va_end( ap );
+    }
     return len;
 }
 
 
 /***************************************************************************//**
-    If ENABLE_TIMER is defined, same as snprintf;
+    If mode is MagmaTimerPrint, same as snprintf;
     else does nothing (returns 0).
     
     @ingroup magma_timer
@@ -235,12 +274,12 @@ static inline int timer_snprintf( char* str, size_t size, const char* format, ..
 static inline int timer_snprintf( char* str, size_t size, const char* format, ... )
 {
     int len = 0;
-    #if defined(ENABLE_TIMER)
-    va_list ap;
-    va_start( ap, format );
-    len = vsnprintf( str, size, format, ap );
-    va_end( ap );
-    #endif
+    if ( timer_printing() ) {
+        va_list ap;
+        va_start( ap, format );
+        len = vsnprintf( str, size, format, ap );
+        va_end( ap );
+    }
     return len;
 }
 
@@ -8,7 +8,11 @@
        @author Mark Gates
 */
 
+#include <vector>
+
 #include "thread_queue.hpp"
+#include "affinity.h"
+#include "trace.h"
 
 // If err, prints error and throws exception.
 static void check( int err )
@@ -23,21 +27,37 @@ static void check( int err )
 /***************************************************************************//**
     @class magma_thread_queue
     
-    TODO: replace with OpenMP tasks.
-    
     Purpose
     -------
-    Implements a thread pool with a multi-producer, multi-consumer queue.
+    Implements a group of tasks executed by a persistent, work-stealing
+    thread pool (magma_thread_pool) that is shared by all queues in the
+    process.
     
     Typical use:
-    A main thread creates the queue and tells it to launch worker threads. Then
-    the main thread inserts (pushes) tasks into the queue. Threads will execute
-    the tasks. No dependencies are tracked. The main thread can sync the queue,
-    waiting for all current tasks to finish, and then insert more tasks into the
-    queue. When finished, the main thread calls quit or simply destructs the
-    queue, which will exit all worker threads.
+    A main thread creates the queue and tells it how many worker threads to
+    use. The first launch creates the pool's threads; they stay alive until the
+    program exits, so later queues do not pay for thread creation. The pool
+    grows if a later launch asks for more threads, and never shrinks, so each
+    queue limits itself: at most nthread of its tasks are queued in or
+    executing on the pool at once; further ready tasks wait in the queue until
+    one of its tasks finished. Then the main thread inserts
+    (pushes) tasks into the queue. Threads will execute the tasks. The main
+    thread can sync the queue, waiting for all current tasks of this queue to
+    finish, and then insert more tasks into the queue. While waiting in sync,
+    the main thread executes tasks itself. When finished, the main thread calls
+    quit or simply destructs the queue, which waits for its remaining tasks.
     
     Tasks are sub-classes of magma_task. They must implement the run() function.
+    push_task returns a magma_task_handle; a task pushed with handles of
+    earlier tasks as dependencies starts only after all of them finished.
+    
+    Each worker thread owns a deque. Tasks pushed by a worker (from inside
+    a running task), and tasks released when their last dependency finished
+    on a worker, go to that worker's deque; tasks pushed by other threads are
+    distributed round robin. A worker executes its own tasks newest first and
+    otherwise steals the oldest task of another worker, trying workers on
+    its own NUMA node before the others. Idle workers sleep on a condition
+    variable.
     
     Example
     -------
@@ -70,11 +90,13 @@ static void check( int err )
         }
         queue.sync();  // wait for all task1 to finish before doing task2.
         for( int i=0; i < n; ++i ) {
+            // task2( i, j ) starts after task2( i, j-1 ) finished
+            magma_task_handle prev;
             for( int j=0; j < i; ++j ) {
-                queue.push_task( new task2( i, j ));
+                prev = queue.push_task( new task2( i, j ), prev );
             }
         }
-        queue.quit();  // [optional] explicitly exit worker threads
+        queue.quit();  // [optional] explicitly wait for all tasks
     }
     @endcode
     
@@ -86,46 +108,319 @@ static void check( int err )
 *******************************************************************************/
 
 
+
+/******************************************************************************/
+// State of a pushed task, shared by its handles, the deques, and the
+// successor lists of its dependencies.
+struct magma_task_node
+{
+    magma_task*                 task;
+    magma_thread_queue*         queue;
+    std::atomic< magma_int_t >  npending;   ///<  unfinished dependencies, plus 1 while being pushed
+    std::atomic< bool >         done;
+    pthread_mutex_t             mutex;      ///<  mutex lock for done and successors
+    std::vector< std::shared_ptr< magma_task_node > > successors;
+
+    magma_task_node( magma_task* in_task, magma_thread_queue* in_queue ):
+        task( in_task ), queue( in_queue ), npending( 1 ), done( false )
+    {
+        check( pthread_mutex_init( &mutex, NULL ));
+    }
+
+    ~magma_task_node()
+    {
+        pthread_mutex_destroy( &mutex );
+    }
+};
+
+
+// Worker of the calling thread, NULL if it is not a pool thread.
+static thread_local magma_thread_pool::worker* tls_worker = NULL;
+
+
+/***************************************************************************//**
+    Returns true if the task has finished, or if the handle refers to no task.
+*******************************************************************************/
+bool magma_task_handle::done() const
+{
+    return node == NULL || node->done;
+}
+
+
 /***************************************************************************//**
     Thread's main routine, executed by pthread_create.
-    Executes tasks from queue (given as arg), until a NULL task is returned.
-    Deletes each task when it is done.
-    @param[in,out] arg    magma_thread_queue to get tasks from.
+    Executes tasks of the pool until the pool is destroyed.
+    If $MAGMA_AFFINITY is set, worker i is bound as thread i+1 of the
+    placement policy, leaving the first CPU to the thread creating the pool.
+    @param[in,out] arg    magma_thread_pool::worker of this thread.
 *******************************************************************************/
 extern "C"
 void* magma_thread_main( void* arg )
 {
-    magma_thread_queue* queue = (magma_thread_queue*) arg;
-    magma_task* task;
-    
+    magma_thread_pool::worker* self = (magma_thread_pool::worker*) arg;
+    tls_worker = self;
+    trace_thread_index( "magma_thread_queue worker", self->index + 1 );
+    affinity_bind binding( self->index + 1, self->index + 2, false );
+    self->node = (binding.cpu() >= 0 ? binding.node() : magma_affinity_current_node());
+    self->pool->main_loop( self );
+    return NULL;  // implicitly does pthread_exit
+}
+
+
+/***************************************************************************//**
+    Returns the pool shared by all queues. Its threads are created by
+    grow() and joined when the program exits.
+*******************************************************************************/
+magma_thread_pool& magma_thread_pool::instance()
+{
+    static magma_thread_pool pool;
+    return pool;
+}
+
+
+/***************************************************************************//**
+    Creates pool with NO threads. Use grow() to create threads.
+*******************************************************************************/
+magma_thread_pool::magma_thread_pool():
+    nworker    ( 0     ),
+    nqueued    ( 0     ),
+    nsleep     ( 0     ),
+    next_victim( 0     ),
+    quit_flag  ( false )
+{
+    check( pthread_mutex_init( &mutex, NULL ));
+    check( pthread_cond_init(  &cond,  NULL ));
+}
+
+
+/***************************************************************************//**
+    Waits until all queued tasks are done and all threads exited,
+    then deallocates data.
+*******************************************************************************/
+magma_thread_pool::~magma_thread_pool()
+{
+    check( pthread_mutex_lock( &mutex ));
+    quit_flag = true;
+    check( pthread_cond_broadcast( &cond ));
+    check( pthread_mutex_unlock( &mutex ));
+
+    magma_int_t n = nworker;
+    for( magma_int_t i=0; i < n; ++i ) {
+        check( pthread_join( workers[i]->thread, NULL ));
+    }
+    for( magma_int_t i=0; i < n; ++i ) {
+        pthread_mutex_destroy( &workers[i]->mutex );
+        delete workers[i];
+    }
+    pthread_mutex_destroy( &mutex );
+    pthread_cond_destroy( &cond );
+}
+
+
+/***************************************************************************//**
+    Creates threads until the pool has at least in_nthread threads.
+    @param[in] in_nthread    Number of threads needed.
+*******************************************************************************/
+void magma_thread_pool::grow( magma_int_t in_nthread )
+{
+    in_nthread = min( max( in_nthread, 1 ), max_threads );
+    if ( nworker >= in_nthread ) {
+        return;
+    }
+    check( pthread_mutex_lock( &mutex ));
+    for( magma_int_t i = nworker; i < in_nthread; ++i ) {
+        worker* w = new worker;
+        check( pthread_mutex_init( &w->mutex, NULL ));
+        w->index = i;
+        w->node  = -1;
+        w->pool  = this;
+        // publish the worker before its thread runs, so it can be stolen from
+        workers[i] = w;
+        nworker = i + 1;
+        check( pthread_create( &w->thread, NULL, magma_thread_main, w ));
+    }
+    check( pthread_mutex_unlock( &mutex ));
+}
+
+
+/***************************************************************************//**
+    Inserts a task whose dependencies are all done into a deque: the deque
+    of the calling thread if it is a worker, otherwise the next deque in
+    round robin order. Wakes a sleeping worker.
+    @param[in] node    Task to queue.
+*******************************************************************************/
+void magma_thread_pool::submit( const std::shared_ptr< magma_task_node >& node )
+{
+    worker* w = tls_worker;
+    if ( w == NULL || w->pool != this ) {
+        w = workers[ magma_int_t( next_victim++ % nworker ) ];
+    }
+    check( pthread_mutex_lock( &w->mutex ));
+    w->tasks.push_back( node );
+    check( pthread_mutex_unlock( &w->mutex ));
+
+    // a worker increments nsleep before it tests nqueued, so it either sees
+    // this task or is woken here
+    nqueued++;
+    if ( nsleep > 0 ) {
+        check( pthread_mutex_lock( &mutex ));
+        check( pthread_cond_broadcast( &cond ));
+        check( pthread_mutex_unlock( &mutex ));
+    }
+}
+
+
+/***************************************************************************//**
+    Removes a task from the deque of w: the newest if the owner pops,
+    the oldest if another thread steals.
+    @return task, or NULL if the deque is empty.
+*******************************************************************************/
+std::shared_ptr< magma_task_node >
+magma_thread_pool::pop( worker* w, bool steal )
+{
+    std::shared_ptr< magma_task_node > node;
+    check( pthread_mutex_lock( &w->mutex ));
+    if ( ! w->tasks.empty() ) {
+        if ( steal ) {
+            node = w->tasks.front();
+            w->tasks.pop_front();
+        }
+        else {
+            node = w->tasks.back();
+            w->tasks.pop_back();
+        }
+        nqueued--;
+    }
+    check( pthread_mutex_unlock( &w->mutex ));
+    return node;
+}
+
+
+/***************************************************************************//**
+    Gets next task: from the own deque if self is a worker, otherwise stolen
+    from the other workers, those on the same NUMA node first.
+    @param[in] self    Worker of the calling thread, or NULL.
+    @return task, or NULL if no task is queued.
+*******************************************************************************/
+std::shared_ptr< magma_task_node >
+magma_thread_pool::find_task( worker* self )
+{
+    std::shared_ptr< magma_task_node > node;
+    if ( self != NULL ) {
+        node = pop( self, false );
+        if ( node ) {
+            return node;
+        }
+    }
+    magma_int_t n = nworker;
+    magma_int_t start = ( self != NULL ? self->index + 1 : next_victim.load() );
+    bool local = ( self != NULL && self->node >= 0 );
+    for( int pass = (local ? 0 : 1); pass < 2 && nqueued > 0; ++pass ) {
+        for( magma_int_t k=0; k < n; ++k ) {
+            worker* w = workers[ (start + k) % n ];
+            if ( w == self ) {
+                continue;
+            }
+            bool same_node = local && w->node == self->node;
+            if ( (pass == 0 && ! same_node) || (pass == 1 && same_node) ) {
+                continue;
+            }
+            node = pop( w, true );
+            if ( node ) {
+                return node;
+            }
+        }
+    }
+    return node;
+}
+
+
+/***************************************************************************//**
+    Runs and deletes the task, releases its successors, and marks it done
+    in its queue.
+*******************************************************************************/
+void magma_thread_pool::execute( const std::shared_ptr< magma_task_node >& node )
+{
+    trace_cpu_start( "task", "magma_thread_queue task" );
+    node->task->run();
+    trace_cpu_end();
+    delete node->task;
+    node->task = NULL;
+
+    std::vector< std::shared_ptr< magma_task_node > > successors;
+    check( pthread_mutex_lock( &node->mutex ));
+    node->done = true;
+    successors.swap( node->successors );
+    check( pthread_mutex_unlock( &node->mutex ));
+    for( size_t i=0; i < successors.size(); ++i ) {
+        if ( --successors[i]->npending == 0 ) {
+            successors[i]->queue->release( successors[i] );
+        }
+    }
+
+    // last, as the queue may be destroyed as soon as its tasks are done
+    node->queue->task_done();
+}
+
+
+/***************************************************************************//**
+    Worker loop: executes tasks, sleeps while no task is queued,
+    and returns once the pool quits and all deques are empty.
+*******************************************************************************/
+void magma_thread_pool::main_loop( worker* self )
+{
     while( true ) {
-        task = queue->pop_task();
-        if ( task == NULL ) {
+        std::shared_ptr< magma_task_node > node = find_task( self );
+        if ( node ) {
+            execute( node );
+            continue;
+        }
+        check( pthread_mutex_lock( &mutex ));
+        nsleep++;
+        while( nqueued <= 0 && ! quit_flag ) {
+            check( pthread_cond_wait( &cond, &mutex ));
+        }
+        nsleep--;
+        bool exit = quit_flag && nqueued <= 0;
+        check( pthread_mutex_unlock( &mutex ));
+        if ( exit ) {
             break;
         }
-        
-        task->run();
-        queue->task_done();
-        delete task;
-        task = NULL;
     }
-    
-    return NULL;  // implicitly does pthread_exit
 }
 
 
 /***************************************************************************//**
-    Creates queue with NO threads. Use launch() to create threads.
+    Executes one queued task in the calling thread, if there is one.
+    @return true if a task was executed.
+*******************************************************************************/
+bool magma_thread_pool::run_one()
+{
+    worker* self = tls_worker;
+    if ( self != NULL && self->pool != this ) {
+        self = NULL;
+    }
+    std::shared_ptr< magma_task_node > node = find_task( self );
+    if ( node ) {
+        execute( node );
+        return true;
+    }
+    return false;
+}
+
+
+/***************************************************************************//**
+    Creates queue using the shared pool. Use launch() to set the number
+    of threads.
 *******************************************************************************/
 magma_thread_queue::magma_thread_queue():
-    q        (),
-    quit_flag( false ),
     ntask    ( 0     ),
-    threads  ( NULL  ),
-    nthread  ( 0     )
+    quit_flag( false ),
+    nthread  ( 1     ),
+    nactive  ( 0     ),
+    pool     ( &magma_thread_pool::instance() )
 {
     check( pthread_mutex_init( &mutex,      NULL ));
-    check( pthread_cond_init(  &cond,       NULL ));
     check( pthread_cond_init(  &cond_ntask, NULL ));
 }
 
@@ -137,154 +432,191 @@ magma_thread_queue::~magma_thread_queue()
 {
     quit();
     check( pthread_mutex_destroy( &mutex ));
-    check( pthread_cond_destroy( &cond ));
     check( pthread_cond_destroy( &cond_ntask ));
 }
 
 
 /***************************************************************************//**
-    Creates threads.
-    @param[in] in_nthread    Number of threads to launch.
+    Makes sure the shared pool has at least in_nthread threads, and limits
+    this queue to in_nthread tasks executing at once, even if another queue
+    grew the pool beyond that. Without launch, the limit is one task.
+    Threads are only created the first time a given number is requested.
+    @param[in] in_nthread    Number of threads to use.
 *******************************************************************************/
 void magma_thread_queue::launch( magma_int_t in_nthread )
 {
-    assert( threads == NULL );  // else launch was called previously
+    in_nthread = max( in_nthread, 1 );
+    pool->grow( in_nthread );
+
+    std::vector< std::shared_ptr< magma_task_node > > start;
+    check( pthread_mutex_lock( &mutex ));
     nthread = in_nthread;
-    if ( nthread < 1 ) {
-        nthread = 1;
+    while( nactive < nthread && ! ready.empty() ) {
+        start.push_back( ready.front() );
+        ready.pop_front();
+        nactive += 1;
     }
-    threads = new pthread_t[ nthread ];
-    for( magma_int_t i=0; i < nthread; ++i ) {
-        check( pthread_create( &threads[i], NULL, magma_thread_main, this ));
-        //printf( "launch %d (%lx)\n", i, (long) threads[i] );
+    check( pthread_mutex_unlock( &mutex ));
+    for( size_t i=0; i < start.size(); ++i ) {
+        pool->submit( start[i] );
     }
 }
 
 
 /***************************************************************************//**
-    Add task to queue. Task must be allocated with C++ new.
+    Add task to queue. Task must be allocated with C++ new; it is deleted
+    after it ran.
     Increments number of outstanding tasks.
-    Signals threads that are waiting in pop_task().
     @param[in] task    Task to queue.
+    @return handle of the task, for use as dependency of later tasks.
+*******************************************************************************/
+magma_task_handle magma_thread_queue::push_task( magma_task* task )
+{
+    return push_task( task, NULL, 0 );
+}
+
+
+/***************************************************************************//**
+    Add task to queue that starts after task dep finished.
+    @param[in] task    Task to queue.
+    @param[in] dep     Handle of a task pushed earlier, possibly to another queue.
+    @return handle of the task, for use as dependency of later tasks.
 *******************************************************************************/
-void magma_thread_queue::push_task( magma_task* task )
+magma_task_handle magma_thread_queue::push_task(
+    magma_task* task, const magma_task_handle& dep )
+{
+    return push_task( task, &dep, 1 );
+}
+
+
+/***************************************************************************//**
+    Add task to queue that starts after all tasks deps[0:ndeps-1] finished.
+    The task becomes ready when its last dependency finishes; until then it
+    occupies no thread.
+    @param[in] task    Task to queue.
+    @param[in] deps    Array of ndeps handles of tasks pushed earlier,
+                       possibly to other queues.
+    @param[in] ndeps   Number of dependencies.
+    @return handle of the task, for use as dependency of later tasks.
+*******************************************************************************/
+magma_task_handle magma_thread_queue::push_task(
+    magma_task* task, const magma_task_handle* deps, magma_int_t ndeps )
 {
     check( pthread_mutex_lock( &mutex ));
     if ( quit_flag ) {
         fprintf( stderr, "Error: push_task() called after quit()\n" );
         throw std::exception();
     }
-    q.push( task );
-    ntask += 1;
-    //printf( "push; ntask %d\n", ntask );
-    check( pthread_cond_broadcast( &cond ));
     check( pthread_mutex_unlock( &mutex ));
+    if ( pool->size() == 0 ) {
+        pool->grow( 1 );  // launch() was not called
+    }
+    ntask += 1;
+
+    std::shared_ptr< magma_task_node > node =
+        std::make_shared< magma_task_node >( task, this );
+    for( magma_int_t i=0; i < ndeps; ++i ) {
+        magma_task_node* dep = deps[i].node.get();
+        if ( dep == NULL ) {
+            continue;
+        }
+        check( pthread_mutex_lock( &dep->mutex ));
+        if ( ! dep->done ) {
+            node->npending++;
+            dep->successors.push_back( node );
+        }
+        check( pthread_mutex_unlock( &dep->mutex ));
+    }
+    if ( --node->npending == 0 ) {
+        release( node );
+    }
+    return magma_task_handle( node );
 }
 
 
 /***************************************************************************//**
-    Get next task from queue.
-    @return next task, blocking until a task is inserted if necesary.
-    @return NULL if queue is empty *and* quit() has been called.
-    
-    This does *not* decrement number of outstanding tasks;
-    thread should call task_done() when task is completed.
+    Task whose dependencies are all done: submits it to the pool if fewer
+    than nthread tasks of this queue are there, otherwise keeps it until
+    task_done frees a slot.
+    @param[in] node    Task to release.
 *******************************************************************************/
-magma_task* magma_thread_queue::pop_task()
+void magma_thread_queue::release( const std::shared_ptr< magma_task_node >& node )
 {
-    magma_task* task = NULL;
     check( pthread_mutex_lock( &mutex ));
-    while( q.empty() && ! quit_flag ) {
-        check( pthread_cond_wait( &cond, &mutex ));
+    bool submit = (nactive < nthread);
+    if ( submit ) {
+        nactive += 1;
     }
-    // q has item or quit is set (or both)
-    if ( ! q.empty()) {
-        task = q.front();
-        q.pop();
+    else {
+        ready.push_back( node );
     }
-    //printf( "pop;  ntask %d\n", ntask );
     check( pthread_mutex_unlock( &mutex ));
-    return task;
+    if ( submit ) {
+        pool->submit( node );
+    }
 }
 
 
 /***************************************************************************//**
     Marks task as finished, decrementing number of outstanding tasks.
+    Its slot goes to the oldest task waiting in ready, if any.
     Signals threads that are waiting in sync().
 *******************************************************************************/
 void magma_thread_queue::task_done()
 {
+    // the queue may be destroyed once ntask is 0, so use only locals after
+    // unlocking; a task taken from ready keeps ntask > 0 until it finished
+    std::shared_ptr< magma_task_node > next;
+    magma_thread_pool* p = pool;
     check( pthread_mutex_lock( &mutex ));
-    ntask -= 1;
-    //printf( "fini; ntask %d\n", ntask );
-    check( pthread_cond_broadcast( &cond_ntask ));
+    if ( ! ready.empty() ) {
+        next = ready.front();
+        ready.pop_front();
+    }
+    else {
+        nactive -= 1;
+    }
+    if ( --ntask == 0 ) {
+        check( pthread_cond_broadcast( &cond_ntask ));
+    }
     check( pthread_mutex_unlock( &mutex ));
+    if ( next ) {
+        p->submit( next );
+    }
 }
 
 
 /***************************************************************************//**
-    Block until all outstanding tasks have been finished.
+    Block until all outstanding tasks of this queue have been finished.
+    The calling thread executes queued tasks while there are any.
     Threads continue to be alive; more tasks can be pushed after sync.
 *******************************************************************************/
 void magma_thread_queue::sync()
 {
+    while( ntask > 0 && pool->run_one() ) {
+    }
+    double start = (ntask > 0 && trace_enabled() ? magma_wtime() : 0);
     check( pthread_mutex_lock( &mutex ));
-    //printf( "sync; ntask %d [start]\n", ntask );
     while( ntask > 0 ) {
         check( pthread_cond_wait( &cond_ntask, &mutex ));
-        //printf( "sync; ntask %d\n", ntask );
     }
-    //printf( "sync; ntask %d [done]\n", ntask );
     check( pthread_mutex_unlock( &mutex ));
+    if ( start > 0 ) {
+        trace_counter( "queue wait (s)", magma_wtime() - start );
+    }
 }
 
 
 /***************************************************************************//**
-    Sets quit_flag, so pop_task() will return NULL once queue is empty,
-    telling threads to exit.
-    Signals all threads that are waiting in pop_task().
-    Waits for all threads to exit (i.e., joins them).
-    It is safe to call quit multiple times -- the first time all the threads are
-    joined; subsequent times it does nothing.
+    Waits for all outstanding tasks, then sets quit_flag, so later
+    push_task() calls fail. The pool's threads keep running for other queues.
+    It is safe to call quit multiple times.
     (Destructor also calls quit, but you may prefer to call it explicitly.)
 *******************************************************************************/
 void magma_thread_queue::quit()
 {
-    // first, set quit_flag and signal waiting threads
-    bool join = true;
+    sync();
     check( pthread_mutex_lock( &mutex ));
-    //printf( "quit %d\n", quit_flag );
-    if ( quit_flag ) {
-        join = false;  // quit previously called; don't join again.
-    }
-    else {
-        quit_flag = true;
-        check( pthread_cond_broadcast( &cond ));
-    }
+    quit_flag = true;
     check( pthread_mutex_unlock( &mutex ));
-    
-    // next, join all threads
-    if ( join ) {
-        assert( threads != NULL );
-        for( magma_int_t i=0; i < nthread; ++i ) {
-            check( pthread_join( threads[i], NULL ));
-            //printf( "joined %d (%lx)\n", i, (long) threads[i] );
-        }
-        delete[] threads;
-        threads = NULL;
-    }
-}
-
-
-/***************************************************************************//**
-    Mostly for debugging, returns thread index in range 0, ..., nthread-1.
-*******************************************************************************/
-magma_int_t magma_thread_queue::get_thread_index( pthread_t thread ) const
-{
-    for( magma_int_t i=0; i < nthread; ++i ) {
-        if ( pthread_equal( thread, threads[i] )) {
-            return i;
-        }
-    }
-    return -1;
 }
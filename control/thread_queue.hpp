@@ -11,7 +11,9 @@
 #ifndef MAGMA_THREAD_HPP
 #define MAGMA_THREAD_HPP
 
-#include <queue>
+#include <atomic>
+#include <deque>
+#include <memory>
 
 #include "magma_internal.h"
 
@@ -20,6 +22,10 @@
 extern "C"
 void* magma_thread_main( void* arg );
 
+class magma_thread_queue;
+class magma_thread_pool;
+struct magma_task_node;
+
 
 /***************************************************************************//**
     Super class for tasks used with \ref magma_thread_queue.
@@ -31,39 +37,109 @@ class magma_task
 public:
     magma_task() {}
     virtual ~magma_task() {}
-    
+
     virtual void run() = 0;  // pure virtual function to execute task
 };
 
 
+/***************************************************************************//**
+    Handle to a task pushed into a \ref magma_thread_queue, used to declare
+    dependencies of later tasks. Handles stay valid after the task finished
+    and was deleted. A default constructed handle refers to no task.
+    @ingroup magma_thread
+*******************************************************************************/
+class magma_task_handle
+{
+public:
+    magma_task_handle() {}
+
+    bool done() const;
+
+private:
+    friend class magma_thread_queue;
+    friend class magma_thread_pool;
+    explicit magma_task_handle( const std::shared_ptr< magma_task_node >& in_node ):
+        node( in_node ) {}
+
+    std::shared_ptr< magma_task_node > node;
+};
+
+
 /******************************************************************************/
 class magma_thread_queue
 {
 public:
     magma_thread_queue();
     ~magma_thread_queue();
-    
+
     void launch( magma_int_t in_nthread );
-    void push_task( magma_task* task );
+    magma_task_handle push_task( magma_task* task );
+    magma_task_handle push_task( magma_task* task, const magma_task_handle& dep );
+    magma_task_handle push_task( magma_task* task,
+                                 const magma_task_handle* deps, magma_int_t ndeps );
     void sync();
     void quit();
-    
+
 protected:
-    friend void* magma_thread_main( void* arg );
-    magma_task* pop_task();
+    friend class magma_thread_pool;
+    void release( const std::shared_ptr< magma_task_node >& node );
     void task_done();
-    
-    magma_int_t get_thread_index( pthread_t thread ) const;
-    
+
+private:
+    std::atomic< magma_int_t > ntask;  ///<  number of unfinished tasks (waiting, queued, or executing)
+    bool            quit_flag;    ///<  quit() sets this to true; after this, push_task throws
+    magma_int_t     nthread;      ///<  at most this many tasks of this queue are in the pool at once (see launch)
+    magma_int_t     nactive;      ///<  number of tasks of this queue queued in or executing on the pool
+    std::deque< std::shared_ptr< magma_task_node > > ready;  ///<  ready tasks waiting for nactive < nthread
+    pthread_mutex_t mutex;        ///<  mutex lock for quit_flag, nactive, ready, and cond_ntask
+    pthread_cond_t  cond_ntask;   ///<  condition variable for ntask reaching 0 (see sync, task_done)
+    magma_thread_pool* pool;      ///<  shared pool executing the tasks
+};
+
+
+/******************************************************************************/
+// Persistent work-stealing pool shared by all magma_thread_queues.
+// Internal; use magma_thread_queue.
+class magma_thread_pool
+{
+public:
+    struct worker {
+        pthread_t       thread;
+        pthread_mutex_t mutex;    ///<  mutex lock for tasks
+        std::deque< std::shared_ptr< magma_task_node > > tasks;  ///<  owner pops at back, thieves steal at front
+        magma_int_t     index;
+        int             node;     ///<  NUMA node, -1 if unknown
+        magma_thread_pool* pool;
+    };
+
+    static magma_thread_pool& instance();
+    ~magma_thread_pool();
+
+    void grow( magma_int_t in_nthread );
+    void submit( const std::shared_ptr< magma_task_node >& node );
+    bool run_one();
+    magma_int_t size() const { return nworker; }
+
+protected:
+    friend void* magma_thread_main( void* arg );
+
+    magma_thread_pool();
+    void main_loop( worker* self );
+    std::shared_ptr< magma_task_node > pop( worker* w, bool steal );
+    std::shared_ptr< magma_task_node > find_task( worker* self );
+    void execute( const std::shared_ptr< magma_task_node >& node );
+
 private:
-    std::queue< magma_task* > q;  ///<  queue of tasks
-    bool            quit_flag;    ///<  quit() sets this to true; after this, pop returns NULL
-    magma_int_t     ntask;        ///<  number of unfinished tasks (in queue or currently executing)
-    pthread_mutex_t mutex;        ///<  mutex lock for queue, quit, ntask
-    pthread_cond_t  cond;         ///<  condition variable for changes to queue and quit (see push, pop, quit)
-    pthread_cond_t  cond_ntask;   ///<  condition variable for changes to ntask (see sync, task_done)
-    pthread_t*      threads;      ///<  array of threads
-    magma_int_t     nthread;      ///<  number of threads
+    static const magma_int_t max_threads = 1024;
+
+    worker*                    workers[ max_threads ];
+    std::atomic< magma_int_t > nworker;   ///<  number of started workers
+    std::atomic< magma_int_t > nqueued;   ///<  number of tasks in all deques
+    std::atomic< magma_int_t > nsleep;    ///<  number of workers waiting in cond
+    std::atomic< magma_int_t > next_victim;  ///<  round robin for tasks submitted by other threads
+    bool            quit_flag;    ///<  destructor sets this to true; workers exit once no tasks are left
+    pthread_mutex_t mutex;        ///<  mutex lock for growing, quit_flag, and sleeping
+    pthread_cond_t  cond;         ///<  condition variable for new tasks and quit
 };
 
 #endif        //  #ifndef MAGMA_THREAD_HPP
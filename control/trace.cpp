@@ -1,342 +1,641 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Mark Gates
+*/
 #include <stdio.h>
-#include <assert.h>
 #include <errno.h>
-#include <string.h>      // strerror_r
+#include <string.h>
 
-#include <set>
+// STL headers before magma_internal.h, which defines min and max
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "trace.h"
+#include "magma_internal.h"
 
-// define TRACING to compile these functions, e.g.,
-// gcc -DTRACING -c trace.cpp
-#ifdef TRACING
 
-#include <cuda_runtime.h>
-#include "magma_internal.h"
-#include "magmablas_v1.h"
+/***************************************************************************//**
+    @page tracing Tracing
+
+    MAGMA can record a timeline of CPU tasks, GPU queue operations, and
+    counters while it runs, and write it as a Chrome trace-event JSON file,
+    which chrome://tracing and https://ui.perfetto.dev display.
+
+    Tracing is off by default. It is started by setting $MAGMA_TRACE to the
+    output file name, in which case the file is written when the program
+    exits, or by calling magma_trace_start() and magma_trace_stop().
+    While off, instrumentation costs one relaxed load of a flag.
+
+    Each thread records into its own ring buffer, without locks; the
+    buffer is registered once, on the thread's first event. Each thread is
+    a CPU lane, named by trace_thread_name(), e.g., for workers of the
+    magma_thread_queue pool, bulge chasing threads, or OpenMP threads.
+    When a thread exits, a later thread of the same name takes over its
+    lane, so threads created per call don't add a lane each call.
+    A buffer holds the last $MAGMA_TRACE_EVENTS events (default 65536);
+    older events are overwritten, and the number dropped is reported.
+
+    Each GPU queue registered by a traced routine (trace_init) is a GPU
+    lane. GPU operations are timed with events, converted to host time
+    when the routine ends (trace_finalize).
+
+    Counters, such as "flops", "bytes moved", and "queue wait (s)", are
+    accumulated over all threads and shown as running totals.
+*******************************************************************************/
+
+std::atomic<bool> g_trace_enabled( false );
+
+namespace {
+
+const char trace_kind_cpu     = 'c';
+const char trace_kind_gpu     = 'g';
+const char trace_kind_counter = 'n';
 
-// set TRACE_METHOD = 2 to record start time as
-// later of CPU time and previous event's end time.
-// set TRACE_METHOD = 1 to record start time using CUDA event.
-#define TRACE_METHOD 2
+const size_t default_capacity = 65536;
 
 
 /******************************************************************************/
-struct event_log
+// One event. For a counter, start is the time and value the amount added.
+struct trace_event
 {
-    int    ncore;
-    int    cpu_id   [ MAX_CORES ];
-    double cpu_first;
-    double cpu_start[ MAX_CORES ][ MAX_EVENTS ];
-    double cpu_end  [ MAX_CORES ][ MAX_EVENTS ];
-    char   cpu_tag  [ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    char   cpu_label[ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    
-    int           ngpu;
-    int           nqueue;
-    magma_queue_t queues   [ MAX_GPU_QUEUES ];
-    int           gpu_id   [ MAX_GPU_QUEUES ];
-    magma_event_t gpu_first[ MAX_GPU_QUEUES ];
-#if TRACE_METHOD == 2
-    double        gpu_start[ MAX_GPU_QUEUES ][ MAX_EVENTS ];
-#else
-    magma_event_t gpu_start[ MAX_GPU_QUEUES ][ MAX_EVENTS ];
-#endif
-    magma_event_t gpu_end  [ MAX_GPU_QUEUES ][ MAX_EVENTS ];
-    char          gpu_tag  [ MAX_GPU_QUEUES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    char          gpu_label[ MAX_GPU_QUEUES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
+    double      start;
+    double      end;       // < 0 while a CPU task is open
+    double      value;
+    const char* name;      // counter name
+    int         lane;      // GPU lane
+    char        kind;
+    char        tag  [ MAX_LABEL_LEN ];
+    char        label[ MAX_LABEL_LEN ];
 };
 
-// global log object
-struct event_log glog;
+
+/******************************************************************************/
+// Ring buffer of one thread. Only the owning thread writes it; head is
+// published with release order, so the writer never takes a lock.
+struct trace_buffer
+{
+    std::vector< trace_event > events;
+    std::atomic< uint64_t >    head;   // number of events written
+    std::vector< uint64_t >    open;   // indices of open CPU tasks, innermost last
+    int                        lane;
+    std::string                name;
+    bool                       retired;  // its thread exited
+
+    trace_buffer(): head( 0 ), lane( 0 ), retired( false ) {}
+};
 
 
 /******************************************************************************/
-void trace_init( int ncore, int ngpu, int nqueue, magma_queue_t* queues )
+// A GPU operation, timed with events until the routine ends.
+struct trace_gpu_op
 {
-    if ( ncore > MAX_CORES ) {
-        fprintf( stderr, "Error in trace_init: ncore %d > MAX_CORES %d\n",
-                 ncore, MAX_CORES );
-        exit(1);
-    }
-    if ( ngpu*nqueue > MAX_GPU_QUEUES ) {
-        fprintf( stderr, "Error in trace_init: (ngpu=%d)*(nqueue=%d) > MAX_GPU_QUEUES=%d\n",
-                 ngpu, nqueue, MAX_GPU_QUEUES );
-        exit(1);
-    }
-    
-    glog.ncore  = ncore;
-    glog.ngpu   = ngpu;
-    glog.nqueue = nqueue;
-    
-    // initialize ID = 0
-    for( int core = 0; core < ncore; ++core ) {
-        glog.cpu_id[core] = 0;
-    }
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        for( int s = 0; s < nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            glog.gpu_id[t] = 0;
-            glog.queues[t] = queues[t];
-        }
-        magma_setdevice( dev );
-        magma_device_sync();
-    }
-    // now that all GPUs are sync'd, record start time
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        magma_setdevice( dev );
-        for( int s = 0; s < nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            magma_event_create( &glog.gpu_first[t] );
-            magma_event_record(  glog.gpu_first[t], glog.queues[t] );
+    magma_event_t start;
+    magma_event_t end;
+    size_t        queue;
+    char          tag  [ MAX_LABEL_LEN ];
+    char          label[ MAX_LABEL_LEN ];
+};
+
+
+/******************************************************************************/
+// Queues of a traced routine, between trace_init and trace_finalize.
+struct trace_routine
+{
+    magma_int_t                  nqueue;
+    std::vector< magma_queue_t > queues;
+    std::vector< magma_device_t> devices;
+    std::vector< int >           lanes;
+    std::vector< magma_event_t > anchors;     // recorded on idle queues at anchor_time
+    double                       anchor_time;
+    std::vector< trace_gpu_op >  ops;
+    std::vector< std::vector< size_t > > open;  // per queue, indices of open ops
+};
+
+
+/******************************************************************************/
+// Global state; buffers live until the program exits, since threads keep
+// pointers to them.
+struct trace_state
+{
+    std::mutex                                    mutex;
+    std::vector< std::unique_ptr< trace_buffer >> buffers;
+    std::map< magma_queue_t, int >                gpu_lanes;
+    std::vector< std::string >                    gpu_names;
+    std::string                                   filename;
+    size_t                                        capacity = default_capacity;
+    double                                        start_time = 0;
+};
+
+trace_state& state()
+{
+    static trace_state s;
+    return s;
+}
+
+thread_local trace_buffer* t_buffer = NULL;
+thread_local std::string   t_name;
+thread_local std::vector< trace_routine > t_routines;
+
+
+/******************************************************************************/
+// Retires the thread's buffer when the thread exits, so a later thread with
+// the same name, e.g., bulge chasing thread 3 of the next call, reuses it.
+struct trace_thread_exit
+{
+    ~trace_thread_exit()
+    {
+        if ( t_buffer != NULL ) {
+            std::lock_guard< std::mutex > lock( state().mutex );
+            t_buffer->open.clear();
+            t_buffer->retired = true;
+            t_buffer = NULL;
         }
     }
-    // sync again
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        magma_setdevice( dev );
-        magma_device_sync();
+};
+
+thread_local trace_thread_exit t_exit;
+
+
+/******************************************************************************/
+// Returns the calling thread's buffer, registering it on first use.
+trace_buffer* thread_buffer()
+{
+    if ( t_buffer == NULL ) {
+        (void) &t_exit;  // constructs it, so its destructor runs at thread exit
+        trace_state& s = state();
+        std::lock_guard< std::mutex > lock( s.mutex );
+        if ( ! t_name.empty() ) {
+            for ( auto& buf : s.buffers ) {
+                if ( buf->retired && buf->name == t_name ) {
+                    buf->retired = false;
+                    t_buffer = buf.get();
+                    return t_buffer;
+                }
+            }
+        }
+        std::unique_ptr< trace_buffer > buf( new trace_buffer );
+        buf->events.resize( s.capacity );
+        buf->lane = int( s.buffers.size() );
+        buf->name = t_name;
+        t_buffer = buf.get();
+        s.buffers.push_back( std::move( buf ));
     }
-    glog.cpu_first = magma_wtime();
+    return t_buffer;
 }
 
 
 /******************************************************************************/
-void trace_cpu_start( int core, const char* tag, const char* lbl )
+// Appends an event to the calling thread's buffer; returns its index.
+uint64_t push_event(
+    char kind, double start, double end, const char* tag, const char* label,
+    int lane=0, const char* name=NULL, double value=0 )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_start[core][id] = magma_wtime();
-    magma_strlcpy( glog.cpu_tag  [core][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.cpu_label[core][id], lbl, MAX_LABEL_LEN );
+    trace_buffer* buf = thread_buffer();
+    uint64_t id = buf->head.load( std::memory_order_relaxed );
+    trace_event& e = buf->events[ id % buf->events.size() ];
+    e.start = start;
+    e.end   = end;
+    e.value = value;
+    e.name  = name;
+    e.lane  = lane;
+    e.kind  = kind;
+    magma_strlcpy( e.tag,   (tag   ? tag   : ""), MAX_LABEL_LEN );
+    magma_strlcpy( e.label, (label ? label : ""), MAX_LABEL_LEN );
+    buf->head.store( id + 1, std::memory_order_release );
+    return id;
 }
 
 
 /******************************************************************************/
-void trace_cpu_end( int core )
+// Returns event with index id, or NULL if it was overwritten.
+trace_event* find_event( trace_buffer* buf, uint64_t id )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_end[core][id] = magma_wtime();
-    if ( id+1 < MAX_EVENTS ) {
-        glog.cpu_id[core] = id+1;
+    uint64_t head = buf->head.load( std::memory_order_relaxed );
+    if ( id >= head || head - id > buf->events.size() ) {
+        return NULL;
     }
-    else {
-        fprintf( stderr, "Error in %s: not enough CPU events.\n", __func__ );
+    return &buf->events[ id % buf->events.size() ];
+}
+
+
+/******************************************************************************/
+// Returns the lane of queue, adding a lane for a new queue.
+int gpu_lane( magma_queue_t queue )
+{
+    trace_state& s = state();
+    std::lock_guard< std::mutex > lock( s.mutex );
+    auto iter = s.gpu_lanes.find( queue );
+    if ( iter != s.gpu_lanes.end() ) {
+        return iter->second;
     }
+    int lane = int( s.gpu_names.size() );
+    char name[ 64 ];
+    snprintf( name, sizeof(name), "device %lld queue %d",
+              (long long) magma_queue_get_device( queue ), lane );
+    s.gpu_names.push_back( name );
+    s.gpu_lanes[ queue ] = lane;
+    return lane;
 }
 
 
 /******************************************************************************/
-void trace_gpu_start( int dev, int s, const char* tag, const char* lbl )
+// Writes s as a JSON string.
+void json_string( FILE* file, const char* str )
 {
-    int t = dev*glog.nqueue + s;
-    int id = glog.gpu_id[t];
-#if TRACE_METHOD == 2
-    glog.gpu_start[t][id] = magma_wtime();
-#else
-    magma_event_create( &glog.gpu_start[t][id] );
-    magma_event_record(  glog.gpu_start[t][id], glog.queues[t] );
-#endif
-    magma_strlcpy( glog.gpu_tag  [t][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.gpu_label[t][id], lbl, MAX_LABEL_LEN );
+    fputc( '"', file );
+    for ( const char* p = str; *p != '\0'; ++p ) {
+        if ( *p == '"' || *p == '\\' ) {
+            fputc( '\\', file );
+            fputc( *p, file );
+        }
+        else if ( (unsigned char) *p < 0x20 ) {
+            fprintf( file, "\\u%04x", (unsigned char) *p );
+        }
+        else {
+            fputc( *p, file );
+        }
+    }
+    fputc( '"', file );
 }
 
 
 /******************************************************************************/
-void trace_gpu_end( int dev, int s )
+// Writes all buffers as Chrome trace-event JSON. Times are in microseconds
+// since magma_trace_start. Counters are written as running totals.
+magma_int_t write_trace( const std::string& filename, double stop_time )
+{
+    trace_state& s = state();
+    FILE* file = fopen( filename.c_str(), "w" );
+    if ( file == NULL ) {
+        fprintf( stderr, "MAGMA trace: can't open file '%s': %s (%d)\n",
+                 filename.c_str(), strerror( errno ), errno );
+        return MAGMA_ERR_NOT_FOUND;
+    }
+
+    const int cpu_pid = 0, gpu_pid = 1;
+    fprintf( file, "{\"traceEvents\": [\n" );
+    fprintf( file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"CPU\"}},\n", cpu_pid );
+    fprintf( file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"GPU\"}}", gpu_pid );
+    for ( size_t i = 0; i < s.gpu_names.size(); ++i ) {
+        fprintf( file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+                 gpu_pid, int(i) );
+        json_string( file, s.gpu_names[i].c_str() );
+        fprintf( file, "}}" );
+    }
+
+    uint64_t dropped = 0;
+    std::vector< const trace_event* > counters;
+    for ( auto& buf : s.buffers ) {
+        uint64_t head = buf->head.load( std::memory_order_acquire );
+        if ( head == 0 ) {
+            continue;
+        }
+        uint64_t cap   = buf->events.size();
+        uint64_t first = (head > cap ? head - cap : 0);
+        dropped += first;
+
+        char name[ 64 ];
+        if ( buf->name.empty() ) {
+            snprintf( name, sizeof(name), "thread %d", buf->lane );
+        }
+        else {
+            snprintf( name, sizeof(name), "%s", buf->name.c_str() );
+        }
+        fprintf( file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+                 cpu_pid, buf->lane );
+        json_string( file, name );
+        fprintf( file, "}}" );
+
+        for ( uint64_t id = first; id < head; ++id ) {
+            const trace_event& e = buf->events[ id % cap ];
+            if ( e.kind == trace_kind_counter ) {
+                counters.push_back( &e );
+                continue;
+            }
+            double end = (e.end < 0 ? stop_time : e.end);  // still open
+            fprintf( file, ",\n{\"name\": " );
+            json_string( file, (e.label[0] != '\0' ? e.label : e.tag) );
+            fprintf( file, ", \"cat\": " );
+            json_string( file, e.tag );
+            fprintf( file, ", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                     (e.kind == trace_kind_gpu ? gpu_pid : cpu_pid),
+                     (e.kind == trace_kind_gpu ? e.lane  : buf->lane),
+                     1e6*(e.start - s.start_time),
+                     1e6*max( end - e.start, 0. ) );
+        }
+    }
+
+    // counters as running totals over all threads, in time order
+    std::stable_sort( counters.begin(), counters.end(),
+        []( const trace_event* a, const trace_event* b ) { return a->start < b->start; } );
+    std::map< std::string, double > totals;
+    for ( const trace_event* e : counters ) {
+        double& total = totals[ e->name ];
+        total += e->value;
+        fprintf( file, ",\n{\"name\": " );
+        json_string( file, e->name );
+        fprintf( file, ", \"ph\": \"C\", \"pid\": %d, \"ts\": %.3f, \"args\": {",
+                 cpu_pid, 1e6*(e->start - s.start_time) );
+        json_string( file, e->name );
+        fprintf( file, ": %.17g}}", total );
+    }
+
+    magma_int_t major, minor, micro;
+    magma_version( &major, &minor, &micro );
+    fprintf( file, "\n],\n\"displayTimeUnit\": \"ms\",\n"
+             "\"otherData\": {\"magma_version\": \"%lld.%lld.%lld\", \"dropped_events\": %llu",
+             (long long) major, (long long) minor, (long long) micro,
+             (unsigned long long) dropped );
+    for ( auto& total : totals ) {
+        fprintf( file, ", " );
+        json_string( file, total.first.c_str() );
+        fprintf( file, ": %.17g", total.second );
+    }
+    fprintf( file, "}}\n" );
+    fclose( file );
+
+    if ( dropped > 0 ) {
+        fprintf( stderr, "MAGMA trace: %llu oldest events were overwritten;"
+                 " increase $MAGMA_TRACE_EVENTS to keep them.\n",
+                 (unsigned long long) dropped );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+// Starts tracing if $MAGMA_TRACE is set, and writes the trace at exit.
+struct trace_environment
+{
+    trace_environment()
+    {
+        state();  // construct first, so it is destroyed after this
+        const char* filename = getenv( "MAGMA_TRACE" );
+        if ( filename != NULL && filename[0] != '\0' ) {
+            magma_trace_start( filename );
+        }
+    }
+
+    ~trace_environment()
+    {
+        if ( trace_enabled() ) {
+            magma_trace_stop();
+        }
+    }
+};
+
+trace_environment g_trace_environment;
+
+}  // namespace
+
+
+/***************************************************************************//**
+    Starts tracing, discarding events of any earlier trace.
+
+    @param[in]
+    filename    File to write the trace to when tracing stops, as Chrome
+                trace-event JSON. If NULL, events are recorded but not written.
+
+    @return MAGMA_SUCCESS, or MAGMA_ERR if tracing is already on.
+
+    @ingroup magma_trace
+*******************************************************************************/
+extern "C" magma_int_t
+magma_trace_start( const char* filename )
 {
-    int t = dev*glog.nqueue + s;
-    int id = glog.gpu_id[t];
-    magma_event_create( &glog.gpu_end[t][id] );
-    magma_event_record(  glog.gpu_end[t][id], glog.queues[t] );
-    if ( id+1 < MAX_EVENTS ) {
-        glog.gpu_id[t] = id+1;
+    if ( trace_enabled() ) {
+        return MAGMA_ERR;
     }
-    else {
-        fprintf( stderr, "Error in %s: not enough GPU events (dev %d, queue %d).\n", __func__, dev, s );
+    trace_state& s = state();
+    {
+        std::lock_guard< std::mutex > lock( s.mutex );
+        s.filename = (filename ? filename : "");
+        s.capacity = default_capacity;
+        const char* env = getenv( "MAGMA_TRACE_EVENTS" );
+        if ( env != NULL && atol( env ) > 0 ) {
+            s.capacity = size_t( atol( env ));
+        }
+        for ( auto& buf : s.buffers ) {
+            buf->events.resize( s.capacity );
+            buf->head.store( 0, std::memory_order_relaxed );
+            buf->open.clear();
+        }
+        s.start_time = magma_wtime();
     }
+    g_trace_enabled.store( true, std::memory_order_release );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Stops tracing and writes the trace to the file given to
+    magma_trace_start. Traced routines should have finished; events
+    recorded concurrently may be incomplete.
+
+    @return MAGMA_SUCCESS, MAGMA_ERR if tracing is off, or
+            MAGMA_ERR_NOT_FOUND if the file can't be opened.
+
+    @ingroup magma_trace
+*******************************************************************************/
+extern "C" magma_int_t
+magma_trace_stop()
+{
+    if ( ! trace_enabled() ) {
+        return MAGMA_ERR;
+    }
+    g_trace_enabled.store( false, std::memory_order_release );
+    double stop_time = magma_wtime();
+
+    trace_state& s = state();
+    std::lock_guard< std::mutex > lock( s.mutex );
+    if ( s.filename.empty() ) {
+        return MAGMA_SUCCESS;
+    }
+    return write_trace( s.filename, stop_time );
 }
 
 
 /******************************************************************************/
-void trace_finalize( const char* filename, const char* cssfile )
+void trace_thread_name( const char* name )
 {
-    // these are all in SVG "pixels"
-    double xscale = 200.; // pixels per second
-    double height = 20.;  // of each row
-    double margin =  5.;  // page margin and between some elements
-    double space  =  2.;  // between rows
-    double pad    =  5.;  // around text
-    double label  = 75.;  // width of "CPU:", "GPU:" labels
-    double left   = 2*margin + label;
-    double xtick  = 0.5;  // interval of xticks (in seconds)
-    char buf[ 1024 ];
-    
-    // sync devices
-    for( int dev = 0; dev < glog.ngpu; ++dev ) {
-        magma_setdevice( dev );
-        magma_device_sync();
-    }
-    double time = magma_wtime() - glog.cpu_first;
-    
-    FILE* trace_file = fopen( filename, "w" );
-    if ( trace_file == NULL ) {
-        strerror_r( errno, buf, sizeof(buf) );
-        fprintf( stderr, "Can't open file '%s': %s (%d)\n", filename, buf, errno );
+    if ( t_name == name ) {
         return;
     }
-    fprintf( stderr, "writing trace to '%s'\n", filename );
-    
-    // row for each CPU and GPU/queue (with space between), time scale, legend
-    // 4 margins: at top, above time scale, above legend, at bottom
-    int h = (int)( (glog.ncore + glog.ngpu*glog.nqueue)*(height + space) - space + 2*height + 4*margin );
-    int w = (int)( left + time*xscale + margin );
-    fprintf( trace_file,
-             "<?xml version=\"1.0\" standalone=\"no\"?>\n"
-             "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\"\n"
-             "    \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n\n"
-             "<svg version=\"1.1\" baseProfile=\"full\"\n"
-             "    xmlns=\"http://www.w3.org/2000/svg\"\n"
-             "    xmlns:inkscape=\"http://www.inkscape.org/namespaces/inkscape\"\n"
-             "    viewBox=\"0 0 %d %d\" width=\"%d\" height=\"%d\" preserveAspectRatio=\"none\">\n\n",
-             w, h, w, h );
-    
-    // Inkscape does not currently (Jan 2012) support external CSS;
-    // see http://wiki.inkscape.org/wiki/index.php/CSS_Support
-    // So embed CSS file here
-    FILE* css_file = fopen( cssfile, "r" );
-    if ( css_file == NULL ) {
-        strerror_r( errno, buf, sizeof(buf) );
-        fprintf( stderr, "Can't open file '%s': %s; skipping CSS\n", cssfile, buf );
-    }
-    else {
-        fprintf( trace_file, "<style type=\"text/css\">\n" );
-        while( fgets( buf, sizeof(buf), css_file ) != NULL ) {
-            fputs( buf, trace_file );
+    t_name = name;
+    if ( t_buffer != NULL ) {
+        std::lock_guard< std::mutex > lock( state().mutex );
+        t_buffer->name = t_name;
+    }
+}
+
+
+/******************************************************************************/
+void trace_thread_index( const char* prefix, magma_int_t index )
+{
+    if ( index > 0 ) {
+        char name[ MAX_LABEL_LEN ];
+        snprintf( name, sizeof(name), "%s %lld", prefix, (long long) index );
+        trace_thread_name( name );
+    }
+}
+
+
+/******************************************************************************/
+void trace_init_impl( magma_int_t ngpu, magma_int_t nqueue, magma_queue_t* queues )
+{
+    magma_device_t orig_dev;
+    magma_getdevice( &orig_dev );
+
+    t_routines.push_back( trace_routine() );
+    trace_routine& r = t_routines.back();
+    r.nqueue = nqueue;
+    r.queues.assign( queues, queues + ngpu*nqueue );
+    r.open.resize( r.queues.size() );
+    r.anchors.resize( r.queues.size(), NULL );
+    r.devices.resize( r.queues.size(), 0 );
+    r.lanes.resize( r.queues.size(), -1 );
+    for ( size_t t = 0; t < r.queues.size(); ++t ) {
+        if ( r.queues[t] != NULL ) {
+            r.devices[t] = magma_queue_get_device( r.queues[t] );
+            r.lanes[t] = gpu_lane( r.queues[t] );
+            magma_queue_sync( r.queues[t] );
         }
-        fclose( css_file );
-        fprintf( trace_file, "</style>\n\n" );
-    }
-    
-    // format takes: x, y, width, height, class (tag), id (label)
-    const char* format =
-        "<rect x=\"%8.3f\" y=\"%4.0f\" width=\"%8.3f\" height=\"%2.0f\" class=\"%-8s\" inkscape:label=\"%s\"/>\n";
-    
-    // accumulate unique legend entries
-    std::set< std::string > legend;
-    
-    // output CPU events
-    double top = margin;
-    for( int core = 0; core < glog.ncore; ++core ) {
-        if ( glog.cpu_id[core] > MAX_EVENTS ) {
-            glog.cpu_id[core] += 1;  // count last event
-            fprintf( stderr, "WARNING: trace on core %d, reached limit of %d events; output will be truncated.\n",
-                     core, glog.cpu_id[core] );
+    }
+    // with all queues idle, anchor events mark the current host time
+    for ( size_t t = 0; t < r.queues.size(); ++t ) {
+        if ( r.queues[t] != NULL ) {
+            magma_setdevice( r.devices[t] );
+            magma_event_create( &r.anchors[t] );
+            magma_event_record( r.anchors[t], r.queues[t] );
         }
-        fprintf( trace_file, "<!-- core %d, nevents %d -->\n", core, glog.cpu_id[core] );
-        fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"core %d\">\n", core );
-        fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">CPU %d:</text>\n",
-                 margin,
-                 top + height - pad,
-                 label, height,
-                 core );
-        for( int i = 0; i < glog.cpu_id[core]; ++i ) {
-            double start  = glog.cpu_start[core][i] - glog.cpu_first;
-            double end    = glog.cpu_end  [core][i] - glog.cpu_first;
-            fprintf( trace_file, format,
-                     left + start*xscale,
-                     top,
-                     (end - start)*xscale,
-                     height,
-                     glog.cpu_tag[core][i],
-                     glog.cpu_label[core][i] );
-            legend.insert( glog.cpu_tag[core][i] );
+    }
+    for ( size_t t = 0; t < r.queues.size(); ++t ) {
+        if ( r.anchors[t] != NULL ) {
+            magma_event_sync( r.anchors[t] );
         }
-        top += (height + space);
-        fprintf( trace_file, "</g>\n\n" );
-    }
-    
-    // output GPU events
-    for( int dev = 0; dev < glog.ngpu; ++dev ) {
-        for( int s = 0; s < glog.nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            if ( glog.gpu_id[t] >= MAX_EVENTS-1 ) {
-                glog.gpu_id[t] += 1;  // count last event
-                fprintf( stderr, "WARNING: trace on gpu %d/queue %d reached limit of %d events; output will be truncated.\n",
-                         dev, s, glog.gpu_id[t] );
-            }
-            fprintf( trace_file, "<!-- gpu %d, queue %d (t %d), nevents %d -->\n", dev, s, t, glog.gpu_id[t] );
-            fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"gpu %d queue %d\">\n", dev, s );
-            fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">GPU %d (s%d):</text>\n",
-                     margin,
-                     margin + (dev*glog.nqueue + s + glog.ncore)*(height + space) + height - pad,
-                     label, height,
-                     dev, s );
-            magma_setdevice( dev );
-            float start, end;
-            for( int i = 0; i < glog.gpu_id[t]; ++i ) {
-                #if TRACE_METHOD == 2
-                    start = glog.gpu_start[t][i] - glog.cpu_first;
-                    if ( i > 0 ) {
-                        // later of task's CPU start time and previous task's end time
-                        start = max( start, end );
-                    }
-                #else
-                    cudaEventElapsedTime( &start, glog.gpu_first[t], glog.gpu_start[t][i] );
-                    start *= 1e-3;  // ms to seconds
-                #endif
-                cudaEventElapsedTime( &end, glog.gpu_first[t], glog.gpu_end  [t][i] );
-                end   *= 1e-3;  // ms to seconds
-                fprintf( trace_file, format,
-                         left + start*xscale,
-                         top,
-                         (end - start)*xscale,
-                         height,
-                         glog.gpu_tag[t][i],
-                         glog.gpu_label[t][i] );
-                legend.insert( glog.gpu_tag[t][i] );
-            }
-            top += (height + space);
-            fprintf( trace_file, "</g>\n\n" );
+    }
+    r.anchor_time = magma_wtime();
+    magma_setdevice( orig_dev );
+}
+
+
+/******************************************************************************/
+void trace_finalize_impl()
+{
+    if ( t_routines.empty() ) {
+        return;
+    }
+    magma_device_t orig_dev;
+    magma_getdevice( &orig_dev );
+
+    // the queues may already be destroyed; only their events are used
+    trace_routine& r = t_routines.back();
+    for ( auto& op : r.ops ) {
+        magma_setdevice( r.devices[ op.queue ] );
+        if ( op.end != NULL ) {
+            double start = r.anchor_time + 1e-3*magma_event_elapsed( r.anchors[ op.queue ], op.start );
+            double end   = r.anchor_time + 1e-3*magma_event_elapsed( r.anchors[ op.queue ], op.end );
+            push_event( trace_kind_gpu, start, end, op.tag, op.label, r.lanes[ op.queue ] );
+            magma_event_destroy( op.end );
+        }
+        magma_event_destroy( op.start );
+    }
+    for ( size_t t = 0; t < r.queues.size(); ++t ) {
+        if ( r.anchors[t] != NULL ) {
+            magma_setdevice( r.devices[t] );
+            magma_event_destroy( r.anchors[t] );
         }
     }
-    
-    // output time scale
-    top += (-space + margin);
-    fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"scale\">\n" );
-    fprintf( trace_file, "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">Time (sec):</text>\n",
-             margin, top + height - pad, label, height );
-    for( double s=0; s < time; s += xtick ) {
-        fprintf( trace_file,
-            "<line x1=\"%8.1f\" y1=\"0\" x2=\"%8.1f\" y2=\"%4.0f\"/>"
-            "<text x=\"%8.1f\" y=\"%4.0f\">%4.1f</text>\n",
-            left + s*xscale,
-            left + s*xscale,
-            top,
-            left + s*xscale,
-            top + height - pad,
-            s );
-    }
-    fprintf( trace_file, "</g>\n\n" );
-    top += (height + margin);
-    
-    // output legend
-    fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"legend\">\n" );
-    fprintf( trace_file, "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">Legend:</text>\n",
-             margin, top + height - pad, label, height );
-    double x=left;
-    for( std::set<std::string>::iterator it=legend.begin(); it != legend.end(); ++it ) {
-        fprintf( trace_file,
-            "<rect x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\" class=\"%s\"/>"
-            "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">%s</text>",
-            x,       top,                label, height, (*it).c_str(),
-            x + pad, top + height - pad, label, height, (*it).c_str() );
-        x += label + margin;
-    }
-    fprintf( trace_file, "</g>\n\n" );
-    
-    fprintf( trace_file, "</svg>\n" );
-    
-    fclose( trace_file );
+    t_routines.pop_back();
+    magma_setdevice( orig_dev );
+}
+
+
+/******************************************************************************/
+void trace_cpu_start_impl( const char* tag, const char* label )
+{
+    uint64_t id = push_event( trace_kind_cpu, magma_wtime(), -1, tag, label );
+    t_buffer->open.push_back( id );
 }
 
-#endif // TRACING
+
+/******************************************************************************/
+void trace_cpu_end_impl()
+{
+    trace_buffer* buf = thread_buffer();
+    if ( buf->open.empty() ) {
+        return;  // started before tracing
+    }
+    trace_event* e = find_event( buf, buf->open.back() );
+    buf->open.pop_back();
+    if ( e != NULL ) {
+        e->end = magma_wtime();
+    }
+}
+
+
+/******************************************************************************/
+void trace_gpu_start_impl( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label )
+{
+    if ( t_routines.empty() ) {
+        return;  // tracing started inside the routine
+    }
+    trace_routine& r = t_routines.back();
+    size_t t = size_t( dev*r.nqueue + queue_num );
+    if ( queue_num >= r.nqueue || t >= r.queues.size() || r.queues[t] == NULL ) {
+        return;
+    }
+    magma_device_t orig_dev;
+    magma_getdevice( &orig_dev );
+    magma_setdevice( r.devices[t] );
+
+    trace_gpu_op op;
+    op.end   = NULL;
+    op.queue = t;
+    magma_strlcpy( op.tag,   (tag   ? tag   : ""), MAX_LABEL_LEN );
+    magma_strlcpy( op.label, (label ? label : ""), MAX_LABEL_LEN );
+    magma_event_create( &op.start );
+    magma_event_record( op.start, r.queues[t] );
+    r.open[t].push_back( r.ops.size() );
+    r.ops.push_back( op );
+    magma_setdevice( orig_dev );
+}
+
+
+/******************************************************************************/
+void trace_gpu_end_impl( magma_int_t dev, magma_int_t queue_num )
+{
+    if ( t_routines.empty() ) {
+        return;
+    }
+    trace_routine& r = t_routines.back();
+    size_t t = size_t( dev*r.nqueue + queue_num );
+    if ( queue_num >= r.nqueue || t >= r.queues.size() || r.open[t].empty() ) {
+        return;
+    }
+    magma_device_t orig_dev;
+    magma_getdevice( &orig_dev );
+    magma_setdevice( r.devices[t] );
+
+    trace_gpu_op& op = r.ops[ r.open[t].back() ];
+    r.open[t].pop_back();
+    magma_event_create( &op.end );
+    magma_event_record( op.end, r.queues[t] );
+    magma_setdevice( orig_dev );
+}
+
+
+/******************************************************************************/
+void trace_counter_impl( const char* name, double value )
+{
+    push_event( trace_kind_counter, magma_wtime(), 0, NULL, NULL, 0, name, value );
+}
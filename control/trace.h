@@ -6,10 +6,17 @@
        @date
 
        @author Mark Gates
+
+       Runtime tracing of CPU tasks, GPU queues, and counters.
+       Tracing is off unless started by $MAGMA_TRACE=filename or
+       magma_trace_start(); see trace.cpp. While off, each call below is
+       one relaxed load of a flag, so instrumentation can stay in the code.
 */
 #ifndef TRACE_H
 #define TRACE_H
 
+#include <atomic>
+
 // has MagmaMaxGPUs, strlcpy, max
 // TODO: what's the best way to protect inclusion?
 #ifndef MAGMA_H
@@ -17,40 +24,113 @@
 #endif
 
 // =============================================================================
-const magma_int_t MAX_CORES       = 1;                 // CPU cores
-const magma_int_t MAX_GPU_QUEUES  = MagmaMaxGPUs * 4;  // #devices * #queues per device
-const magma_int_t MAX_EVENTS      = 20000;
-const magma_int_t MAX_LABEL_LEN   = 16;
+const magma_int_t MAX_LABEL_LEN   = 32;
 
 
 // =============================================================================
-#ifdef TRACING
-
-void trace_init     ( magma_int_t ncore, magma_int_t ngpu, magma_int_t nqueue, magma_queue_t *queues );
-
-void trace_cpu_start( magma_int_t core, const char* tag, const char* label );
-void trace_cpu_end  ( magma_int_t core );
+// implementation, in trace.cpp; call the inline wrappers below instead.
 
-magma_event_t*
-     trace_gpu_event( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label );
-void trace_gpu_start( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label );
-void trace_gpu_end  ( magma_int_t dev, magma_int_t queue_num );
+extern std::atomic<bool> g_trace_enabled;
 
-void trace_finalize ( const char* filename, const char* cssfile );
+void trace_init_impl     ( magma_int_t ngpu, magma_int_t nqueue, magma_queue_t *queues );
+void trace_finalize_impl ();
 
-#else
+void trace_cpu_start_impl( const char* tag, const char* label );
+void trace_cpu_end_impl  ();
 
-#define trace_init(      x1, x2, x3, x4 ) ((void)(0))
+void trace_gpu_start_impl( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label );
+void trace_gpu_end_impl  ( magma_int_t dev, magma_int_t queue_num );
 
-#define trace_cpu_start( x1, x2, x3     ) ((void)(0))
-#define trace_cpu_end(   x1             ) ((void)(0))
+void trace_counter_impl  ( const char* name, double value );
 
-#define trace_gpu_event( x1, x2, x3, x4 ) (NULL)
-#define trace_gpu_start( x1, x2, x3, x4 ) ((void)(0))
-#define trace_gpu_end(   x1, x2         ) ((void)(0))
 
-#define trace_finalize(  x1, x2         ) ((void)(0))
-
-#endif
+// =============================================================================
+/// @return whether tracing is on.
+inline bool trace_enabled()
+{
+    return g_trace_enabled.load( std::memory_order_relaxed );
+}
+
+/// Sets the lane name of the calling thread, e.g., "bulge chasing 3".
+/// Cheap enough to call when tracing is off, so persistent threads are named.
+void trace_thread_name( const char* name );
+
+/// Names thread index of a team "prefix index", e.g., for OpenMP threads;
+/// index 0, the calling thread, keeps its name.
+void trace_thread_index( const char* prefix, magma_int_t index );
+
+/// At the start of a traced routine: GPU lane (dev, queue_num) is
+/// queues[ dev*nqueue + queue_num ]. Pair with trace_finalize.
+inline void trace_init( magma_int_t ngpu, magma_int_t nqueue, magma_queue_t *queues )
+{
+    if ( trace_enabled() ) {
+        trace_init_impl( ngpu, nqueue, queues );
+    }
+}
+
+/// At the end of a traced routine: waits for its queues and converts their
+/// events to times. The trace file is written by magma_trace_stop().
+inline void trace_finalize()
+{
+    if ( trace_enabled() ) {
+        trace_finalize_impl();
+    }
+}
+
+/// Starts and ends a task on the calling thread's CPU lane.
+/// tag is the category, e.g., "getrf"; label describes the instance.
+inline void trace_cpu_start( const char* tag, const char* label )
+{
+    if ( trace_enabled() ) {
+        trace_cpu_start_impl( tag, label );
+    }
+}
+
+inline void trace_cpu_end()
+{
+    if ( trace_enabled() ) {
+        trace_cpu_end_impl();
+    }
+}
+
+/// Task on the calling thread's CPU lane for the rest of the scope,
+/// so it ends on every return or goto out of the scope.
+class trace_cpu_scope
+{
+public:
+    trace_cpu_scope( const char* tag, const char* label )
+    {
+        trace_cpu_start( tag, label );
+    }
+
+    ~trace_cpu_scope()
+    {
+        trace_cpu_end();
+    }
+};
+
+/// Starts and ends a task on a GPU queue registered by trace_init.
+inline void trace_gpu_start( magma_int_t dev, magma_int_t queue_num, const char* tag, const char* label )
+{
+    if ( trace_enabled() ) {
+        trace_gpu_start_impl( dev, queue_num, tag, label );
+    }
+}
+
+inline void trace_gpu_end( magma_int_t dev, magma_int_t queue_num )
+{
+    if ( trace_enabled() ) {
+        trace_gpu_end_impl( dev, queue_num );
+    }
+}
+
+/// Adds value to the named counter, e.g., "flops", "bytes moved",
+/// "queue wait (s)". name must be a string literal.
+inline void trace_counter( const char* name, double value )
+{
+    if ( trace_enabled() ) {
+        trace_counter_impl( name, value );
+    }
+}
 
 #endif        //  #ifndef TRACE_H
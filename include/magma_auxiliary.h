@@ -49,6 +49,42 @@ real_Double_t magma_wtime( void );
 real_Double_t magma_sync_wtime( magma_queue_t queue );
 
 
+// =============================================================================
+// timers inside routines
+
+typedef enum {
+    MagmaTimerOff   = 0,
+    MagmaTimerOn    = 1,    ///< record phases, for magma_timer_query
+    MagmaTimerPrint = 2     ///< also print timer_printf output
+} magma_timer_mode_t;
+
+void        magma_timer_set_mode( magma_timer_mode_t mode );
+magma_timer_mode_t magma_timer_get_mode( void );
+
+magma_int_t magma_timer_set_counter( const char* name );
+const char* magma_timer_get_counter( void );
+
+void        magma_timer_reset( void );
+magma_int_t magma_timer_count( void );
+
+magma_int_t magma_timer_get(
+    magma_int_t index, const char** routine, const char** phase,
+    double* seconds, magma_int_t* calls, long long* count );
+
+magma_int_t magma_timer_query(
+    const char* routine, const char* phase,
+    double* seconds, magma_int_t* calls, long long* count );
+
+void        magma_timer_print( void );
+
+
+// =============================================================================
+// tracing
+
+magma_int_t magma_trace_start( const char* filename );
+magma_int_t magma_trace_stop( void );
+
+
 // =============================================================================
 // misc. functions
 
@@ -163,6 +199,9 @@ static inline magma_int_t magma_index_malloc_cpu( magma_index_t **ptr_ptr, size_
 /// Type-safe version of magma_malloc_cpu(), for magma_uindex_t arrays. Allocates n*sizeof(magma_uindex_t) bytes.
 static inline magma_int_t magma_uindex_malloc_cpu( magma_uindex_t **ptr_ptr, size_t n ) { return magma_malloc_cpu( (void**) ptr_ptr, n*sizeof(magma_uindex_t)      ); }
 
+/// Type-safe version of magma_malloc_cpu(), for magma_offset_t arrays. Allocates n*sizeof(magma_offset_t) bytes.
+static inline magma_int_t magma_offset_malloc_cpu( magma_offset_t **ptr_ptr, size_t n ) { return magma_malloc_cpu( (void**) ptr_ptr, n*sizeof(magma_offset_t)     ); }
+
 /// Type-safe version of magma_malloc_cpu(), for float arrays. Allocates n*sizeof(float) bytes.
 static inline magma_int_t magma_smalloc_cpu( float              **ptr_ptr, size_t n ) { return magma_malloc_cpu( (void**) ptr_ptr, n*sizeof(float)              ); }
 
@@ -347,6 +386,9 @@ magma_event_query( magma_event_t event );
 void
 magma_event_sync( magma_event_t event );
 
+float
+magma_event_elapsed( magma_event_t start, magma_event_t end );
+
 void
 magma_queue_wait_event( magma_queue_t queue, magma_event_t event );
 
@@ -38,6 +38,12 @@ extern "C" {
 
     magma_int_t magma_bulge_get_blkcnt(magma_int_t n, magma_int_t nb, magma_int_t Vblksiz);
 
+    magma_int_t magma_bulge_get_tuning(const char* routine, magma_int_t n, magma_int_t nb,
+                                       magma_int_t *Vblksiz, magma_int_t *colblktile, magma_int_t *nthread);
+    void magma_bulge_set_tuning(const char* routine, magma_int_t n, magma_int_t nb,
+                                magma_int_t Vblksiz, magma_int_t colblktile, magma_int_t nthread, double time);
+    magma_int_t magma_bulge_write_tuning(const char* filename);
+
     void findVTpos(magma_int_t n, magma_int_t nb, magma_int_t Vblksiz, magma_int_t sweep, magma_int_t st, magma_int_t *Vpos, magma_int_t *TAUpos, magma_int_t *Tpos, magma_int_t *myblkid);
 
 #ifdef __cplusplus
@@ -24,7 +24,7 @@
 
 
 // each implementation of MAGMA defines HAVE_* appropriately.
-#if ! defined(MAGMA_HAVE_CUDA) && ! defined(MAGMA_HAVE_OPENCL) && ! defined(HAVE_MIC) && ! defined(MAGMA_HAVE_HIP)
+#if ! defined(MAGMA_HAVE_CUDA) && ! defined(MAGMA_HAVE_OPENCL) && ! defined(HAVE_MIC) && ! defined(MAGMA_HAVE_HIP) && ! defined(MAGMA_HAVE_CPU)
 // Pytorch requires that the error commented out below is not produced and that MAGMA_HAVE_CUDA is defined:
 // #error No 'HAVE_*' macros were set! (defaulting to CUBLAS)
 #define MAGMA_HAVE_CUDA
@@ -71,6 +71,10 @@ typedef int magma_int_t;
 typedef int magma_index_t;
 typedef unsigned int magma_uindex_t;
 
+// 64-bit offsets into sparse arrays, e.g., row pointers of Magma_CSR64
+// matrices whose nnz exceeds the range of magma_index_t
+typedef long long int magma_offset_t;
+
 // Define new type that the precision generator will not change (matches PLASMA)
 typedef double real_Double_t;
 
@@ -323,6 +327,117 @@ typedef double real_Double_t;
     }
 
 
+    #ifdef __cplusplus
+    }
+    #endif
+
+#elif defined(MAGMA_HAVE_CPU)
+
+    // Host backend: device memory is host memory, and queues execute on
+    // MAGMA's thread pool. __host__ and __device__ are used by inline
+    // functions in MAGMA headers.
+    #ifndef __host__
+    #define __host__
+    #endif
+    #ifndef __device__
+    #define __device__
+    #endif
+
+    #include <math.h>  // hypot, fabs for MAGMA_Z_ABS, etc.
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    // opaque queue and event structures
+    struct magma_queue;
+    struct magma_event;
+    typedef struct magma_queue* magma_queue_t;
+    typedef struct magma_event* magma_event_t;
+    typedef magma_int_t         magma_device_t;
+
+    typedef short            magmaHalf;    // placeholder; no half precision on the host
+
+    /* binary compatible with double _Complex and std::complex<double> */
+    typedef struct {
+        double x, y;
+    } magmaDoubleComplex;
+
+    /* binary compatible with float _Complex and std::complex<float> */
+    typedef struct {
+        float x, y;
+    } magmaFloatComplex;
+
+    #define MAGMA_Z_MAKE(r, i)    ((magmaDoubleComplex){(double)(r), (double)(i)})
+    #define MAGMA_Z_REAL(a)       (a).x
+    #define MAGMA_Z_IMAG(a)       (a).y
+    #define MAGMA_Z_ADD(a, b)     magmaCadd(a, b)
+    #define MAGMA_Z_SUB(a, b)     magmaCsub(a, b)
+    #define MAGMA_Z_MUL(a, b)     magmaCmul(a, b)
+    #define MAGMA_Z_DIV(a, b)     magmaCdiv(a, b)
+    #define MAGMA_Z_ABS(a)        (hypot(MAGMA_Z_REAL(a), MAGMA_Z_IMAG(a)))
+    #define MAGMA_Z_ABS1(a)       (fabs(MAGMA_Z_REAL(a)) + fabs(MAGMA_Z_IMAG(a)))
+    #define MAGMA_Z_CONJ(a)       magmaConj(a)
+
+    #define MAGMA_C_MAKE(r, i)    ((magmaFloatComplex){(float)(r), (float)(i)})
+    #define MAGMA_C_REAL(a)       (a).x
+    #define MAGMA_C_IMAG(a)       (a).y
+    #define MAGMA_C_ADD(a, b)     magmaCaddf(a, b)
+    #define MAGMA_C_SUB(a, b)     magmaCsubf(a, b)
+    #define MAGMA_C_MUL(a, b)     magmaCmulf(a, b)
+    #define MAGMA_C_DIV(a, b)     magmaCdivf(a, b)
+    #define MAGMA_C_ABS(a)        (hypotf(MAGMA_C_REAL(a), MAGMA_C_IMAG(a)))
+    #define MAGMA_C_ABS1(a)       (fabsf(MAGMA_C_REAL(a)) + fabsf(MAGMA_C_IMAG(a)))
+    #define MAGMA_C_CONJ(a)       magmaConjf(a)
+
+    /* double complex arithmetic */
+    static inline magmaDoubleComplex magmaCadd(magmaDoubleComplex a, magmaDoubleComplex b) {
+        return MAGMA_Z_MAKE(a.x+b.x, a.y+b.y);
+    }
+    static inline magmaDoubleComplex magmaCsub(magmaDoubleComplex a, magmaDoubleComplex b) {
+        return MAGMA_Z_MAKE(a.x-b.x, a.y-b.y);
+    }
+    static inline magmaDoubleComplex magmaCmul(magmaDoubleComplex a, magmaDoubleComplex b) {
+        return MAGMA_Z_MAKE(a.x*b.x - a.y*b.y, a.x*b.y + a.y*b.x);
+    }
+    static inline magmaDoubleComplex magmaCdiv(magmaDoubleComplex a, magmaDoubleComplex b) {
+        double sqabs = b.x*b.x + b.y*b.y;
+        return MAGMA_Z_MAKE(
+            (a.x * b.x + a.y * b.y) / sqabs,
+            (a.y * b.x - a.x * b.y) / sqabs
+        );
+    }
+    static inline magmaDoubleComplex magmaConj(magmaDoubleComplex a) {
+        return MAGMA_Z_MAKE(a.x, -a.y);
+    }
+    static inline magmaDoubleComplex magmaCfma(magmaDoubleComplex a, magmaDoubleComplex b, magmaDoubleComplex c) {
+        return magmaCadd(magmaCmul(a, b), c);
+    }
+
+    /* float complex arithmetic */
+    static inline magmaFloatComplex magmaCaddf(magmaFloatComplex a, magmaFloatComplex b) {
+        return MAGMA_C_MAKE(a.x+b.x, a.y+b.y);
+    }
+    static inline magmaFloatComplex magmaCsubf(magmaFloatComplex a, magmaFloatComplex b) {
+        return MAGMA_C_MAKE(a.x-b.x, a.y-b.y);
+    }
+    static inline magmaFloatComplex magmaCmulf(magmaFloatComplex a, magmaFloatComplex b) {
+        return MAGMA_C_MAKE(a.x*b.x - a.y*b.y, a.x*b.y + a.y*b.x);
+    }
+    static inline magmaFloatComplex magmaCdivf(magmaFloatComplex a, magmaFloatComplex b) {
+        float sqabs = b.x*b.x + b.y*b.y;
+        return MAGMA_C_MAKE(
+            (a.x * b.x + a.y * b.y) / sqabs,
+            (a.y * b.x - a.x * b.y) / sqabs
+        );
+    }
+    static inline magmaFloatComplex magmaConjf(magmaFloatComplex a) {
+        return MAGMA_C_MAKE(a.x, -a.y);
+    }
+    static inline magmaFloatComplex magmaCfmaf(magmaFloatComplex a, magmaFloatComplex b, magmaFloatComplex c) {
+        return magmaCaddf(magmaCmulf(a, b), c);
+    }
+
     #ifdef __cplusplus
     }
     #endif
@@ -410,7 +525,7 @@ typedef double real_Double_t;
     }
     #endif
 #else
-    #error "One of MAGMA_HAVE_CUDA, MAGMA_HAVE_HIP, MAGMA_HAVE_OPENCL, or HAVE_MIC must be defined. For example, add -DMAGMA_HAVE_CUDA to CFLAGS, or #define MAGMA_HAVE_CUDA before #include <magma.h>. In MAGMA, this happens in Makefile."
+    #error "One of MAGMA_HAVE_CUDA, MAGMA_HAVE_HIP, MAGMA_HAVE_CPU, MAGMA_HAVE_OPENCL, or HAVE_MIC must be defined. For example, add -DMAGMA_HAVE_CUDA to CFLAGS, or #define MAGMA_HAVE_CUDA before #include <magma.h>. In MAGMA, this happens in Makefile."
 #endif
 
 #ifdef __cplusplus
@@ -730,7 +845,8 @@ typedef enum {
     Magma_CSRCOO       = 629,
     Magma_CUCSR        = 630,
     Magma_COOLIST      = 631,
-    Magma_CSR5         = 632
+    Magma_CSR5         = 632,
+    Magma_CSR64        = 633
 } magma_storage_t;
 
 
@@ -0,0 +1,352 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef DEBUG_MEMORY
+#include <map>
+#endif
+
+#include "host_stream.h"
+#include "error.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+
+#ifdef DEBUG_MEMORY
+std::mutex                g_pointers_mutex;  // requires C++11
+std::map< void*, size_t > g_pointers_dev;
+std::map< void*, size_t > g_pointers_cpu;
+std::map< void*, size_t > g_pointers_pin;
+#endif
+
+
+/******************************************************************************/
+// Allocates size bytes aligned to a 64 byte boundary (typical cache line size).
+static magma_int_t
+magma_malloc_aligned( void** ptrPtr, size_t size )
+{
+    // malloc and free sometimes don't work for size=0, so allocate some minimal size
+    if ( size == 0 )
+        size = sizeof(magmaDoubleComplex);
+#if defined( _WIN32 ) || defined( _WIN64 )
+    *ptrPtr = _aligned_malloc( size, 64 );
+    if ( *ptrPtr == NULL ) {
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+#else
+    int err = posix_memalign( ptrPtr, 64, size );
+    if ( err != 0 ) {
+        *ptrPtr = NULL;
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+#endif
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+static void
+magma_free_aligned( void* ptr )
+{
+#if defined( _WIN32 ) || defined( _WIN64 )
+    _aligned_free( ptr );
+#else
+    free( ptr );
+#endif
+}
+
+
+/***************************************************************************//**
+    Allocates "device" memory, which in the CPU backend is host memory,
+    aligned to a 64 byte boundary.
+    Use magma_free() to free this memory.
+
+    @param[out]
+    ptrPtr  On output, set to the pointer that was allocated.
+            NULL on failure.
+
+    @param[in]
+    size    Size in bytes to allocate. If size = 0, allocates some minimal size.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_DEVICE_ALLOC on failure
+
+    Type-safe versions avoid the need for a (void**) cast and explicit sizeof.
+    @see magma_smalloc
+    @see magma_dmalloc
+    @see magma_cmalloc
+    @see magma_zmalloc
+    @see magma_imalloc
+    @see magma_index_malloc
+
+    @ingroup magma_malloc
+*******************************************************************************/
+extern "C" magma_int_t
+magma_malloc( magma_ptr* ptrPtr, size_t size )
+{
+    if ( magma_malloc_aligned( ptrPtr, size ) != MAGMA_SUCCESS ) {
+        return MAGMA_ERR_DEVICE_ALLOC;
+    }
+
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    g_pointers_dev[ *ptrPtr ] = size;
+    g_pointers_mutex.unlock();
+    #endif
+
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    @fn magma_free( ptr )
+
+    Frees "device" memory previously allocated by magma_malloc().
+    As cudaFree does, this first waits for operations on all queues to
+    finish, since they may still use the memory.
+
+    @param[in]
+    ptr     Pointer to free.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_INVALID_PTR on failure
+
+    @ingroup magma_malloc
+*******************************************************************************/
+extern "C" magma_int_t
+magma_free_internal( magma_ptr ptr,
+    const char* func, const char* file, int line )
+{
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    if ( ptr != NULL && g_pointers_dev.count( ptr ) == 0 ) {
+        fprintf( stderr, "magma_free( %p ) that wasn't allocated with magma_malloc.\n", ptr );
+    }
+    else {
+        g_pointers_dev.erase( ptr );
+    }
+    g_pointers_mutex.unlock();
+    #endif
+
+    magma_host_sync_all();
+    magma_free_aligned( ptr );
+
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Allocate size bytes on CPU.
+    The purpose of using this instead of malloc is to properly align arrays
+    for vector (SSE, AVX) instructions. The default implementation uses
+    posix_memalign (on Linux, MacOS, etc.) or _aligned_malloc (on Windows)
+    to align memory to a 64 byte boundary (typical cache line size).
+    Use magma_free_cpu() to free this memory.
+
+    @param[out]
+    ptrPtr  On output, set to the pointer that was allocated.
+            NULL on failure.
+
+    @param[in]
+    size    Size in bytes to allocate. If size = 0, allocates some minimal size.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_HOST_ALLOC on failure
+
+    Type-safe versions avoid the need for a (void**) cast and explicit sizeof.
+    @see magma_smalloc_cpu
+    @see magma_dmalloc_cpu
+    @see magma_cmalloc_cpu
+    @see magma_zmalloc_cpu
+    @see magma_imalloc_cpu
+    @see magma_index_malloc_cpu
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C" magma_int_t
+magma_malloc_cpu( void** ptrPtr, size_t size )
+{
+    magma_int_t err = magma_malloc_aligned( ptrPtr, size );
+    if ( err != MAGMA_SUCCESS ) {
+        return err;
+    }
+
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    g_pointers_cpu[ *ptrPtr ] = size;
+    g_pointers_mutex.unlock();
+    #endif
+
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Frees CPU memory previously allocated by magma_malloc_cpu().
+    The default implementation uses free(),
+    which works for both malloc and posix_memalign.
+    For Windows, _aligned_free() is used.
+
+    @param[in]
+    ptr     Pointer to free.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_INVALID_PTR on failure
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C" magma_int_t
+magma_free_cpu( void* ptr )
+{
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    if ( ptr != NULL && g_pointers_cpu.count( ptr ) == 0 ) {
+        fprintf( stderr, "magma_free_cpu( %p ) that wasn't allocated with magma_malloc_cpu.\n", ptr );
+    }
+    else {
+        g_pointers_cpu.erase( ptr );
+    }
+    g_pointers_mutex.unlock();
+    #endif
+
+    magma_free_aligned( ptr );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Allocates "pinned" memory on the CPU. In the CPU backend, there are no
+    transfers to pin memory for, so this is aligned host memory.
+    Use magma_free_pinned() to free this memory.
+
+    @param[out]
+    ptrPtr  On output, set to the pointer that was allocated.
+            NULL on failure.
+
+    @param[in]
+    size    Size in bytes to allocate. If size = 0, allocates some minimal size.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_HOST_ALLOC on failure
+
+    Type-safe versions avoid the need for a (void**) cast and explicit sizeof.
+    @see magma_smalloc_pinned
+    @see magma_dmalloc_pinned
+    @see magma_cmalloc_pinned
+    @see magma_zmalloc_pinned
+    @see magma_imalloc_pinned
+    @see magma_index_malloc_pinned
+
+    @ingroup magma_malloc_pinned
+*******************************************************************************/
+extern "C" magma_int_t
+magma_malloc_pinned( void** ptrPtr, size_t size )
+{
+    magma_int_t err = magma_malloc_aligned( ptrPtr, size );
+    if ( err != MAGMA_SUCCESS ) {
+        return err;
+    }
+
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    g_pointers_pin[ *ptrPtr ] = size;
+    g_pointers_mutex.unlock();
+    #endif
+
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    @fn magma_free_pinned( ptr )
+
+    Frees CPU pinned memory previously allocated by magma_malloc_pinned().
+    As cudaFreeHost does, this first waits for operations on all queues to
+    finish, since they may still use the memory.
+
+    @param[in]
+    ptr     Pointer to free.
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_INVALID_PTR on failure
+
+    @ingroup magma_malloc_pinned
+*******************************************************************************/
+extern "C" magma_int_t
+magma_free_pinned_internal( void* ptr,
+    const char* func, const char* file, int line )
+{
+    #ifdef DEBUG_MEMORY
+    g_pointers_mutex.lock();
+    if ( ptr != NULL && g_pointers_pin.count( ptr ) == 0 ) {
+        fprintf( stderr, "magma_free_pinned( %p ) that wasn't allocated with magma_malloc_pinned.\n", ptr );
+    }
+    else {
+        g_pointers_pin.erase( ptr );
+    }
+    g_pointers_mutex.unlock();
+    #endif
+
+    magma_host_sync_all();
+    magma_free_aligned( ptr );
+
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+    return MAGMA_SUCCESS;
+}
+
+/***************************************************************************//**
+    @fn magma_mem_info( free, total )
+
+    Sets the parameters 'free' and 'total' to the free and total memory in the
+    system (in bytes).
+
+    @param[in]
+    free    Address of the result for 'free' bytes on the system
+    total   Address of the result for 'total' bytes on the system
+
+    @return MAGMA_SUCCESS
+    @return MAGMA_ERR_INVALID_PTR on failure
+
+*******************************************************************************/
+extern "C" magma_int_t
+magma_mem_info(size_t * freeMem, size_t * totalMem) {
+    long avail    = sysconf( _SC_AVPHYS_PAGES );
+    long pages    = sysconf( _SC_PHYS_PAGES );
+    long pagesize = sysconf( _SC_PAGESIZE );
+    if ( avail < 0 || pages < 0 || pagesize < 0 ) {
+        return MAGMA_ERR_UNKNOWN;
+    }
+    *freeMem  = size_t(avail) * size_t(pagesize);
+    *totalMem = size_t(pages) * size_t(pagesize);
+    return MAGMA_SUCCESS;
+}
+
+
+extern "C" magma_int_t
+magma_memset(void * ptr, int value, size_t count) {
+    magma_host_sync_all();
+    memset( ptr, value, count );
+    return MAGMA_SUCCESS;
+}
+
+extern "C" magma_int_t
+magma_memset_async(void * ptr, int value, size_t count, magma_queue_t queue) {
+    magma_host_enqueue( queue, [=]() { memset( ptr, value, count ); } );
+    return MAGMA_SUCCESS;
+}
+
+#endif // MAGMA_HAVE_CPU
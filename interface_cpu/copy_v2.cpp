@@ -0,0 +1,517 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <string.h>
+
+#include "host_stream.h"
+#include "error.h"
+#include "trace.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+// Generic, type-independent routines to copy data.
+// Type-safe versions which avoid the user needing sizeof(...) are in headers;
+// see magma_{s,d,c,z,i,index_}{set,get,copy}{matrix,vector}
+//
+// In the CPU backend, host and device memory are the same, so set, get,
+// and copy are all host memory copies, queued on the queue's stream.
+// The synchronous versions wait for the queue afterwards.
+
+
+/******************************************************************************/
+// Copies an m-by-n matrix of elemSize-byte elements.
+static void
+magma_host_memcpy2d(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    const void* src, magma_int_t lda,
+    void*       dst, magma_int_t ldb )
+{
+    const char* s = (const char*) src;
+    char*       d = (char*)       dst;
+    size_t width = size_t(m) * size_t(elemSize);
+    if ( lda == m && ldb == m ) {
+        memmove( d, s, width * size_t(n) );
+        return;
+    }
+    for (magma_int_t j = 0; j < n; ++j) {
+        memmove( d + size_t(j)*size_t(ldb)*size_t(elemSize),
+                 s + size_t(j)*size_t(lda)*size_t(elemSize), width );
+    }
+}
+
+
+/******************************************************************************/
+// Copies a strided vector of n elemSize-byte elements.
+static void
+magma_host_memcpy1d(
+    magma_int_t n, magma_int_t elemSize,
+    const void* src, magma_int_t incx,
+    void*       dst, magma_int_t incy )
+{
+    // a strided vector is a 1-by-n matrix with leading dimension inc
+    if ( incx == 1 && incy == 1 ) {
+        magma_host_memcpy2d( n, 1, elemSize, src, n, dst, n );
+    }
+    else {
+        magma_host_memcpy2d( 1, n, elemSize, src, incx, dst, incy );
+    }
+}
+
+
+/***************************************************************************//**
+    @fn magma_setvector( n, elemSize, hx_src, incx, dy_dst, incy, queue )
+
+    Copy vector hx_src on CPU host to dy_dst on the device,
+    which in the CPU backend is host memory.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_setvector_async() for an asynchronous version.
+
+    @param[in]
+    n           Number of elements in vector.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    hx_src      Source array of dimension (1 + (n-1))*incx, on CPU host.
+
+    @param[in]
+    incx        Increment between elements of hx_src. incx > 0.
+
+    @param[out]
+    dy_dst      Destination array of dimension (1 + (n-1))*incy, on device.
+
+    @param[in]
+    incy        Increment between elements of dy_dst. incy > 0.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_setvector
+*******************************************************************************/
+extern "C" void
+magma_setvector_internal(
+    magma_int_t n, magma_int_t elemSize,
+    void const* hx_src, magma_int_t incx,
+    magma_ptr   dy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_setvector_async_internal( n, elemSize, hx_src, incx, dy_dst, incy,
+                                    queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_setvector_async( n, elemSize, hx_src, incx, dy_dst, incy, queue )
+
+    Asynchronous version of magma_setvector(): it may return before the
+    copy finishes, so hx_src must not be changed until the queue is synced.
+
+    @ingroup magma_setvector
+*******************************************************************************/
+extern "C" void
+magma_setvector_async_internal(
+    magma_int_t n, magma_int_t elemSize,
+    void const* hx_src, magma_int_t incx,
+    magma_ptr   dy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(n)*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy1d( n, elemSize, hx_src, incx, dy_dst, incy );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_getvector( n, elemSize, dx_src, incx, hy_dst, incy, queue )
+
+    Copy vector dx_src on the device, which in the CPU backend is host
+    memory, to hy_dst on CPU host.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_getvector_async() for an asynchronous version.
+
+    @param[in]
+    n           Number of elements in vector.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    dx_src      Source array of dimension (1 + (n-1))*incx, on device.
+
+    @param[in]
+    incx        Increment between elements of dx_src. incx > 0.
+
+    @param[out]
+    hy_dst      Destination array of dimension (1 + (n-1))*incy, on CPU host.
+
+    @param[in]
+    incy        Increment between elements of hy_dst. incy > 0.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_getvector
+*******************************************************************************/
+extern "C" void
+magma_getvector_internal(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx_src, magma_int_t incx,
+    void*           hy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_getvector_async_internal( n, elemSize, dx_src, incx, hy_dst, incy,
+                                    queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_getvector_async( n, elemSize, dx_src, incx, hy_dst, incy, queue )
+
+    Asynchronous version of magma_getvector(): it may return before the
+    copy finishes, so hy_dst must not be read until the queue is synced.
+
+    @ingroup magma_getvector
+*******************************************************************************/
+extern "C" void
+magma_getvector_async_internal(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx_src, magma_int_t incx,
+    void*           hy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(n)*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy1d( n, elemSize, dx_src, incx, hy_dst, incy );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_copyvector( n, elemSize, dx_src, incx, dy_dst, incy, queue )
+
+    Copy vector dx_src on the device to dy_dst on the device;
+    in the CPU backend, both are host memory.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_copyvector_async() for an asynchronous version.
+
+    @param[in]
+    n           Number of elements in vector.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    dx_src      Source array of dimension (1 + (n-1))*incx, on device.
+
+    @param[in]
+    incx        Increment between elements of dx_src. incx > 0.
+
+    @param[out]
+    dy_dst      Destination array of dimension (1 + (n-1))*incy, on device.
+
+    @param[in]
+    incy        Increment between elements of dy_dst. incy > 0.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_copyvector
+*******************************************************************************/
+extern "C" void
+magma_copyvector_internal(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx_src, magma_int_t incx,
+    magma_ptr       dy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_copyvector_async_internal( n, elemSize, dx_src, incx, dy_dst, incy,
+                                     queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_copyvector_async( n, elemSize, dx_src, incx, dy_dst, incy, queue )
+
+    Asynchronous version of magma_copyvector(): it may return before the
+    copy finishes.
+
+    @ingroup magma_copyvector
+*******************************************************************************/
+extern "C" void
+magma_copyvector_async_internal(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx_src, magma_int_t incx,
+    magma_ptr       dy_dst, magma_int_t incy,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(n)*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy1d( n, elemSize, dx_src, incx, dy_dst, incy );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_setmatrix( m, n, elemSize, hA_src, lda, dB_dst, lddb, queue )
+
+    Copy all or part of matrix hA_src on CPU host to dB_dst on the device,
+    which in the CPU backend is host memory.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_setmatrix_async() for an asynchronous version.
+
+    @param[in]
+    m           Number of rows of matrix A. m >= 0.
+
+    @param[in]
+    n           Number of columns of matrix A. n >= 0.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    hA_src      Source array of dimension (lda,n), on CPU host.
+
+    @param[in]
+    lda         Leading dimension of matrix A. lda >= m.
+
+    @param[out]
+    dB_dst      Destination array of dimension (lddb,n), on device.
+
+    @param[in]
+    lddb        Leading dimension of matrix B. lddb >= m.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_setmatrix
+*******************************************************************************/
+extern "C" void
+magma_setmatrix_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    void const* hA_src, magma_int_t lda,
+    magma_ptr   dB_dst, magma_int_t lddb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_setmatrix_async_internal( m, n, elemSize, hA_src, lda, dB_dst, lddb,
+                                    queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_setmatrix_async( m, n, elemSize, hA_src, lda, dB_dst, lddb, queue )
+
+    Asynchronous version of magma_setmatrix(): it may return before the
+    copy finishes, so hA_src must not be changed until the queue is synced.
+
+    @ingroup magma_setmatrix
+*******************************************************************************/
+extern "C" void
+magma_setmatrix_async_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    void const* hA_src, magma_int_t lda,
+    magma_ptr   dB_dst, magma_int_t lddb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(m)*n*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy2d( m, n, elemSize, hA_src, lda, dB_dst, lddb );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_getmatrix( m, n, elemSize, dA_src, ldda, hB_dst, ldb, queue )
+
+    Copy all or part of matrix dA_src on the device, which in the CPU
+    backend is host memory, to hB_dst on CPU host.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_getmatrix_async() for an asynchronous version.
+
+    @param[in]
+    m           Number of rows of matrix A. m >= 0.
+
+    @param[in]
+    n           Number of columns of matrix A. n >= 0.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    dA_src      Source array of dimension (ldda,n), on device.
+
+    @param[in]
+    ldda        Leading dimension of matrix A. ldda >= m.
+
+    @param[out]
+    hB_dst      Destination array of dimension (ldb,n), on CPU host.
+
+    @param[in]
+    ldb         Leading dimension of matrix B. ldb >= m.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_getmatrix
+*******************************************************************************/
+extern "C" void
+magma_getmatrix_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dA_src, magma_int_t ldda,
+    void*           hB_dst, magma_int_t ldb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_getmatrix_async_internal( m, n, elemSize, dA_src, ldda, hB_dst, ldb,
+                                    queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_getmatrix_async( m, n, elemSize, dA_src, ldda, hB_dst, ldb, queue )
+
+    Asynchronous version of magma_getmatrix(): it may return before the
+    copy finishes, so hB_dst must not be read until the queue is synced.
+
+    @ingroup magma_getmatrix
+*******************************************************************************/
+extern "C" void
+magma_getmatrix_async_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dA_src, magma_int_t ldda,
+    void*           hB_dst, magma_int_t ldb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(m)*n*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy2d( m, n, elemSize, dA_src, ldda, hB_dst, ldb );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_copymatrix( m, n, elemSize, dA_src, ldda, dB_dst, lddb, queue )
+
+    Copy all or part of matrix dA_src on the device to dB_dst on the device;
+    in the CPU backend, both are host memory.
+    Elements may be arbitrary size.
+    Type-safe versions set elemSize appropriately.
+
+    This version synchronizes the queue after the transfer.
+    See magma_copymatrix_async() for an asynchronous version.
+
+    @param[in]
+    m           Number of rows of matrix A. m >= 0.
+
+    @param[in]
+    n           Number of columns of matrix A. n >= 0.
+
+    @param[in]
+    elemSize    Size of each element, e.g., sizeof(double).
+
+    @param[in]
+    dA_src      Source array of dimension (ldda,n), on device.
+
+    @param[in]
+    ldda        Leading dimension of matrix A. ldda >= m.
+
+    @param[out]
+    dB_dst      Destination array of dimension (lddb,n), on device.
+
+    @param[in]
+    lddb        Leading dimension of matrix B. lddb >= m.
+
+    @param[in]
+    queue       Queue to execute in.
+
+    @ingroup magma_copymatrix
+*******************************************************************************/
+extern "C" void
+magma_copymatrix_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dA_src, magma_int_t ldda,
+    magma_ptr       dB_dst, magma_int_t lddb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    magma_copymatrix_async_internal( m, n, elemSize, dA_src, ldda, dB_dst, lddb,
+                                     queue, func, file, line );
+    magma_queue_sync_internal( queue, func, file, line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_copymatrix_async( m, n, elemSize, dA_src, ldda, dB_dst, lddb, queue )
+
+    Asynchronous version of magma_copymatrix(): it may return before the
+    copy finishes.
+
+    @ingroup magma_copymatrix
+*******************************************************************************/
+extern "C" void
+magma_copymatrix_async_internal(
+    magma_int_t m, magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dA_src, magma_int_t ldda,
+    magma_ptr       dB_dst, magma_int_t lddb,
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    trace_counter( "bytes moved", double(m)*n*elemSize );
+    magma_host_enqueue( queue, [=]() {
+        magma_host_memcpy2d( m, n, elemSize, dA_src, ldda, dB_dst, lddb );
+    });
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+#endif // MAGMA_HAVE_CPU
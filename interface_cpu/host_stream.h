@@ -0,0 +1,58 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_HOST_STREAM_H
+#define MAGMA_HOST_STREAM_H
+
+// STL headers before magma_internal.h, which defines min and max
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "thread_queue.hpp"
+
+
+/***************************************************************************//**
+    Execution stream of a queue in the CPU backend.
+    Each operation on the queue is a task on MAGMA's shared thread pool that
+    depends on the previous task of the same queue, so operations execute in
+    order, asynchronously to the calling thread, and concurrently with
+    operations on other queues, the same as on a CUDA stream.
+
+    @ingroup magma_queue
+*******************************************************************************/
+struct magma_host_stream
+{
+    magma_thread_queue tasks;
+    magma_task_handle  last;    ///< last task pushed; the next task depends on it
+    std::mutex         mutex;   ///< mutex lock for last
+};
+
+
+/***************************************************************************//**
+    Event in the CPU backend: the last task of the queue it was recorded in.
+    A timed event records a task of its own, which stores the time it ran;
+    the task holds a reference, in case the event is destroyed first.
+    @ingroup magma_event
+*******************************************************************************/
+struct magma_event
+{
+    magma_task_handle  handle;
+    std::shared_ptr< double > time;  ///< time it triggered; NULL if untimed
+    std::mutex         mutex;   ///< mutex lock for handle
+};
+
+
+/******************************************************************************/
+// Appends func to the queue's stream; with a NULL queue, executes it now.
+void magma_host_enqueue( magma_queue_t queue, std::function< void() > func );
+
+// Waits for all operations on all queues to finish.
+void magma_host_sync_all();
+
+#endif // MAGMA_HOST_STREAM_H
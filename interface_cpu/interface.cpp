@@ -0,0 +1,833 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#if defined(MAGMA_WITH_MKL)
+#include <mkl_service.h>
+#endif
+
+#if defined(MAGMA_WITH_ACML)
+#include <acml.h>
+#endif
+
+// defining MAGMA_LAPACK_H is a hack to NOT include magma_lapack.h
+// via magma_internal.h here, since it conflicts with acml.h and we don't
+// need lapack here, but we want acml.h for the acmlversion() function.
+#define MAGMA_LAPACK_H
+
+#include "host_stream.h"
+#include "error.h"
+
+#define MAX_BATCHCOUNT    (65534)
+
+#ifdef MAGMA_HAVE_CPU
+
+#ifdef DEBUG_MEMORY
+// defined in alloc.cpp
+extern std::map< void*, size_t > g_pointers_dev;
+extern std::map< void*, size_t > g_pointers_cpu;
+extern std::map< void*, size_t > g_pointers_pin;
+
+// -----------------------------------------------------------------------------
+// prototypes
+extern "C" void
+magma_warn_leaks( const std::map< void*, size_t >& pointers, const char* type );
+#endif
+
+
+// -----------------------------------------------------------------------------
+// globals
+static std::mutex g_mutex;
+
+// count of (init - finalize) calls
+static int g_init = 0;
+
+// streams of the queues alive; the thread pool grows to this many threads,
+// so every queue can progress concurrently. Shared ownership lets
+// magma_host_sync_all wait on a stream whose queue is destroyed meanwhile.
+static std::mutex g_streams_mutex;
+static std::map< magma_host_stream*, std::shared_ptr< magma_host_stream > >
+    g_streams;
+
+// device 0 is the host; the current device is always 0
+static const int g_magma_devices_cnt = 1;
+
+
+// -----------------------------------------------------------------------------
+// properties of the host, set by magma_init()
+struct magma_device_info
+{
+    size_t memory;
+    magma_int_t ncore;
+};
+
+static struct magma_device_info g_magma_device = { 0, 0 };
+
+
+/******************************************************************************/
+// Task executing one operation of a queue.
+class magma_host_task: public magma_task
+{
+public:
+    explicit magma_host_task( std::function< void() >&& in_func ):
+        func( std::move( in_func ))
+    {}
+
+    virtual void run() { func(); }
+
+private:
+    std::function< void() > func;
+};
+
+
+/***************************************************************************//**
+    Waits for all operations on all queues to finish, like
+    cudaDeviceSynchronize. Used before freeing memory, which may still be
+    used by queued operations.
+
+    @ingroup magma_queue
+*******************************************************************************/
+void magma_host_sync_all()
+{
+    // sync outside the lock: sync() runs pool tasks, which may create or
+    // destroy queues, or free memory, and so re-enter here
+    std::vector< std::shared_ptr< magma_host_stream > > streams;
+    {
+        std::lock_guard< std::mutex > lock( g_streams_mutex );
+        streams.reserve( g_streams.size() );
+        for (auto& entry : g_streams) {
+            streams.push_back( entry.second );
+        }
+    }
+    for (auto& stream : streams) {
+        stream->tasks.sync();
+    }
+}
+
+
+/***************************************************************************//**
+    Appends an operation to the queue's stream. It starts after all
+    operations previously appended to the queue, and events the queue was
+    told to wait for, have finished.
+    With a NULL queue, the calling thread waits for all queues, then executes
+    the operation immediately, like on the legacy NULL stream in CUDA.
+
+    @param[in]
+    queue       Queue to execute in, or NULL.
+
+    @param[in]
+    func        Operation, with its arguments captured by value.
+
+    @ingroup magma_queue
+*******************************************************************************/
+void magma_host_enqueue( magma_queue_t queue, std::function< void() > func )
+{
+    if ( queue == NULL ) {
+        magma_host_sync_all();
+        func();
+        return;
+    }
+    magma_host_stream* stream = queue->host_stream();
+    std::lock_guard< std::mutex > lock( stream->mutex );
+    stream->last = stream->tasks.push_task(
+        new magma_host_task( std::move( func )), stream->last );
+}
+
+
+// =============================================================================
+// initialization
+
+/***************************************************************************//**
+    Initializes the MAGMA library.
+    In the CPU backend, there is one device, the host, with device memory
+    in host memory. This caches the amount of memory and number of cores.
+
+    Every magma_init call must be paired with a magma_finalize call.
+    Only one thread needs to call magma_init and magma_finalize,
+    but every thread may call it. If n threads call magma_init,
+    the n-th call to magma_finalize will release resources.
+
+    @retval MAGMA_SUCCESS
+
+    @see magma_finalize
+
+    @ingroup magma_init
+*******************************************************************************/
+extern "C" magma_int_t
+magma_init()
+{
+    std::lock_guard< std::mutex > lock( g_mutex );
+    if ( g_init == 0 ) {
+        long pages    = sysconf( _SC_PHYS_PAGES );
+        long pagesize = sysconf( _SC_PAGESIZE );
+        long ncore    = sysconf( _SC_NPROCESSORS_ONLN );
+        g_magma_device.memory = (pages > 0 && pagesize > 0 ? size_t(pages) * size_t(pagesize) : 0);
+        g_magma_device.ncore  = (ncore > 0 ? ncore : 1);
+    }
+    g_init += 1;  // increment (init - finalize) count
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Frees information used by the MAGMA library.
+    @see magma_init
+
+    @ingroup magma_init
+*******************************************************************************/
+extern "C" magma_int_t
+magma_finalize()
+{
+    magma_int_t info = 0;
+
+    std::lock_guard< std::mutex > lock( g_mutex );
+    if ( g_init <= 0 ) {
+        info = MAGMA_ERR_NOT_INITIALIZED;
+    }
+    else {
+        g_init -= 1;  // decrement (init - finalize) count
+        #ifdef DEBUG_MEMORY
+        if ( g_init == 0 ) {
+            magma_warn_leaks( g_pointers_dev, "device" );
+            magma_warn_leaks( g_pointers_cpu, "CPU" );
+            magma_warn_leaks( g_pointers_pin, "CPU pinned" );
+        }
+        #endif
+    }
+    return info;
+}
+
+
+// =============================================================================
+// testing and debugging support
+
+#ifdef DEBUG_MEMORY
+/***************************************************************************//**
+    If DEBUG_MEMORY is defined at compile time, prints warnings when
+    magma_finalize() is called for any device, CPU, or CPU pinned
+    allocations that were not freed.
+
+    @param[in]
+    pointers    Hash table mapping allocated pointers to size.
+
+    @param[in]
+    type        String describing type of pointers (device, CPU, etc.)
+
+    @ingroup magma_testing
+*******************************************************************************/
+extern "C" void
+magma_warn_leaks( const std::map< void*, size_t >& pointers, const char* type )
+{
+    if ( pointers.size() > 0 ) {
+        fprintf( stderr, "Warning: MAGMA detected memory leak of %llu %s pointers:\n",
+                 (long long unsigned) pointers.size(), type );
+        std::map< void*, size_t >::const_iterator iter;
+        for( iter = pointers.begin(); iter != pointers.end(); ++iter ) {
+            fprintf( stderr, "    pointer %p, size %lu\n", iter->first, iter->second );
+        }
+    }
+}
+#endif
+
+
+/***************************************************************************//**
+    Print MAGMA version, backend, LAPACK/BLAS library version,
+    number of threads, date, etc.
+    Used in testing.
+    @ingroup magma_testing
+*******************************************************************************/
+extern "C" void
+magma_print_environment()
+{
+    magma_int_t major, minor, micro;
+    magma_version( &major, &minor, &micro );
+
+    printf( "%% MAGMA %lld.%lld.%lld %s %lld-bit magma_int_t, %lld-bit pointer.\n",
+            (long long) major, (long long) minor, (long long) micro,
+            MAGMA_VERSION_STAGE,
+            (long long) (8*sizeof(magma_int_t)),
+            (long long) (8*sizeof(void*)) );
+
+    printf( "%% Compiled for the CPU backend; device memory is host memory. " );
+
+/* OpenMP */
+
+#if defined(_OPENMP)
+    int omp_threads = 0;
+    #pragma omp parallel
+    {
+        omp_threads = omp_get_num_threads();
+    }
+    printf( "OpenMP threads %d. ", omp_threads );
+#else
+    printf( "MAGMA not compiled with OpenMP. " );
+#endif
+
+#if defined(MAGMA_WITH_MKL)
+    MKLVersion mkl_version;
+    mkl_get_version( &mkl_version );
+    printf( "MKL %d.%d.%d, MKL threads %d. ",
+            mkl_version.MajorVersion,
+            mkl_version.MinorVersion,
+            mkl_version.UpdateVersion,
+            mkl_get_max_threads() );
+#endif
+
+#if defined(MAGMA_WITH_ACML)
+    // ACML 4 doesn't have acml_build parameter
+    int acml_major, acml_minor, acml_patch, acml_build;
+    acmlversion( &acml_major, &acml_minor, &acml_patch, &acml_build );
+    printf( "ACML %d.%d.%d.%d ", acml_major, acml_minor, acml_patch, acml_build );
+#endif
+
+    printf( "\n" );
+
+    // print device
+    printf( "%% device 0: host, %lld cores, %.1f MiB memory\n",
+            (long long) g_magma_device.ncore,
+            g_magma_device.memory / (1024.*1024.) );
+
+    time_t t = time( NULL );
+    printf( "%% %s", ctime( &t ));
+}
+
+
+/***************************************************************************//**
+    For debugging purposes, determines whether a pointer points to CPU or
+    device memory. In the CPU backend, device memory is host memory;
+    if DEBUG_MEMORY is defined, pointers allocated by magma_malloc() are
+    known to be device pointers.
+
+    @param[in] A    pointer to test
+
+    @return  1:  if A is a device pointer (definitely),
+    @return  0:  if A is a host   pointer (definitely),
+    @return -1:  if unknown.
+
+    @ingroup magma_util
+*******************************************************************************/
+extern "C" magma_int_t
+magma_is_devptr( const void* A )
+{
+    #ifdef DEBUG_MEMORY
+    if ( g_pointers_dev.count( const_cast<void*>( A )) > 0 ) {
+        return 1;
+    }
+    if ( g_pointers_cpu.count( const_cast<void*>( A )) > 0 ||
+         g_pointers_pin.count( const_cast<void*>( A )) > 0 ) {
+        return 0;
+    }
+    #endif
+    MAGMA_UNUSED( A );
+    return -1;
+}
+
+
+// =============================================================================
+// device support
+
+/***************************************************************************//**
+    Returns the device architecture, which is 0 for the host.
+    @return 0.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" magma_int_t
+magma_getdevice_arch()
+{
+    return 0;
+}
+
+
+/***************************************************************************//**
+    Fills in devices array with the available devices; in the CPU backend,
+    only the host, device 0.
+
+    @param[out]
+    devices     Array of dimension (size).
+                On output, devices[0, ..., num_dev-1] contain device IDs.
+                Entries >= num_dev are not touched.
+
+    @param[in]
+    size        Dimension of the array devices.
+
+    @param[out]
+    num_dev     Number of devices, limited to size.
+
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" void
+magma_getdevices(
+    magma_device_t* devices,
+    magma_int_t  size,
+    magma_int_t* num_dev )
+{
+    magma_int_t cnt = min( magma_int_t(g_magma_devices_cnt), size );
+    for( magma_int_t i = 0; i < cnt; ++i ) {
+        devices[i] = i;
+    }
+    *num_dev = cnt;
+}
+
+
+/***************************************************************************//**
+    Get the current device, which is always the host, device 0.
+
+    @param[out]
+    device      On output, device ID of the current device.
+
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" void
+magma_getdevice( magma_device_t* device )
+{
+    *device = 0;
+}
+
+
+/***************************************************************************//**
+    Set the current device. Only device 0, the host, exists.
+
+    @param[in]
+    device      Device ID to set as the current device.
+
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" void
+magma_setdevice( magma_device_t device )
+{
+    if ( device != 0 ) {
+        check_error( MAGMA_ERR_ILLEGAL_VALUE );
+    }
+}
+
+
+/***************************************************************************//**
+    Returns the number of CPU cores, the host's analog of multiprocessors.
+    This requires magma_init() to be called first to cache the information.
+    @return the number of cores.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" magma_int_t
+magma_getdevice_multiprocessor_count()
+{
+    if ( g_init <= 0 ) {
+        fprintf( stderr, "Error in %s: MAGMA not initialized (call magma_init() first)\n", __func__ );
+        return 0;
+    }
+    return g_magma_device.ncore;
+}
+
+
+/***************************************************************************//**
+    The host executes each operation on one thread of the pool.
+    @return 1.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" magma_int_t
+magma_getdevice_num_threads_block()
+{
+    return 1;
+}
+
+
+/***************************************************************************//**
+    The host executes each operation on one thread of the pool.
+    @return 1.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" magma_int_t
+magma_getdevice_num_threads_multiprocessor()
+{
+    return 1;
+}
+
+
+/***************************************************************************//**
+    The host has no shared memory in the device sense.
+    @return 0.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" size_t
+magma_getdevice_shmem_block()
+{
+    return 0;
+}
+
+
+/***************************************************************************//**
+    The host has no shared memory in the device sense.
+    @return 0.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" size_t
+magma_getdevice_shmem_block_optin()
+{
+    return 0;
+}
+
+
+/***************************************************************************//**
+    The host has no shared memory in the device sense.
+    @return 0.
+    @ingroup magma_device
+*******************************************************************************/
+extern "C" size_t
+magma_getdevice_shmem_multiprocessor()
+{
+    return 0;
+}
+
+
+/***************************************************************************//**
+    @param[in]
+    queue           Queue to query.
+
+    @return         Amount of free host memory in bytes.
+
+    @ingroup magma_queue
+*******************************************************************************/
+extern "C" size_t
+magma_mem_size( magma_queue_t queue )
+{
+    MAGMA_UNUSED( queue );
+    long pages    = sysconf( _SC_AVPHYS_PAGES );
+    long pagesize = sysconf( _SC_PAGESIZE );
+    return (pages > 0 && pagesize > 0 ? size_t(pages) * size_t(pagesize) : 0);
+}
+
+
+// =============================================================================
+// queue support
+
+/***************************************************************************//**
+    @param[in]
+    queue       Queue to query.
+
+    @return Device ID associated with the MAGMA queue.
+
+    @ingroup magma_queue
+*******************************************************************************/
+extern "C"
+magma_int_t
+magma_queue_get_device( magma_queue_t queue )
+{
+    return queue->device();
+}
+
+
+/***************************************************************************//**
+    @fn magma_queue_create( device, queue_ptr )
+
+    magma_queue_create( device, queue_ptr ) is the preferred alias to this
+    function.
+
+    Creates a new MAGMA queue, with an associated host stream. Operations
+    on the queue execute in order on MAGMA's thread pool, which grows so
+    it has a thread for each queue.
+
+    @param[in]
+    device          Device to create queue on; must be 0, the host.
+
+    @param[out]
+    queue_ptr       On output, the newly created queue.
+
+    @ingroup magma_queue
+*******************************************************************************/
+extern "C" void
+magma_queue_create_internal(
+    magma_device_t device, magma_queue_t* queue_ptr,
+    const char* func, const char* file, int line )
+{
+    magma_queue_t queue;
+    magma_malloc_cpu( (void**)&queue, sizeof(*queue) );
+    assert( queue != NULL );
+    *queue_ptr = queue;
+
+    if ( device != 0 ) {
+        check_xerror( MAGMA_ERR_ILLEGAL_VALUE, func, file, line );
+    }
+    queue->own__      = 0;
+    queue->device__   = device;
+    queue->ptrArray__ = NULL;
+    queue->dAarray__  = NULL;
+    queue->dBarray__  = NULL;
+    queue->dCarray__  = NULL;
+    queue->maxbatch__ = MAX_BATCHCOUNT;
+
+    std::shared_ptr< magma_host_stream > stream
+        = std::make_shared< magma_host_stream >();
+    queue->stream__ = stream.get();
+    {
+        std::lock_guard< std::mutex > lock( g_streams_mutex );
+        g_streams[ stream.get() ] = stream;
+        stream->tasks.launch( g_streams.size() );
+    }
+
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_queue_destroy( queue )
+
+    Destroys a queue, after waiting for all its operations to finish.
+
+    @param[in]
+    queue           Queue to destroy.
+
+    @ingroup magma_queue
+*******************************************************************************/
+extern "C" void
+magma_queue_destroy_internal(
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    if ( queue != NULL ) {
+        if ( queue->stream__ != NULL ) {
+            // deleted when the last reference drops, which may be held by
+            // magma_host_sync_all in another thread
+            std::shared_ptr< magma_host_stream > stream;
+            {
+                std::lock_guard< std::mutex > lock( g_streams_mutex );
+                auto iter = g_streams.find( queue->stream__ );
+                if ( iter != g_streams.end() ) {
+                    stream = std::move( iter->second );
+                    g_streams.erase( iter );
+                }
+            }
+            queue->stream__->tasks.quit();
+        }
+        if ( queue->ptrArray__ != NULL ) magma_free( queue->ptrArray__ );
+
+        queue->own__      = 0;
+        queue->device__   = -1;
+        queue->stream__   = NULL;
+        queue->ptrArray__ = NULL;
+        queue->dAarray__  = NULL;
+        queue->dBarray__  = NULL;
+        queue->dCarray__  = NULL;
+
+        magma_free_cpu( queue );
+    }
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+/***************************************************************************//**
+    @fn magma_queue_sync( queue )
+
+    Synchronizes with a queue. The CPU blocks until all operations on the queue
+    are finished; while waiting, it executes queued operations itself.
+
+    @param[in]
+    queue           Queue to synchronize.
+
+    @ingroup magma_queue
+*******************************************************************************/
+extern "C" void
+magma_queue_sync_internal(
+    magma_queue_t queue,
+    const char* func, const char* file, int line )
+{
+    if ( queue != NULL ) {
+        queue->host_stream()->tasks.sync();
+    }
+    MAGMA_UNUSED( func );
+    MAGMA_UNUSED( file );
+    MAGMA_UNUSED( line );
+}
+
+
+// =============================================================================
+// event support
+
+/***************************************************************************//**
+    Creates an event.
+
+    @param[in]
+    event           On output, the newly created event.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_event_create( magma_event_t* event )
+{
+    *event = new magma_event;
+    (*event)->time = std::make_shared< double >( 0. );
+}
+
+
+/***************************************************************************//**
+    Creates an event, without timing support, so recording it adds no task
+    to the queue.
+
+    @param[in]
+    event           On output, the newly created event.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_event_create_untimed( magma_event_t* event )
+{
+    *event = new magma_event;
+}
+
+
+/***************************************************************************//**
+    Destroys an event, freeing its resources.
+
+    @param[in]
+    event           Event to destroy.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_event_destroy( magma_event_t event )
+{
+    delete event;
+}
+
+
+/***************************************************************************//**
+    Records an event into the queue's execution stream.
+    The event will trigger when all previous operations on this queue finish.
+
+    @param[in]
+    event           Event to record.
+
+    @param[in]
+    queue           Queue to execute in.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_event_record( magma_event_t event, magma_queue_t queue )
+{
+    magma_task_handle last;
+    if ( event->time && queue == NULL ) {
+        *event->time = magma_wtime();
+    }
+    else if ( event->time ) {
+        // a task that notes when the queue reached it
+        std::shared_ptr< double > time = event->time;
+        magma_host_enqueue( queue, [time]() { *time = magma_wtime(); } );
+    }
+    if ( queue != NULL ) {
+        magma_host_stream* stream = queue->host_stream();
+        std::lock_guard< std::mutex > lock( stream->mutex );
+        last = stream->last;
+    }
+    std::lock_guard< std::mutex > lock( event->mutex );
+    event->handle = last;
+}
+
+
+/***************************************************************************//**
+    Synchronizes with an event. The CPU blocks until the event triggers;
+    while waiting, it executes queued operations itself.
+
+    @param[in]
+    event           Event to synchronize with.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_event_sync( magma_event_t event )
+{
+    magma_task_handle handle;
+    {
+        std::lock_guard< std::mutex > lock( event->mutex );
+        handle = event->handle;
+    }
+    magma_thread_pool& pool = magma_thread_pool::instance();
+    while ( ! handle.done() ) {
+        if ( ! pool.run_one() ) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    Returns the time between two events, after waiting for end to trigger.
+    Both events must have been created with magma_event_create.
+
+    @param[in]
+    start           Event recorded first.
+
+    @param[in]
+    end             Event recorded second.
+
+    @return Elapsed time in milliseconds, as in cudaEventElapsedTime.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" float
+magma_event_elapsed( magma_event_t start, magma_event_t end )
+{
+    magma_event_sync( start );
+    magma_event_sync( end );
+    if ( ! start->time || ! end->time ) {
+        return 0;
+    }
+    return float( (*end->time - *start->time) * 1e3 );
+}
+
+
+/***************************************************************************//**
+    Synchronizes a queue with an event. The queue blocks until the event
+    triggers. The CPU does not block.
+
+    @param[in]
+    event           Event to synchronize with.
+
+    @param[in]
+    queue           Queue to synchronize.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" void
+magma_queue_wait_event( magma_queue_t queue, magma_event_t event )
+{
+    magma_task_handle deps[2];
+    {
+        std::lock_guard< std::mutex > lock( event->mutex );
+        deps[1] = event->handle;
+    }
+    if ( queue == NULL ) {
+        magma_event_sync( event );
+        return;
+    }
+    // an empty task after the queue's last task and the event
+    magma_host_stream* stream = queue->host_stream();
+    std::lock_guard< std::mutex > lock( stream->mutex );
+    deps[0] = stream->last;
+    stream->last = stream->tasks.push_task(
+        new magma_host_task( []() {} ), deps, 2 );
+}
+
+#endif // MAGMA_HAVE_CPU
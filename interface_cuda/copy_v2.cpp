@@ -9,6 +9,7 @@
 */
 #include "magma_internal.h"
 #include "error.h"
+#include "trace.h"
 
 #include <cuda_runtime.h>
 
@@ -59,6 +60,7 @@ magma_setvector_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -117,6 +119,7 @@ magma_setvector_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     // for backwards compatability, accepts NULL queue to mean NULL stream.
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
@@ -176,6 +179,7 @@ magma_getvector_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -234,6 +238,7 @@ magma_getvector_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     // for backwards compatability, accepts NULL queue to mean NULL stream.
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
@@ -296,6 +301,7 @@ magma_copyvector_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -360,6 +366,7 @@ magma_copyvector_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(n)*elemSize );
     // for backwards compatability, accepts NULL queue to mean NULL stream.
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
@@ -428,6 +435,7 @@ magma_setmatrix_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -489,6 +497,7 @@ magma_setmatrix_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     // for backwards compatability, accepts NULL queue to mean NULL stream.
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
@@ -551,6 +560,7 @@ magma_getmatrix_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -612,6 +622,7 @@ magma_getmatrix_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -674,6 +685,7 @@ magma_copymatrix_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
         stream = queue->cuda_stream();
@@ -735,6 +747,7 @@ magma_copymatrix_async_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    trace_counter( "bytes moved", double(m)*n*elemSize );
     // for backwards compatability, accepts NULL queue to mean NULL stream.
     cudaStream_t stream = NULL;
     if ( queue != NULL ) {
@@ -39,6 +39,7 @@
 
 #include "magma_internal.h"
 #include "error.h"
+#include "trace.h"
 
 #define MAX_BATCHCOUNT    (65534)
 
@@ -1322,6 +1323,7 @@ magma_queue_sync_internal(
     magma_queue_t queue,
     const char* func, const char* file, int line )
 {
+    double start = (trace_enabled() ? magma_wtime() : 0);
     cudaError_t err;
     if ( queue != NULL ) {
         err = cudaStreamSynchronize( queue->cuda_stream() );
@@ -1331,6 +1333,9 @@ magma_queue_sync_internal(
     }
     check_xerror( err, func, file, line );
     MAGMA_UNUSED( err );
+    if ( start > 0 ) {
+        trace_counter( "queue wait (s)", magma_wtime() - start );
+    }
 }
 
 
@@ -1434,6 +1439,34 @@ magma_event_sync( magma_event_t event )
 }
 
 
+/***************************************************************************//**
+    Returns the time between two events, after waiting for end to trigger.
+    Both events must have been created with magma_event_create.
+
+    @param[in]
+    start           Event recorded first.
+
+    @param[in]
+    end             Event recorded second.
+
+    @return Elapsed time in milliseconds, as in cudaEventElapsedTime.
+
+    @ingroup magma_event
+*******************************************************************************/
+extern "C" float
+magma_event_elapsed( magma_event_t start, magma_event_t end )
+{
+    float time = 0;
+    cudaError_t err;
+    err = cudaEventSynchronize( end );
+    check_error( err );
+    err = cudaEventElapsedTime( &time, start, end );
+    check_error( err );
+    MAGMA_UNUSED( err );
+    return time;
+}
+
+
 /***************************************************************************//**
     Synchronizes a queue with an event. The queue blocks until the event
     triggers. The CPU does not block.
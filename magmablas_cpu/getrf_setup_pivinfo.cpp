@@ -0,0 +1,60 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+/***************************************************************************//**
+    Converts the nb 1-based pivots in ipiv, relative to the m rows of the
+    panel, to the 1-based permutation pivinfo of length m used by
+    magma_zlaswp_rowparallel_native. Host version of the CUDA kernel.
+
+    @ingroup magma_getrf_batched
+*******************************************************************************/
+extern "C" void
+setup_pivinfo( magma_int_t *pivinfo, magma_int_t *ipiv,
+                 magma_int_t m, magma_int_t nb,
+                 magma_queue_t queue)
+{
+    if (nb == 0 ) return;
+
+    magma_host_enqueue( queue, [=]() {
+        for (magma_int_t i = 0; i < m; ++i) {
+            pivinfo[i] = i + 1;
+        }
+        for (magma_int_t i = 0; i < nb && i < m; ++i) {
+            magma_int_t r = ipiv[i] - 1;
+            magma_int_t tmp = pivinfo[r];
+            pivinfo[r] = pivinfo[i];
+            pivinfo[i] = tmp;
+        }
+    });
+}
+
+
+/***************************************************************************//**
+    Adds offset to the first m pivots in ipiv. Host version of the CUDA kernel.
+
+    @ingroup magma_getrf_batched
+*******************************************************************************/
+extern "C" void
+adjust_ipiv( magma_int_t *ipiv,
+                 magma_int_t m, magma_int_t offset,
+                 magma_queue_t queue)
+{
+    if (offset == 0 ) return;
+
+    magma_host_enqueue( queue, [=]() {
+        for (magma_int_t i = 0; i < m; ++i) {
+            ipiv[i] += offset;
+        }
+    });
+}
+
+#endif // MAGMA_HAVE_CPU
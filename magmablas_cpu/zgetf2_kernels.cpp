@@ -0,0 +1,122 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+// Host versions of the kernels of magma_zgetf2_native. The pivots and info
+// live in "device" memory, which here is host memory read and written by
+// the queued tasks, so the calling thread never waits for them.
+
+/******************************************************************************/
+extern "C" magma_int_t
+magma_izamax_native(
+    magma_int_t length,
+    magmaDoubleComplex_ptr x, magma_int_t incx,
+    magma_int_t* ipiv, magma_int_t *info,
+    magma_int_t step, magma_int_t gbstep, magma_queue_t queue)
+{
+    if (length == 0 ) return 0;
+
+    magma_host_enqueue( queue, [=]() {
+        magma_int_t idx  = 0;
+        double      xmax = MAGMA_Z_ABS1( x[0] );
+        for (magma_int_t i = 1; i < length; ++i) {
+            double xi = MAGMA_Z_ABS1( x[ i*incx ] );
+            if ( xi > xmax ) {
+                xmax = xi;
+                idx  = i;
+            }
+        }
+        // as in the kernel: the first zero pivot of the factorization wins
+        magma_int_t linfo = ( (gbstep+step) == 0 ) ? 0 : *info;
+        *ipiv = idx + step + 1;  // Fortran Indexing
+        if ( xmax == 0 && linfo == 0 ) {
+            linfo = idx + step + gbstep + 1;
+        }
+        *info = linfo;
+    });
+    return 0;
+}
+
+
+/******************************************************************************/
+extern "C" void
+magma_zswap_native( magma_int_t n, magmaDoubleComplex_ptr x, magma_int_t incx,
+                    magma_int_t step, magma_int_t* ipiv,
+                    magma_queue_t queue)
+{
+    /*
+    zswap two row: (ipiv[step]-1)th and step th
+    */
+    magma_host_enqueue( queue, [=]() {
+        magma_int_t jp = ipiv[step] - 1;
+        if ( jp != step ) {
+            blasf77_zswap( &n, x + jp, &incx, x + step, &incx );
+        }
+    });
+}
+
+
+/******************************************************************************/
+extern "C"
+magma_int_t
+magma_zscal_zgeru_native(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, magma_int_t lda,
+    magma_int_t *info, magma_int_t step, magma_int_t gbstep,
+    magma_queue_t queue)
+{
+    /*
+    1) zscale the first column vector A(1:M-1,0) with 1/A(0,0), or 1 if
+       A(0,0) is zero, as the kernel does;
+    2) zgeru on the trailing matrix A(1:M-1,1:N-1) -= x*y**T, where
+       x := A(1:M-1,0) and y := A(0,1:N-1);
+    */
+    if ( n == 0) return 0;
+
+    magma_host_enqueue( queue, [=]() {
+        const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+        magma_int_t m1 = m - 1;
+        magma_int_t n1 = n - 1;
+        if ( m1 <= 0 ) {
+            return;
+        }
+        magmaDoubleComplex reg = ( MAGMA_Z_ABS1( dA[0] ) == 0 )
+                               ? MAGMA_Z_ONE
+                               : MAGMA_Z_DIV( MAGMA_Z_ONE, dA[0] );
+        magma_int_t ione = 1;
+        blasf77_zscal( &m1, &reg, dA + 1, &ione );
+        if ( n1 > 0 ) {
+            blasf77_zgeru( &m1, &n1, &c_neg_one, dA + 1, &ione,
+                           dA + lda, &lda, dA + 1 + lda, &lda );
+        }
+    });
+    return 0;
+}
+
+
+/******************************************************************************/
+// B = L^{-1} * B, with L the m-by-m unit lower triangle of A
+extern "C" void
+magma_zgetf2trsm_2d_native(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, magma_int_t ldda,
+    magmaDoubleComplex_ptr dB, magma_int_t lddb,
+    magma_queue_t queue)
+{
+    magma_ztrsm( MagmaLeft, MagmaLower, MagmaNoTrans, MagmaUnit,
+                 m, n, MAGMA_Z_ONE,
+                 dA, ldda,
+                 dB, lddb, queue );
+}
+
+#endif // MAGMA_HAVE_CPU
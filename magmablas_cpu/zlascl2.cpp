@@ -0,0 +1,62 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+/***************************************************************************//**
+    ZLASCL2 scales the M by N complex matrix A by the real diagonal matrix dD.
+    TYPE specifies that A may be full, upper triangular, lower triangular.
+    Host version of the CUDA kernel, queued on the queue's stream; as in the
+    kernel, dD is read when the queue executes the scaling.
+
+    Arguments are the same as the CUDA version.
+
+    @see magma_zlascl_diag
+    @ingroup magma_lascl_diag
+*******************************************************************************/
+extern "C" void
+magmablas_zlascl2(
+    magma_type_t type, magma_int_t m, magma_int_t n,
+    magmaDouble_const_ptr dD,
+    magmaDoubleComplex_ptr dA, magma_int_t ldda,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    *info = 0;
+    if ( type != MagmaLower && type != MagmaUpper && type != MagmaFull )
+        *info = -1;
+    else if ( m < 0 )
+        *info = -2;
+    else if ( n < 0 )
+        *info = -3;
+    else if ( ldda < max(1,m) )
+        *info = -5;
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return;  //info;
+    }
+
+    magma_host_enqueue( queue, [=]() {
+        // column by column; row i is scaled in columns j <= i for lower,
+        // j >= i for upper
+        for (magma_int_t j = 0; j < n; ++j) {
+            magma_int_t i0 = (type == MagmaLower ? j : 0);
+            magma_int_t i1 = (type == MagmaUpper ? min( m, j+1 ) : m);
+            for (magma_int_t i = i0; i < i1; ++i) {
+                dA[ i + j*ldda ] *= dD[i];
+            }
+        }
+    });
+}
+
+#endif // MAGMA_HAVE_CPU
@@ -0,0 +1,160 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+// STL headers before magma_internal.h, which defines min and max
+#include <vector>
+
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+/***************************************************************************//**
+    Purpose:
+    =============
+    ZLASWP performs a series of row interchanges on the matrix A.
+    One row interchange is initiated for each of rows K1 through K2 of A.
+
+    ** Unlike LAPACK, here A is stored row-wise (hence dAT). **
+    Otherwise, this is identical to LAPACK's interface.
+
+    Host version of the CUDA kernel. As a kernel launch does, the pivots
+    are copied when the routine is called, so ipiv may be changed before the
+    queue executes the swaps. Each swap is a contiguous row, done with zswap.
+
+    Arguments are the same as the CUDA version.
+
+    @ingroup magma_laswp
+*******************************************************************************/
+extern "C" void
+magmablas_zlaswp(
+    magma_int_t n,
+    magmaDoubleComplex_ptr dAT, magma_int_t ldda,
+    magma_int_t k1, magma_int_t k2,
+    const magma_int_t *ipiv, magma_int_t inci,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( n < 0 )
+        info = -1;
+    else if ( n > ldda )
+        info = -3;
+    else if ( k1 < 1 )
+        info = -4;
+    else if ( k2 < 1 )
+        info = -5;
+    else if ( inci <= 0 )
+        info = -7;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return;  //info;
+    }
+
+    if ( n == 0 || k2 < k1 )
+        return;
+
+    // 0-based pivots of rows k1-1 .. k2-1
+    std::vector< magma_int_t > piv( k2 - k1 + 1 );
+    for (magma_int_t k = k1-1; k < k2; ++k) {
+        piv[ k - (k1-1) ] = ipiv[ k*inci ] - 1;
+    }
+
+    magma_host_enqueue( queue, [=]() {
+        const magma_int_t ione = 1;
+        for (magma_int_t k = k1-1; k < k2; ++k) {
+            magma_int_t k2p = piv[ k - (k1-1) ];
+            if ( k2p != k ) {
+                blasf77_zswap( &n, dAT + k*ldda, &ione, dAT + k2p*ldda, &ione );
+            }
+        }
+    });
+}
+
+
+/***************************************************************************//**
+    Row-parallel swap used by the native LU panel. With height = k2 - k1 and
+    the 1-based permutation pivinfo, row i of output, for i < height, gets
+    row pivinfo[i]-1 of input, and that input row gets row
+    pivinfo[pivinfo[i]-1]-1. Host version of the CUDA kernel: all rows are
+    read before any is written, the same as the kernel's shared memory.
+
+    @ingroup magma_laswp
+*******************************************************************************/
+extern "C" void
+magma_zlaswp_rowparallel_native(
+    magma_int_t n,
+    magmaDoubleComplex* input, magma_int_t ldi,
+    magmaDoubleComplex* output, magma_int_t ldo,
+    magma_int_t k1, magma_int_t k2,
+    magma_int_t *pivinfo,
+    magma_queue_t queue)
+{
+    if (n == 0 ) return;
+    magma_int_t height = k2 - k1;
+    if ( height <= 0 ) return;
+
+    magma_host_enqueue( queue, [=]() {
+        std::vector< magmaDoubleComplex > orig( height ), repl( height );
+        for (magma_int_t j = 0; j < n; ++j) {
+            magmaDoubleComplex *in  = input  + j*ldi;
+            magmaDoubleComplex *out = output + j*ldo;
+            for (magma_int_t i = 0; i < height; ++i) {
+                magma_int_t r = pivinfo[i] - 1;
+                orig[i] = in[ r ];
+                repl[i] = in[ pivinfo[r] - 1 ];
+            }
+            for (magma_int_t i = 0; i < height; ++i) {
+                in[ pivinfo[i] - 1 ] = repl[i];
+            }
+            for (magma_int_t i = 0; i < height; ++i) {
+                out[i] = orig[i];
+            }
+        }
+    });
+}
+
+
+/***************************************************************************//**
+    Serial swap of rows k1 to k2 (1-based, in either direction) of dA, which
+    is stored row-wise with rows of n contiguous elements, using the 1-based
+    pivots in dipiv. Unlike magmablas_zlaswp, dipiv is read when the queue
+    executes the swaps. Host version of the CUDA kernel.
+
+    @ingroup magma_laswp
+*******************************************************************************/
+extern "C" void
+magma_zlaswp_columnserial(
+    magma_int_t n, magmaDoubleComplex_ptr dA, magma_int_t lda,
+    magma_int_t k1, magma_int_t k2,
+    magma_int_t *dipiv, magma_queue_t queue)
+{
+    if ( n == 0 ) return;
+
+    magma_int_t i1 = k1 - 1;
+    magma_int_t i2 = k2 - 1;
+    if ( i1 < 0 || i2 < 0 ) return;
+
+    magma_host_enqueue( queue, [=]() {
+        // as in the kernel, each of the n columns does all its swaps in turn
+        magma_int_t inc = (i1 <= i2 ? 1 : -1);
+        for (magma_int_t j = 0; j < n; ++j) {
+            for (magma_int_t i = i1; i != i2 + inc; i += inc) {
+                magma_int_t ip = dipiv[i] - 1;
+                if ( ip != i ) {
+                    magmaDoubleComplex tmp = dA[ i*lda + j ];
+                    dA[ i*lda + j ]  = dA[ ip*lda + j ];
+                    dA[ ip*lda + j ] = tmp;
+                }
+            }
+        }
+    });
+}
+
+#endif // MAGMA_HAVE_CPU
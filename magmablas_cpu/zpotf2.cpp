@@ -0,0 +1,99 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#ifdef MAGMA_HAVE_CPU
+
+/******************************************************************************/
+// Factors the n-by-n block with LAPACK, unless an earlier block already
+// failed; a failure at column k sets *dinfo = gbstep + k, as the kernels do.
+static void
+zpotf2_host(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex *dA, magma_int_t ldda, magma_int_t gbstep,
+    magma_int_t *dinfo, magma_queue_t queue )
+{
+    magma_host_enqueue( queue, [=]() {
+        if ( *dinfo != 0 ) {
+            return;
+        }
+        magma_int_t iinfo = 0;
+        lapackf77_zpotrf( lapack_uplo_const( uplo ), &n, dA, &ldda, &iinfo );
+        if ( iinfo > 0 ) {
+            *dinfo = gbstep + iinfo;
+        }
+    });
+}
+
+
+/***************************************************************************//**
+    zpotf2 computes the Cholesky factorization of a real symmetric
+    positive definite matrix A, with the status of the factorization in
+    device_info. Host version of the CUDA routine: the block is factored by
+    LAPACK's zpotrf on the queue's stream. Arguments are the same as the
+    CUDA version.
+
+    @ingroup magma_potf2
+*******************************************************************************/
+extern "C" magma_int_t
+magma_zpotf2_native(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr dA, magma_int_t ldda,
+    magma_int_t step, magma_int_t *device_info,
+    magma_queue_t queue )
+{
+    magma_int_t arginfo = 0;
+    if ( uplo != MagmaUpper && uplo != MagmaLower) {
+        arginfo = -1;
+    } else if (n < 0) {
+        arginfo = -2;
+    } else if (ldda < max(1,n)) {
+        arginfo = -4;
+    }
+
+    if (arginfo != 0) {
+        magma_xerbla( __func__, -(arginfo) );
+        return arginfo;
+    }
+
+    // Quick return if possible
+    if (n == 0) {
+        return arginfo;
+    }
+
+    zpotf2_host( uplo, n, dA, ldda, step, device_info, queue );
+    return arginfo;
+}
+
+
+/***************************************************************************//**
+    Cholesky panel of the native zpotrf, lower triangle, with the status of
+    the factorization in dinfo. Host version of the CUDA kernels.
+
+    @ingroup magma_potf2
+*******************************************************************************/
+extern "C" magma_int_t
+magma_zpotf2_lpin(
+        magma_uplo_t uplo, magma_int_t n,
+        magmaDoubleComplex *dA, magma_int_t ldda, magma_int_t gbstep,
+        magma_int_t *dinfo, magma_queue_t queue)
+{
+    magma_int_t arginfo = 0;
+    // Quick return if possible
+    if ( n == 0 ) {
+        return arginfo;
+    }
+
+    zpotf2_host( uplo, n, dA, ldda, gbstep, dinfo, queue );
+    return arginfo;
+}
+
+#endif // MAGMA_HAVE_CPU
@@ -0,0 +1,207 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "host_stream.h"
+#include "magma_internal.h"
+
+#define COMPLEX
+
+#ifdef MAGMA_HAVE_CPU
+
+// tile size; a tile of the source and of the destination fit in L1 cache
+#define NB 32
+
+
+/******************************************************************************/
+// dAT = dA^T (or dA^H with conj), by NB x NB tiles
+static void
+ztranspose_host(
+    bool conj, magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *dA,  magma_int_t ldda,
+    magmaDoubleComplex       *dAT, magma_int_t lddat )
+{
+    for (magma_int_t j0 = 0; j0 < n; j0 += NB) {
+        magma_int_t j1 = min( n, j0 + NB );
+        for (magma_int_t i0 = 0; i0 < m; i0 += NB) {
+            magma_int_t i1 = min( m, i0 + NB );
+            for (magma_int_t j = j0; j < j1; ++j) {
+                for (magma_int_t i = i0; i < i1; ++i) {
+                    magmaDoubleComplex a = dA[ i + j*ldda ];
+                    dAT[ j + i*lddat ] = (conj ? MAGMA_Z_CONJ( a ) : a);
+                }
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+// dA = dA^T (or dA^H with conj), swapping across the diagonal
+static void
+ztranspose_inplace_host(
+    bool conj, magma_int_t n,
+    magmaDoubleComplex *dA, magma_int_t ldda )
+{
+    for (magma_int_t j = 0; j < n; ++j) {
+        for (magma_int_t i = 0; i < j; ++i) {
+            magmaDoubleComplex a = dA[ i + j*ldda ];
+            magmaDoubleComplex b = dA[ j + i*ldda ];
+            dA[ i + j*ldda ] = (conj ? MAGMA_Z_CONJ( b ) : b);
+            dA[ j + i*ldda ] = (conj ? MAGMA_Z_CONJ( a ) : a);
+        }
+        if ( conj ) {
+            dA[ j + j*ldda ] = MAGMA_Z_CONJ( dA[ j + j*ldda ] );
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    ztranspose copies and transposes a matrix dA to matrix dAT,
+    dAT = dA^T. Host version of the CUDA kernel, queued on the queue's stream.
+    Same as ztranspose_conj, but without the conjugate.
+
+    @ingroup magma_transpose
+*******************************************************************************/
+extern "C" void
+magmablas_ztranspose(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_const_ptr dA,  magma_int_t ldda,
+    magmaDoubleComplex_ptr       dAT, magma_int_t lddat,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( m < 0 )
+        info = -1;
+    else if ( n < 0 )
+        info = -2;
+    else if ( ldda < m )
+        info = -4;
+    else if ( lddat < n )
+        info = -6;
+
+    if ( info != 0 ) {
+        magma_xerbla( __func__, -(info) );
+        return;  //info;
+    }
+
+    /* Quick return */
+    if ( (m == 0) || (n == 0) )
+        return;
+
+    magma_host_enqueue( queue, [=]() {
+        ztranspose_host( false, m, n, dA, ldda, dAT, lddat );
+    });
+}
+
+
+/***************************************************************************//**
+    ztranspose_inplace transposes a square N-by-N matrix in-place,
+    dA = dA^T. Host version of the CUDA kernel.
+
+    @ingroup magma_transpose
+*******************************************************************************/
+extern "C" void
+magmablas_ztranspose_inplace(
+    magma_int_t n,
+    magmaDoubleComplex_ptr dA, magma_int_t ldda,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( n < 0 )
+        info = -1;
+    else if ( ldda < n )
+        info = -3;
+
+    if ( info != 0 ) {
+        magma_xerbla( __func__, -(info) );
+        return;  //info;
+    }
+
+    if ( n == 0 )
+        return;
+
+    magma_host_enqueue( queue, [=]() {
+        ztranspose_inplace_host( false, n, dA, ldda );
+    });
+}
+
+
+#ifdef COMPLEX
+/***************************************************************************//**
+    ztranspose_conj copies and conjugate-transposes a matrix dA to matrix
+    dAT, dAT = dA^H. Host version of the CUDA kernel.
+
+    @ingroup magma_transpose
+*******************************************************************************/
+extern "C" void
+magmablas_ztranspose_conj(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_const_ptr dA,  magma_int_t ldda,
+    magmaDoubleComplex_ptr       dAT, magma_int_t lddat,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( m < 0 )
+        info = -1;
+    else if ( n < 0 )
+        info = -2;
+    else if ( ldda < m )
+        info = -4;
+    else if ( lddat < n )
+        info = -6;
+
+    if ( info != 0 ) {
+        magma_xerbla( __func__, -(info) );
+        return;  //info;
+    }
+
+    /* Quick return */
+    if ( (m == 0) || (n == 0) )
+        return;
+
+    magma_host_enqueue( queue, [=]() {
+        ztranspose_host( true, m, n, dA, ldda, dAT, lddat );
+    });
+}
+
+
+/***************************************************************************//**
+    ztranspose_conj_inplace conjugate-transposes a square N-by-N matrix
+    in-place, dA = dA^H. Host version of the CUDA kernel.
+
+    @ingroup magma_transpose
+*******************************************************************************/
+extern "C" void
+magmablas_ztranspose_conj_inplace(
+    magma_int_t n,
+    magmaDoubleComplex_ptr dA, magma_int_t ldda,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if ( n < 0 )
+        info = -1;
+    else if ( ldda < n )
+        info = -3;
+
+    if ( info != 0 ) {
+        magma_xerbla( __func__, -(info) );
+        return;  //info;
+    }
+
+    if ( n == 0 )
+        return;
+
+    magma_host_enqueue( queue, [=]() {
+        ztranspose_inplace_host( true, n, dA, ldda );
+    });
+}
+#endif // COMPLEX
+
+#endif // MAGMA_HAVE_CPU
@@ -22,6 +22,7 @@
   #endif
 #endif
 
+#ifndef MAGMA_HAVE_CPU
 #if CUDA_VERSION >= 12000
   #define CUSPARSE_CSRMV_ALG2 CUSPARSE_SPMV_CSR_ALG2
   #define CUSPARSE_CSRMV_ALG1 CUSPARSE_SPMV_CSR_ALG1
@@ -92,6 +93,7 @@
         cusparseDestroyDnMat(descrY);                                                           \
     }
 #endif
+#endif // not MAGMA_HAVE_CPU
 
 /**
     Purpose
@@ -143,9 +145,15 @@ magma_z_spmv(
     magma_z_matrix dA={Magma_CSR};
     magma_z_matrix dx={Magma_CSR};
     magma_z_matrix dy={Magma_CSR};
+    magmaDoubleComplex_ptr dt = NULL;
 
+    CHECK_NOT_CSR64( A );
+
+    #ifndef MAGMA_HAVE_CPU
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
     cusparseHandle_t cusparseHandle = 0;
     cusparseMatDescr_t descr = 0;
+    #endif
     // make sure RHS is a dense matrix
     if ( x.storage_type != Magma_DENSE ) {
          printf("error: only dense vectors are supported for SpMV.\n");
@@ -162,6 +170,7 @@ magma_z_spmv(
         goto cleanup;
     }
 
+    #ifndef MAGMA_HAVE_CPU
     // DEV case
     if ( A.memory_location == Magma_DEV ) {
         if ( A.num_cols == x.num_rows && x.num_cols == 1 ) {
@@ -213,6 +222,15 @@ magma_z_spmv(
                         beta, y.dval, A.alignment, A.blocksize, queue ));
                 //printf("done.\n");
             }
+            else if ( A.storage_type == Magma_SELLP && A.drowidx != NULL ) {
+                // SELL-C-sigma: product in the sorted row order, then scatter
+                CHECK( magma_zmalloc( &dt, A.num_rows ));
+                CHECK( magma_zgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.blocksize, A.numblocks, A.alignment,
+                   alpha, A.dval, A.dcol, A.drow, x.dval, c_zero, dt, queue ));
+                CHECK( magma_zgesellpmv_scatter( A.num_rows, 1, beta, A.drowidx,
+                   dt, y.dval, queue ));
+            }
             else if ( A.storage_type == Magma_SELLP ) {
                 //printf("using SELLP kernel for SpMV: ");
                 CHECK( magma_zgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
@@ -301,6 +319,22 @@ magma_z_spmv(
                                         (cuDoubleComplex*)&alpha, descr, (cuDoubleComplex*)A.dval, A.drow, A.dcol,
                                         (cuDoubleComplex*)x.dval, A.num_cols, (cuDoubleComplex*)&beta, (cuDoubleComplex*)y.dval, A.num_cols);
                     }
+            } else if ( A.storage_type == Magma_SELLP && A.drowidx != NULL ) {
+                // SELL-C-sigma: product in the sorted row order, then scatter
+                CHECK( magma_zmalloc( &dt, A.num_rows*num_vecs ));
+                if ( x.major == MagmaRowMajor) {
+                    CHECK( magma_zmgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
+                                              num_vecs, A.blocksize, A.numblocks, A.alignment,
+                                              alpha, A.dval, A.dcol, A.drow, x.dval, c_zero, dt, queue ));
+                } else if ( x.major == MagmaColMajor) {
+                    // transpose first to row major
+                    CHECK( magma_zvtranspose( x, &x2, queue ));
+                    CHECK( magma_zmgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
+                                              num_vecs, A.blocksize, A.numblocks, A.alignment,
+                                              alpha, A.dval, A.dcol, A.drow, x2.dval, c_zero, dt, queue ));
+                }
+                CHECK( magma_zgesellpmv_scatter( A.num_rows, num_vecs, beta, A.drowidx,
+                                                 dt, y.dval, queue ));
             } else if ( A.storage_type == Magma_SELLP ) {
                 if ( x.major == MagmaRowMajor) {
                     CHECK( magma_zmgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
@@ -327,7 +361,69 @@ magma_z_spmv(
             }
         }
     }
-    // CPU case missing!
+    else
+    #else
+    // CPU backend: device memory is host memory, so DEV matrices use the
+    // host kernels below, after the earlier operations on the queue
+    if ( A.memory_location == Magma_DEV ) {
+        magma_queue_sync( queue );
+    }
+    #endif
+    // CPU case: host kernels for CSR, SELLP, and CSR5
+    if ( A.num_cols == x.num_rows && x.num_cols == 1 &&
+              ( A.storage_type == Magma_CSR   ||
+                A.storage_type == Magma_CUCSR ||
+                A.storage_type == Magma_CSRL  ||
+                A.storage_type == Magma_CSRU  ||
+                A.storage_type == Magma_SELLP ||
+                A.storage_type == Magma_CSR5 ))
+    {
+        if ( A.storage_type == Magma_SELLP ) {
+            CHECK( magma_zgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               A.blocksize, A.numblocks, A.alignment,
+               alpha, A.val, A.col, A.row, A.rowidx, x.val, beta, y.val, queue ));
+        }
+        else if ( A.storage_type == Magma_CSR5 ) {
+            CHECK( magma_zgecsr5mv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               A.csr5_p, alpha, A.csr5_sigma, A.tile_ptr,
+               A.val, A.row, A.col, x.val, beta, y.val, queue ));
+        }
+        else {
+            CHECK( magma_zgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               alpha, A.val, A.row, A.col, x.val, beta, y.val, queue ));
+        }
+    }
+    else if ( ( A.num_cols < x.num_rows || x.num_cols > 1 ) &&
+              ( ( A.storage_type == Magma_CSR && x.major == MagmaColMajor ) ||
+                A.storage_type == Magma_SELLP ))
+    {
+        magma_int_t num_vecs = x.num_rows / A.num_cols * x.num_cols;
+        if ( A.storage_type == Magma_CSR ) {
+            CHECK( magma_zmgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               num_vecs, alpha, A.val, A.row, A.col, x.val, beta, y.val, queue ));
+        }
+        else if ( x.major == MagmaRowMajor ) {
+            CHECK( magma_zmgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               num_vecs, A.blocksize, A.numblocks, A.alignment,
+               alpha, A.val, A.col, A.row, A.rowidx, x.val, beta, y.val, queue ));
+        }
+        else {
+            // column-major vectors are contiguous, one SpMV each
+            for( magma_int_t i=0; i < num_vecs; i++ ) {
+                CHECK( magma_zgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.blocksize, A.numblocks, A.alignment,
+                   alpha, A.val, A.col, A.row, A.rowidx, x.val + i*A.num_cols,
+                   beta, y.val + i*A.num_rows, queue ));
+            }
+        }
+    }
+    #ifdef MAGMA_HAVE_CPU
+    else {
+        printf("error: format not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    #else
+    // other formats in CPU memory go through the device
     else {
         CHECK( magma_zmtransfer( x, &dx, x.memory_location, Magma_DEV, queue ));
         CHECK( magma_zmtransfer( y, &dy, y.memory_location, Magma_DEV, queue ));
@@ -341,10 +437,14 @@ magma_z_spmv(
         CHECK( magma_zmtransfer( dA, &A, dA.memory_location, Magma_CPU, queue ));
 
     }
+    #endif
 
 cleanup:
+    #ifndef MAGMA_HAVE_CPU
     cusparseDestroyMatDescr( descr );
     descr = 0;
+    #endif
+    magma_free( dt );
     magma_zmfree(&x2, queue );
     magma_zmfree(&dx, queue );
     magma_zmfree(&dy, queue );
@@ -421,6 +521,8 @@ magma_z_spmv_shift(
 {
     magma_int_t info = 0;
 
+    CHECK_NOT_CSR64( A );
+
     // make sure RHS is a dense matrix
     if ( x.storage_type != Magma_DENSE ) {
          printf("error: only dense vectors are supported.\n");
@@ -438,6 +540,7 @@ magma_z_spmv_shift(
         goto cleanup;
     }
 
+    #ifndef MAGMA_HAVE_CPU
     // DEV case
     if ( A.memory_location == Magma_DEV ) {
         if ( A.storage_type == Magma_CSR ) {
@@ -467,7 +570,9 @@ magma_z_spmv_shift(
         }
     }
     // CPU case missing!
-    else {
+    else
+    #endif
+    {
         printf("error: CPU not yet supported.\n");
         info = MAGMA_ERR_NOT_SUPPORTED;
     }
@@ -523,6 +628,8 @@ magma_z_spmm(
     magma_z_matrix dB = {Magma_CSR};
     magma_z_matrix dC = {Magma_CSR};
     
+    CHECK_NOT_CSR64( A );
+
     if ( A.memory_location != B.memory_location ) {
         printf("error: linear algebra objects are not located in same memory!\n");
         printf("memory locations are: %d   %d\n",
@@ -531,6 +638,11 @@ magma_z_spmm(
         goto cleanup;
     }
 
+    #ifdef MAGMA_HAVE_CPU
+    // the CPU backend has no sparse matrix-matrix product
+    printf("error: CPU not yet supported.\n");
+    info = MAGMA_ERR_NOT_SUPPORTED;
+    #else
     // DEV case
     if ( A.memory_location == Magma_DEV ) {
         if ( A.num_cols == B.num_rows ) {
@@ -555,6 +667,7 @@ magma_z_spmm(
         CHECK(  magma_zcuspmm( dA, dB, &dC, queue ) );
         CHECK( magma_zmtransfer( dC, C, Magma_DEV, Magma_CPU, queue ) );
     }
+    #endif
     
 cleanup:
     magma_zmfree( &dA, queue );
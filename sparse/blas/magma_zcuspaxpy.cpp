@@ -105,6 +105,9 @@ magma_zcuspaxpy(
     magma_int_t info = 0;
     
     magma_z_matrix C={Magma_CSR};
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     C.num_rows = A.num_rows;
     C.num_cols = A.num_cols;
     C.storage_type = A.storage_type;
@@ -106,6 +106,9 @@ magma_zcuspmm(
     
     
     magma_z_matrix C={Magma_CSR};
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     C.num_rows = A.num_rows;
     C.num_cols = B.num_cols;
     C.storage_type = A.storage_type;
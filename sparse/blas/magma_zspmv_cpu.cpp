@@ -0,0 +1,924 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define COMPLEX
+
+// minimum amount of work (nonzeros plus rows) per OpenMP chunk
+#define MAGMA_ZSPMV_CPU_GRAIN 8192
+
+
+/******************************************************************************/
+// s + a*b, in real arithmetic so the compiler can vectorize the loops
+static inline magmaDoubleComplex
+magma_zspmv_cpu_fma(
+    magmaDoubleComplex s, magmaDoubleComplex a, magmaDoubleComplex b )
+{
+#ifdef COMPLEX
+    const double ar = MAGMA_Z_REAL( a ), ai = MAGMA_Z_IMAG( a );
+    const double br = MAGMA_Z_REAL( b ), bi = MAGMA_Z_IMAG( b );
+    return MAGMA_Z_MAKE( MAGMA_Z_REAL( s ) + ar*br - ai*bi,
+                         MAGMA_Z_IMAG( s ) + ar*bi + ai*br );
+#else
+    return s + a*b;
+#endif
+}
+
+
+/******************************************************************************/
+// alpha*s + beta*y; y is not read for beta = 0, so it may be uninitialized
+static inline magmaDoubleComplex
+magma_zspmv_cpu_axpby(
+    magmaDoubleComplex alpha, magmaDoubleComplex s,
+    magmaDoubleComplex beta,  magmaDoubleComplex y, bool betazero )
+{
+    return betazero ? alpha * s : alpha * s + beta * y;
+}
+
+
+/******************************************************************************/
+// sum of val[k] * x[col[k]] for k in [begin, end)
+static inline magmaDoubleComplex
+magma_zspmv_cpu_dot(
+    magma_index_t begin, magma_index_t end,
+    const magmaDoubleComplex *val, const magma_index_t *col,
+    const magmaDoubleComplex *x )
+{
+#ifdef COMPLEX
+    double sr = 0, si = 0;
+    #pragma omp simd reduction(+:sr,si)
+    for (magma_index_t k = begin; k < end; k++) {
+        const double ar = MAGMA_Z_REAL( val[k] ),    ai = MAGMA_Z_IMAG( val[k] );
+        const double xr = MAGMA_Z_REAL( x[col[k]] ), xi = MAGMA_Z_IMAG( x[col[k]] );
+        sr += ar*xr - ai*xi;
+        si += ar*xi + ai*xr;
+    }
+    return MAGMA_Z_MAKE( sr, si );
+#else
+    magmaDoubleComplex s = 0;
+    #pragma omp simd reduction(+:s)
+    for (magma_index_t k = begin; k < end; k++) {
+        s += val[k] * x[col[k]];
+    }
+    return s;
+#endif
+}
+
+
+/******************************************************************************/
+// sum of p[k] for k in [begin, end)
+static inline magmaDoubleComplex
+magma_zspmv_cpu_sum(
+    magma_index_t begin, magma_index_t end,
+    const magmaDoubleComplex *p )
+{
+#ifdef COMPLEX
+    double sr = 0, si = 0;
+    #pragma omp simd reduction(+:sr,si)
+    for (magma_index_t k = begin; k < end; k++) {
+        sr += MAGMA_Z_REAL( p[k] );
+        si += MAGMA_Z_IMAG( p[k] );
+    }
+    return MAGMA_Z_MAKE( sr, si );
+#else
+    magmaDoubleComplex s = 0;
+    #pragma omp simd reduction(+:s)
+    for (magma_index_t k = begin; k < end; k++) {
+        s += p[k];
+    }
+    return s;
+#endif
+}
+
+
+/******************************************************************************/
+// Number of chunks the work is split in: one per thread, but none with
+// less than MAGMA_ZSPMV_CPU_GRAIN of work.
+static magma_int_t
+magma_zspmv_cpu_nchunk( magma_int_t work )
+{
+    magma_int_t nchunk = 1;
+    #ifdef _OPENMP
+    nchunk = magma_get_parallel_numthreads();
+    #endif
+    return max( 1, min( nchunk, work / MAGMA_ZSPMV_CPU_GRAIN ));
+}
+
+
+/******************************************************************************/
+// Start of chunk c of nchunk, for total items split as evenly as possible.
+static inline magma_int_t
+magma_zspmv_cpu_split( magma_int_t total, magma_int_t nchunk, magma_int_t c )
+{
+    return c*(total / nchunk) + min( c, total % nchunk );
+}
+
+
+/******************************************************************************/
+// Smallest i in [0, n] with ptr[i] >= target, for nondecreasing ptr[0:n].
+static inline magma_int_t
+magma_zspmv_cpu_lower_bound(
+    const magma_index_t *ptr, magma_int_t n, magma_int_t target )
+{
+    magma_int_t lo = 0, hi = n;
+    while (lo < hi) {
+        magma_int_t mid = lo + (hi - lo)/2;
+        if (ptr[mid] < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+/******************************************************************************/
+// Merge-path search: the point (i, k) where the diagonal i + k = diagonal
+// crosses the path that merges the row ends row[1:m] with the nonzero
+// indices 0:nnz-1; rows < i are complete and nonzeros < k consumed.
+static inline void
+magma_zspmv_cpu_merge_search(
+    magma_int_t diagonal, magma_int_t m, magma_int_t nnz,
+    const magma_index_t *row,
+    magma_int_t *i, magma_int_t *k )
+{
+    magma_int_t lo = max( 0, diagonal - nnz );
+    magma_int_t hi = min( diagonal, m );
+    while (lo < hi) {
+        magma_int_t mid = lo + (hi - lo)/2;
+        if (row[mid+1] <= diagonal - 1 - mid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *i = lo;
+    *k = diagonal - lo;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSR; all arrays are in CPU memory.
+
+    The work is balanced over OpenMP threads by nonzeros, not by rows:
+    the path that merges the row pointer with the nonzeros is split in
+    equal pieces (merge-path), so rows with many nonzeros are shared
+    between threads. The partial sums of shared rows are added after the
+    parallel part. The inner products are vectorized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR
+
+    @param[in]
+    rowptr      magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y; not read for beta = 0
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in; the product is computed on the host
+                and is complete on return.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *carry_row = NULL;
+    magmaDoubleComplex *carry_val = NULL;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( m <= 0 ) {
+        goto cleanup;
+    }
+
+    {
+        const bool betazero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+        const magma_int_t nnz = rowptr[m];
+        const magma_int_t total = m + nnz;
+        const magma_int_t nchunk = magma_zspmv_cpu_nchunk( total );
+
+        CHECK( magma_index_malloc_cpu( &carry_row, nchunk ));
+        CHECK( magma_zmalloc_cpu( &carry_val, nchunk ));
+
+        #pragma omp parallel for schedule(static) num_threads(nchunk)
+        for (magma_int_t c = 0; c < nchunk; c++) {
+            magma_int_t i, k, i_end, k_end;
+            magma_zspmv_cpu_merge_search(
+                magma_zspmv_cpu_split( total, nchunk, c ),
+                m, nnz, rowptr, &i, &k );
+            magma_zspmv_cpu_merge_search(
+                magma_zspmv_cpu_split( total, nchunk, c+1 ),
+                m, nnz, rowptr, &i_end, &k_end );
+
+            // rows that end in this chunk; the first may have started in
+            // a previous chunk, whose part is its carry
+            for (; i < i_end; i++) {
+                magmaDoubleComplex s = magma_zspmv_cpu_dot(
+                    k, rowptr[i+1], val, colind, x );
+                y[i] = magma_zspmv_cpu_axpby( alpha, s, beta, y[i], betazero );
+                k = rowptr[i+1];
+            }
+            // the row that continues in the next chunk
+            carry_row[c] = i_end;
+            carry_val[c] = magma_zspmv_cpu_dot( k, k_end, val, colind, x );
+        }
+
+        for (magma_int_t c = 0; c < nchunk; c++) {
+            if ( carry_row[c] < m ) {
+                y[carry_row[c]] += alpha * carry_val[c];
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( carry_row );
+    magma_free_cpu( carry_val );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU, for
+    num_vecs vectors stored column-major in X (leading dimension n) and
+    Y (leading dimension m), as for magma_zmgecsrmv on the GPU.
+    Input format is CSR; all arrays are in CPU memory.
+
+    The rows are split in contiguous blocks with the same number of
+    nonzeros, one per OpenMP thread; each row is applied to all vectors
+    while it is in cache.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR
+
+    @param[in]
+    rowptr      magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vectors X, n-by-num_vecs
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vectors Y, m-by-num_vecs; not read for beta = 0
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in; the product is computed on the host
+                and is complete on return.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( m <= 0 || num_vecs <= 0 ) {
+        return MAGMA_SUCCESS;
+    }
+
+    const bool betazero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    const magma_int_t nnz = rowptr[m];
+    const magma_int_t nchunk = magma_zspmv_cpu_nchunk( (m + nnz)*num_vecs );
+
+    #pragma omp parallel for schedule(static) num_threads(nchunk)
+    for (magma_int_t c = 0; c < nchunk; c++) {
+        magma_int_t i_begin = magma_zspmv_cpu_lower_bound(
+            rowptr, m, magma_zspmv_cpu_split( nnz, nchunk, c ));
+        magma_int_t i_end   = magma_zspmv_cpu_lower_bound(
+            rowptr, m, magma_zspmv_cpu_split( nnz, nchunk, c+1 ));
+        if ( c == nchunk-1 ) {
+            i_end = m;  // trailing empty rows
+        }
+        for (magma_int_t i = i_begin; i < i_end; i++) {
+            for (magma_int_t v = 0; v < num_vecs; v++) {
+                magmaDoubleComplex s = magma_zspmv_cpu_dot(
+                    rowptr[i], rowptr[i+1], val, colind, x + v*n );
+                y[i + v*m] = magma_zspmv_cpu_axpby( alpha, s, beta, y[i + v*m], betazero );
+            }
+        }
+    }
+
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is SELLP, or SELL-C-sigma if rowidx is given;
+    all arrays are in CPU memory.
+
+    The slices are split in contiguous blocks with the same number of
+    stored (padded) entries, one per OpenMP thread. Within a slice, the
+    blocksize rows are processed together, so the loads of values and
+    column indices are contiguous and vectorized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one ELL-slice
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row (unused on the CPU)
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in SELLP
+
+    @param[in]
+    colind      magma_index_t*
+                columnindices of A in SELLP
+
+    @param[in]
+    rowptr      magma_index_t*
+                rowpointer of SELLP
+
+    @param[in]
+    rowidx      magma_index_t*
+                for SELL-C-sigma, original row index of each stored row;
+                NULL if the rows are not permuted
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y; not read for beta = 0
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in; the product is computed on the host
+                and is complete on return.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *colind,
+    magma_index_t *rowptr,
+    magma_index_t *rowidx,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    return magma_zmgesellpmv_cpu( transA, m, n, 1, blocksize, slices, alignment,
+                                  alpha, val, colind, rowptr, rowidx, x, beta, y, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU, for
+    num_vecs vectors stored row-major in X and Y, i.e., entry (i, v) of
+    X is x[ i*num_vecs + v ], as for magma_zmgesellpmv on the GPU.
+    Input format is SELLP, or SELL-C-sigma if rowidx is given;
+    all arrays are in CPU memory.
+
+    The slices are split in contiguous blocks with the same number of
+    stored (padded) entries, one per OpenMP thread; each entry of A is
+    applied to all vectors at once.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one ELL-slice
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row (unused on the CPU)
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in SELLP
+
+    @param[in]
+    colind      magma_index_t*
+                columnindices of A in SELLP
+
+    @param[in]
+    rowptr      magma_index_t*
+                rowpointer of SELLP
+
+    @param[in]
+    rowidx      magma_index_t*
+                for SELL-C-sigma, original row index of each stored row;
+                NULL if the rows are not permuted
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vectors X, n-by-num_vecs, row-major
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vectors Y, m-by-num_vecs, row-major;
+                not read for beta = 0
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in; the product is computed on the host
+                and is complete on return.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *colind,
+    magma_index_t *rowptr,
+    magma_index_t *rowidx,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magmaDoubleComplex *work = NULL;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( m <= 0 || num_vecs <= 0 || slices <= 0 ) {
+        goto cleanup;
+    }
+
+    {
+        const bool betazero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+        const magma_int_t C = blocksize;
+        const magma_int_t nv = num_vecs;
+        const magma_int_t nnz = rowptr[slices];
+        const magma_int_t nchunk = magma_zspmv_cpu_nchunk( (m + nnz)*nv );
+
+        // accumulators of one slice, per chunk
+        CHECK( magma_zmalloc_cpu( &work, nchunk*C*nv ));
+
+        #pragma omp parallel for schedule(static) num_threads(nchunk)
+        for (magma_int_t c = 0; c < nchunk; c++) {
+            magmaDoubleComplex *sum = work + c*C*nv;
+            magma_int_t s_begin = magma_zspmv_cpu_lower_bound(
+                rowptr, slices, magma_zspmv_cpu_split( nnz, nchunk, c ));
+            magma_int_t s_end   = magma_zspmv_cpu_lower_bound(
+                rowptr, slices, magma_zspmv_cpu_split( nnz, nchunk, c+1 ));
+            if ( c == nchunk-1 ) {
+                s_end = slices;
+            }
+            for (magma_int_t s = s_begin; s < s_end; s++) {
+                const magma_int_t offset = rowptr[s];
+                const magma_int_t len = (rowptr[s+1] - offset) / C;
+                for (magma_int_t j = 0; j < C*nv; j++) {
+                    sum[j] = MAGMA_Z_ZERO;
+                }
+                // padding has value 0 and column 0, so it needs no test
+                for (magma_int_t l = 0; l < len; l++) {
+                    const magmaDoubleComplex *v  = val    + offset + l*C;
+                    const magma_index_t      *ci = colind + offset + l*C;
+                    if ( nv == 1 ) {
+                        #pragma omp simd
+                        for (magma_int_t j = 0; j < C; j++) {
+                            sum[j] = magma_zspmv_cpu_fma( sum[j], v[j], x[ci[j]] );
+                        }
+                    }
+                    else {
+                        for (magma_int_t j = 0; j < C; j++) {
+                            const magmaDoubleComplex *xj = x + ci[j]*nv;
+                            magmaDoubleComplex *sj = sum + j*nv;
+                            #pragma omp simd
+                            for (magma_int_t iv = 0; iv < nv; iv++) {
+                                sj[iv] = magma_zspmv_cpu_fma( sj[iv], v[j], xj[iv] );
+                            }
+                        }
+                    }
+                }
+                const magma_int_t rows = min( C, m - s*C );
+                if ( rowidx == NULL ) {
+                    magmaDoubleComplex *ys = y + s*C*nv;
+                    for (magma_int_t j = 0; j < rows*nv; j++) {
+                        ys[j] = magma_zspmv_cpu_axpby( alpha, sum[j], beta, ys[j], betazero );
+                    }
+                }
+                else {
+                    // SELL-C-sigma: scatter to the original rows
+                    for (magma_int_t j = 0; j < rows; j++) {
+                        magmaDoubleComplex *yr = y + rowidx[ s*C + j ]*nv;
+                        for (magma_int_t iv = 0; iv < nv; iv++) {
+                            yr[iv] = magma_zspmv_cpu_axpby( alpha, sum[j*nv + iv],
+                                                            beta, yr[iv], betazero );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( work );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSR5, as generated by magma_zmconvert; all arrays are
+    in CPU memory.
+
+    The tiles of omega*sigma nonzeros (omega = MAGMA_CSR5_OMEGA) are
+    distributed over OpenMP threads, so the work is balanced by nonzeros.
+    Within a transposed tile, the products of the omega lanes are
+    computed together with contiguous loads, then summed per row. The
+    rows are found from the tile pointer and the CSR row pointer, which
+    CSR5 keeps, instead of the bit-flag descriptors that are laid out for
+    the GPU kernel. Rows shared between tiles are summed after the
+    parallel part.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    p           magma_int_t
+                number of tiles in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    sigma       magma_int_t
+                sigma in A in CSR5
+
+    @param[in]
+    tile_ptr    magma_uindex_t*
+                tilepointer of A in CSR5
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR5
+
+    @param[in]
+    rowptr      magma_index_t*
+                rowpointer of A in CSR5
+
+    @param[in]
+    colind      magma_index_t*
+                columnindices of A in CSR5
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y; not read for beta = 0
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in; the product is computed on the host
+                and is complete on return.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t p,
+    magmaDoubleComplex alpha,
+    magma_int_t sigma,
+    magma_uindex_t *tile_ptr,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    const magma_int_t omega = MAGMA_CSR5_OMEGA;
+
+    magma_index_t *part_row = NULL;
+    magmaDoubleComplex *part_val = NULL, *work = NULL;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( m <= 0 ) {
+        goto cleanup;
+    }
+
+    {
+        const bool betazero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+        const magma_int_t nnz = rowptr[m];
+        const magma_int_t nchunk = min( max( p, 1 ), magma_zspmv_cpu_nchunk( m + nnz ));
+
+        // rows without nonzeros are in no tile
+        #pragma omp parallel for schedule(static) num_threads(nchunk)
+        for (magma_int_t i = 0; i < m; i++) {
+            if ( rowptr[i] == rowptr[i+1] ) {
+                y[i] = betazero ? MAGMA_Z_ZERO : beta * y[i];
+            }
+        }
+        if ( p <= 0 ) {
+            goto cleanup;
+        }
+
+        // partial sums of the first and last row of each tile
+        CHECK( magma_index_malloc_cpu( &part_row, 2*p ));
+        CHECK( magma_zmalloc_cpu( &part_val, 2*p ));
+        // products of a transposed tile in CSR order, per chunk
+        CHECK( magma_zmalloc_cpu( &work, nchunk*omega*sigma ));
+
+        #pragma omp parallel for schedule(static) num_threads(nchunk)
+        for (magma_int_t c = 0; c < nchunk; c++) {
+            magmaDoubleComplex *prod = work + c*omega*sigma;
+            const magma_int_t t_end = magma_zspmv_cpu_split( p, nchunk, c+1 );
+            for (magma_int_t t = magma_zspmv_cpu_split( p, nchunk, c ); t < t_end; t++) {
+                const magma_int_t lo = t*omega*sigma;
+                const magma_int_t hi = min( nnz, lo + omega*sigma );
+                // same test as the conversion; the last tile and
+                // fast-track tiles (all in one row) are not transposed
+                const bool transposed = t < p-1 && tile_ptr[t] != tile_ptr[t+1];
+                if ( transposed ) {
+                    // CSR entry lo + lane*sigma + l is at lo + l*omega + lane
+                    for (magma_int_t l = 0; l < sigma; l++) {
+                        const magmaDoubleComplex *v  = val    + lo + l*omega;
+                        const magma_index_t      *ci = colind + lo + l*omega;
+                        #pragma omp simd
+                        for (magma_int_t lane = 0; lane < omega; lane++) {
+                            prod[lane*sigma + l] = magma_zspmv_cpu_fma(
+                                MAGMA_Z_ZERO, v[lane], x[ci[lane]] );
+                        }
+                    }
+                }
+
+                part_row[2*t] = part_row[2*t+1] = -1;
+                // mask the empty-row flag in the high bit
+                magma_int_t i = (magma_int_t) ((tile_ptr[t] << 1) >> 1);
+                for (; i < m && rowptr[i] < hi; i++) {
+                    const magma_int_t begin = max( (magma_int_t) rowptr[i],   lo );
+                    const magma_int_t end   = min( (magma_int_t) rowptr[i+1], hi );
+                    if ( begin == end ) {
+                        continue;
+                    }
+                    magmaDoubleComplex s = transposed
+                        ? magma_zspmv_cpu_sum( begin - lo, end - lo, prod )
+                        : magma_zspmv_cpu_dot( begin, end, val, colind, x );
+                    if ( rowptr[i] < lo ) {
+                        part_row[2*t] = i;
+                        part_val[2*t] = s;
+                    }
+                    else if ( rowptr[i+1] > hi ) {
+                        part_row[2*t+1] = i;
+                        part_val[2*t+1] = s;
+                    }
+                    else {
+                        y[i] = magma_zspmv_cpu_axpby( alpha, s, beta, y[i], betazero );
+                    }
+                }
+            }
+        }
+
+        // rows shared between tiles are partial in consecutive tiles
+        magma_index_t row = -1;
+        magmaDoubleComplex s = MAGMA_Z_ZERO;
+        for (magma_int_t j = 0; j < 2*p; j++) {
+            if ( part_row[j] < 0 ) {
+                continue;
+            }
+            if ( part_row[j] != row ) {
+                if ( row >= 0 ) {
+                    y[row] = magma_zspmv_cpu_axpby( alpha, s, beta, y[row], betazero );
+                }
+                row = part_row[j];
+                s = MAGMA_Z_ZERO;
+            }
+            s += part_val[j];
+        }
+        if ( row >= 0 ) {
+            y[row] = magma_zspmv_cpu_axpby( alpha, s, beta, y[row], betazero );
+        }
+    }
+
+cleanup:
+    magma_free_cpu( part_row );
+    magma_free_cpu( part_val );
+    magma_free_cpu( work );
+    return info;
+}
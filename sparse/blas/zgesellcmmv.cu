@@ -962,3 +962,101 @@ magma_zgesellpmv(
 
     return MAGMA_SUCCESS;
 }
+
+
+// SELL-C-sigma: the SpMV result t is in the sorted row order;
+// y[ rowidx[i] ] = t[ i ] + beta * y[ rowidx[i] ], for num_vecs
+// vectors stored row-major
+template<bool betazero>
+__global__ void
+zgesellpmv_scatter_kernel(
+    int num_rows,
+    int num_vecs,
+    magmaDoubleComplex beta,
+    const magma_index_t * __restrict__ drowidx,
+    const magmaDoubleComplex * __restrict__ dt,
+    magmaDoubleComplex * __restrict__ dy)
+{
+    int idx = blockDim.x * blockIdx.x + threadIdx.x;
+    if ( idx < num_rows * num_vecs ) {
+        int i = idx / num_vecs;
+        int v = idx - i * num_vecs;
+        int k = drowidx[ i ] * num_vecs + v;
+        if (betazero) {
+            dy[ k ] = dt[ idx ];
+        } else {
+            dy[ k ] = dt[ idx ] + beta * dy[ k ];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    
+    For a SELL-C-sigma matrix, whose rows are stored in sorted order,
+    this routine scatters the product t = alpha * A * x, computed with
+    magma_zgesellpmv or magma_zmgesellpmv in the sorted row order,
+    to the original rows: y[ rowidx[i] ] = t[ i ] + beta * y[ rowidx[i] ].
+    
+    Arguments
+    ---------
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors, stored row-major in t and y
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    drowidx     magmaIndex_ptr
+                original row index of each stored row of A
+
+    @param[in]
+    dt          magmaDoubleComplex_ptr
+                product in the sorted row order
+
+    @param[in,out]
+    dy          magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgesellpmv_scatter(
+    magma_int_t m,
+    magma_int_t num_vecs,
+    magmaDoubleComplex beta,
+    magmaIndex_ptr drowidx,
+    magmaDoubleComplex_ptr dt,
+    magmaDoubleComplex_ptr dy,
+    magma_queue_t queue )
+{
+    if ( m*num_vecs == 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    int num_threads = 256;
+    dim3 grid( magma_ceildiv( m*num_vecs, num_threads ));
+    dim3 block( num_threads );
+    if (beta == MAGMA_Z_ZERO) {
+        zgesellpmv_scatter_kernel<true><<< grid, block, 0, queue->cuda_stream() >>>
+        ( m, num_vecs, beta, drowidx, dt, dy );
+    } else {
+        zgesellpmv_scatter_kernel<false><<< grid, block, 0, queue->cuda_stream() >>>
+        ( m, num_vecs, beta, drowidx, dt, dy );
+    }
+
+    return MAGMA_SUCCESS;
+}
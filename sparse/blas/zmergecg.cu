@@ -1119,6 +1119,23 @@ magma_zcgmerge_spmv1(
         magma_zcgmerge_spmvellpackrt_kernel2<<< Gs, Bs, Ms, queue->cuda_stream() >>>
                       ( A.num_rows, dz, dd, d1 );
     }
+    else if ( A.storage_type == Magma_SELLP && A.drowidx != NULL ) {
+        // SELL-C-sigma: the fused kernels assume the original row order,
+        // so the product is computed in the sorted order and scattered
+        magmaDoubleComplex c_one = MAGMA_Z_ONE;
+        magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+        magmaDoubleComplex_ptr dt = NULL;
+        if ( magma_zmalloc( &dt, A.num_rows ) != MAGMA_SUCCESS ) {
+            return MAGMA_ERR_DEVICE_ALLOC;
+        }
+        magma_zgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
+                          A.blocksize, A.numblocks, A.alignment,
+                          c_one, A.dval, A.dcol, A.drow, dd, c_zero, dt, queue );
+        magma_zgesellpmv_scatter( A.num_rows, 1, c_zero, A.drowidx, dt, dz, queue );
+        magma_free( dt );
+        magma_zcgmerge_spmvellpackrt_kernel2<<< Gs, Bs, Ms, queue->cuda_stream() >>>
+                              ( A.num_rows, dz, dd, d1 );
+    }
     else if ( A.storage_type == Magma_SELLP && A.alignment == 1 ) {
             magma_zcgmerge_spmvell_kernelb1<<< Gs, Bs, Ms, queue->cuda_stream() >>>
             ( A.num_rows, A.blocksize, 
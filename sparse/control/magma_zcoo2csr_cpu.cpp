@@ -0,0 +1,365 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <algorithm>
+#include <vector>
+#include <utility>  // pair
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+// rows up to this length are sorted by insertion sort
+#define MAGMA_SORTROWS_SMALL 32
+
+
+/*
+    Parallel stable bucketing shared by magma_zcoo2csr_cpu and
+    magma_zcsr2csc_cpu.
+
+    Entry j goes to bucket key[j]. Its index in the output is other[j], or,
+    if other is NULL, the row of j in the CSR structure srcptr[nsrc+1].
+
+    The entries are split into P contiguous blocks. Each block counts its
+    entries per bucket, a column-wise scan over the P histograms turns the
+    counts into block offsets within each bucket, and
+    magma_zmatrix_createrowptr builds ptr. Every block then scatters its
+    entries without synchronization. The result is the same as a serial
+    counting sort, in particular the input order is preserved within each
+    bucket.
+*/
+static magma_int_t
+magma_zbucket_cpu(
+    magma_int_t nbuckets,
+    magma_int_t nnz,
+    const magma_index_t *key,
+    const magma_index_t *other,
+    const magma_index_t *srcptr,
+    magma_int_t nsrc,
+    const magmaDoubleComplex *val,
+    magma_index_t *ptr,
+    magma_index_t *idx,
+    magmaDoubleComplex *outval,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_index_t *cnt = NULL;
+    magma_int_t nblocks = 1;
+
+#ifdef _OPENMP
+    nblocks = omp_get_max_threads();
+#endif
+    // the P histograms should not outgrow the matrix itself
+    if ( int64_t(nblocks) > 4*int64_t(nnz) / (nbuckets+1) ) {
+        nblocks = magma_int_t( 4*int64_t(nnz) / (nbuckets+1) );
+    }
+    nblocks = max( nblocks, 1 );
+
+    CHECK( magma_index_malloc_cpu( &cnt, size_t(nblocks)*nbuckets ));
+
+    // pass 1: block-local histograms
+    #pragma omp parallel for schedule(static, 1)
+    for( magma_int_t b=0; b < nblocks; b++ ) {
+        magma_index_t *c = cnt + size_t(b)*nbuckets;
+        magma_int_t start = magma_int_t( int64_t(nnz) * b / nblocks );
+        magma_int_t end   = magma_int_t( int64_t(nnz) * (b+1) / nblocks );
+        for( magma_int_t i=0; i < nbuckets; i++ ) {
+            c[i] = 0;
+        }
+        for( magma_int_t j=start; j < end; j++ ) {
+            c[ key[j] ]++;
+        }
+    }
+
+    // pass 2: offsets of the blocks within each bucket, bucket sizes
+    #pragma omp parallel for schedule(static)
+    for( magma_int_t i=0; i < nbuckets; i++ ) {
+        magma_index_t sum = 0;
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            magma_index_t c = cnt[ size_t(b)*nbuckets + i ];
+            cnt[ size_t(b)*nbuckets + i ] = sum;
+            sum += c;
+        }
+        ptr[i+1] = sum;
+    }
+    ptr[0] = 0;
+    CHECK( magma_zmatrix_createrowptr( nbuckets, ptr, queue ));
+
+    // pass 3: scatter
+    #pragma omp parallel for schedule(static, 1)
+    for( magma_int_t b=0; b < nblocks; b++ ) {
+        magma_index_t *c = cnt + size_t(b)*nbuckets;
+        magma_int_t start = magma_int_t( int64_t(nnz) * b / nblocks );
+        magma_int_t end   = magma_int_t( int64_t(nnz) * (b+1) / nblocks );
+        magma_int_t src = 0;
+        if ( other == NULL ) {
+            // first source row containing entry start
+            src = magma_int_t( std::upper_bound( srcptr, srcptr+nsrc+1,
+                                                 magma_index_t(start) )
+                               - srcptr ) - 1;
+        }
+        for( magma_int_t j=start; j < end; j++ ) {
+            magma_index_t k = key[j];
+            magma_index_t dest = ptr[k] + c[k]++;
+            if ( other != NULL ) {
+                idx[dest] = other[j];
+            } else {
+                while ( srcptr[src+1] <= j ) {
+                    src++;
+                }
+                idx[dest] = magma_index_t( src );
+            }
+            outval[dest] = val[j];
+        }
+    }
+
+cleanup:
+    magma_free_cpu( cnt );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Converts a matrix in coordinate format into CSR on the CPU using a
+    multithreaded counting sort: parallel histogram, prefix sum and scatter.
+    Entries of the same row keep their input order; call
+    magma_zcsr_sortrows_cpu afterwards if the column indices have to be
+    sorted.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                number of rows
+
+    @param[in]
+    nnz         magma_int_t
+                number of entries
+
+    @param[in]
+    rowidx      const magma_index_t*
+                row index of each entry, array of size nnz
+
+    @param[in]
+    colidx      const magma_index_t*
+                column index of each entry, array of size nnz
+
+    @param[in]
+    val         const magmaDoubleComplex*
+                value of each entry, array of size nnz
+
+    @param[out]
+    row         magma_index_t*
+                CSR row pointer, array of size num_rows+1
+
+    @param[out]
+    col         magma_index_t*
+                CSR column indices, array of size nnz
+
+    @param[out]
+    csrval      magmaDoubleComplex*
+                CSR values, array of size nnz
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcoo2csr_cpu(
+    magma_int_t num_rows,
+    magma_int_t nnz,
+    const magma_index_t *rowidx,
+    const magma_index_t *colidx,
+    const magmaDoubleComplex *val,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *csrval,
+    magma_queue_t queue )
+{
+    return magma_zbucket_cpu( num_rows, nnz, rowidx, colidx, NULL, 0, val,
+                              row, col, csrval, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Converts a CSR matrix into CSC (equivalently, computes the CSR arrays of
+    its transpose) on the CPU using a multithreaded counting sort. If the
+    column indices of the input are sorted within each row, the row indices
+    of the output are sorted within each column.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                number of rows of the CSR matrix
+
+    @param[in]
+    num_cols    magma_int_t
+                number of columns of the CSR matrix
+
+    @param[in]
+    row         const magma_index_t*
+                CSR row pointer, array of size num_rows+1
+
+    @param[in]
+    col         const magma_index_t*
+                CSR column indices, array of size row[num_rows]
+
+    @param[in]
+    val         const magmaDoubleComplex*
+                CSR values, array of size row[num_rows]
+
+    @param[out]
+    colptr      magma_index_t*
+                CSC column pointer, array of size num_cols+1
+
+    @param[out]
+    rowind      magma_index_t*
+                CSC row indices, array of size row[num_rows]
+
+    @param[out]
+    cscval      magmaDoubleComplex*
+                CSC values, array of size row[num_rows]
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcsr2csc_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *val,
+    magma_index_t *colptr,
+    magma_index_t *rowind,
+    magmaDoubleComplex *cscval,
+    magma_queue_t queue )
+{
+    return magma_zbucket_cpu( num_cols, row[num_rows], col, NULL,
+                              row, num_rows, val,
+                              colptr, rowind, cscval, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts the column indices within each row of a CSR matrix on the CPU,
+    permuting the values accordingly. Rows are processed in parallel;
+    short rows use insertion sort, longer rows are sorted as
+    (index, value) pairs. Rows that are already sorted are left untouched.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                number of rows
+
+    @param[in]
+    row         const magma_index_t*
+                CSR row pointer, array of size num_rows+1
+
+    @param[in,out]
+    col         magma_index_t*
+                CSR column indices, sorted within each row on output
+
+    @param[in,out]
+    val         magmaDoubleComplex*
+                CSR values, permuted like col. May be NULL.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcsr_sortrows_cpu(
+    magma_int_t num_rows,
+    const magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    #pragma omp parallel
+    {
+        std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+        #pragma omp for schedule(dynamic, 1024)
+        for( magma_int_t k=0; k < num_rows; k++ ) {
+            magma_index_t start = row[k], end = row[k+1];
+            magma_index_t i = start + 1;
+            while ( i < end && col[i-1] <= col[i] ) {
+                i++;
+            }
+            if ( i >= end ) {
+                continue;   // already sorted
+            }
+            if ( end - start <= MAGMA_SORTROWS_SMALL ) {
+                for( ; i < end; i++ ) {
+                    magma_index_t c = col[i];
+                    magmaDoubleComplex v = (val != NULL ? val[i] : MAGMA_Z_ZERO);
+                    magma_index_t j = i - 1;
+                    while ( j >= start && col[j] > c ) {
+                        col[j+1] = col[j];
+                        if ( val != NULL ) {
+                            val[j+1] = val[j];
+                        }
+                        j--;
+                    }
+                    col[j+1] = c;
+                    if ( val != NULL ) {
+                        val[j+1] = v;
+                    }
+                }
+            }
+            else if ( val == NULL ) {
+                std::sort( col + start, col + end );
+            }
+            else {
+                rowval.resize( end - start );
+                for( magma_index_t j=start; j < end; j++ ) {
+                    rowval[j-start] = std::make_pair( col[j], val[j] );
+                }
+                std::stable_sort( rowval.begin(), rowval.end(),
+                    []( const std::pair< magma_index_t, magmaDoubleComplex >& a,
+                        const std::pair< magma_index_t, magmaDoubleComplex >& b )
+                    { return a.first < b.first; } );
+                for( magma_index_t j=start; j < end; j++ ) {
+                    col[j] = rowval[j-start].first;
+                    val[j] = rowval[j-start].second;
+                }
+            }
+        }
+    }
+
+    return info;
+}
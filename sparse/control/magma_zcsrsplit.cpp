@@ -62,6 +62,8 @@ magma_zcsrsplit(
     
     magma_int_t i, k, j, nnz_diag, nnz_offd;
     
+    CHECK_NOT_CSR64( A );
+
     // make sure the target structure is empty
     magma_zmfree( D, queue );
     magma_zmfree( R, queue );
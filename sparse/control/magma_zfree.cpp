@@ -79,6 +79,7 @@ magma_zmfree(
                 magma_free_cpu( A->val );
                 magma_free_cpu( A->row );
                 magma_free_cpu( A->col );
+                magma_free_cpu( A->rowidx );
             }
             A->num_rows = 0;
             A->num_cols = 0;
@@ -132,6 +133,18 @@ magma_zmfree(
             A->num_cols = 0;
             A->nnz = 0; A->true_nnz = 0;
         }
+        // CSR64 may carry row indices (magma_zmatrix_addrowindex)
+        if ( A->storage_type == Magma_CSR64 ) {
+            if (A->ownership) {
+                magma_free_cpu( A->val );
+                magma_free_cpu( A->col );
+                magma_free_cpu( A->row64 );
+                magma_free_cpu( A->rowidx );
+            }
+            A->num_rows = 0;
+            A->num_cols = 0;
+            A->nnz = 0; A->true_nnz = 0; A->nnz64 = 0;
+        }
         if (  A->storage_type == Magma_CSRCOO ) {
             if (A->ownership) {
                 magma_free_cpu( A->val );
@@ -253,6 +266,10 @@ magma_zmfree(
                     printf("Memory Free Error.\n");
                     return MAGMA_ERR_INVALID_PTR; 
                 }
+                if ( magma_free( A->drowidx ) != MAGMA_SUCCESS ) {
+                    printf("Memory Free Error.\n");
+                    return MAGMA_ERR_INVALID_PTR; 
+                }
             }
             A->num_rows = 0;
             A->num_cols = 0;
@@ -611,6 +628,8 @@ magma_zprecondfree(
         magma_free_cpu( precond_par->UT.blockinfo );
         precond_par->UT.blockinfo = NULL;
     }
+    // the CPU backend sets up no triangular solves
+    #ifndef MAGMA_HAVE_CPU
     if ((precond_par->solver == Magma_ILU ||
          precond_par->solver == Magma_PARILU ||
          precond_par->solver == Magma_ICC ||
@@ -622,6 +641,7 @@ magma_zprecondfree(
         magma_trisolve_free( &precond_par->cuinfoLT );
         magma_trisolve_free( &precond_par->cuinfoUT );
     }
+    #endif
     if ( precond_par->LD.val != NULL ) {
         if ( precond_par->LD.memory_location == Magma_DEV )
             magma_free( precond_par->LD.dval );
@@ -11,6 +11,7 @@
 */
 
 #include "magmasparse_internal.h"
+#include <limits.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -59,6 +60,9 @@ magma_zmatrix_cup(
 {
     magma_int_t info = 0;
     assert(A.num_rows == B.num_rows);
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
     U->storage_type = Magma_CSR;
@@ -239,6 +243,9 @@ magma_zmatrix_cap(
     //printf("\n"); fflush(stdout);
     // parallel for using openmp
     assert(A.num_rows == B.num_rows);
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
     U->storage_type = Magma_CSR;
@@ -359,6 +366,9 @@ magma_zmatrix_negcap(
     //printf("\n"); fflush(stdout);
     // parallel for using openmp
     assert(A.num_rows == B.num_rows);
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
     U->storage_type = Magma_CSR;
@@ -495,6 +505,9 @@ magma_zmatrix_tril_negcap(
     //printf("\n"); fflush(stdout);
     // parallel for using openmp
     assert(A.num_rows == B.num_rows);
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
     U->storage_type = Magma_CSR;
@@ -650,6 +663,9 @@ magma_zmatrix_triu_negcap(
 {
     magma_int_t info = 0;
     assert(A.num_rows == B.num_rows);
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
     U->storage_type = Magma_CSR;
@@ -769,7 +785,7 @@ cleanup:
 /***************************************************************************//**
     Purpose
     -------
-    Adds to a CSR matrix an array containing the rowindexes.
+    Adds to a CSR or CSR64 matrix an array containing the rowindexes.
 
     Arguments
     ---------
@@ -792,12 +808,13 @@ magma_zmatrix_addrowindex(
 {
     magma_int_t info = 0;
     
-    CHECK(magma_index_malloc_cpu(&A->rowidx, A->nnz));
+    CHECK(magma_index_malloc_cpu(&A->rowidx, MAGMA_CSR_NNZ(*A)));
     
     #pragma omp parallel for
     for (magma_int_t row=0; row<A->num_rows; row++) {
         
-        for (magma_int_t i=A->row[row]; i<A->row[row+1]; i++) {
+        for (magma_offset_t i=MAGMA_CSR_ROWPTR(*A, row);
+                            i<MAGMA_CSR_ROWPTR(*A, row+1); i++) {
             A->rowidx[i] = row;
         }
     }
@@ -838,12 +855,9 @@ magma_zcsrcoo_transpose(
     magma_queue_t queue)
 {
     magma_int_t info = 0;
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
-    
-    magma_int_t el_per_block, num_threads=1;
     
+    CHECK_NOT_CSR64( A );
+
     B->storage_type = A.storage_type;
     B->memory_location = A.memory_location;
     
@@ -851,83 +865,23 @@ magma_zcsrcoo_transpose(
     B->num_cols = A.num_cols;
     B->nnz      = A.nnz;
     
-    CHECK(magma_index_malloc_cpu(&linked_list, A.nnz));
-    CHECK(magma_index_malloc_cpu(&row_ptr, A.num_rows+1));
-    CHECK(magma_index_malloc_cpu(&last_rowel, A.num_rows+1));
     CHECK(magma_index_malloc_cpu(&B->row, A.num_rows+1));
     CHECK(magma_index_malloc_cpu(&B->rowidx, A.nnz));
     CHECK(magma_index_malloc_cpu(&B->col, A.nnz));
     CHECK(magma_zmalloc_cpu(&B->val, A.nnz));
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
     
-    #pragma omp parallel for
-    for (magma_int_t i=0; i<A.num_rows; i++) {
-        row_ptr[i] = -1;
-    }
-    #pragma omp parallel for
-    for (magma_int_t i=0; i<A.num_rows+1; i++) {
-        B->row[i] = 0;
-    }
-    
-    el_per_block = magma_ceildiv(A.num_rows, num_threads);
-
-    #pragma omp parallel
-    {
-#ifdef _OPENMP
-    magma_int_t id = omp_get_thread_num();
-#else
-    magma_int_t id = 0;
-#endif
-        for (magma_int_t i=0; i<A.nnz; i++) {
-            magma_index_t row = A.col[ i ];
-            if((row < (id+1)*el_per_block) && (row >=(id)*el_per_block)) {
-                if(row_ptr[row] == -1) {
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                }
-                B->row[row+1] = B->row[row+1] + 1;
-            }
-        }
-    }
-    
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr(B->num_rows, B->row, queue);
-    
-
-    assert(B->row[B->num_rows] == A.nnz);
+    // stable parallel counting sort of the entries by column index
+    CHECK(magma_zcoo2csr_cpu(B->num_rows, A.nnz, A.col, A.rowidx, A.val,
+                             B->row, B->col, B->val, queue));
     
     #pragma omp parallel for
-    for (magma_int_t row=0; row<A.num_rows; row++) {
-        magma_int_t el = row_ptr[row];
-        if(el>-1) {
-            
-            for (magma_int_t i=B->row[row]; i<B->row[row+1]; i++) {
-                // assert(A.col[el] == row);
-                B->val[i] = A.val[el];
-                B->col[i] = A.rowidx[el];
-                B->rowidx[i] = row;
-                el = linked_list[el];
-            }
+    for (magma_int_t row=0; row<B->num_rows; row++) {
+        for (magma_int_t i=B->row[row]; i<B->row[row+1]; i++) {
+            B->rowidx[i] = row;
         }
     }
     
 cleanup:
-    magma_free_cpu(row_ptr);
-    magma_free_cpu(last_rowel);
-    magma_free_cpu(linked_list);
     return info;
 }
 
@@ -1088,11 +1042,11 @@ magma_zmatrix_swap(
 
     @param[in]
     A           magma_z_matrix
-                Element part of this.
+                Element part of this (CSR or CSR64).
 
     @param[out]
     L           magma_z_matrix*
-                Lower triangular part of A.
+                Lower triangular part of A, in Magma_CSR64 format if A is.
 
     @param[in]
     queue       magma_queue_t
@@ -1111,48 +1065,68 @@ magma_zmatrix_tril(
     
     L->num_rows = A.num_rows;
     L->num_cols = A.num_cols;
-    L->storage_type = Magma_CSR;
+    L->storage_type = A.storage_type == Magma_CSR64 ? Magma_CSR64 : Magma_CSR;
     L->memory_location = Magma_CPU;
     
-    CHECK(magma_index_malloc_cpu(&L->row, A.num_rows+1));
+    if (L->storage_type == Magma_CSR64) {
+        CHECK(magma_offset_malloc_cpu(&L->row64, A.num_rows+1));
+    } else {
+        CHECK(magma_index_malloc_cpu(&L->row, A.num_rows+1));
+    }
     #pragma omp parallel for
     for (magma_int_t row=0; row<A.num_rows; row++) {
         magma_int_t nz = 0;
         
-        for (magma_int_t i=A.row[row]; i<A.row[row+1]; i++) {
+        magma_offset_t rend = MAGMA_CSR_ROWPTR(A, row+1);
+        for (magma_offset_t i=MAGMA_CSR_ROWPTR(A, row); i<rend; i++) {
             magma_index_t col = A.col[i];
             if(col <= row) {
                 nz++;    
             } else {
-                i=A.row[row+1];   
+                i=rend;   
             }
         }
-        L->row[row+1] = nz;
+        if (L->storage_type == Magma_CSR64) {
+            L->row64[row+1] = nz;
+        } else {
+            L->row[row+1] = nz;
+        }
     }
     
     // new row pointer
-    L->row[ 0 ] = 0;
-    CHECK(magma_zmatrix_createrowptr(L->num_rows, L->row, queue));
-    L->nnz = L->row[ L->num_rows ];
+    if (L->storage_type == Magma_CSR64) {
+        L->row64[ 0 ] = 0;
+        for (magma_int_t row=0; row<L->num_rows; row++) {
+            L->row64[row+1] += L->row64[row];
+        }
+        L->nnz64 = L->row64[ L->num_rows ];
+        L->nnz = (magma_offset_t(magma_int_t(L->nnz64)) == L->nnz64
+                  ? magma_int_t(L->nnz64) : -1);
+    } else {
+        L->row[ 0 ] = 0;
+        CHECK(magma_zmatrix_createrowptr(L->num_rows, L->row, queue));
+        L->nnz = L->row[ L->num_rows ];
+    }
     
     // allocate memory
-    CHECK(magma_zmalloc_cpu(&L->val, L->nnz));
-    CHECK(magma_index_malloc_cpu(&L->col, L->nnz));
+    CHECK(magma_zmalloc_cpu(&L->val, MAGMA_CSR_NNZ(*L)));
+    CHECK(magma_index_malloc_cpu(&L->col, MAGMA_CSR_NNZ(*L)));
     
     // copy
     #pragma omp parallel for
     for (magma_int_t row=0; row<A.num_rows; row++) {
         magma_int_t nz = 0;
-        magma_int_t offset = L->row[row];
+        magma_offset_t offset = MAGMA_CSR_ROWPTR(*L, row);
         
-        for (magma_int_t i=A.row[row]; i<A.row[row+1]; i++) {
+        magma_offset_t rend = MAGMA_CSR_ROWPTR(A, row+1);
+        for (magma_offset_t i=MAGMA_CSR_ROWPTR(A, row); i<rend; i++) {
             magma_index_t col = A.col[i];
             if(col <= row) {
                 L->col[offset+nz] = col;
                 L->val[offset+nz] = A.val[i];
                 nz++;    
             } else {
-                i=A.row[row+1];    
+                i=rend;    
             }
         }
     }
@@ -1174,11 +1148,11 @@ cleanup:
 
     @param[in]
     A           magma_z_matrix
-                Element part of this.
+                Element part of this (CSR or CSR64).
 
     @param[out]
     U           magma_z_matrix*
-                Lower triangular part of A.
+                Upper triangular part of A, in Magma_CSR64 format if A is.
 
     @param[in]
     queue       magma_queue_t
@@ -1197,15 +1171,20 @@ magma_zmatrix_triu(
     
     U->num_rows = A.num_rows;
     U->num_cols = A.num_cols;
-    U->storage_type = Magma_CSR;
+    U->storage_type = A.storage_type == Magma_CSR64 ? Magma_CSR64 : Magma_CSR;
     U->memory_location = Magma_CPU;
     
-    CHECK(magma_index_malloc_cpu(&U->row, A.num_rows+1));
+    if (U->storage_type == Magma_CSR64) {
+        CHECK(magma_offset_malloc_cpu(&U->row64, A.num_rows+1));
+    } else {
+        CHECK(magma_index_malloc_cpu(&U->row, A.num_rows+1));
+    }
     #pragma omp parallel for
     for (magma_int_t row=0; row<A.num_rows; row++) {
         magma_int_t nz = 0;
         
-        for (magma_int_t i=A.row[row]; i<A.row[row+1]; i++) {
+        magma_offset_t rend = MAGMA_CSR_ROWPTR(A, row+1);
+        for (magma_offset_t i=MAGMA_CSR_ROWPTR(A, row); i<rend; i++) {
             magma_index_t col = A.col[i];
             if(col >= row) {
                 nz++;    
@@ -1213,26 +1192,40 @@ magma_zmatrix_triu(
                 ;    
             }
         }
-        U->row[row+1] = nz;
+        if (U->storage_type == Magma_CSR64) {
+            U->row64[row+1] = nz;
+        } else {
+            U->row[row+1] = nz;
+        }
     }
     
     // new row pointer
-    U->row[ 0 ] = 0;
-    CHECK(magma_zmatrix_createrowptr(U->num_rows, U->row, queue));
-    U->nnz = U->row[ U->num_rows ];
-    
+    if (U->storage_type == Magma_CSR64) {
+        U->row64[ 0 ] = 0;
+        for (magma_int_t row=0; row<U->num_rows; row++) {
+            U->row64[row+1] += U->row64[row];
+        }
+        U->nnz64 = U->row64[ U->num_rows ];
+        U->nnz = (magma_offset_t(magma_int_t(U->nnz64)) == U->nnz64
+                  ? magma_int_t(U->nnz64) : -1);
+    } else {
+        U->row[ 0 ] = 0;
+        CHECK(magma_zmatrix_createrowptr(U->num_rows, U->row, queue));
+        U->nnz = U->row[ U->num_rows ];
+    }
     
     // allocate memory
-    CHECK(magma_zmalloc_cpu(&U->val, U->nnz));
-    CHECK(magma_index_malloc_cpu(&U->col, U->nnz));
+    CHECK(magma_zmalloc_cpu(&U->val, MAGMA_CSR_NNZ(*U)));
+    CHECK(magma_index_malloc_cpu(&U->col, MAGMA_CSR_NNZ(*U)));
     
     // copy
     #pragma omp parallel for
     for (magma_int_t row=0; row<A.num_rows; row++) {
         magma_int_t nz = 0;
-        magma_int_t offset = U->row[row];
+        magma_offset_t offset = MAGMA_CSR_ROWPTR(*U, row);
         
-        for (magma_int_t i=A.row[row]; i<A.row[row+1]; i++) {
+        magma_offset_t rend = MAGMA_CSR_ROWPTR(A, row+1);
+        for (magma_offset_t i=MAGMA_CSR_ROWPTR(A, row); i<rend; i++) {
             magma_index_t col = A.col[i];
             if(col >= row) {
                 U->col[offset+nz] = col;
@@ -1281,9 +1274,10 @@ magma_zmatrix_abssum(
     magma_int_t info = 0;
     
     double locsum = .0;
+    magma_offset_t nnz = MAGMA_CSR_NNZ(A);
     
     #pragma omp parallel for reduction(+:locsum)
-    for (magma_int_t i=0; i < A.nnz; i++) {
+    for (magma_offset_t i=0; i < nnz; i++) {
         locsum = locsum + (MAGMA_Z_ABS(A.val[i]) * MAGMA_Z_ABS(A.val[i]));
     }
     
@@ -1297,6 +1291,7 @@ magma_zmatrix_abssum(
     Purpose
     -------
     SOrts the elements in a CSR matrix for increasing column index.
+    The values are permuted along with the column indices.
 
     Arguments
     ---------
@@ -1320,14 +1315,12 @@ magma_zcsr_sort(
     magma_int_t info = 0;
     
     if (A->memory_location == Magma_CPU && A->storage_type == Magma_CSR){
-        #pragma omp parallel  
-        for (int row=0; row<A->num_rows; row++) {
-            magma_zindexsort(&A->col[A->row[row]], 0, 
-                A->row[row+1]-A->row[row]-1, queue);
-        }
+        CHECK(magma_zcsr_sortrows_cpu(A->num_rows, A->row, A->col, A->val,
+                                      queue));
     } else {
         info = MAGMA_ERR_NOT_SUPPORTED;
     }
     
+cleanup:
     return info;
 }
@@ -45,6 +45,8 @@ magma_zrowentries(
     magma_index_t *length=NULL;
     magma_index_t i,j, maxrowlength=0;
     
+    CHECK_NOT_CSR64( *A );
+
     // check whether matrix on CPU
     if ( A->memory_location == Magma_CPU ) {
         // CSR
@@ -112,6 +114,8 @@ magma_zdiameter(
     
     magma_index_t i, j, tmp,  *dim=NULL, maxdim=0;
     
+    CHECK_NOT_CSR64( *A );
+
     // check whether matrix on CPU
     if ( A->memory_location == Magma_CPU ) {
         // CSR
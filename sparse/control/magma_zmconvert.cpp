@@ -8,9 +8,15 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+// STL headers before magmasparse_internal.h, which defines min and max
+#include <algorithm>
+
 #include "magmasparse_internal.h"
+#include <limits.h>
 
+#ifndef MAGMA_HAVE_CPU
 #include <cuda.h>  // for CUDA_VERSION
+#endif
 
 
 /* For hipSPARSE, they use a separate complex type than for hipBLAS */
@@ -159,7 +165,8 @@ cleanup:
 
     @param[in]
     old_format  magma_storage_t
-                original storage format
+                original storage format; A in Magma_CSR64 format is always
+                read as such
 
     @param[in]
     new_format  magma_storage_t
@@ -193,8 +200,10 @@ magma_zmconvert(
     magmaDoubleComplex *transpose=NULL;
     magma_index_t *nnz_per_row=NULL;
 
+    #ifndef MAGMA_HAVE_CPU
     cusparseHandle_t cusparseHandle = 0;
     cusparseMatDescr_t descr = 0;
+    #endif
     
     // make sure the target structure is empty
     magma_zmfree( B, queue );
@@ -226,11 +235,117 @@ magma_zmconvert(
 
     magmaDoubleComplex zero = MAGMA_Z_MAKE( 0.0, 0.0 );
 
+    // the 64-bit row offsets must not be read as magma_index_t, whatever
+    // old_format the caller passed
+    if ( A.storage_type == Magma_CSR64 ) {
+        old_format = Magma_CSR64;
+    }
+
     // check whether matrix on CPU
     if ( A.memory_location == Magma_CPU )
     {
+        // CSR64 to anything
+        if ( old_format == Magma_CSR64 )
+        {
+            // CSR64 to CSR64
+            if ( new_format == Magma_CSR64 ) {
+                CHECK( magma_zmtransfer( A, B, Magma_CPU, Magma_CPU, queue ));
+            }
+            // CSR64 to COO (row indices are 32-bit, only the offsets are wide);
+            // COO keeps its count in nnz, so it has to fit into magma_int_t
+            else if ( new_format == Magma_COO ) {
+                magma_offset_t nnz = MAGMA_CSR_NNZ( A );
+                if ( nnz > (magma_offset_t) INT_MAX ) {
+                    printf("error: %lld nonzeros do not fit into magma_int_t.\n",
+                           (long long) nnz );
+                    info = MAGMA_ERR_NOT_SUPPORTED;
+                    goto cleanup;
+                }
+                B->storage_type = Magma_COO;
+                B->memory_location = A.memory_location;
+                B->fill_mode = A.fill_mode;
+                B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+                B->num_cols = A.num_cols;
+                B->nnz = magma_int_t( nnz ); B->true_nnz = B->nnz;
+                B->max_nnz_row = A.max_nnz_row;
+                B->diameter = A.diameter;
+
+                CHECK( magma_zmalloc_cpu( &B->val, nnz ));
+                CHECK( magma_index_malloc_cpu( &B->row, nnz ));
+                CHECK( magma_index_malloc_cpu( &B->col, nnz ));
+                #pragma omp parallel for schedule(dynamic,1024)
+                for( magma_int_t i=0; i < A.num_rows; i++) {
+                    for( magma_offset_t j=A.row64[i]; j < A.row64[i+1]; j++) {
+                        B->row[j] = i;
+                        B->col[j] = A.col[j];
+                        B->val[j] = A.val[j];
+                    }
+                }
+            }
+            // CSR64 to CSR, and via CSR to anything else
+            else {
+                magma_offset_t nnz = MAGMA_CSR_NNZ( A );
+                if ( nnz > (magma_offset_t) INT_MAX ) {
+                    printf("error: %lld nonzeros do not fit into 32-bit CSR.\n",
+                           (long long) nnz );
+                    info = MAGMA_ERR_NOT_SUPPORTED;
+                    goto cleanup;
+                }
+                hA.storage_type = Magma_CSR;
+                hA.ownership = MagmaTrue;
+                hA.memory_location = A.memory_location;
+                hA.fill_mode = A.fill_mode;
+                hA.num_rows = A.num_rows; hA.true_nnz = A.true_nnz;
+                hA.num_cols = A.num_cols;
+                hA.nnz = magma_int_t( nnz ); hA.true_nnz = hA.nnz;
+                hA.max_nnz_row = A.max_nnz_row;
+                hA.diameter = A.diameter;
+                CHECK( magma_zmalloc_cpu( &hA.val, hA.nnz ));
+                CHECK( magma_index_malloc_cpu( &hA.row, A.num_rows+1 ));
+                CHECK( magma_index_malloc_cpu( &hA.col, hA.nnz ));
+                for( magma_int_t i=0; i < A.num_rows+1; i++) {
+                    hA.row[i] = (magma_index_t) A.row64[i];
+                }
+                for( magma_int_t i=0; i < hA.nnz; i++) {
+                    hA.val[i] = A.val[i];
+                    hA.col[i] = A.col[i];
+                }
+                if ( new_format == Magma_CSR ) {
+                    // hand over the arrays instead of copying them again
+                    *B = hA;
+                    hA.val = NULL;
+                    hA.col = NULL;
+                    hA.row = NULL;
+                } else {
+                    CHECK( magma_zmconvert( hA, B, Magma_CSR, new_format, queue ));
+                }
+            }
+        }
+        // CSR to CSR64
+        else if ( old_format == Magma_CSR && new_format == Magma_CSR64 ) {
+            B->storage_type = Magma_CSR64;
+            B->memory_location = A.memory_location;
+            B->fill_mode = A.fill_mode;
+            B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+            B->num_cols = A.num_cols;
+            B->nnz = A.nnz;
+            B->nnz64 = A.nnz;
+            B->max_nnz_row = A.max_nnz_row;
+            B->diameter = A.diameter;
+
+            CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+            CHECK( magma_offset_malloc_cpu( &B->row64, A.num_rows+1 ));
+            CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+            for( magma_int_t i=0; i < A.nnz; i++) {
+                B->val[i] = A.val[i];
+                B->col[i] = A.col[i];
+            }
+            for( magma_int_t i=0; i < A.num_rows+1; i++) {
+                B->row64[i] = A.row[i];
+            }
+        }
         // CSR to anything
-        if ( old_format == Magma_CSR )
+        else if ( old_format == Magma_CSR )
         {
             // CSR to CSR
             if ( new_format == Magma_CSR ) {
@@ -635,12 +750,21 @@ magma_zmconvert(
             // in SELLP we modify SELLC:
             // alignment is posible such that multiple threads can be used for SpMV
             // so the rowlength is padded (SELLP) to a multiple of the alignment
+            // for B->sellp_sigma > 1 (SELL-C-sigma), the rows are sorted by
+            // decreasing length within windows of sigma rows, so rows of
+            // similar length share a slice and need less padding;
+            // B->rowidx[i] is the original row index of the i-th stored row
             else if ( new_format == Magma_SELLP ) {
                 if( 256%(B->blocksize) !=0 ){
                     printf("error: blocksize not supported!\n");
                     info = MAGMA_ERR_NOT_SUPPORTED;
                     goto cleanup;
                 }
+                if( B->sellp_sigma > 1 && B->sellp_sigma%(B->blocksize) !=0 ){
+                    printf("error: sigma has to be a multiple of the blocksize!\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED;
+                    goto cleanup;
+                }
 
                 // fill in information for B
                 B->storage_type = new_format;
@@ -656,8 +780,29 @@ magma_zmconvert(
                 magma_int_t slices = ( A.num_rows+C-1)/(C);
                 B->numblocks = slices;
                 magma_int_t alignedlength, alignment = B->alignment;
+                magma_int_t sigma = B->sellp_sigma;
                 // conversion
-                magma_index_t i, j, k, maxrowlength=0;
+                magma_index_t i, j, maxrowlength=0;
+                magma_index_t *perm = NULL;
+                if ( sigma > 1 ) {
+                    // row permutation: stable sort by decreasing row length
+                    // within each window of sigma rows
+                    CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                    perm = B->rowidx;
+                    magma_int_t windows = ( A.num_rows+sigma-1)/(sigma);
+                    #pragma omp parallel for schedule(dynamic)
+                    for( magma_int_t w=0; w < windows; w++ ) {
+                        magma_index_t *begin = perm + w*sigma;
+                        magma_index_t *end   = perm + min( (w+1)*sigma, A.num_rows );
+                        for( magma_index_t *r=begin; r < end; r++ ) {
+                            *r = magma_index_t( r - perm );
+                        }
+                        std::stable_sort( begin, end,
+                            [&A]( magma_index_t r1, magma_index_t r2 ) {
+                                return A.row[r1+1]-A.row[r1] > A.row[r2+1]-A.row[r2];
+                            });
+                    }
+                }
                 CHECK( magma_index_malloc_cpu( &length, C));
                 // B-row points to the start of each slice
                 CHECK( magma_index_malloc_cpu( &B->row, slices+1 ));
@@ -668,7 +813,8 @@ magma_zmconvert(
                     maxrowlength = 0;
                     for(j=0; j < C; j++) {
                         if (i*C+j < A.num_rows) {
-                            length[j] = A.row[i*C+j+1]-A.row[i*C+j];
+                            magma_index_t line = perm ? perm[i*C+j] : i*C+j;
+                            length[j] = A.row[line+1]-A.row[line];
                         }
                         else
                             length[j]=0;
@@ -689,20 +835,22 @@ magma_zmconvert(
                 CHECK( magma_zmalloc_cpu( &B->val, B->row[slices] ));
                 CHECK( magma_index_malloc_cpu( &B->col, B->row[slices] ));
 
-                // zero everything
-                for( i=0; i < B->row[slices]; i++ ) {
-                    B->val[ i ] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[ i ] =  0;
-                }
-                // fill in values
-                for( i=0; i < slices; i++ ) {
-                    for(j=0; j < C; j++) {
-                        magma_int_t line = i*C+j;
+                // fill in values, zero the padding
+                #pragma omp parallel for
+                for( magma_int_t s=0; s < slices; s++ ) {
+                    for( magma_int_t l=B->row[s]; l < B->row[s+1]; l++ ) {
+                        B->val[ l ] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[ l ] =  0;
+                    }
+                    for( magma_int_t jj=0; jj < C; jj++ ) {
+                        magma_int_t line = s*C+jj;
                         magma_int_t offset = 0;
                         if ( line < A.num_rows) {
-                            for( k=A.row[line]; k < A.row[line+1]; k++ ) {
-                                B->val[ B->row[i] + j +offset*C ] = A.val[k];
-                                B->col[ B->row[i] + j +offset*C ] = A.col[k];
+                            if ( perm != NULL )
+                                line = perm[ line ];
+                            for( magma_int_t kk=A.row[line]; kk < A.row[line+1]; kk++ ) {
+                                B->val[ B->row[s] + jj +offset*C ] = A.val[kk];
+                                B->col[ B->row[s] + jj +offset*C ] = A.col[kk];
                                 offset++;
                             }
                         }
@@ -739,479 +887,22 @@ magma_zmconvert(
                 //printf( "done\n" );
             }
 
-            // CSR to BCSR
+            // CSR to BCSR; the CPU backend has no BCSR conversion
+            #ifndef MAGMA_HAVE_CPU
             else if ( new_format == Magma_BCSR ) {
                 CHECK( magma_zmtransfer(A, &dA, Magma_CPU, Magma_DEV, queue ) );
                 dB.blocksize = B->blocksize;
                 CHECK( magma_zmconvert(dA, &dB, Magma_CSR, Magma_BCSR, queue ) );
                 CHECK( magma_zmtransfer(dB, B, Magma_DEV, Magma_CPU, queue ) );
             }
+            #endif
 
             // CSR to CSR5
+            // see paper by W. LIU, B. VINTER
+            // CSR5: AN EFFICIENT STORAGE FORMAT FOR CROSS-PLATFORM
+            // SPARSE MATRIX-VECTOR MULTIPLICATION
             else if ( new_format == Magma_CSR5 ) {
-                //printf( "Conversion to CSR5: " );
-                // fill in information for B
-                B->storage_type = Magma_CSR5;
-                B->memory_location = A.memory_location;
-                B->fill_mode = A.fill_mode;
-                B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
-                B->num_cols = A.num_cols;
-                B->nnz = A.nnz;
-                B->max_nnz_row = A.max_nnz_row;
-                B->diameter = A.diameter;
-
-                CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
-                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-                CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
-
-                for( magma_int_t i=0; i < A.num_rows+1; i++) {
-                    B->row[i] = A.row[i];
-                }
-
-                // compute sigma
-                int r = 4;
-                int s = 32;
-                int t = 256;
-                int u = 6;
-
-                int csr_nnz_per_row = B->nnz / B->num_rows;
-                if (csr_nnz_per_row <= r)
-                    B->csr5_sigma = r;
-                else if (csr_nnz_per_row > r && csr_nnz_per_row <= s)
-                    B->csr5_sigma = csr_nnz_per_row;
-                else if (csr_nnz_per_row <= t && csr_nnz_per_row > s)
-                    B->csr5_sigma = s;
-                else // csr_nnz_per_row > t
-                    B->csr5_sigma = u;
-
-                // conversion
-                // compute #bits required for `y_offset' and `scansum_offset'
-                int base = 2;
-                B->csr5_bit_y_offset = 1;
-                while (base < MAGMA_CSR5_OMEGA * B->csr5_sigma)
-                { base *= 2; B->csr5_bit_y_offset++; }
-
-                base = 2;
-                B->csr5_bit_scansum_offset = 1;
-                while (base < MAGMA_CSR5_OMEGA)
-                { base *= 2; B->csr5_bit_scansum_offset++; }
-
-                if ( (size_t) B->csr5_bit_y_offset + B->csr5_bit_scansum_offset >
-                    sizeof(magma_uindex_t) * 8 - 1)
-                {
-                    printf("error: csr5-omega not supported.\n");
-                    info = MAGMA_ERR_NOT_SUPPORTED;
-                }
-
-                int bit_all = B->csr5_bit_y_offset + B->csr5_bit_scansum_offset
-                              + B->csr5_sigma;
-                B->csr5_num_packets = ceil((double)bit_all
-                                           /(double)(sizeof(magma_uindex_t)*8));
-
-                // calculate the number of tiles
-                B->csr5_p = ceil((double)B->nnz
-                                 / (double)(MAGMA_CSR5_OMEGA * B->csr5_sigma));
-                //printf("sigma = %i, p = %i\n", B->csr5_sigma, B->csr5_p);
-                // malloc the newly added arrays for CSR5
-                CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, B->csr5_p+1 ));
-                for( magma_int_t i=0; i<B->csr5_p+1; i++) {
-                    B->tile_ptr[i] = 0;
-                }
-
-                CHECK( magma_uindex_malloc_cpu( &B->tile_desc,
-                          B->csr5_p * MAGMA_CSR5_OMEGA * B->csr5_num_packets ));
-                for( magma_int_t i=0; i<B->csr5_p * MAGMA_CSR5_OMEGA
-                                        * B->csr5_num_packets; i++) {
-                    B->tile_desc[i] = 0;
-                }
-
-
-                CHECK( magma_zmalloc_cpu( &B->calibrator, B->csr5_p ));
-                for( magma_int_t i=0; i<B->csr5_p; i++) {
-                    B->calibrator[i] = MAGMA_Z_MAKE(0., 0.);
-                }
-
-                CHECK( magma_index_malloc_cpu( &B->tile_desc_offset_ptr,
-                                               B->csr5_p+1 ));
-                for( magma_int_t i=0; i<B->csr5_p+1; i++) {
-                    B->tile_desc_offset_ptr[i] = 0;
-                }
-
-
-                // convert csr data to csr5 data (3 steps)
-                // step 1 generate tile pointer
-                // step 1.1 binary search row pointer
-                for (magma_index_t global_id = 0; global_id <= B->csr5_p;
-                     global_id++)
-                {
-                    // compute tile boundaries by tile of size sigma * omega
-                    magma_index_t boundary = global_id * B->csr5_sigma
-                                             * MAGMA_CSR5_OMEGA;
-
-                    // clamp tile boundaries to [0, nnz]
-                    boundary = boundary > B->nnz ? B->nnz : boundary;
-
-                    // binary search
-                    magma_index_t start = 0, stop = B->num_rows, median;
-                    magma_index_t key_median;
-                    while (stop >= start)
-                    {
-                        median = (stop + start) / 2;
-                        key_median = B->row[median];
-                        if (boundary >= key_median)
-                            start = median + 1;
-                        else
-                            stop = median - 1;
-                    }
-                    B->tile_ptr[global_id] = start-1;
-                }
-                
-                // step 1.2 check empty rows
-                for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
-                    int dirty = 0;
-                
-                    magma_uindex_t start = B->tile_ptr[group_id];
-                    magma_uindex_t stop  = B->tile_ptr[group_id+1];
-                    start = (start << 1) >> 1;
-                    stop  = (stop << 1) >> 1;
-                
-                    if (start == stop)
-                        continue;
-                
-                    for (magma_uindex_t row_idx = start; row_idx <= stop; row_idx++) {
-                        if (B->row[row_idx] == B->row[row_idx+1]) {
-                            dirty = 1;
-                            break;
-                        }
-                    }
-                
-                    if (dirty) {
-                        start |= sizeof(magma_uindex_t) == 4
-                                           ? 0x80000000 : 0x8000000000000000;
-                        B->tile_ptr[group_id] = start;
-                    }
-                }
-                B->csr5_tail_tile_start = (B->tile_ptr[B->csr5_p-1] << 1) >> 1;
-                
-                // step 2. generate tile descriptor
-                
-                int bit_all_offset = B->csr5_bit_y_offset
-                                     + B->csr5_bit_scansum_offset;
-                
-                //generate_tile_descriptor_s1_kernel
-                for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                    const magma_index_t row_start = B->tile_ptr[par_id]
-                                                    & 0x7FFFFFFF;
-                    const magma_index_t row_stop  = B->tile_ptr[par_id + 1]
-                                                    & 0x7FFFFFFF;
-                
-                    for (int rid = row_start; rid <= row_stop; rid++) {
-                        int ptr = B->row[rid];
-                        int pid = ptr / (MAGMA_CSR5_OMEGA * B->csr5_sigma);
-                
-                        if (pid == par_id) {
-                            int lx = (ptr / B->csr5_sigma) % MAGMA_CSR5_OMEGA;
-                
-                            const int glid = ptr%B->csr5_sigma+bit_all_offset;
-                            const int ly = glid / 32;
-                            const int llid = glid % 32;
-                
-                            const magma_uindex_t val = 0x1 << (31 - llid);
-                
-                            const int location = pid * MAGMA_CSR5_OMEGA
-                                * B->csr5_num_packets
-                                + ly * MAGMA_CSR5_OMEGA + lx;
-                            B->tile_desc[location] |= val;
-                        }
-                    }
-                }
-                
-                //generate_tile_descriptor_s2_kernel
-                int num_thread = 1; //omp_get_max_threads();
-                magma_index_t *s_segn_scan_all, *s_present_all;
-                
-                CHECK( magma_index_malloc_cpu( &s_segn_scan_all,
-                                           2 * MAGMA_CSR5_OMEGA * num_thread ));
-                CHECK( magma_index_malloc_cpu( &s_present_all,
-                                           2 * MAGMA_CSR5_OMEGA * num_thread ));
-                
-                
-                //int *s_segn_scan_all = (int *)malloc(2 * MAGMA_CSR5_OMEGA
-                //                                   * sizeof(int) * num_thread);
-                //int *s_present_all   = (int *)malloc(2 * MAGMA_CSR5_OMEGA
-                //                                   * sizeof(int) * num_thread);
-                for (magma_index_t i = 0; i < num_thread; i++)
-                    s_present_all[i * 2 * MAGMA_CSR5_OMEGA + MAGMA_CSR5_OMEGA]
-                        = 1;
-                
-                //const int bit_all_offset = bit_y_offset + bit_scansum_offset;
-                
-                //#pragma omp parallel for
-                for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                    int tid = 0; //omp_get_thread_num();
-                    int *s_segn_scan = &s_segn_scan_all[tid * 2
-                                                        * MAGMA_CSR5_OMEGA];
-                    int *s_present = &s_present_all[tid * 2
-                                                        * MAGMA_CSR5_OMEGA];
-                
-                    memset(s_segn_scan, 0, (MAGMA_CSR5_OMEGA + 1)*sizeof(int));
-                    memset(s_present, 0, MAGMA_CSR5_OMEGA * sizeof(int));
-                
-                    bool with_empty_rows = (B->tile_ptr[par_id] >> 31) & 0x1;
-                    magma_index_t row_start       = B->tile_ptr[par_id]
-                                                    & 0x7FFFFFFF;
-                    const magma_index_t row_stop  = B->tile_ptr[par_id + 1]
-                                                    & 0x7FFFFFFF;
-                
-                    if (row_start == row_stop)
-                        continue;
-                
-                    //#pragma simd
-                    for (int lane_id = 0; lane_id < MAGMA_CSR5_OMEGA; lane_id++) {
-                        int start = 0, stop = 0, segn = 0;
-                        bool present = 0;
-                        magma_uindex_t bitflag = 0;
-                
-                        present |= !lane_id;
-                
-                        // extract the first bit-flag packet
-                        int ly = 0;
-                        magma_uindex_t first_packet = B->tile_desc[par_id
-                            * MAGMA_CSR5_OMEGA * B->csr5_num_packets+lane_id];
-                        bitflag = (first_packet << bit_all_offset)
-                                   | ((magma_uindex_t)present << 31);
-                        start = !((bitflag >> 31) & 0x1);
-                        present |= (bitflag >> 31) & 0x1;
-                
-                        for (int i = 1; i < B->csr5_sigma; i++) {
-                            if ((!ly && i == 32 - bit_all_offset)
-                                || (ly && (i - (32 - bit_all_offset)) % 32==0))
-                            {
-                                ly++;
-                                bitflag = B->tile_desc[par_id
-                                          * MAGMA_CSR5_OMEGA
-                                          * B->csr5_num_packets
-                                          + ly * MAGMA_CSR5_OMEGA + lane_id];
-                            }
-                            const int norm_i = !ly ? i
-                                               : i - (32 - bit_all_offset);
-                            stop += (bitflag >> (31 - norm_i % 32) ) & 0x1;
-                            present |= (bitflag >> (31 - norm_i % 32)) & 0x1;
-                        }
-                
-                        // compute y_offset for all tiles
-                        segn = stop - start + present;
-                        segn = segn > 0 ? segn : 0;
-                
-                        s_segn_scan[lane_id] = segn;
-                
-                        // compute scansum_offset
-                        s_present[lane_id] = present;
-                    }
-                
-                    //scan_single<int>(s_segn_scan, MAGMA_CSR5_OMEGA + 1);
-                    int old_val, new_val;
-                    old_val = s_segn_scan[0];
-                    s_segn_scan[0] = 0;
-                    for (int i = 1; i < MAGMA_CSR5_OMEGA + 1; i++) {
-                        new_val = s_segn_scan[i];
-                        s_segn_scan[i] = old_val + s_segn_scan[i-1];
-                        old_val = new_val;
-                    }
-                
-                    if (with_empty_rows) {
-                        B->tile_desc_offset_ptr[par_id]
-                            = s_segn_scan[MAGMA_CSR5_OMEGA];
-                        B->tile_desc_offset_ptr[B->csr5_p] = 1;
-                    }
-                
-                    //#pragma simd
-                    for (int lane_id = 0; lane_id < MAGMA_CSR5_OMEGA; lane_id++) {
-                        int y_offset = s_segn_scan[lane_id];
-                
-                        int scansum_offset = 0;
-                        int next1 = lane_id + 1;
-                        if (s_present[lane_id]) {
-                            while ( ! s_present[next1] && next1 < MAGMA_CSR5_OMEGA)
-                            {
-                                scansum_offset++;
-                                next1++;
-                            }
-                        }
-                
-                        magma_uindex_t first_packet = B->tile_desc[par_id
-                           * MAGMA_CSR5_OMEGA * B->csr5_num_packets + lane_id];
-                
-                        y_offset = lane_id ? y_offset - 1 : 0;
-                
-                        first_packet |= y_offset << (32-B->csr5_bit_y_offset);
-                        first_packet |= scansum_offset << (32-bit_all_offset);
-                
-                        B->tile_desc[par_id * MAGMA_CSR5_OMEGA
-                              * B->csr5_num_packets + lane_id] = first_packet;
-                    }
-                }
-                
-                magma_free_cpu(s_segn_scan_all);
-                magma_free_cpu(s_present_all);
-                
-                if (B->tile_desc_offset_ptr[B->csr5_p]) {
-                    //scan_single(B->tile_desc_offset_ptr, p+1);
-                    int old_val, new_val;
-                    old_val = B->tile_desc_offset_ptr[0];
-                    B->tile_desc_offset_ptr[0] = 0;
-                    for (int i = 1; i < B->csr5_p+1; i++)
-                    {
-                        new_val = B->tile_desc_offset_ptr[i];
-                        B->tile_desc_offset_ptr[i] = old_val
-                                                + B->tile_desc_offset_ptr[i-1];
-                        old_val = new_val;
-                    }
-                }
-                
-                B->csr5_num_offsets = B->tile_desc_offset_ptr[B->csr5_p];
-                
-                if (B->csr5_num_offsets) {
-                    CHECK( magma_index_malloc_cpu( &B->tile_desc_offset
-                                                   , B->csr5_num_offsets ));
-                
-                    //err = generate_tile_descriptor_offset
-                    const int bit_bitflag = 32 - bit_all_offset;
-                
-                    //#pragma omp parallel for
-                    for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                        bool with_empty_rows = (B->tile_ptr[par_id] >> 31)&0x1;
-                        if (!with_empty_rows)
-                            continue;
-                
-                        magma_index_t row_start       = B->tile_ptr[par_id]
-                                                        & 0x7FFFFFFF;
-                        const magma_index_t row_stop  = B->tile_ptr[par_id + 1]
-                                                        & 0x7FFFFFFF;
-                
-                        int offset_pointer = B->tile_desc_offset_ptr[par_id];
-                        //#pragma simd
-                        for (int lane_id = 0; lane_id < MAGMA_CSR5_OMEGA; lane_id++) {
-                            bool local_bit;
-                
-                            // extract the first bit-flag packet
-                            int ly = 0;
-                            magma_uindex_t descriptor = B->tile_desc[par_id
-                                * MAGMA_CSR5_OMEGA * B->csr5_num_packets
-                                + lane_id];
-                            int y_offset = descriptor
-                                           >> (32 - B->csr5_bit_y_offset);
-                
-                            descriptor = descriptor << bit_all_offset;
-                            descriptor = lane_id ? descriptor
-                                         : descriptor | 0x80000000;
-                
-                            local_bit = (descriptor >> 31) & 0x1;
-                
-                            if (local_bit && lane_id) {
-                                const magma_index_t idx = par_id
-                                    * MAGMA_CSR5_OMEGA * B->csr5_sigma
-                                    + lane_id * B->csr5_sigma;
-                                // binary search
-                                magma_index_t start = 0;
-                                magma_index_t stop = row_stop - row_start - 1;
-                                magma_index_t median, key_median;
-                                while (stop >= start) {
-                                    median = (stop + start) / 2;
-                                    key_median = B->row[row_start+1+median];
-                                    if (idx >= key_median)
-                                        start = median + 1;
-                                    else
-                                        stop = median - 1;
-                                }
-                                const magma_index_t y_index = start-1;
-                
-                                B->tile_desc_offset[offset_pointer + y_offset]
-                                    = y_index;
-                
-                                y_offset++;
-                            }
-                
-                            for (int i = 1; i < B->csr5_sigma; i++) {
-                                if ((!ly && i == bit_bitflag)
-                                    || (ly && !(31 & (i - bit_bitflag))))
-                                {
-                                    ly++;
-                                    descriptor = B->tile_desc[par_id
-                                        * MAGMA_CSR5_OMEGA
-                                        * B->csr5_num_packets
-                                        + ly * MAGMA_CSR5_OMEGA + lane_id];
-                                }
-                                const int norm_i = 31 & (!ly
-                                                        ? i : i - bit_bitflag);
-                
-                                local_bit = (descriptor >> (31 - norm_i))&0x1;
-                
-                                if (local_bit) {
-                                    const magma_index_t idx = par_id
-                                        * MAGMA_CSR5_OMEGA * B->csr5_sigma
-                                        + lane_id * B->csr5_sigma + i;
-                                    // binary search
-                                    magma_index_t start = 0;
-                                    magma_index_t stop = row_stop-row_start-1;
-                                    magma_index_t median, key_median;
-                                    while (stop >= start) {
-                                        median = (stop + start) / 2;
-                                        key_median=B->row[row_start+1+median];
-                                        if (idx >= key_median)
-                                            start = median + 1;
-                                        else
-                                            stop = median - 1;
-                                    }
-                                    const magma_index_t y_index = start-1;
-                
-                                    B->tile_desc_offset[offset_pointer
-                                                        + y_offset] = y_index;
-                
-                                    y_offset++;
-                                }
-                            }
-                        }
-                    }
-                }
-                
-                // step 3. transpose column_index and value arrays
-                //#pragma omp parallel for
-                for (int par_id = 0; par_id < B->csr5_p; par_id++) {
-                    // if this is fast track tile, do not transpose it
-                    if (B->tile_ptr[par_id] == B->tile_ptr[par_id + 1]) {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * B->csr5_sigma; idx++) {
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx;
-                            B->col[src_idx] = A.col[src_idx];
-                            B->val[src_idx] = A.val[src_idx];
-                        }
-                        continue;
-                    }
-                    //#pragma simd
-                    if (par_id < B->csr5_p-1) {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * B->csr5_sigma; idx++) {
-                            int idx_y = idx % B->csr5_sigma;
-                            int idx_x = idx / B->csr5_sigma;
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx;
-                            int dst_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * B->csr5_sigma + idx_y
-                                          * MAGMA_CSR5_OMEGA + idx_x;
-                
-                            B->col[dst_idx] = A.col[src_idx];
-                            B->val[dst_idx] = A.val[src_idx];
-                        }
-                    }
-                    else { // the last tile
-                        for (int idx = par_id * MAGMA_CSR5_OMEGA * B->csr5_sigma; idx < B->nnz; idx++) {
-                            B->col[idx] = A.col[idx];
-                            B->val[idx] = A.val[idx];
-                        }
-                    }
-                }
-
-                //printf( "done\n" );
+                CHECK( magma_zmcsr5_cpu( A, B, queue ));
             }
 
             else {
@@ -1234,14 +925,8 @@ magma_zmconvert(
             // CSRD to CSR (diagonal elements first)
             else if ( old_format == Magma_CSRD ) {
                 CHECK( magma_zmconvert( A, B, Magma_CSR, Magma_CSR, queue ));
-                for( magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_zindexsortval(
-                    B->col,
-                    B->val,
-                    B->row[i],
-                    B->row[i+1]-1,
-                    queue );
-                }
+                CHECK( magma_zcsr_sortrows_cpu( B->num_rows, B->row, B->col,
+                                                B->val, queue ));
             }
 
             // CSRCOO to CSR
@@ -1268,14 +953,8 @@ magma_zmconvert(
                     B->row[ row+1 ] = numnnz;
                 }
                 // sort elements in every row according to col
-                for( magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_zindexsortval(
-                    B->col,
-                    B->val,
-                    B->row[i],
-                    B->row[i+1]-1,
-                    queue );
-                }
+                CHECK( magma_zcsr_sortrows_cpu( B->num_rows, B->row, B->col,
+                                                B->val, queue ));
             }
 
             // ELL/ELLPACK to CSR
@@ -1465,13 +1144,20 @@ magma_zmconvert(
                 }
 
                 //transform RowMajor to ColMajor
+                //for SELL-C-sigma, undo the row permutation
                 for( magma_int_t k=0; k < slices; k++) {
                     magma_int_t blockinfo = (A.row[k+1]-A.row[k])/A.blocksize;
                     for( magma_int_t j=0; j < C; j++ ) {
+                        magma_int_t line = k*C+j;
+                        if ( A.rowidx != NULL ) {
+                            if ( line >= A.num_rows )
+                                continue;
+                            line = A.rowidx[ line ];
+                        }
                         for( magma_int_t i=0; i < blockinfo; i++ ) {
-                            col_tmp[ (k*C+j)*A.max_nnz_row+i ] =
+                            col_tmp[ line*A.max_nnz_row+i ] =
                                                     A.col[A.row[k]+i*C+j];
-                            val_tmp[ (k*C+j)*A.max_nnz_row+i ] =
+                            val_tmp[ line*A.max_nnz_row+i ] =
                                                     A.val[A.row[k]+i*C+j];
                         }
                     }
@@ -1509,17 +1195,18 @@ magma_zmconvert(
                 }
 
                 // step 1. transpose column_index and value arrays
-                //#pragma omp parallel for
+                #pragma omp parallel for
                 for (int par_id = 0; par_id < A.csr5_p; par_id++)
                 {
-                    // if this is fast track tile, do not transpose it
+                    // if this is fast track tile, do not transpose it;
+                    // the last tile may be shorter
                     if (A.tile_ptr[par_id] == A.tile_ptr[par_id + 1])
                     {
-                        for (int idx = 0; idx < MAGMA_CSR5_OMEGA * A.csr5_sigma; idx++) {
-                            int src_idx = par_id * MAGMA_CSR5_OMEGA
-                                          * A.csr5_sigma + idx;
-                            B->col[src_idx] = A.col[src_idx];
-                            B->val[src_idx] = A.val[src_idx];
+                        int begin = par_id * MAGMA_CSR5_OMEGA * A.csr5_sigma;
+                        int end = min( begin + MAGMA_CSR5_OMEGA * A.csr5_sigma, A.nnz );
+                        for (int idx = begin; idx < end; idx++) {
+                            B->col[idx] = A.col[idx];
+                            B->val[idx] = A.val[idx];
                         }
                         continue;
                     }
@@ -1600,6 +1287,7 @@ magma_zmconvert(
             }
 
             // BCSR to CSR
+            #ifndef MAGMA_HAVE_CPU
             else if ( old_format == Magma_BCSR ) {
                 CHECK( magma_zmtransfer(A, &dA, Magma_CPU, Magma_DEV, queue ) );
                 CHECK( magma_zmconvert(dA, &dB, Magma_BCSR, Magma_CSR, queue ) );
@@ -1607,14 +1295,26 @@ magma_zmconvert(
                 CHECK( magma_zmtransfer(dB, B, Magma_DEV, Magma_CPU, queue ) );
                 magma_zmfree( &dB, queue );
             }
+            #endif
 
             // COO to CSR
             else if ( old_format == Magma_COO ) {
-                CHECK( magma_zmtransfer(A, &dA, Magma_CPU, Magma_DEV, queue ) );
-                CHECK( magma_zmconvert(dA, &dB, Magma_COO, Magma_CSR, queue ) );
-                magma_zmfree( &dA, queue );
-                CHECK( magma_zmtransfer(dB, B, Magma_DEV, Magma_CPU, queue ) );
-                magma_zmfree( &dB, queue );
+                B->storage_type = Magma_CSR;
+                B->memory_location = A.memory_location;
+                B->fill_mode = A.fill_mode;
+                B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+                B->num_cols = A.num_cols;
+                B->nnz = A.nnz;
+                B->max_nnz_row = A.max_nnz_row;
+                B->diameter = A.diameter;
+
+                CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+                CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+                CHECK( magma_zcoo2csr_cpu( A.num_rows, A.nnz, A.row, A.col, A.val,
+                                           B->row, B->col, B->val, queue ));
+                CHECK( magma_zcsr_sortrows_cpu( B->num_rows, B->row, B->col,
+                                                B->val, queue ));
             }
 
             else {
@@ -1630,6 +1330,12 @@ magma_zmconvert(
         }
     } // end CPU case
     else if ( A.memory_location == Magma_DEV ) {
+        #ifdef MAGMA_HAVE_CPU
+        // CPU backend: device memory is host memory; convert on the host
+        CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+        CHECK( magma_zmconvert( hA, &hB, old_format, new_format, queue ));
+        CHECK( magma_zmtransfer( hB, B, Magma_CPU, A.memory_location, queue ));
+        #else
         // CSR to CSR
         if ( old_format == Magma_CSR && new_format == Magma_CSR ) {
             CHECK( magma_zmtransfer( A, B, Magma_DEV, Magma_DEV, queue ));
@@ -1965,13 +1671,16 @@ magma_zmconvert(
             CHECK( magma_zmconvert( hA, &hB, old_format, new_format, queue ));
             CHECK( magma_zmtransfer( hB, B, Magma_CPU, A.memory_location, queue ));
         }
+        #endif
     }
 
 cleanup:
+    #ifndef MAGMA_HAVE_CPU
     cusparseDestroyMatDescr(descr);
     cusparseDestroy(cusparseHandle);
     descr = NULL;
     cusparseHandle = NULL;
+    #endif
     magma_free( nnz_per_row );
     magma_free_cpu( row_tmp );
     magma_free_cpu( col_tmp );
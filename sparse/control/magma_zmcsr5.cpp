@@ -0,0 +1,437 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// high bit of a tile pointer: the tile contains empty rows
+#define MAGMA_CSR5_EMPTY_FLAG 0x80000000
+#define MAGMA_CSR5_ROW_MASK   0x7FFFFFFF
+
+
+/**
+    Exclusive prefix sum of a[0..n), in place. Each thread scans a
+    contiguous block; the block sums are scanned serially, then each
+    thread adds the offset of its block. partial holds nthreads+1 entries.
+*/
+static void
+magma_zmcsr5_scan(
+    magma_index_t *a,
+    magma_int_t n,
+    magma_index_t *partial,
+    magma_int_t nthreads )
+{
+    #pragma omp parallel num_threads(nthreads)
+    {
+        magma_int_t tid = 0, nt = 1;
+        #ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nt  = omp_get_num_threads();
+        #endif
+        magma_int_t begin = (n *  tid   ) / nt;
+        magma_int_t end   = (n * (tid+1)) / nt;
+        magma_index_t sum = 0;
+        for( magma_int_t i=begin; i < end; i++ ) {
+            magma_index_t tmp = a[i];
+            a[i] = sum;
+            sum += tmp;
+        }
+        partial[tid+1] = sum;
+        #pragma omp barrier
+        #pragma omp single
+        {
+            partial[0] = 0;
+            for( magma_int_t t=0; t < nt; t++ ) {
+                partial[t+1] += partial[t];
+            }
+        }
+        for( magma_int_t i=begin; i < end; i++ ) {
+            a[i] += partial[tid];
+        }
+    }
+}
+
+
+/**
+    Binary search: the largest i in [lo, hi] with row[i] <= key,
+    or lo-1 if there is none.
+*/
+static inline magma_index_t
+magma_zmcsr5_search(
+    const magma_index_t *row,
+    magma_index_t lo,
+    magma_index_t hi,
+    magma_index_t key )
+{
+    magma_index_t start = lo, stop = hi;
+    while (stop >= start) {
+        magma_index_t median = (stop + start) / 2;
+        if (key >= row[median])
+            start = median + 1;
+        else
+            stop = median - 1;
+    }
+    return start-1;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Converts a CSR matrix into CSR5 on the CPU, as used by
+    magma_zmconvert and consumed by magma_zgecsr5mv.
+
+    All steps are parallel over the tiles with OpenMP: the tile pointers
+    are found by binary search in the row pointer, the bit flags of the
+    row starts are packed into the tile descriptors, the y and scansum
+    offsets are computed with a per-tile scan, the offsets of the tiles
+    with empty rows are placed with a parallel prefix sum, and the
+    column indices and values are transposed tile by tile.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix in CSR, in CPU memory
+
+    @param[out]
+    B           magma_z_matrix*
+                sparse matrix in CSR5
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmcsr5_cpu(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *partial = NULL;
+    magma_int_t nthreads = magma_get_parallel_numthreads();
+
+    const magma_int_t omega = MAGMA_CSR5_OMEGA;
+    magma_int_t sigma, p, tile_size, bit_all_offset, num_packets;
+
+    CHECK_NOT_CSR64( A );
+
+    magma_zmfree( B, queue );
+    B->ownership = MagmaTrue;
+
+    B->storage_type = Magma_CSR5;
+    B->memory_location = A.memory_location;
+    B->fill_mode = A.fill_mode;
+    B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+    B->num_cols = A.num_cols;
+    B->nnz = A.nnz;
+    B->max_nnz_row = A.max_nnz_row;
+    B->diameter = A.diameter;
+
+    // compute sigma
+    {
+        int r = 4;
+        int s = 32;
+        int t = 256;
+        int u = 6;
+
+        int csr_nnz_per_row = A.num_rows > 0 ? A.nnz / A.num_rows : 0;
+        if (csr_nnz_per_row <= r)
+            B->csr5_sigma = r;
+        else if (csr_nnz_per_row > r && csr_nnz_per_row <= s)
+            B->csr5_sigma = csr_nnz_per_row;
+        else if (csr_nnz_per_row <= t && csr_nnz_per_row > s)
+            B->csr5_sigma = s;
+        else // csr_nnz_per_row > t
+            B->csr5_sigma = u;
+    }
+    sigma = B->csr5_sigma;
+    tile_size = omega * sigma;
+
+    // compute #bits required for `y_offset' and `scansum_offset'
+    {
+        int base = 2;
+        B->csr5_bit_y_offset = 1;
+        while (base < tile_size)
+        { base *= 2; B->csr5_bit_y_offset++; }
+
+        base = 2;
+        B->csr5_bit_scansum_offset = 1;
+        while (base < omega)
+        { base *= 2; B->csr5_bit_scansum_offset++; }
+    }
+    if ( (size_t) B->csr5_bit_y_offset + B->csr5_bit_scansum_offset >
+        sizeof(magma_uindex_t) * 8 - 1)
+    {
+        printf("error: csr5-omega not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    bit_all_offset = B->csr5_bit_y_offset + B->csr5_bit_scansum_offset;
+    B->csr5_num_packets = magma_ceildiv( bit_all_offset + sigma,
+                                         (magma_int_t) sizeof(magma_uindex_t)*8 );
+    num_packets = B->csr5_num_packets;
+
+    // the number of tiles
+    B->csr5_p = magma_ceildiv( A.nnz, tile_size );
+    p = B->csr5_p;
+
+    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+    CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, p+1 ));
+    CHECK( magma_uindex_malloc_cpu( &B->tile_desc, p * omega * num_packets ));
+    CHECK( magma_zmalloc_cpu( &B->calibrator, p ));
+    CHECK( magma_index_malloc_cpu( &B->tile_desc_offset_ptr, p+1 ));
+    CHECK( magma_index_malloc_cpu( &partial, nthreads+1 ));
+
+    #pragma omp parallel for num_threads(nthreads)
+    for( magma_int_t i=0; i < A.num_rows+1; i++ ) {
+        B->row[i] = A.row[i];
+    }
+    #pragma omp parallel for num_threads(nthreads)
+    for( magma_int_t i=0; i < p * omega * num_packets; i++ ) {
+        B->tile_desc[i] = 0;
+    }
+    for( magma_int_t i=0; i < p; i++ ) {
+        B->calibrator[i] = MAGMA_Z_ZERO;
+    }
+
+    // step 1: tile pointers, the first row of each tile, with the high
+    // bit set if a row in the tile is empty
+    #pragma omp parallel for num_threads(nthreads)
+    for( magma_int_t tid=0; tid <= p; tid++ ) {
+        magma_index_t boundary = (magma_index_t) min( tid * tile_size, A.nnz );
+        B->tile_ptr[tid] = magma_zmcsr5_search( A.row, 0, A.num_rows, boundary );
+    }
+    // the flags go to tile_desc_offset_ptr first, as tile tid reads
+    // tile_ptr[tid+1]
+    #pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+    for( magma_int_t tid=0; tid < p; tid++ ) {
+        magma_uindex_t start = B->tile_ptr[tid];
+        magma_uindex_t stop  = B->tile_ptr[tid+1];
+        B->tile_desc_offset_ptr[tid] = 0;
+        if (start == stop)
+            continue;
+        for( magma_uindex_t r=start; r <= stop && r < (magma_uindex_t) A.num_rows; r++ ) {
+            if (A.row[r] == A.row[r+1]) {
+                B->tile_desc_offset_ptr[tid] = 1;
+                break;
+            }
+        }
+    }
+    #pragma omp parallel for num_threads(nthreads)
+    for( magma_int_t tid=0; tid < p; tid++ ) {
+        if (B->tile_desc_offset_ptr[tid]) {
+            B->tile_ptr[tid] |= MAGMA_CSR5_EMPTY_FLAG;
+        }
+    }
+    B->csr5_tail_tile_start = p > 0 ? (B->tile_ptr[p-1] & MAGMA_CSR5_ROW_MASK) : 0;
+
+    // step 2: tile descriptors of all but the last tile
+    #pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+    for( magma_int_t tid=0; tid < p-1; tid++ ) {
+        magma_uindex_t *desc = B->tile_desc + tid * omega * num_packets;
+        const magma_index_t row_start = B->tile_ptr[tid]   & MAGMA_CSR5_ROW_MASK;
+        const magma_index_t row_stop  = B->tile_ptr[tid+1] & MAGMA_CSR5_ROW_MASK;
+        const bool with_empty_rows = (B->tile_ptr[tid] >> 31) & 0x1;
+
+        // step 2.1: bit flags of the rows starting in this tile, packed
+        // behind the y and scansum offsets of each lane
+        for( magma_index_t rid=row_start; rid <= row_stop; rid++ ) {
+            magma_index_t ptr = A.row[rid];
+            if (ptr / tile_size == tid) {
+                const int lx = (ptr / sigma) % omega;
+                const int glid = ptr % sigma + bit_all_offset;
+                const int ly = glid / 32;
+                const int llid = glid % 32;
+                desc[ ly * omega + lx ] |= 0x1u << (31 - llid);
+            }
+        }
+
+        B->tile_desc_offset_ptr[tid] = 0;
+        if (row_start == row_stop)
+            continue;
+
+        // step 2.2: number of segments and presence of a row start per lane
+        magma_index_t s_segn_scan[ MAGMA_CSR5_OMEGA+1 ];
+        int s_present[ MAGMA_CSR5_OMEGA+1 ];
+        s_segn_scan[ omega ] = 0;
+        s_present[ omega ] = 1;
+        for( int lane_id=0; lane_id < omega; lane_id++ ) {
+            int start = 0, stop = 0, segn = 0;
+            bool present = 0;
+            magma_uindex_t bitflag = 0;
+
+            present |= !lane_id;
+
+            // extract the first bit-flag packet
+            int ly = 0;
+            magma_uindex_t first_packet = desc[ lane_id ];
+            bitflag = (first_packet << bit_all_offset)
+                       | ((magma_uindex_t)present << 31);
+            start = !((bitflag >> 31) & 0x1);
+            present |= (bitflag >> 31) & 0x1;
+
+            for( int i=1; i < sigma; i++ ) {
+                if ((!ly && i == 32 - bit_all_offset)
+                    || (ly && (i - (32 - bit_all_offset)) % 32 == 0))
+                {
+                    ly++;
+                    bitflag = desc[ ly * omega + lane_id ];
+                }
+                const int norm_i = !ly ? i : i - (32 - bit_all_offset);
+                stop    += (bitflag >> (31 - norm_i % 32)) & 0x1;
+                present |= (bitflag >> (31 - norm_i % 32)) & 0x1;
+            }
+
+            // y_offset for all tiles
+            segn = stop - start + present;
+            s_segn_scan[ lane_id ] = segn > 0 ? segn : 0;
+            s_present[ lane_id ] = present;
+        }
+
+        // exclusive scan of the segment counts over the lanes
+        {
+            magma_index_t sum = 0;
+            for( int i=0; i < omega + 1; i++ ) {
+                magma_index_t tmp = s_segn_scan[i];
+                s_segn_scan[i] = sum;
+                sum += tmp;
+            }
+        }
+        if (with_empty_rows) {
+            B->tile_desc_offset_ptr[tid] = s_segn_scan[ omega ];
+        }
+
+        // step 2.3: pack y_offset and scansum_offset into the first packet
+        for( int lane_id=0; lane_id < omega; lane_id++ ) {
+            int y_offset = s_segn_scan[ lane_id ];
+
+            int scansum_offset = 0;
+            int next1 = lane_id + 1;
+            if (s_present[ lane_id ]) {
+                while ( ! s_present[ next1 ] && next1 < omega ) {
+                    scansum_offset++;
+                    next1++;
+                }
+            }
+
+            y_offset = lane_id ? y_offset - 1 : 0;
+
+            magma_uindex_t first_packet = desc[ lane_id ];
+            first_packet |= y_offset << (32 - B->csr5_bit_y_offset);
+            first_packet |= scansum_offset << (32 - bit_all_offset);
+            desc[ lane_id ] = first_packet;
+        }
+    }
+    if ( p > 0 ) {
+        B->tile_desc_offset_ptr[p-1] = 0;
+    }
+    B->tile_desc_offset_ptr[p] = 0;
+
+    // step 3: offsets of the tiles with empty rows
+    magma_zmcsr5_scan( B->tile_desc_offset_ptr, p+1, partial, nthreads );
+    B->csr5_num_offsets = B->tile_desc_offset_ptr[p];
+
+    if (B->csr5_num_offsets) {
+        CHECK( magma_index_malloc_cpu( &B->tile_desc_offset, B->csr5_num_offsets ));
+        #pragma omp parallel for num_threads(nthreads)
+        for( magma_int_t i=0; i < B->csr5_num_offsets; i++ ) {
+            B->tile_desc_offset[i] = 0;
+        }
+
+        const int bit_bitflag = 32 - bit_all_offset;
+
+        #pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+        for( magma_int_t tid=0; tid < p-1; tid++ ) {
+            const bool with_empty_rows = (B->tile_ptr[tid] >> 31) & 0x1;
+            if (!with_empty_rows)
+                continue;
+
+            const magma_uindex_t *desc = B->tile_desc + tid * omega * num_packets;
+            const magma_index_t row_start = B->tile_ptr[tid]   & MAGMA_CSR5_ROW_MASK;
+            const magma_index_t row_stop  = B->tile_ptr[tid+1] & MAGMA_CSR5_ROW_MASK;
+            magma_index_t *offset = B->tile_desc_offset + B->tile_desc_offset_ptr[tid];
+
+            for( int lane_id=0; lane_id < omega; lane_id++ ) {
+                // extract the first bit-flag packet
+                int ly = 0;
+                magma_uindex_t descriptor = desc[ lane_id ];
+                int y_offset = descriptor >> (32 - B->csr5_bit_y_offset);
+
+                descriptor = descriptor << bit_all_offset;
+                descriptor = lane_id ? descriptor : descriptor | 0x80000000;
+
+                bool local_bit = (descriptor >> 31) & 0x1;
+                if (local_bit && lane_id) {
+                    const magma_index_t idx = tid * tile_size + lane_id * sigma;
+                    offset[ y_offset ] = magma_zmcsr5_search(
+                        A.row + row_start+1, 0, row_stop - row_start - 1, idx );
+                    y_offset++;
+                }
+
+                for( int i=1; i < sigma; i++ ) {
+                    if ((!ly && i == bit_bitflag)
+                        || (ly && !(31 & (i - bit_bitflag))))
+                    {
+                        ly++;
+                        descriptor = desc[ ly * omega + lane_id ];
+                    }
+                    const int norm_i = 31 & (!ly ? i : i - bit_bitflag);
+
+                    local_bit = (descriptor >> (31 - norm_i)) & 0x1;
+                    if (local_bit) {
+                        const magma_index_t idx = tid * tile_size + lane_id * sigma + i;
+                        offset[ y_offset ] = magma_zmcsr5_search(
+                            A.row + row_start+1, 0, row_stop - row_start - 1, idx );
+                        y_offset++;
+                    }
+                }
+            }
+        }
+    }
+
+    // step 4: transpose column indices and values of the full tiles;
+    // fast-track tiles (within a single row) and the last tile are copied
+    #pragma omp parallel for num_threads(nthreads)
+    for( magma_int_t tid=0; tid < p; tid++ ) {
+        const magma_int_t begin = tid * tile_size;
+        if (tid < p-1 && B->tile_ptr[tid] != B->tile_ptr[tid+1]) {
+            for( magma_int_t idx=0; idx < tile_size; idx++ ) {
+                magma_int_t dst = begin + (idx % sigma) * omega + idx / sigma;
+                B->col[ dst ] = A.col[ begin + idx ];
+                B->val[ dst ] = A.val[ begin + idx ];
+            }
+        }
+        else {
+            const magma_int_t end = min( begin + tile_size, A.nnz );
+            for( magma_int_t idx=begin; idx < end; idx++ ) {
+                B->col[ idx ] = A.col[ idx ];
+                B->val[ idx ] = A.val[ idx ];
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( partial );
+    if ( info != 0 ) {
+        magma_zmfree( B, queue );
+    }
+    return info;
+}
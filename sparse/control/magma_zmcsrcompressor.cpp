@@ -41,6 +41,8 @@ magma_zmcsrcompressor(
     magma_z_matrix B={Magma_CSR};
     magma_z_matrix hA={Magma_CSR}, CSRA={Magma_CSR};
         
+    CHECK_NOT_CSR64( *A );
+
     if (A->ownership) {
         if ( A->memory_location == Magma_CPU && A->storage_type == Magma_CSR ) {
             CHECK( magma_zmconvert( *A, &B, Magma_CSR, Magma_CSR, queue ));
@@ -59,6 +59,10 @@ magma_zmfrobenius(
         
     magma_z_matrix hA={Magma_CSR}, hB={Magma_CSR}, hS={Magma_CSR};
 
+    CHECK_NOT_CSR64( A );
+    CHECK_NOT_CSR64( B );
+    CHECK_NOT_CSR64( S );
+
     CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue  ));
     CHECK( magma_zmtransfer( B, &hB, B.memory_location, Magma_CPU, queue  ));
     CHECK( magma_zmtransfer( S, &hS, S.memory_location, Magma_CPU, queue  ));
@@ -9,274 +9,188 @@
        @author Hartwig Anzt
 */
 
-//  in this file, many routines are taken from
-//  the IO functions provided by MatrixMarket
+#include <algorithm>
+#include <vector>
 
 #include "magmasparse_internal.h"
 
 
-/******************************************************************************
- * ILU mex function from MATLAB:
- *
- * [l, u] = ilu_mex(a, level, omega, storage);
- *****************************************************************************/
-
-#define mwIndex magma_index_t
-
-
-
-void magma_zshell_sort(
-    const magma_int_t n, magma_index_t *x)
+/*
+    Fill-path search for row i of the ILU(levfill) pattern of A (Hysom and
+    Pothen, incomplete fill path theorem): (i,j) is in the pattern if and
+    only if G(A) contains a path from i to j with at most levfill+1 edges
+    whose intermediate vertices are all numbered below min(i,j). Its level
+    of fill is the length of the shortest such path minus one.
+
+    After round r, bound[v] is the smallest possible largest intermediate
+    vertex over all paths from i to v with at most r+1 edges, -1 for the
+    entries of A, n if v was not reached. Only vertices h < i can be
+    intermediates, and only vertices whose bound dropped in the previous
+    round are expanded. The search does not depend on other rows of the
+    factors, so all rows can be processed concurrently.
+
+    On return, touched holds the reached vertices; the caller selects
+    those with bound[v] < min(i,v) and resets bound and mark.
+*/
+static void
+magma_zsymbolic_ilu_row(
+    magma_int_t i,
+    magma_int_t levfill,
+    magma_int_t n,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    std::vector<magma_index_t> &bound,
+    std::vector<magma_index_t> &mark,
+    std::vector<magma_index_t> &touched,
+    std::vector<magma_index_t> &front,
+    std::vector<magma_index_t> &next,
+    std::vector<magma_index_t> &frontval )
 {
-    magma_int_t m, max, j, k, itemp;
-
-    m = n/2;
+    touched.clear();
+    front.clear();
+    for( magma_index_t e=ia[i]; e < ia[i+1]; e++ ) {
+        magma_index_t v = ja[e];
+        if ( bound[v] == n ) {
+            touched.push_back( v );
+            if ( v < i ) {
+                front.push_back( v );
+            }
+        }
+        bound[v] = -1;
+    }
 
-    while (m > 0) {
-        max = n - m;
-        for (j=0; j<max; j++)
-        {
-            for (k=j; k>=0; k-=m)
-            {
-                if (x[k+m] >= x[k])
-                    break;
-                itemp = x[k+m];
-                x[k+m] = x[k];
-                x[k] = itemp;
+    for( magma_int_t lev=1; lev <= levfill && ! front.empty(); lev++ ) {
+        // paths of this round extend the bounds of the previous round
+        frontval.resize( front.size() );
+        for( size_t f=0; f < front.size(); f++ ) {
+            frontval[f] = bound[ front[f] ];
+        }
+        next.clear();
+        for( size_t f=0; f < front.size(); f++ ) {
+            magma_index_t h = front[f];
+            magma_index_t b = max( frontval[f], h );
+            for( magma_index_t e=ia[h]; e < ia[h+1]; e++ ) {
+                magma_index_t v = ja[e];
+                if ( b < bound[v] ) {
+                    if ( bound[v] == n ) {
+                        touched.push_back( v );
+                    }
+                    bound[v] = b;
+                    if ( v < i && mark[v] != lev ) {
+                        mark[v] = magma_index_t( lev );
+                        next.push_back( v );
+                    }
+                }
             }
         }
-        m = m/2;
+        front.swap( next );
     }
 }
 
+
 /*
-// symbolic level ILU
-// factors magma_int_to separate upper and lower parts
-// sorts the entries in each row of A by index
-// assumes no zero rows
+    Symbolic ILU(levfill) factorization of the n-by-n CSR pattern (ia, ja).
+    On output, (ial, *jal) holds the strictly lower triangular part of the
+    pattern and (iau, *jau) the upper triangular part including the
+    diagonal, both with sorted column indices. ial and iau have to provide
+    n+1 entries; jal and jau are allocated with the exact size.
+
+    Every row is computed independently by magma_zsymbolic_ilu_row. A
+    first parallel pass counts the entries of each row, a prefix sum gives
+    the row pointers, and a second pass writes the column indices.
 */
-
-extern "C"
-magma_int_t
+static magma_int_t
 magma_zsymbolic_ilu(
-    const magma_int_t levfill,                 /* level of fill */
-    const magma_int_t n,                       /* order of matrix */
-    magma_int_t *nzl,                          /* input-output */
-    magma_int_t *nzu,                          /* input-output */
-    const mwIndex *ia,
-    const mwIndex *ja,    /* input */
-    mwIndex *ial,
-    mwIndex *jal,              /* output lower factor structure */
-    mwIndex *iau,
-    mwIndex *jau)              /* output upper factor structure */
+    magma_int_t levfill,
+    magma_int_t n,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *ial,
+    magma_index_t **jal,
+    magma_index_t *iau,
+    magma_index_t **jau,
+    magma_queue_t queue )
 {
     magma_int_t info = 0;
-    
-    magma_int_t i;
-    magma_index_t *lnklst=NULL;
-    magma_index_t *curlev=NULL;
-    magma_index_t *levels=NULL;
-    magma_index_t *iwork=NULL;
-    
-    magma_int_t knzl = 0;
-    magma_int_t knzu = 0;
-
-    CHECK( magma_index_malloc_cpu( &lnklst, n ));
-    CHECK( magma_index_malloc_cpu( &curlev, n ));
-    CHECK( magma_index_malloc_cpu( &levels, *nzu ));
-    CHECK( magma_index_malloc_cpu( &iwork, n ));
-    
-    for(magma_int_t t=0; t<n; t++){
-        lnklst[t] = 0;
-        curlev[t] = 0;
-        iwork[t] = 0;
-    }
-
-    for(magma_int_t t=0; t<*nzu; t++){
-        levels[t] = 0;
-    }
-
-    ial[0] = 0;
-    iau[0] = 0;
-
-    for (i=0; i<n; i++) {
-        //printf("check line %d\n", i);
-        magma_int_t first, next, j;
-
-        /* copy column indices of row into workspace and sort them */
-
-        magma_int_t len = ia[i+1] - ia[i];
-        next = 0;
-        for (j=ia[i]; j<ia[i+1]; j++)
-            iwork[next++] = ja[j];
-        magma_zshell_sort(len, iwork);
-        //printf("check2 line %d\n", i);
-        /* construct implied linked list for row */
+    magma_int_t singular = 0;
 
-        first = iwork[0];
-        curlev[first] = 0;
+    *jal = NULL;
+    *jau = NULL;
 
-        for (j=0; j<=len-2; j++)
+    for( magma_int_t pass=0; pass < 2; pass++ ) {
+        #pragma omp parallel reduction(+:singular)
         {
-            lnklst[iwork[j]] = iwork[j+1];
-            curlev[iwork[j]] = 0;
-        }
-        // printf("check3 line %d iwork[len-1]:%d\n", i, iwork[len-1]);
-        lnklst[iwork[len-1]] = n;
-        curlev[iwork[len-1]] = 0;
-
-        /* merge with rows in U */
-        // printf("check4 line %d lnklst[iwork[len-1]]:%d\n", i, lnklst[iwork[len-1]]);
-        next = first;
-        // printf("next:%d (!<) first:%d\n", next, i);
-        while (next < i)
-        {
-          //  printf("check line %d while %d\n", i, next);
-            magma_int_t oldlst = next;
-            magma_int_t nxtlst = lnklst[next];
-            magma_int_t row = next;
-            magma_int_t ii;
-
-            /* scan row */
-
-            for (ii=iau[row]+1; ii<iau[row+1]; /*nop*/)
-            {
-                if (jau[ii] < nxtlst)
-                {
-                    /* new fill-in */
-                    magma_int_t newlev = curlev[row] + levels[ii] + 1;
-                    if (newlev <= levfill)
-                    {
-                        lnklst[oldlst]  = jau[ii];
-                        lnklst[jau[ii]] = nxtlst;
-                        oldlst = jau[ii];
-                        curlev[jau[ii]] = newlev;
+            std::vector<magma_index_t> bound( n, magma_index_t(n) ), mark( n, 0 );
+            std::vector<magma_index_t> touched, front, next, frontval;
+            #pragma omp for schedule(dynamic, 256)
+            for( magma_int_t i=0; i < n; i++ ) {
+                magma_zsymbolic_ilu_row( i, levfill, n, ia, ja, bound, mark,
+                                         touched, front, next, frontval );
+                magma_index_t nl = 0, nu = 0;
+                bool diag = false;
+                for( size_t t=0; t < touched.size(); t++ ) {
+                    magma_index_t v = touched[t];
+                    if ( bound[v] < min( magma_index_t(i), v ) ) {
+                        if ( v < i ) {
+                            if ( pass == 1 ) {
+                                (*jal)[ ial[i] + nl ] = v;
+                            }
+                            nl++;
+                        } else {
+                            if ( pass == 1 ) {
+                                (*jau)[ iau[i] + nu ] = v;
+                            }
+                            nu++;
+                            diag = diag || ( v == i );
+                        }
                     }
-                    ii++;
-                }
-                else if (jau[ii] == nxtlst)
-                {
-                    magma_int_t newlev;
-                    oldlst = nxtlst;
-                    nxtlst = lnklst[oldlst];
-                    newlev = curlev[row] + levels[ii] + 1;
-                    curlev[jau[ii]] = min( curlev[jau[ii]], newlev );
-                    ii++;
+                    bound[v] = magma_index_t(n);
+                    mark[v] = 0;
                 }
-                else /* (jau[ii] > nxtlst) */
-                {
-                    oldlst = nxtlst;
-                    nxtlst = lnklst[oldlst];
+                if ( pass == 0 ) {
+                    ial[i+1] = nl;
+                    iau[i+1] = nu;
+                    singular += ! diag;
+                } else {
+                    std::sort( *jal + ial[i], *jal + ial[i+1] );
+                    std::sort( *jau + iau[i], *jau + iau[i+1] );
                 }
             }
-            next = lnklst[next];
-        }
-        
-        /* gather the pattern magma_int_to L and U */
-       // printf("check line5 %d\n", i);
-        next = first;
-        while (next < i)
-        {
-            if (knzl >= *nzl) {
-                printf("ILU: STORAGE parameter value %d<%d too small.\n", int(*nzl), int(knzl));
-                printf("Increase STORAGE parameter.\n");
-                info = -1;
-                goto cleanup;
-            }
-            jal[knzl++] = next;
-            next = lnklst[next];
-        }
-        ial[i+1] = knzl;
-        //  printf("check line6 %d\n", i);
-        if (next != i)
-        {
-            printf("ILU structurally singular.\n");
-            /*
-                assert(knzu < *nzu);
-                levels[knzu] = 2*n;
-                jau[knzu++] = i;
-            */
         }
-        //  printf("check line7 %d\n", i);
-        //                 printf("next:%d  n:%d \n", next, n);
-        while (next < n)
-        {
-            if (knzu >= *nzu) {
-                printf("ILU: STORAGE parameter value %d < %d too small.\n", int(*nzu), int(knzu));
-                printf("Increase STORAGE parameter.\n");
-                info = -1;
-                goto cleanup;
-            }
-            // printf("1 knzu:%d  next:%d \n", knzu, next );
-            levels[knzu] = curlev[next];
-            //  printf("2 knzu:%d  next:%d \n", knzu, next );
-            jau[knzu++] = next;
-            //  printf("3 knzu:%d  next:%d \n", knzu, next );
-            next = lnklst[next];
-            //  printf("4 next:%d  n:%d \n", next, n);
+        if ( pass == 0 ) {
+            ial[0] = 0;
+            iau[0] = 0;
+            CHECK( magma_zmatrix_createrowptr( n, ial, queue ));
+            CHECK( magma_zmatrix_createrowptr( n, iau, queue ));
+            CHECK( magma_index_malloc_cpu( jal, ial[n] ));
+            CHECK( magma_index_malloc_cpu( jau, iau[n] ));
         }
-        iau[i+1] = knzu;
     }
-
-    *nzl = knzl;
-    *nzu = knzu;
-
-    // printf("ende\n");
-
-#if 0
-    printf( "Actual nnz for ILU: %d\n", *nzl + *nzu );
-#endif
+    if ( singular > 0 ) {
+        printf("%% ILU structurally singular: %lld rows without diagonal.\n",
+               (long long) singular );
+    }
 
 cleanup:
-    magma_free_cpu(lnklst);
-    magma_free_cpu(curlev);
-    magma_free_cpu(levels);
-    magma_free_cpu(iwork);
-    
+    if ( info != 0 ) {
+        magma_free_cpu( *jal );
+        magma_free_cpu( *jau );
+        *jal = NULL;
+        *jau = NULL;
+    }
     return info;
 }
 
 
-
-/******************************************************************************
- *
- * MEX function
- *
- *****************************************************************************/
-
-void magma_zmexFunction(magma_int_t nlhs, magma_int_t n, magmaDoubleComplex omega,
-                 magma_int_t levfill, magma_int_t storage,
-                magma_index_t * ial, magma_index_t *jal, magmaDoubleComplex *al,
-                magma_index_t * iau, magma_index_t *jau, magmaDoubleComplex *au,
-                magma_int_t nrhs,
-                magma_index_t * ia, magma_index_t *ja, magmaDoubleComplex *a )
-{
-    /* matrix is stored in CSC format, 0-based */
-
-    magma_int_t nzl, nzu;
-
-    
-    nzl = storage;
-    nzu = storage;
-
-
-    /* the following will fail and return to matlab if insufficient storage */
-    magma_zsymbolic_ilu(levfill, n, &nzl, &nzu, ia, ja, ial, jal, iau, jau);
-}
-
-/* shell sort
-// stable, so it is fast if already sorted
-// sorts x[0:n-1] in place, ascending order.
-*/
-
-
-
 /**
     Purpose
     -------
 
     This routine performs a symbolic ILU factorization.
-    The algorithm is taken from an implementation written by Edmond Chow.
+    The ILU(levels) pattern is computed row-parallel from the incomplete
+    fill path theorem and allocated with the exact size; see
+    magma_zsymbolic_ilu. L and U are initialized with the values of A,
+    and A is replaced by the union of both patterns.
 
     Arguments
     ---------
@@ -320,6 +234,8 @@ magma_zsymbilu(
     magma_z_matrix A_copy={Magma_CSR}, B={Magma_CSR};
     magma_z_matrix hA={Magma_CSR}, CSRCOOA={Magma_CSR};
     
+    CHECK_NOT_CSR64( *A );
+
     // make sure the target structure is empty
     magma_zmfree( L, queue );
     magma_zmfree( U, queue );
@@ -334,82 +250,70 @@ magma_zsymbilu(
         CHECK( magma_zmconvert( B, L, Magma_CSR, Magma_CSR , queue));
         CHECK( magma_zmconvert( B, U, Magma_CSR, Magma_CSR, queue ));
 
-        magma_int_t num_lnnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
-        magma_int_t num_unnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
-
         magma_free_cpu( L->col );
         magma_free_cpu( U->col );
-        CHECK( magma_index_malloc_cpu( &L->col, num_lnnz ));
-        CHECK( magma_index_malloc_cpu( &U->col, num_unnz ));
-
-        magma_zsymbolic_ilu( levels, A->num_rows, &num_lnnz, &num_unnz, B.row, B.col,
-                                            L->row, L->col, U->row, U->col );
-        L->nnz = num_lnnz;
-        U->nnz = num_unnz;
+        L->col = NULL;
+        U->col = NULL;
+        CHECK( magma_zsymbolic_ilu( levels, A->num_rows, B.row, B.col,
+                                    L->row, &L->col, U->row, &U->col, queue ));
+        L->nnz = L->row[L->num_rows];
+        U->nnz = U->row[U->num_rows];
         magma_free_cpu( L->val );
         magma_free_cpu( U->val );
         CHECK( magma_zmalloc_cpu( &L->val, L->nnz ));
         CHECK( magma_zmalloc_cpu( &U->val, U->nnz ));
-        for( magma_int_t i=0; i<L->nnz; i++ )
-            L->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
-
-        for( magma_int_t i=0; i<U->nnz; i++ )
-            U->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
-        // take the original values (scaled) as initial guess for L
-        for(magma_int_t i=0; i<L->num_rows; i++){
-            for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
-                magma_index_t lcol = B.col[j];
-                for(magma_int_t k=L->row[i]; k<L->row[i+1]; k++){
-                    if( L->col[k] == lcol ){
-                        L->val[k] =  B.val[j];
-                    }
-                }
-            }
-        }
 
-        // take the original values (scaled) as initial guess for U
-        for(magma_int_t i=0; i<U->num_rows; i++){
-            for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
+        // take the original values (scaled) as initial guess for L and U,
+        // the rows of both patterns are sorted
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for(magma_int_t i=0; i<A->num_rows; i++){
+            for(magma_index_t k=L->row[i]; k<L->row[i+1]; k++){
+                L->val[k] = MAGMA_Z_ZERO;
+            }
+            for(magma_index_t k=U->row[i]; k<U->row[i+1]; k++){
+                U->val[k] = MAGMA_Z_ZERO;
+            }
+            for(magma_index_t j=B.row[i]; j<B.row[i+1]; j++){
                 magma_index_t lcol = B.col[j];
-                for(magma_int_t k=U->row[i]; k<U->row[i+1]; k++){
-                    if( U->col[k] == lcol ){
-                        U->val[k] =  B.val[j];
-                    }
-                }
+                magma_z_matrix *F = ( lcol < i ) ? L : U;
+                magma_index_t *pos = std::lower_bound( F->col + F->row[i],
+                                                       F->col + F->row[i+1], lcol );
+                F->val[ pos - F->col ] = B.val[j];
             }
         }
         magma_zmfree( &B, queue );
-        // fill A with the new structure;
+
+        // fill A with the new structure: row i of A is row i of L followed
+        // by row i of U
         magma_free_cpu( A->col );
         magma_free_cpu( A->val );
         CHECK( magma_index_malloc_cpu( &A->col, L->nnz+U->nnz ));
         CHECK( magma_zmalloc_cpu( &A->val, L->nnz+U->nnz ));
         A->nnz = L->nnz+U->nnz;
-        
-        magma_int_t z = 0;
+
+        #pragma omp parallel for schedule(static)
+        for(magma_int_t i=0; i<=A->num_rows; i++){
+            A->row[i] = L->row[i] + U->row[i];
+        }
+        #pragma omp parallel for schedule(dynamic, 1024)
         for(magma_int_t i=0; i<A->num_rows; i++){
-            A->row[i] = z;
-            for(magma_int_t j=L->row[i]; j<L->row[i+1]; j++){
+            magma_index_t z = A->row[i];
+            for(magma_index_t j=L->row[i]; j<L->row[i+1]; j++){
                 A->col[z] = L->col[j];
-                A->val[z] = L->val[j];
+                A->val[z] = MAGMA_Z_ZERO;
                 z++;
             }
-            for(magma_int_t j=U->row[i]; j<U->row[i+1]; j++){
+            for(magma_index_t j=U->row[i]; j<U->row[i+1]; j++){
                 A->col[z] = U->col[j];
-                A->val[z] = U->val[j];
+                A->val[z] = MAGMA_Z_ZERO;
                 z++;
             }
-        }
-        A->row[A->num_rows] = z;
-        // reset the values of A to the original entries
-        for(magma_int_t i=0; i<A->num_rows; i++){
-            for(magma_int_t j=A_copy.row[i]; j<A_copy.row[i+1]; j++){
-                magma_index_t lcol = A_copy.col[j];
-                for(magma_int_t k=A->row[i]; k<A->row[i+1]; k++){
-                    if( A->col[k] == lcol ){
-                        A->val[k] =  A_copy.val[j];
-                    }
-                }
+            // reset the values of A to the original entries
+            for(magma_index_t j=A_copy.row[i]; j<A_copy.row[i+1]; j++){
+                magma_index_t *pos = std::lower_bound( A->col + A->row[i],
+                                                       A->col + A->row[i+1],
+                                                       A_copy.col[j] );
+                A->val[ pos - A->col ] = A_copy.val[j];
             }
         }
     }
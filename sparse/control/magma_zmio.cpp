@@ -16,6 +16,20 @@
 #include <algorithm>
 #include <vector>
 #include <utility>  // pair
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <sys/stat.h>
+
+#if ! defined( _WIN32 ) && ! defined( _WIN64 )
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
 
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
@@ -24,18 +38,1217 @@
 /**
     Purpose
     -------
-    Returns true if first element of a is less than first element of b.
-    Ignores second element. Used for sorting pairs,
-    std::pair< int, magmaDoubleComplex >, of column indices and values.
+    Returns true if column index of a is less than that of b, breaking ties
+    by the bytes of the values. The parallel reader scatters the entries of a
+    row in an order that depends on thread timing; ordering duplicates by
+    value makes the row, and any later summation of the duplicates,
+    independent of that order.
+*/
+static bool compare_first_value(
+    const std::pair< magma_index_t, magmaDoubleComplex >& a,
+    const std::pair< magma_index_t, magmaDoubleComplex >& b )
+{
+    if (a.first != b.first) {
+        return (a.first < b.first);
+    }
+    return memcmp( &a.second, &b.second, sizeof(magmaDoubleComplex) ) < 0;
+}
+
+
+// -----------------------------------------------------------------------------
+// Memory-mapped, multithreaded Matrix Market reader.
+// The file is mapped read-only and split into line-aligned chunks that are
+// tokenized in parallel; the symmetric expansion and the row histogram are
+// fused into the same pass, so building CSR needs one scatter afterwards.
+
+#if ! defined( _WIN32 ) && ! defined( _WIN64 )
+
+// powers of ten that are exactly representable in double
+static const double magma_mtx_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static inline bool magma_mtx_isspace( char c )
+{
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+
+/*
+    Parses a non-negative decimal integer starting at p (leading blanks are
+    skipped). Returns pointer past the number, or NULL if there is none.
+*/
+static inline const char*
+magma_mtx_parse_index( const char *p, const char *end, magma_index_t *val )
+{
+    while ( p < end && magma_mtx_isspace( *p ) )
+        ++p;
+    if ( p >= end || *p < '0' || *p > '9' )
+        return NULL;
+    int64_t v = 0;
+    while ( p < end && *p >= '0' && *p <= '9' ) {
+        v = 10*v + (*p - '0');
+        ++p;
+    }
+    *val = magma_index_t( v );
+    return p;
+}
+
+
+/*
+    Parses a floating point number starting at p (leading blanks are skipped).
+    Mantissas with at most 19 digits and small exponents take Clinger's exact
+    fast path; everything else (long mantissas, inf, nan, huge exponents) is
+    handed to strtod, so the result always matches the fscanf based reader.
+    Returns pointer past the number, or NULL if there is none.
+*/
+static inline const char*
+magma_mtx_parse_double( const char *p, const char *end, double *val )
+{
+    while ( p < end && magma_mtx_isspace( *p ) )
+        ++p;
+    const char *start = p;
+    bool neg = false;
+    if ( p < end && (*p == '-' || *p == '+') ) {
+        neg = (*p == '-');
+        ++p;
+    }
+    uint64_t mant = 0;
+    int ndigits = 0, exp10 = 0;
+    bool any = false, exact = true;
+    for ( ; p < end && *p >= '0' && *p <= '9'; ++p ) {
+        any = true;
+        if ( ndigits < 19 ) {
+            mant = 10*mant + (*p - '0');
+            ndigits += (mant != 0);
+        } else {
+            exact = exact && (*p == '0');
+            ++exp10;
+        }
+    }
+    if ( p < end && *p == '.' ) {
+        for ( ++p; p < end && *p >= '0' && *p <= '9'; ++p ) {
+            any = true;
+            if ( ndigits < 19 ) {
+                mant = 10*mant + (*p - '0');
+                ndigits += (mant != 0);
+                --exp10;
+            } else {
+                exact = exact && (*p == '0');
+            }
+        }
+    }
+    if ( any && p < end && (*p == 'e' || *p == 'E') ) {
+        const char *q = p + 1;
+        bool eneg = false;
+        if ( q < end && (*q == '-' || *q == '+') ) {
+            eneg = (*q == '-');
+            ++q;
+        }
+        if ( q < end && *q >= '0' && *q <= '9' ) {
+            int e = 0;
+            for ( ; q < end && *q >= '0' && *q <= '9'; ++q ) {
+                if ( e < 100000 )
+                    e = 10*e + (*q - '0');
+            }
+            exp10 += (eneg ? -e : e);
+            p = q;
+        }
+    }
+    if ( any && (p >= end || magma_mtx_isspace( *p ) || *p == '\n') ) {
+        if ( mant == 0 ) {
+            *val = (neg ? -0.0 : 0.0);
+            return p;
+        }
+        if ( exact && mant < (uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22 ) {
+            double d = double( mant );
+            d = (exp10 < 0 ? d / magma_mtx_pow10[ -exp10 ] : d * magma_mtx_pow10[ exp10 ]);
+            *val = (neg ? -d : d);
+            return p;
+        }
+    }
+    // slow path: copy the token so strtod cannot run past the mapping
+    char token[ 128 ];
+    size_t len = 0;
+    p = start;
+    while ( p < end && ! magma_mtx_isspace( *p ) && *p != '\n' && len < sizeof(token)-1 )
+        token[ len++ ] = *p++;
+    token[ len ] = '\0';
+    char *tend;
+    *val = strtod( token, &tend );
+    if ( tend == token )
+        return NULL;
+    return start + (tend - token);
+}
+
+
+/*
+    Entries parsed from one chunk of the file, kept in COO until the row
+    pointer is known.
+*/
+struct magma_zmtx_chunk
+{
+    const char *begin, *end;
+    std::vector< magma_index_t > rowidx;
+    std::vector< magma_index_t > col;
+    std::vector< magmaDoubleComplex > val;
+    magma_offset_t nparsed; // entries in the file, including dropped zeros
+    magma_int_t error;
+};
+
+
+/**
+    Purpose
+    -------
+
+    Reads a coordinate Matrix Market file into CSR format using a
+    memory-mapped, multithreaded parser.
+
+    The file is split into line-aligned chunks that are parsed concurrently
+    with a hand-written number scanner. Symmetric and Hermitian expansion and
+    the row histogram are fused into the parsing pass; the CSR arrays are then
+    filled by a parallel scatter and each row is sorted by column index.
+    Duplicate entries are ordered by value, so the result does not depend on
+    the number of threads or their timing.
+    The achieved parsing bandwidth is printed.
+
+    Row offsets are counted in 64 bit. If the (expanded) number of nonzeros
+    exceeds the range of magma_index_t, A is returned in Magma_CSR64 format.
+    Its number of nonzeros is then A->nnz64; A->nnz holds it only if it fits
+    into magma_int_t, and -1 otherwise.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix in magma sparse matrix format
+
+    @param[in]
+    filename    const char*
+                filname of the mtx matrix
+
+    @param[in]
+    expand      magma_bool_t
+                MagmaTrue: duplicate the off-diagonal entries of symmetric
+                and Hermitian files. MagmaFalse: store the file as is.
+
+    @param[in]
+    allow_csr64 magma_bool_t
+                MagmaTrue: return Magma_CSR64 for matrices with more
+                nonzeros than magma_index_t can address. MagmaFalse: fail
+                with MAGMA_ERR_NOT_SUPPORTED instead.
+
+    @param[in]
+    drop_zeros  magma_bool_t
+                MagmaTrue: skip explicit zeros in real and integer files
+                (same result as running the CSR compressor afterwards).
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @return MAGMA_ERR_NOT_IMPLEMENTED if the platform has no mmap; callers
+            then fall back to the stream based reader.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+static magma_int_t
+magma_zmtx_read_parallel(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_bool_t expand,
+    magma_bool_t allow_csr64,
+    magma_bool_t drop_zeros,
+    magma_queue_t queue )
+{
+    char buffer[ 1024 ];
+    magma_int_t info = 0;
+
+    FILE *fid = NULL;
+    int fd = -1;
+    void *map = MAP_FAILED;
+    size_t map_size = 0;
+    MM_typecode matcode;
+    long data_offset = 0;
+    struct stat st;
+    real_Double_t start = magma_wtime(), elapsed;
+
+    magma_offset_t *rowptr = NULL, *fill = NULL;
+    magma_index_t num_rows, num_cols;
+    magma_offset_t num_nonzeros, nnz = 0, nparsed = 0;
+    magma_int_t nthreads = 1, nchunks = 1;
+    magma_int_t field, is_herm = 0, is_symm = 0, bad = 0;
+    std::vector< magma_zmtx_chunk > chunks;
+    const char *data, *data_end;
+
+    fid = fopen( filename, "r" );
+    if ( fid == NULL ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+
+    printf("%% Reading sparse matrix from file (%s):", filename);
+    fflush(stdout);
+
+    if (mm_read_banner(fid, &matcode) != 0) {
+        printf("\n%% Could not process Matrix Market banner: %s.\n", matcode);
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    if (!mm_is_valid(matcode)) {
+        printf("\n%% Invalid Matrix Market file.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    if ( ! ( ( mm_is_real(matcode)    ||
+               mm_is_integer(matcode) ||
+               mm_is_pattern(matcode) ||
+               mm_is_complex(matcode) ) &&
+             mm_is_coordinate(matcode)  &&
+             mm_is_sparse(matcode) ) )
+    {
+        mm_snprintf_typecode( buffer, sizeof(buffer), matcode );
+        printf("\n%% Sorry, MAGMA-sparse does not support Market Market type: [%s]\n", buffer );
+        printf("%% Only real-valued or pattern coordinate matrices are supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    if (mm_read_mtx_crd_size64(fid, &num_rows, &num_cols, &num_nonzeros) != 0) {
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    data_offset = ftell( fid );
+    fclose( fid );
+    fid = NULL;
+
+    // 0: real/integer, 1: pattern, 2: complex
+    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
+        field = 0;
+    } else if (mm_is_pattern(matcode)) {
+        field = 1;
+    } else {
+        field = 2;
+    }
+    is_herm   = mm_is_hermitian(matcode);
+    is_symm   = (mm_is_symmetric(matcode) || is_herm);
+    if ( field != 0 ) {
+        drop_zeros = MagmaFalse;
+    }
+
+    fd = open( filename, O_RDONLY );
+    if ( fd < 0 || fstat( fd, &st ) != 0 ) {
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    map_size = size_t( st.st_size );
+    if ( map_size > size_t( data_offset ) ) {
+        map = mmap( NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( map == MAP_FAILED ) {
+            // e.g., a pipe or special file; let the caller stream it
+            info = MAGMA_ERR_NOT_IMPLEMENTED;
+            goto cleanup;
+        }
+        #ifdef MADV_SEQUENTIAL
+        madvise( map, map_size, MADV_SEQUENTIAL );
+        #endif
+    }
+    data     = (map == MAP_FAILED ? NULL : (const char*) map + data_offset);
+    data_end = (map == MAP_FAILED ? NULL : (const char*) map + map_size);
+
+    A->storage_type    = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->num_rows        = num_rows;
+    A->num_cols        = num_cols;
+    A->fill_mode       = MagmaFull;
+    A->sym             = (is_symm ? Magma_SYMMETRIC : Magma_GENERAL);
+
+    CHECK( magma_offset_malloc_cpu( &rowptr, num_rows+1 ));
+    CHECK( magma_offset_malloc_cpu( &fill, num_rows+1 ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < num_rows+1; i++ ) {
+        rowptr[i] = 0;
+    }
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    // about 4 chunks per thread for load balance, but at least 1 MiB each
+    if ( data != NULL ) {
+        nchunks = magma_int_t( (data_end - data) >> 20 );
+        nchunks = max( 1, min( nchunks, 4*nthreads ));
+    }
+    chunks.resize( nchunks );
+    for( magma_int_t k=0; k < nchunks; k++ ) {
+        const char *p = data;
+        if ( data != NULL && k > 0 ) {
+            p = data + (data_end - data) * k / nchunks;
+            while ( p < data_end && p[-1] != '\n' )
+                ++p;
+        }
+        chunks[k].begin = p;
+        if ( k > 0 ) {
+            chunks[k-1].end = p;
+        }
+    }
+    chunks[nchunks-1].end = data_end;
+
+    // pass 1: tokenize, expand symmetric entries, count entries per row
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:bad)
+    for( magma_int_t k=0; k < nchunks; k++ ) {
+        magma_zmtx_chunk& c = chunks[k];
+        c.nparsed = 0;
+        c.error = 0;
+        if ( c.begin == NULL || c.begin >= c.end )
+            continue;
+        size_t lines = 1;
+        for( const char *q = c.begin;
+             (q = (const char*) memchr( q, '\n', c.end - q )) != NULL; ++q )
+            ++lines;
+        size_t cap = (is_symm && expand) ? 2*lines : lines;
+        c.rowidx.reserve( cap );
+        c.col.reserve( cap );
+        c.val.reserve( cap );
+
+        const char *p = c.begin, *e = c.end;
+        while ( p < e ) {
+            while ( p < e && (magma_mtx_isspace( *p ) || *p == '\n') )
+                ++p;
+            if ( p >= e )
+                break;
+            if ( *p != '%' ) {
+                magma_index_t r, j;
+                double re = 1.0, im = 0.0;
+                p = magma_mtx_parse_index( p, e, &r );
+                if ( p != NULL )
+                    p = magma_mtx_parse_index( p, e, &j );
+                if ( p != NULL && field != 1 )
+                    p = magma_mtx_parse_double( p, e, &re );
+                if ( p != NULL && field == 2 )
+                    p = magma_mtx_parse_double( p, e, &im );
+                if ( p == NULL || r < 1 || r > num_rows || j < 1 || j > num_cols ) {
+                    c.error = 1;
+                    break;
+                }
+                c.nparsed++;
+                r--;
+                j--;
+                if ( ! (drop_zeros && re == 0.0) ) {
+                    magmaDoubleComplex v = MAGMA_Z_MAKE( re, im );
+                    c.rowidx.push_back( r );
+                    c.col.push_back( j );
+                    c.val.push_back( v );
+                    #pragma omp atomic
+                    rowptr[r+1]++;
+                    if ( is_symm && expand && r != j ) {
+                        c.rowidx.push_back( j );
+                        c.col.push_back( r );
+                        c.val.push_back( is_herm ? MAGMA_Z_CONJ( v ) : v );
+                        #pragma omp atomic
+                        rowptr[j+1]++;
+                    }
+                }
+            }
+            // skip the remainder of the line
+            while ( p < e && *p != '\n' )
+                ++p;
+        }
+        bad += c.error;
+    }
+    for( magma_int_t k=0; k < nchunks; k++ ) {
+        nparsed += chunks[k].nparsed;
+    }
+    if ( bad > 0 || nparsed != num_nonzeros ) {
+        printf("\n%% Malformed Matrix Market file: expected %lld entries, parsed %lld%s.\n",
+               (long long) num_nonzeros, (long long) nparsed,
+               (bad > 0 ? " before an invalid line" : "") );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    printf(" done. Converting to CSR:");
+    fflush(stdout);
+    if ( is_symm ) {
+        printf("\n%% Detected symmetric case.");
+    }
+
+    // exclusive scan of the row histogram (row[0] stays 0)
+    for( magma_int_t i=0; i < num_rows; i++ ) {
+        rowptr[i+1] += rowptr[i];
+    }
+    nnz = rowptr[num_rows];
+    if ( nnz > (magma_offset_t) INT_MAX ) {
+        if ( ! allow_csr64 ) {
+            printf("\n%% %lld nonzeros exceed the 32-bit CSR range.\n",
+                   (long long) nnz );
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        A->storage_type = Magma_CSR64;
+    }
+    // with 32-bit magma_int_t, a CSR64 count is only in nnz64
+    A->nnz = (magma_offset_t( magma_int_t( nnz )) == nnz ? magma_int_t( nnz ) : -1);
+    A->true_nnz = A->nnz;
+    A->nnz64 = nnz;
+    CHECK( magma_index_malloc_cpu( &A->col, nnz ));
+    CHECK( magma_zmalloc_cpu( &A->val, nnz ));
+
+    // pass 2: scatter the chunks into the CSR arrays
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < num_rows+1; i++ ) {
+        fill[i] = rowptr[i];
+    }
+    #pragma omp parallel for schedule(dynamic, 1)
+    for( magma_int_t k=0; k < nchunks; k++ ) {
+        magma_zmtx_chunk& c = chunks[k];
+        for( size_t l=0; l < c.rowidx.size(); l++ ) {
+            magma_offset_t dest;
+            #pragma omp atomic capture
+            dest = fill[ c.rowidx[l] ]++;
+            A->col[dest] = c.col[l];
+            A->val[dest] = c.val[l];
+        }
+        std::vector< magma_index_t >().swap( c.rowidx );
+        std::vector< magma_index_t >().swap( c.col );
+        std::vector< magmaDoubleComplex >().swap( c.val );
+    }
+
+    // sort column indices within each row; the scatter order is not
+    // deterministic, so duplicates are ordered by value
+    #pragma omp parallel
+    {
+        std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+        #pragma omp for schedule(dynamic, 1024)
+        for( magma_int_t k=0; k < num_rows; k++ ) {
+            magma_offset_t kk  = rowptr[k];
+            magma_index_t  len = magma_index_t( rowptr[k+1] - kk );
+            rowval.resize( len );
+            for( magma_index_t i=0; i < len; ++i ) {
+                rowval[i] = std::make_pair( A->col[kk+i], A->val[kk+i] );
+            }
+            std::sort( rowval.begin(), rowval.end(), compare_first_value );
+            for( magma_index_t i=0; i < len; ++i ) {
+                A->col[kk+i] = rowval[i].first;
+                A->val[kk+i] = rowval[i].second;
+            }
+        }
+    }
+
+    // keep the 64-bit offsets only if they are needed
+    if ( A->storage_type == Magma_CSR64 ) {
+        A->row64 = rowptr;
+        rowptr = NULL;
+    }
+    else {
+        CHECK( magma_index_malloc_cpu( &A->row, num_rows+1 ));
+        #pragma omp parallel for
+        for( magma_int_t i=0; i < num_rows+1; i++ ) {
+            A->row[i] = magma_index_t( rowptr[i] );
+        }
+    }
+
+    elapsed = magma_wtime() - start;
+    printf(" done.\n%% Parsed %.1f MB in %.3f s (%.1f MB/s, %lld threads).\n",
+           map_size / 1e6, elapsed, map_size / 1e6 / max( elapsed, 1e-9 ),
+           (long long) nthreads );
+
+cleanup:
+    if ( fid != NULL ) {
+        fclose( fid );
+        fid = NULL;
+    }
+    if ( map != MAP_FAILED ) {
+        munmap( map, map_size );
+    }
+    if ( fd >= 0 ) {
+        close( fd );
+    }
+    magma_free_cpu( rowptr );
+    magma_free_cpu( fill );
+    if ( info != 0 && info != MAGMA_ERR_NOT_IMPLEMENTED ) {
+        magma_zmfree( A, queue );
+    }
+    return info;
+}
+
+#else  // _WIN32 || _WIN64
+
+static magma_int_t
+magma_zmtx_read_parallel(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_bool_t expand,
+    magma_bool_t allow_csr64,
+    magma_bool_t drop_zeros,
+    magma_queue_t queue )
+{
+    return MAGMA_ERR_NOT_IMPLEMENTED;
+}
+
+#endif  // ! _WIN32 && ! _WIN64
+
+
+// -----------------------------------------------------------------------------
+// Binary sparse matrix container.
+//
+// A 128 byte header followed by the CSR arrays row[num_rows+1], col[nnz] and
+// val[nnz], each starting on a 64 byte boundary, so the file can be mapped and
+// the arrays used in place. The header stores the size, modification time,
+// and a hash of the first bytes of the .mtx file it was generated from, which
+// are used to detect stale sidecar caches.
+
+#define COMPLEX
+
+#define MAGMA_MBIN_MAGIC     "MAGMASPB"
+#define MAGMA_MBIN_VERSION   1
+#define MAGMA_MBIN_ALIGN     64
+
+typedef struct magma_zmbin_header
+{
+    char    magic[8];           // MAGMA_MBIN_MAGIC, not NUL terminated
+    int32_t version;            // MAGMA_MBIN_VERSION
+    int32_t value_size;         // sizeof(magmaDoubleComplex)
+    int32_t is_complex;         // 1 for z, c; 0 for d, s
+    int32_t index_size;         // sizeof(magma_index_t)
+    int32_t storage_type;       // magma_storage_t, currently always Magma_CSR
+    int32_t sym;                // magma_symmetry_t
+    int32_t fill_mode;          // magma_uplo_t
+    int32_t reserved0;
+    int64_t num_rows;
+    int64_t num_cols;
+    int64_t nnz;
+    int64_t row_offset;         // byte offsets of the arrays in the file
+    int64_t col_offset;
+    int64_t val_offset;
+    int64_t file_size;
+    int64_t source_size;        // size of the .mtx file, 0 if none
+    int64_t source_mtime;       // st_mtime of the .mtx file, 0 if none
+    int64_t source_mtime_nsec;  // nanoseconds of st_mtime, if the OS has them
+    uint64_t source_hash;       // hash of the first bytes of the .mtx file
+} magma_zmbin_header;
+
+
+static inline int64_t magma_mbin_align( int64_t offset )
+{
+    return ((offset + MAGMA_MBIN_ALIGN - 1) / MAGMA_MBIN_ALIGN) * MAGMA_MBIN_ALIGN;
+}
+
+
+/*
+    Gets the size, modification time, and a hash of the first 4 KiB (the
+    header lines and the first entries) of file source. st_mtime has a
+    resolution of one second, so the nanoseconds and the hash catch a file
+    rewritten within the second its cache was written.
+    Returns false if source cannot be read.
+*/
+static bool
+magma_mtx_source_stamp(
+    const char *source,
+    int64_t *size,
+    int64_t *mtime,
+    int64_t *mtime_nsec,
+    uint64_t *hash )
+{
+    struct stat st;
+    if ( stat( source, &st ) != 0 ) {
+        return false;
+    }
+    *size  = st.st_size;
+    *mtime = st.st_mtime;
+    #if defined( __APPLE__ )
+    *mtime_nsec = st.st_mtimespec.tv_nsec;
+    #elif defined( _WIN32 ) || defined( _WIN64 )
+    *mtime_nsec = 0;
+    #else
+    *mtime_nsec = st.st_mtim.tv_nsec;
+    #endif
+
+    // 64-bit FNV-1a
+    char buf[ 4096 ];
+    size_t len = 0;
+    FILE *fp = fopen( source, "rb" );
+    if ( fp == NULL ) {
+        return false;
+    }
+    len = fread( buf, 1, sizeof(buf), fp );
+    fclose( fp );
+    *hash = 14695981039346656037ull;
+    for( size_t i=0; i < len; ++i ) {
+        *hash = (*hash ^ (unsigned char) buf[i]) * 1099511628211ull;
+    }
+    return true;
+}
+
+
+/*
+    Fills the header for matrix A. If source is not NULL, its size,
+    modification time, and hash are recorded.
+*/
+static void
+magma_zmbin_header_init(
+    magma_zmbin_header *hdr,
+    const magma_z_matrix *A,
+    const char *source )
+{
+    memset( hdr, 0, sizeof(*hdr) );
+    memcpy( hdr->magic, MAGMA_MBIN_MAGIC, sizeof(hdr->magic) );
+    hdr->version      = MAGMA_MBIN_VERSION;
+    hdr->value_size   = sizeof(magmaDoubleComplex);
+    #ifdef COMPLEX
+    hdr->is_complex   = 1;
+    #endif
+    hdr->index_size   = sizeof(magma_index_t);
+    hdr->storage_type = Magma_CSR;
+    hdr->sym          = A->sym;
+    hdr->fill_mode    = A->fill_mode;
+    hdr->num_rows     = A->num_rows;
+    hdr->num_cols     = A->num_cols;
+    hdr->nnz          = A->nnz;
+    hdr->row_offset   = magma_mbin_align( sizeof(*hdr) );
+    hdr->col_offset   = magma_mbin_align( hdr->row_offset + (hdr->num_rows+1)*sizeof(magma_index_t) );
+    hdr->val_offset   = magma_mbin_align( hdr->col_offset + hdr->nnz*sizeof(magma_index_t) );
+    hdr->file_size    = hdr->val_offset + hdr->nnz*sizeof(magmaDoubleComplex);
+
+    if ( source != NULL ) {
+        magma_mtx_source_stamp( source, &hdr->source_size, &hdr->source_mtime,
+                                &hdr->source_mtime_nsec, &hdr->source_hash );
+    }
+}
+
+
+/*
+    Checks that hdr describes a matrix of this precision and index width and
+    that the arrays fit in a file of file_size bytes.
+*/
+static magma_int_t
+magma_zmbin_header_check(
+    const magma_zmbin_header *hdr,
+    int64_t file_size )
+{
+    int is_complex = 0;
+    #ifdef COMPLEX
+    is_complex = 1;
+    #endif
+    if ( memcmp( hdr->magic, MAGMA_MBIN_MAGIC, sizeof(hdr->magic) ) != 0 ||
+         hdr->version != MAGMA_MBIN_VERSION ) {
+        printf("%% Not a MAGMA binary sparse matrix (or unsupported version).\n");
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( hdr->value_size != int32_t( sizeof(magmaDoubleComplex) ) ||
+         hdr->is_complex != is_complex ||
+         hdr->index_size != int32_t( sizeof(magma_index_t) ) ||
+         hdr->storage_type != Magma_CSR ) {
+        printf("%% Binary sparse matrix has a different precision or index type.\n");
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( hdr->num_rows < 0 || hdr->num_cols < 0 || hdr->nnz < 0 ||
+         hdr->file_size > file_size ||
+         hdr->val_offset + hdr->nnz*int64_t( sizeof(magmaDoubleComplex) ) > file_size ) {
+        printf("%% Binary sparse matrix is truncated.\n");
+        return MAGMA_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+
+/*
+    Writes A, which must be CSR on the CPU, to filename. The data go to a
+    temporary file that is renamed on success, so concurrent readers never
+    see a partially written container.
+*/
+static magma_int_t
+magma_zmbin_write(
+    magma_z_matrix A,
+    const char *filename,
+    const char *source )
+{
+    magma_int_t info = 0;
+    magma_zmbin_header hdr;
+    char tmpname[ 4096 ];
+    char pad[ MAGMA_MBIN_ALIGN ] = { 0 };
+    FILE *fp = NULL;
+    int64_t pos;
+
+    CHECK_NOT_CSR64( A );
+
+    magma_zmbin_header_init( &hdr, &A, source );
+    snprintf( tmpname, sizeof(tmpname), "%s.tmp%d", filename, int( getpid() ));
+    fp = fopen( tmpname, "wb" );
+    if ( fp == NULL ) {
+        info = MAGMA_ERR_FILESYSTEM;
+        goto cleanup;
+    }
+    pos = sizeof(hdr);
+    if ( fwrite( &hdr, sizeof(hdr), 1, fp ) != 1 ||
+         fwrite( pad, 1, hdr.row_offset - pos, fp ) != size_t( hdr.row_offset - pos ) ||
+         fwrite( A.row, sizeof(magma_index_t), A.num_rows+1, fp ) != size_t( A.num_rows+1 ) )
+    {
+        info = MAGMA_ERR_FILESYSTEM;
+        goto cleanup;
+    }
+    pos = hdr.row_offset + (A.num_rows+1)*sizeof(magma_index_t);
+    if ( fwrite( pad, 1, hdr.col_offset - pos, fp ) != size_t( hdr.col_offset - pos ) ||
+         fwrite( A.col, sizeof(magma_index_t), A.nnz, fp ) != size_t( A.nnz ) )
+    {
+        info = MAGMA_ERR_FILESYSTEM;
+        goto cleanup;
+    }
+    pos = hdr.col_offset + A.nnz*sizeof(magma_index_t);
+    if ( fwrite( pad, 1, hdr.val_offset - pos, fp ) != size_t( hdr.val_offset - pos ) ||
+         fwrite( A.val, sizeof(magmaDoubleComplex), A.nnz, fp ) != size_t( A.nnz ) )
+    {
+        info = MAGMA_ERR_FILESYSTEM;
+        goto cleanup;
+    }
+    if ( fclose( fp ) != 0 ) {
+        fp = NULL;
+        info = MAGMA_ERR_FILESYSTEM;
+        goto cleanup;
+    }
+    fp = NULL;
+    if ( rename( tmpname, filename ) != 0 ) {
+        info = MAGMA_ERR_FILESYSTEM;
+    }
+
+cleanup:
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    if ( info != 0 ) {
+        remove( tmpname );
+    }
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes a matrix to a file in the MAGMA binary sparse format: a versioned
+    header (storage type, dimensions, nnz, symmetry, fill mode) followed by
+    64-byte aligned CSR arrays. The file can be read back with
+    read_z_csr_from_binary or mapped in place with magma_z_csr_binary.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                matrix to write out, any format and location
+
+    @param[in]
+    filename    const char*
+                output-filname of the binary matrix
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zwrite_csr_binary(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_matrix hA={Magma_CSR}, B={Magma_CSR};
+
+    CHECK_NOT_CSR64( A );
+
+    if ( A.memory_location == Magma_CPU && A.storage_type == Magma_CSR ) {
+        CHECK( magma_zmbin_write( A, filename, NULL ));
+    }
+    else {
+        CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+        CHECK( magma_zmconvert( hA, &B, hA.storage_type, Magma_CSR, queue ));
+        CHECK( magma_zmbin_write( B, filename, NULL ));
+    }
+
+cleanup:
+    if ( info == MAGMA_ERR_FILESYSTEM ) {
+        printf("%% error writing binary matrix %s\n", filename);
+    }
+    magma_zmfree( &hA, queue );
+    magma_zmfree( &B, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reads a matrix stored in the MAGMA binary sparse format (see
+    magma_zwrite_csr_binary) into newly allocated CSR arrays.
+
+    Arguments
+    ---------
+
+    @param[out]
+    n_row       magma_int_t*
+                number of rows in matrix
+
+    @param[out]
+    n_col       magma_int_t*
+                number of columns in matrix
+
+    @param[out]
+    nnz         magma_int_t*
+                number of nonzeros in matrix
+
+    @param[out]
+    val         magmaDoubleComplex**
+                value array of CSR output
+
+    @param[out]
+    row         magma_index_t**
+                row pointer of CSR output
+
+    @param[out]
+    col         magma_index_t**
+                column indices of CSR output
+
+    @param[in]
+    filename    const char*
+                filname of the binary matrix
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+read_z_csr_from_binary(
+    magma_int_t* n_row,
+    magma_int_t* n_col,
+    magma_int_t* nnz,
+    magmaDoubleComplex **val,
+    magma_index_t **row,
+    magma_index_t **col,
+    const char * filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_zmbin_header hdr;
+    struct stat st;
+    FILE *fp = NULL;
+
+    *val = NULL;
+    *row = NULL;
+    *col = NULL;
+
+    fp = fopen( filename, "rb" );
+    if ( fp == NULL || fstat( fileno( fp ), &st ) != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    if ( fread( &hdr, sizeof(hdr), 1, fp ) != 1 ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    CHECK( magma_zmbin_header_check( &hdr, st.st_size ));
+
+    CHECK( magma_index_malloc_cpu( row, hdr.num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( col, hdr.nnz ));
+    CHECK( magma_zmalloc_cpu( val, hdr.nnz ));
+    if ( fseek( fp, hdr.row_offset, SEEK_SET ) != 0 ||
+         fread( *row, sizeof(magma_index_t), hdr.num_rows+1, fp ) != size_t( hdr.num_rows+1 ) ||
+         fseek( fp, hdr.col_offset, SEEK_SET ) != 0 ||
+         fread( *col, sizeof(magma_index_t), hdr.nnz, fp ) != size_t( hdr.nnz ) ||
+         fseek( fp, hdr.val_offset, SEEK_SET ) != 0 ||
+         fread( *val, sizeof(magmaDoubleComplex), hdr.nnz, fp ) != size_t( hdr.nnz ) )
+    {
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    *n_row = hdr.num_rows;
+    *n_col = hdr.num_cols;
+    *nnz   = hdr.nnz;
+
+cleanup:
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    if ( info != 0 ) {
+        magma_free_cpu( *val );
+        magma_free_cpu( *row );
+        magma_free_cpu( *col );
+        *val = NULL;
+        *row = NULL;
+        *col = NULL;
+    }
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Maps a matrix stored in the MAGMA binary sparse format (see
+    magma_zwrite_csr_binary) into memory and returns a Magma_CPU CSR matrix
+    whose arrays point directly into the mapping. No data are copied; pages
+    are loaded on first access.
+
+    The mapping is private: modifying the arrays does not change the file.
+    The matrix does not own its arrays (A->ownership = MagmaFalse), so
+    magma_zmfree does not release it; use magma_zmunmap instead.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix in magma sparse matrix format
+
+    @param[in]
+    filename    const char*
+                filname of the binary matrix
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_binary(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue )
+{
+#if ! defined( _WIN32 ) && ! defined( _WIN64 )
+    magma_int_t info = 0;
+    const magma_zmbin_header *hdr = NULL;
+    struct stat st;
+    void *map = MAP_FAILED;
+    int fd = -1;
+
+    magma_zmfree( A, queue );
+
+    fd = open( filename, O_RDONLY );
+    if ( fd < 0 || fstat( fd, &st ) != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    if ( size_t( st.st_size ) < sizeof(magma_zmbin_header) ) {
+        printf("%% Not a MAGMA binary sparse matrix.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    map = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    if ( map == MAP_FAILED ) {
+        info = MAGMA_ERR_HOST_ALLOC;
+        goto cleanup;
+    }
+    hdr = (const magma_zmbin_header*) map;
+    CHECK( magma_zmbin_header_check( hdr, st.st_size ));
+    if ( hdr->file_size != int64_t( st.st_size ) ) {
+        // magma_zmunmap releases exactly file_size bytes
+        printf("%% Binary sparse matrix size does not match its header.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    A->storage_type    = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->sym             = magma_symmetry_t( hdr->sym );
+    A->fill_mode       = magma_uplo_t( hdr->fill_mode );
+    A->num_rows        = hdr->num_rows;
+    A->num_cols        = hdr->num_cols;
+    A->nnz             = hdr->nnz;
+    A->true_nnz        = hdr->nnz;
+    A->ownership       = MagmaFalse;
+    A->row = (magma_index_t*)      ((char*) map + hdr->row_offset);
+    A->col = (magma_index_t*)      ((char*) map + hdr->col_offset);
+    A->val = (magmaDoubleComplex*) ((char*) map + hdr->val_offset);
+
+cleanup:
+    if ( fd >= 0 ) {
+        close( fd );  // the mapping stays valid
+    }
+    if ( info != 0 && map != MAP_FAILED ) {
+        munmap( map, st.st_size );
+    }
+    return info;
+#else
+    return MAGMA_ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+    Purpose
+    -------
+
+    Releases a matrix obtained from magma_z_csr_binary. Matrices that own
+    their arrays are passed on to magma_zmfree.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix to release
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmunmap(
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    if ( A->ownership || A->memory_location != Magma_CPU ||
+         A->storage_type != Magma_CSR || A->row == NULL ) {
+        return magma_zmfree( A, queue );
+    }
+#if ! defined( _WIN32 ) && ! defined( _WIN64 )
+    magma_zmbin_header *hdr = (magma_zmbin_header*)
+        ((char*) A->row - magma_mbin_align( sizeof(magma_zmbin_header) ));
+    if ( memcmp( hdr->magic, MAGMA_MBIN_MAGIC, sizeof(hdr->magic) ) != 0 ) {
+        return MAGMA_ERR_INVALID_PTR;
+    }
+    munmap( hdr, hdr->file_size );
+#endif
+    A->row = NULL;
+    A->col = NULL;
+    A->val = NULL;
+    A->num_rows = 0;
+    A->num_cols = 0;
+    A->nnz = 0;
+    A->true_nnz = 0;
+    return MAGMA_SUCCESS;
+}
+
+
+/*
+    Returns true if the sidecar cache for a Matrix Market file is enabled
+    through the environment, i.e., MAGMA_SPARSE_MTX_CACHE is set to a value
+    other than "0".
 */
-static bool compare_first(
-    const std::pair< magma_index_t, magmaDoubleComplex >& a,
-    const std::pair< magma_index_t, magmaDoubleComplex >& b )
+static bool magma_zmtx_cache_enabled()
+{
+    const char *env = getenv( "MAGMA_SPARSE_MTX_CACHE" );
+    return (env != NULL && strcmp( env, "0" ) != 0);
+}
+
+
+/*
+    Name of the sidecar cache of mtxfile, e.g., A.mtx.c16.mbin for double
+    complex or A.mtx.r8.mbin for double, so runs in different precisions do
+    not overwrite each other's cache.
+*/
+static void
+magma_zmtx_cache_name(
+    char *cachefile,
+    size_t len,
+    const char *mtxfile )
 {
-    return (a.first < b.first);
+    const char *field = "r";
+    #ifdef COMPLEX
+    field = "c";
+    #endif
+    snprintf( cachefile, len, "%s.%s%d.mbin", mtxfile, field,
+              int( sizeof(magmaDoubleComplex) ));
+}
+
+
+/*
+    Loads the sidecar cache of mtxfile into A if it exists and was generated
+    from the current version of mtxfile. Returns 0 on success.
+*/
+static magma_int_t
+magma_zmtx_cache_read(
+    magma_z_matrix *A,
+    const char *mtxfile,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    char cachefile[ 4096 ];
+    magma_zmbin_header hdr;
+    int64_t size, mtime, mtime_nsec;
+    uint64_t hash;
+    FILE *fp;
+
+    magma_zmtx_cache_name( cachefile, sizeof(cachefile), mtxfile );
+    if ( ! magma_mtx_source_stamp( mtxfile, &size, &mtime, &mtime_nsec, &hash )) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    fp = fopen( cachefile, "rb" );
+    if ( fp == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    size_t nread = fread( &hdr, sizeof(hdr), 1, fp );
+    fclose( fp );
+    if ( nread != 1 ||
+         memcmp( hdr.magic, MAGMA_MBIN_MAGIC, sizeof(hdr.magic) ) != 0 ||
+         hdr.source_size       != size  ||
+         hdr.source_mtime      != mtime ||
+         hdr.source_mtime_nsec != mtime_nsec ||
+         hdr.source_hash       != hash ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+
+    printf("%% Reading sparse matrix from cache (%s):", cachefile);
+    fflush(stdout);
+    A->storage_type    = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->sym             = magma_symmetry_t( hdr.sym );
+    A->fill_mode       = magma_uplo_t( hdr.fill_mode );
+    A->ownership       = MagmaTrue;
+    info = read_z_csr_from_binary( &A->num_rows, &A->num_cols, &A->nnz,
+                                   &A->val, &A->row, &A->col, cachefile, queue );
+    A->true_nnz = A->nnz;
+    printf( info == 0 ? " done.\n" : " failed.\n" );
+    return info;
+}
+
+
+/*
+    Writes the sidecar cache of mtxfile from A. Failures are reported but not
+    returned, as the cache is only an optimization.
+*/
+static void
+magma_zmtx_cache_write(
+    magma_z_matrix A,
+    const char *mtxfile )
+{
+    char cachefile[ 4096 ];
+    if ( A.storage_type != Magma_CSR ) {
+        return;  // the container holds 32-bit row pointers only
+    }
+    magma_zmtx_cache_name( cachefile, sizeof(cachefile), mtxfile );
+    if ( magma_zmbin_write( A, cachefile, mtxfile ) != 0 ) {
+        printf("%% Could not write sparse matrix cache %s\n", cachefile);
+    }
 }
 
 
+
 /**
     Purpose
     -------
@@ -110,11 +1323,29 @@ magma_int_t read_z_csr_from_mtx(
     magma_index_t *new_col=NULL, *new_row=NULL;
     magmaDoubleComplex *new_val=NULL;
     magma_int_t hermitian = 0;
+    magma_z_matrix A={Magma_CSR};
     
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
     
     FILE *fid = NULL;
     MM_typecode matcode;
+
+    // fast path: memory-mapped, multithreaded reader
+    info = magma_zmtx_read_parallel( &A, filename, MagmaTrue, MagmaFalse, MagmaFalse, queue );
+    if ( info != MAGMA_ERR_NOT_IMPLEMENTED ) {
+        if ( info == 0 ) {
+            *type     = A.storage_type;
+            *location = A.memory_location;
+            *n_row    = A.num_rows;
+            *n_col    = A.num_cols;
+            *nnz      = A.nnz;
+            *val      = A.val;
+            *row      = A.row;
+            *col      = A.col;
+        }
+        goto cleanup;
+    }
+    info = 0;
+
     fid = fopen(filename, "r");
     
     if (fid == NULL) {
@@ -263,63 +1494,14 @@ magma_int_t read_z_csr_from_mtx(
         *nnz = true_nonzeros;
     } // end symmetric case
     
-    CHECK( magma_zmalloc_cpu( val, *nnz ) );
-    
     CHECK( magma_index_malloc_cpu( col, *nnz ) );
     CHECK( magma_index_malloc_cpu( row, (*n_row+1) ) );
     CHECK( magma_zmalloc_cpu( val, *nnz ) );
 
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (*row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < *nnz; i++)
-        (*row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (*row)[i];
-        (*row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (*row)[num_rows] = *nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < *nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (*row)[row_];
-        (*col)[dest] = coo_col[i];
-        (*val)[dest] = coo_val[i];
-        (*row)[row_]++;
-    }
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp  = (*row)[i];
-        (*row)[i] = last;
-        last      = temp;
-    }
-    
-    (*row)[*n_row] = *nnz;
-
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < *n_row; ++k) {
-        int kk  = (*row)[k];
-        int len = (*row)[k+1] - (*row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (*col)[kk+i], (*val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (*col)[kk+i] = rowval[i].first;
-            (*val)[kk+i] = rowval[i].second;
-        }
-    }
+    // parallel counting sort by row, then sort column indices within each row
+    CHECK( magma_zcoo2csr_cpu( num_rows, *nnz, coo_row, coo_col, coo_val,
+                               *row, *col, *val, queue ));
+    CHECK( magma_zcsr_sortrows_cpu( num_rows, *row, *col, *val, queue ));
 
     printf(" done.\n");
 cleanup:
@@ -348,11 +1530,99 @@ cleanup:
 }
 
 
+/*
+    Writes the decimal representation of i+1 to buf and returns its length.
+*/
+static inline int
+magma_mtx_format_index( char *buf, magma_index_t i )
+{
+    char tmp[ 24 ];
+    int len = 0;
+    int64_t v = int64_t( i ) + 1;
+    do {
+        tmp[ len++ ] = char( '0' + v % 10 );
+        v /= 10;
+    } while ( v > 0 );
+    for( int k=0; k < len; ++k ) {
+        buf[k] = tmp[ len-1-k ];
+    }
+    return len;
+}
+
+
+/*
+    Writes the nonzeros of CSR matrix A to fp, one "row col value" line each.
+    If transposed is MagmaTrue, row and column are swapped in the output.
+
+    Rows are grouped into chunks of about the same number of nonzeros. Each
+    thread formats its chunks into a private buffer; the buffers are written
+    in order with one fwrite per chunk, so formatting overlaps with I/O.
+*/
+static magma_int_t
+magma_zmtx_write_entries(
+    FILE *fp,
+    magma_z_matrix A,
+    magma_bool_t transposed )
+{
+    // longest line: 2 x 11 digit index, 2 x 24 character %.16g, separators
+    const magma_int_t max_line  = 80;
+    const magma_int_t chunk_nnz = 65536;
+
+    magma_int_t failed = 0;
+    std::vector< magma_index_t > bounds;
+
+    bounds.push_back( 0 );
+    for( magma_index_t i=0; i < A.num_rows; i++ ) {
+        if ( A.row[i+1] - A.row[ bounds.back() ] >= chunk_nnz ) {
+            bounds.push_back( i+1 );
+        }
+    }
+    if ( bounds.back() != A.num_rows ) {
+        bounds.push_back( A.num_rows );
+    }
+    magma_int_t nchunks = magma_int_t( bounds.size() ) - 1;
+
+    #pragma omp parallel
+    {
+        std::vector< char > buf;
+        #pragma omp for ordered schedule(static, 1)
+        for( magma_int_t k=0; k < nchunks; k++ ) {
+            magma_index_t rbegin = bounds[k], rend = bounds[k+1];
+            buf.resize( size_t( A.row[rend] - A.row[rbegin] ) * max_line + 1 );
+            char *p = buf.data();
+            for( magma_index_t i=rbegin; i < rend; i++ ) {
+                for( magma_index_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+                    magmaDoubleComplex v = A.val[j];
+                    p += magma_mtx_format_index( p, (transposed ? A.col[j] : i) );
+                    *p++ = ' ';
+                    p += magma_mtx_format_index( p, (transposed ? i : A.col[j]) );
+                    #ifdef COMPLEX
+                    p += sprintf( p, " %.16g %.16g\n", MAGMA_Z_REAL(v), MAGMA_Z_IMAG(v) );
+                    #else
+                    p += sprintf( p, " %.16g\n", MAGMA_Z_REAL(v) );
+                    #endif
+                }
+            }
+            size_t len = p - buf.data();
+            #pragma omp ordered
+            {
+                if ( failed == 0 && fwrite( buf.data(), 1, len, fp ) != len ) {
+                    failed = 1;
+                }
+            }
+        }
+    }
+    return (failed ? MAGMA_ERR_FILESYSTEM : MAGMA_SUCCESS);
+}
+
+
 /**
     Purpose
     -------
 
     Writes a CSR matrix to a file using Matrix Market format.
+    Chunks of rows are formatted in parallel into thread-local buffers and
+    written in order with large block writes.
 
     Arguments
     ---------
@@ -387,131 +1657,56 @@ magma_zwrite_csr_mtx(
 {
     magma_int_t info = 0;
     
-    FILE *fp;
+    FILE *fp = NULL;
     magma_z_matrix B = {Magma_CSR};
     
+    CHECK_NOT_CSR64( A );
+
     if ( MajorType == MagmaColMajor ) {
         // to obtain ColMajor output we transpose the matrix
         // and flip the row and col pointer in the output
-        
         CHECK( magma_z_cucsrtranspose( A, &B, queue ));
-        
-        // TODO avoid duplicating this code below.
-        printf("%% Writing sparse matrix to file (%s):", filename);
-        fflush(stdout);
-        
-        fp = fopen(filename, "w");
-        if ( fp == NULL ){
-            printf("\n%% error writing matrix: file exists or missing write permission\n");
-            info = -1;
-            goto cleanup;
-        }
-            
-        #define COMPLEX
+    }
+    
+    printf("%% Writing sparse matrix to file (%s):", filename);
+    fflush(stdout);
+    
+    fp = fopen(filename, "w");
+    if ( fp == NULL ){
+        printf("\n%% error writing matrix: file exists or missing write permission\n");
+        info = -1;
+        goto cleanup;
+    }
+    
+    #define COMPLEX
 
-        #ifdef COMPLEX
-        // complex case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
-        fprintf( fp, "%d %d %d\n", int(B.num_cols), int(B.num_rows), int(B.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-        
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = B.row[i];
-            magma_index_t rowtemp2 = B.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g %.16g\n",
-                    ((B.col)[rowtemp1+j]+1), rowindex,
-                    MAGMA_Z_REAL((B.val)[rowtemp1+j]),
-                    MAGMA_Z_IMAG((B.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #else
-        // real case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
+    #ifdef COMPLEX
+    // complex case
+    fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
+    #else
+    // real case
+    fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
+    #endif
+    
+    if ( MajorType == MagmaColMajor ) {
         fprintf( fp, "%d %d %d\n", int(B.num_cols), int(B.num_rows), int(B.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-                
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = B.row[i];
-            magma_index_t rowtemp2 = B.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g\n",
-                    ((B.col)[rowtemp1+j]+1), rowindex,
-                    MAGMA_Z_REAL((B.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #endif
-       
-        if (fclose(fp) != 0)
-            printf("\n%% error: writing matrix failed\n");
-        else
-            printf(" done\n");
+        info = magma_zmtx_write_entries( fp, B, MagmaTrue );
     }
     else {
-        printf("%% Writing sparse matrix to file (%s):", filename);
-        fflush(stdout);
-        
-        fp = fopen (filename, "w");
-        if (  fp == NULL ){
-            printf("\n%% error writing matrix: file exists or missing write permission\n");
-            info = -1;
-            goto cleanup;
-        }
-             
-            
-        #define COMPLEX
-
-        #ifdef COMPLEX
-        // complex case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
-        fprintf( fp, "%d %d %d\n", int(A.num_rows), int(A.num_cols), int(A.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-        
-        for(i=0; i < A.num_rows; i++) {
-            magma_index_t rowtemp1 = A.row[i];
-            magma_index_t rowtemp2 = A.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g %.16g\n",
-                    rowindex, ((A.col)[rowtemp1+j]+1), 
-                    MAGMA_Z_REAL((A.val)[rowtemp1+j]),
-                    MAGMA_Z_IMAG((A.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #else
-        // real case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
         fprintf( fp, "%d %d %d\n", int(A.num_rows), int(A.num_cols), int(A.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-                
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = A.row[i];
-            magma_index_t rowtemp2 = A.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g\n",
-                    rowindex, ((A.col)[rowtemp1+j]+1),
-                    MAGMA_Z_REAL((A.val)[rowtemp1+j]));
-            }
-            rowindex++;
-        }
-        #endif
-
-        if (fclose(fp) != 0)
-            printf("\n%% error: writing matrix failed\n");
-        else
-            printf(" done\n");
+        info = magma_zmtx_write_entries( fp, A, MagmaFalse );
+    }
+    
+    if ( fclose(fp) != 0 || info != 0 ) {
+        printf("\n%% error: writing matrix failed\n");
+        info = (info != 0 ? info : -1);
+    }
+    else {
+        printf(" done\n");
     }
+    
 cleanup:
+    magma_zmfree( &B, queue );
     return info;
 }
 
@@ -805,6 +2000,8 @@ magma_zprint_matrix(
     magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
     magma_z_matrix C={Magma_CSR};
 
+    CHECK_NOT_CSR64( A );
+
     if ( A.memory_location == Magma_CPU ) {
         printf("visualizing matrix of size %d x %d with %d nonzeros:\n",
             int(A.num_rows), int(A.num_cols), int(A.nnz));
@@ -959,14 +2156,31 @@ magma_z_csr_mtx(
     magma_index_t* new_row = NULL;
     magma_index_t* new_col = NULL;
     magma_int_t hermitian = 0;
+    bool use_cache = false;
     
     // make sure the target structure is empty
     magma_zmfree( A, queue );
     A->ownership = MagmaTrue;
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
     
     FILE *fid = NULL;
     MM_typecode matcode;
+
+    // reuse the binary sidecar cache if enabled and up to date
+    use_cache = magma_zmtx_cache_enabled();
+    if ( use_cache && magma_zmtx_cache_read( A, filename, queue ) == 0 ) {
+        goto cleanup;
+    }
+
+    // fast path: memory-mapped, multithreaded reader
+    info = magma_zmtx_read_parallel( A, filename, MagmaTrue, MagmaTrue, MagmaTrue, queue );
+    if ( info != MAGMA_ERR_NOT_IMPLEMENTED ) {
+        if ( info == 0 && use_cache ) {
+            magma_zmtx_cache_write( *A, filename );
+        }
+        goto cleanup;
+    }
+    info = 0;
+
     fid = fopen(filename, "r");
     
     if (fid == NULL) {
@@ -1122,31 +2336,10 @@ magma_z_csr_mtx(
     CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
     CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ));
     
-    // original code from Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-        
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_ = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }    
+    // parallel counting sort by row, then sort column indices within each row
+    CHECK( magma_zcoo2csr_cpu( num_rows, A->nnz, coo_row, coo_col, coo_val,
+                               A->row, A->col, A->val, queue ));
+    CHECK( magma_zcsr_sortrows_cpu( num_rows, A->row, A->col, A->val, queue ));
     magma_free_cpu(coo_row);
     magma_free_cpu(coo_col);
     magma_free_cpu(coo_val);
@@ -1154,31 +2347,6 @@ magma_z_csr_mtx(
     coo_col = NULL;
     coo_val = NULL;
 
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
-    }
-    (A->row)[A->num_rows] = A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
-    }
-
     if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
         //printf("removing zeros: ");
         CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
@@ -1196,6 +2364,9 @@ magma_z_csr_mtx(
     }
     A->true_nnz = A->nnz;
     printf(" done.\n");
+    if ( use_cache ) {
+        magma_zmtx_cache_write( *A, filename );
+    }
 cleanup:
     if ( fid != NULL ) {
         fclose( fid );
@@ -1251,7 +2422,6 @@ magma_z_csr_mtxsymm(
     magma_index_t *coo_col=NULL, *coo_row=NULL;
     magmaDoubleComplex *coo_val=NULL;
 
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
     
     FILE *fid = NULL;
     MM_typecode matcode;
@@ -1259,6 +2429,14 @@ magma_z_csr_mtxsymm(
     
     magma_zmfree( A, queue );
     A->ownership = MagmaTrue;
+
+    // fast path: memory-mapped, multithreaded reader
+    info = magma_zmtx_read_parallel( A, filename, MagmaFalse, MagmaTrue, MagmaTrue, queue );
+    if ( info != MAGMA_ERR_NOT_IMPLEMENTED ) {
+        goto cleanup;
+    }
+    info = 0;
+
     if (fid == NULL) {
         printf("%% Unable to open file %s\n", filename);
         info = MAGMA_ERR_NOT_FOUND;
@@ -1367,63 +2545,16 @@ magma_z_csr_mtxsymm(
     CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ) );
     CHECK( magma_zmalloc_cpu( &A->val, A->nnz ) );
 
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }
+    // parallel counting sort by row, then sort column indices within each row
+    CHECK( magma_zcoo2csr_cpu( num_rows, A->nnz, coo_row, coo_col, coo_val,
+                               A->row, A->col, A->val, queue ));
+    CHECK( magma_zcsr_sortrows_cpu( num_rows, A->row, A->col, A->val, queue ));
     magma_free_cpu(coo_row);
     magma_free_cpu(coo_col);
     magma_free_cpu(coo_val);
     coo_row = NULL;
     coo_col = NULL;
     coo_val = NULL;
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
-    }
-    
-    (A->row)[A->num_rows]=A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
-    }
 
     if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
         //printf("removing zeros: ");
@@ -1455,3 +2586,4 @@ cleanup:
     magma_free_cpu(coo_val);
     return info;
 }
+
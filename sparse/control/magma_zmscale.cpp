@@ -51,6 +51,8 @@ magma_zmscale(
     
     magma_z_matrix hA={Magma_CSR}, CSRA={Magma_CSR};
     
+    CHECK_NOT_CSR64( *A );
+
     if( A->num_rows != A->num_cols && scaling != Magma_NOSCALE ){
         printf("%% warning: non-square matrix.\n");
         printf("%% Fallback: no scaling.\n");
@@ -177,6 +179,8 @@ magma_zmscale_matrix_rhs(
     
     // printf("%% scaling = %d\n", scaling);
     
+    CHECK_NOT_CSR64( *A );
+
     if( A->num_rows != A->num_cols && scaling != Magma_NOSCALE ){
         printf("%% warning: non-square matrix.\n");
         printf("%% Fallback: no scaling.\n");
@@ -347,6 +351,8 @@ magma_zmdiagadd(
     
     magma_z_matrix hA={Magma_CSR}, CSRA={Magma_CSR};
     
+    CHECK_NOT_CSR64( *A );
+
     if ( A->memory_location == Magma_CPU && A->storage_type == Magma_CSRCOO ) {
         for( magma_int_t z=0; z<A->nnz; z++ ) {
             if ( A->col[z]== A->rowidx[z] ) {
@@ -47,6 +47,8 @@ magma_zmshrink(
 
     magma_z_matrix hA={Magma_CSR}, hACSR={Magma_CSR}, hB={Magma_CSR}, hBCSR={Magma_CSR};
      
+    CHECK_NOT_CSR64( A );
+
     if( A.num_rows<=A.num_cols){
         if( A.memory_location == Magma_CPU && A.storage_type == Magma_CSR ){
             CHECK( magma_zmconvert( A, B, Magma_CSR, Magma_CSR, queue ));
@@ -95,6 +95,8 @@ magma_zmslice(
 {
     magma_int_t info = 0;
     
+    CHECK_NOT_CSR64( A );
+
     // make sure the target structure is empty
     magma_zmfree( B, queue );
     
@@ -60,6 +60,8 @@ magma_zmsupernodal(
     int current_size = 0;
     int prev_matches = 0;
     
+    CHECK_NOT_CSR64( A );
+
     // make sure the target structure is empty
     magma_zmfree( S, queue );
 
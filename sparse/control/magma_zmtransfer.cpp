@@ -87,6 +87,10 @@ magma_zmtransfer(
     B->calibrator = NULL;
     B->dcalibrator = NULL;
     
+    // Magma_CSR64 matrices live on the CPU only
+    if ( src != Magma_CPU || dst != Magma_CPU ) {
+        CHECK_NOT_CSR64( A );
+    }
 
     // first case: copy matrix from host to device
     if ( src == Magma_CPU && dst == Magma_DEV ) {
@@ -267,6 +271,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sellp_sigma = A.sellp_sigma;
             // memory allocation
             CHECK( magma_zmalloc( &B->dval, A.nnz ));
             CHECK( magma_index_malloc( &B->dcol, A.nnz ));
@@ -275,6 +280,11 @@ magma_zmtransfer(
             magma_zsetvector( A.nnz, A.val, 1, B->dval, 1, queue );
             magma_index_setvector( A.nnz, A.col, 1, B->dcol, 1, queue );
             magma_index_setvector( A.numblocks + 1, A.row, 1, B->drow, 1, queue );
+            // SELL-C-sigma row permutation
+            if ( A.rowidx != NULL ) {
+                CHECK( magma_index_malloc( &B->drowidx, A.num_rows ));
+                magma_index_setvector( A.num_rows, A.rowidx, 1, B->drowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -403,6 +413,37 @@ magma_zmtransfer(
                 B->row[i] = A.row[i];
             }
         }
+        //CSR64-type
+        else if ( A.storage_type == Magma_CSR64 )
+        {
+            magma_offset_t nnz = MAGMA_CSR_NNZ( A );
+            // fill in information for B
+            B->storage_type = A.storage_type;
+            B->memory_location = Magma_CPU;
+            B->sym = A.sym;
+            B->diagorder_type = A.diagorder_type;
+            B->fill_mode = A.fill_mode;
+            B->num_rows = A.num_rows;
+            B->num_cols = A.num_cols;
+            B->nnz = A.nnz; B->true_nnz = A.true_nnz;
+            B->nnz64 = nnz;
+            B->max_nnz_row = A.max_nnz_row;
+            B->diameter = A.diameter;
+            // memory allocation
+            CHECK( magma_zmalloc_cpu( &B->val, nnz ));
+            CHECK( magma_offset_malloc_cpu( &B->row64, A.num_rows + 1 ));
+            CHECK( magma_index_malloc_cpu( &B->col, nnz ));
+            // data transfer
+            #pragma omp parallel for
+            for( magma_offset_t i=0; i<nnz; i++ ) {
+                B->val[i] = A.val[i];
+                B->col[i] = A.col[i];
+            }
+            #pragma omp parallel for
+            for( magma_int_t i=0; i<A.num_rows+1; i++ ) {
+                B->row64[i] = A.row64[i];
+            }
+        }
         //CSC-type
         if ( A.storage_type == Magma_CSC )
         {
@@ -581,6 +622,7 @@ magma_zmtransfer(
             B->diameter = A.diameter;
             B->blocksize = A.blocksize;
             B->alignment = A.alignment;
+            B->sellp_sigma = A.sellp_sigma;
             B->numblocks = A.numblocks;
             // memory allocation
             CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
@@ -596,6 +638,13 @@ magma_zmtransfer(
             for( magma_int_t i=0; i<A.numblocks+1; i++ ) {
                 B->row[i] = A.row[i];
             }
+            // SELL-C-sigma row permutation
+            if ( A.rowidx != NULL ) {
+                CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                for( magma_int_t i=0; i<A.num_rows; i++ ) {
+                    B->rowidx[i] = A.rowidx[i];
+                }
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -906,6 +955,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sellp_sigma = A.sellp_sigma;
             // memory allocation
             CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
             CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
@@ -914,6 +964,11 @@ magma_zmtransfer(
             magma_zgetvector( A.nnz, A.dval, 1, B->val, 1, queue );
             magma_index_getvector( A.nnz, A.dcol, 1, B->col, 1, queue );
             magma_index_getvector( A.numblocks + 1, A.drow, 1, B->row, 1, queue );
+            // SELL-C-sigma row permutation
+            if ( A.drowidx != NULL ) {
+                CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                magma_index_getvector( A.num_rows, A.drowidx, 1, B->rowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -1188,6 +1243,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sellp_sigma = A.sellp_sigma;
             // memory allocation
             CHECK( magma_zmalloc( &B->dval, A.nnz ));
             CHECK( magma_index_malloc( &B->dcol, A.nnz ));
@@ -1196,6 +1252,11 @@ magma_zmtransfer(
             magma_zcopyvector( A.nnz, A.dval, 1, B->dval, 1, queue );
             magma_index_copyvector( A.nnz, A.dcol, 1, B->dcol, 1, queue );
             magma_index_copyvector( A.numblocks + 1, A.drow, 1, B->drow, 1, queue );
+            // SELL-C-sigma row permutation
+            if ( A.drowidx != NULL ) {
+                CHECK( magma_index_malloc( &B->drowidx, A.num_rows ));
+                magma_index_copyvector( A.num_rows, A.drowidx, 1, B->drowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -12,7 +12,9 @@
 */
 #include "magmasparse_internal.h"
 
+#ifndef MAGMA_HAVE_CPU
 #include <cuda.h>  // for CUDA_VERSION
+#endif
 
 /* For hipSPARSE, they use a separate complex type than for hipBLAS */
 #ifdef MAGMA_HAVE_HIP
@@ -38,6 +40,40 @@
     }
 #endif
 
+
+#ifdef MAGMA_HAVE_CPU
+// CPU backend: transposes A, in any format and memory location, on the host
+// with trans, either magma_zmtranspose_cpu or magma_zmtransposeconj_cpu.
+static magma_int_t
+magma_zmtranspose_host(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_int_t (*trans)( magma_z_matrix, magma_z_matrix*, magma_queue_t ),
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hA={Magma_CSR}, hB={Magma_CSR};
+    magma_z_matrix ACSR={Magma_CSR}, BCSR={Magma_CSR};
+
+    CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+    CHECK( magma_zmconvert( hA, &ACSR, A.storage_type, Magma_CSR, queue ));
+    CHECK( trans( ACSR, &BCSR, queue ));
+    CHECK( magma_zmconvert( BCSR, &hB, Magma_CSR, A.storage_type, queue ));
+    CHECK( magma_zmtransfer( hB, B, Magma_CPU, A.memory_location, queue ));
+
+cleanup:
+    magma_zmfree( &hA, queue );
+    magma_zmfree( &hB, queue );
+    magma_zmfree( &ACSR, queue );
+    magma_zmfree( &BCSR, queue );
+    if( info != 0 ){
+        magma_zmfree( B, queue );
+    }
+    return info;
+}
+#endif
+
 /**
     Purpose
     -------
@@ -271,6 +307,9 @@ magma_z_cucsrtranspose(
     magma_z_matrix *B,
     magma_queue_t queue )
 {
+    #ifdef MAGMA_HAVE_CPU
+    return magma_zmtranspose_host( A, B, magma_zmtranspose_cpu, queue );
+    #else
     // for symmetric matrices: convert to csc using cusparse
     
     magma_int_t info = 0;
@@ -348,6 +387,7 @@ cleanup:
         magma_zmfree( B, queue );
     }
     return info;
+    #endif
 }
 
 
@@ -382,6 +422,9 @@ magma_zmtransposeconjugate(
     magma_z_matrix *B,
     magma_queue_t queue )
 {
+    #ifdef MAGMA_HAVE_CPU
+    return magma_zmtranspose_host( A, B, magma_zmtransposeconj_cpu, queue );
+    #else
     // for symmetric matrices: convert to csc using cusparse
     
     magma_int_t info = 0;
@@ -457,4 +500,5 @@ cleanup:
         magma_zmfree( B, queue );
     }
     return info;
+    #endif
 }
@@ -15,11 +15,12 @@
 
 
 /**
- * op(from[i], to[i]);
+ * Counting-sort transpose for Magma_CSR64 (64-bit row offsets,
+ * 32-bit column indices). op(from[i], to[i]);
  */
 template <typename Operator>
 inline magma_int_t
-magma_z_mtrans_template(
+magma_z_mtrans64_template(
     magma_z_matrix A, 
     magma_z_matrix *B,
     Operator op,
@@ -27,95 +28,99 @@ magma_z_mtrans_template(
 {
     magma_int_t info = 0;
     
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
+    magma_offset_t *fill = NULL;
+    magma_offset_t nnz = MAGMA_CSR_NNZ( A );
     
-    // magma_int_t num_threads;
-    // magma_int_t el_per_block;
     magma_zmfree( B, queue );
     B->ownership = MagmaTrue;
     
-    B->storage_type = A.storage_type;
+    B->storage_type = Magma_CSR64;
     B->memory_location = A.memory_location;
     
-    B->num_rows = A.num_rows;
-    B->num_cols = A.num_cols;
+    B->num_rows = A.num_cols;
+    B->num_cols = A.num_rows;
     B->nnz      = A.nnz;
+    B->true_nnz = A.nnz;
+    B->nnz64    = nnz;
     
-    CHECK( magma_index_malloc_cpu( &linked_list, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &row_ptr, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &last_rowel, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
-    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
-    
-    magma_free_cpu( A.rowidx );
+    CHECK( magma_offset_malloc_cpu( &B->row64, B->num_rows+1 ));
+    CHECK( magma_offset_malloc_cpu( &fill, B->num_rows ));
+    CHECK( magma_index_malloc_cpu( &B->col, nnz ));
+    CHECK( magma_zmalloc_cpu( &B->val, nnz ) );
     
-    CHECK( magma_zmatrix_addrowindex(&A, queue) );
-    
-    //#pragma omp parallel
-    // {
-    //     num_threads = omp_get_max_threads();
-    // }
-    
-    //#pragma omp parallel for
+    for( magma_int_t i=0; i<B->num_rows+1; i++ ){
+        B->row64[i] = 0;
+    }
+    // histogram of the column indices
+    for( magma_offset_t j=0; j<nnz; j++ ){
+        B->row64[ A.col[j]+1 ]++;
+    }
+    for( magma_int_t i=0; i<B->num_rows; i++ ){
+        B->row64[i+1] += B->row64[i];
+        fill[i] = B->row64[i];
+    }
+    // scatter in row order keeps the column indices of B sorted
     for( magma_int_t i=0; i<A.num_rows; i++ ){
-        row_ptr[i] = -1;
+        for( magma_offset_t j=A.row64[i]; j<A.row64[i+1]; j++ ){
+            magma_offset_t k = fill[ A.col[j] ]++;
+            op(A.val[j], B->val[k]);
+            B->col[k] = (magma_index_t) i;
+        }
     }
-    //#pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows+1; i++ ){
-        B->row[i] = 0;
+    
+cleanup:
+    magma_free_cpu( fill );
+    if( info != 0 ){
+        magma_zmfree( B, queue );
     }
+    return info;
+}
+
+
+/**
+ * op(from[i], to[i]);
+ */
+template <typename Operator>
+inline magma_int_t
+magma_z_mtrans_template(
+    magma_z_matrix A, 
+    magma_z_matrix *B,
+    Operator op,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
     
-    //el_per_block = magma_ceildiv( A.num_rows, num_threads );
-
-    //#pragma omp parallel
-    {
-        // magma_int_t id = omp_get_thread_num();
-        for(magma_int_t i=0; i<A.nnz; i++ ){
-            magma_index_t row = A.col[ i ];
-            //if( (row < (id+1)*el_per_block) && (row >=(id)*el_per_block)  ){
-            {
-                if( row_ptr[row] == -1 ){
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                }
-                B->row[row+1] = B->row[row+1] + 1;
-            }
-        }
+    if( A.storage_type == Magma_CSR64 ){
+        return magma_z_mtrans64_template( A, B, op, queue );
     }
     
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr( B->num_rows, B->row, queue );
+    magma_zmfree( B, queue );
+    B->ownership = MagmaTrue;
+    
+    B->storage_type = A.storage_type;
+    B->memory_location = A.memory_location;
     
-
-    assert( B->row[B->num_rows] == A.nnz );
+    B->num_rows = A.num_cols;
+    B->num_cols = A.num_rows;
+    B->nnz      = A.nnz;
     
-    //#pragma omp parallel for
-    for( magma_int_t row=0; row<A.num_rows; row++){
-        magma_int_t el = row_ptr[row];
-        if( el>-1 ) {
-            for( magma_int_t i=B->row[row]; i<B->row[row+1]; i++ ){
-                op(A.val[el], B->val[i]);
-                B->col[i] = A.rowidx[el];
-                el = linked_list[el];
-            }
-        }
+    CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
+    
+    // parallel counting sort by column, see magma_zcoo2csr_cpu.cpp
+    CHECK( magma_zcsr2csc_cpu( A.num_rows, A.num_cols, A.row, A.col, A.val,
+                               B->row, B->col, B->val, queue ));
+    
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<A.nnz; i++ ){
+        op(B->val[i], B->val[i]);
     }
     
 cleanup:
-    magma_free_cpu( row_ptr );
-    magma_free_cpu( last_rowel );
-    magma_free_cpu( linked_list );
-    magma_free_cpu( A.rowidx );
+    if( info != 0 ){
+        magma_zmfree( B, queue );
+    }
     return info;
 }
 
@@ -133,11 +138,11 @@ inline void cpy(const magmaDoubleComplex &from, magmaDoubleComplex &to) { to = f
 
     @param[in]
     A           magma_z_matrix
-                input matrix (CSR)
+                input matrix (CSR or CSR64)
 
     @param[out]
     B           magma_z_matrix*
-                output matrix (CSR)
+                output matrix (same format as A)
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -172,11 +177,11 @@ inline void conjop(const magmaDoubleComplex &from, magmaDoubleComplex &to) { to
 
     @param[in]
     A           magma_z_matrix
-                input matrix (CSR)
+                input matrix (CSR or CSR64)
 
     @param[out]
     B           magma_z_matrix*
-                output matrix (CSR)
+                output matrix (same format as A)
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -211,11 +216,11 @@ inline void pass(const magmaDoubleComplex &from, magmaDoubleComplex &to) { }
 
     @param[in]
     A           magma_z_matrix
-                input matrix (CSR)
+                input matrix (CSR or CSR64)
 
     @param[out]
     B           magma_z_matrix*
-                output matrix (CSR)
+                output matrix (same format as A)
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -250,11 +255,11 @@ inline void absval(const magmaDoubleComplex &from, magmaDoubleComplex &to) { to
 
     @param[in]
     A           magma_z_matrix
-                input matrix (CSR)
+                input matrix (CSR or CSR64)
 
     @param[out]
     B           magma_z_matrix*
-                output matrix (CSR)
+                output matrix (same format as A)
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -17,28 +17,96 @@
 
 #define SWAP(a, b)  { val_swap = a; a = b; b = val_swap; }
 
+// number of A entries per scheduling block of the sweeps
+#define MAGMA_PARILU_BLOCK 4096
+
+
+/*
+    ParILU update of the entry (i,j) of A with value aij.
+
+    Computes s = aij - sum_{k<min(i,j)} L(i,k) U(k,j) from the rows of L
+    (CSR or CSR64) and U^T (CSR or CSR64). On return, *il_out and *iu_out
+    point behind the last entries visited, i.e., one behind the (i,j) entry
+    of L respectively U.
+*/
+static inline magmaDoubleComplex
+magma_zparilu_entry(
+    magma_index_t i,
+    magma_index_t j,
+    magmaDoubleComplex aij,
+    const magma_z_matrix *L,
+    const magma_z_matrix *U,
+    magma_offset_t *il_out,
+    magma_offset_t *iu_out )
+{
+    magmaDoubleComplex s = aij, sp = MAGMA_Z_ZERO;
+    magma_offset_t il = MAGMA_CSR_ROWPTR( *L, i ), ilend = MAGMA_CSR_ROWPTR( *L, i+1 );
+    magma_offset_t iu = MAGMA_CSR_ROWPTR( *U, j ), iuend = MAGMA_CSR_ROWPTR( *U, j+1 );
+
+    while ( il < ilend && iu < iuend ) {
+        magma_index_t jl = L->col[il];
+        magma_index_t ju = U->col[iu];
+
+        // avoid branching
+        sp = ( jl == ju ) ? L->val[il] * U->val[iu] : MAGMA_Z_ZERO;
+        s  = ( jl == ju ) ? s - sp : s;
+        il = ( jl <= ju ) ? il+1 : il;
+        iu = ( jl >= ju ) ? iu+1 : iu;
+    }
+    // undo the last operation (it must be the last)
+    *il_out = il;
+    *iu_out = iu;
+    return s + sp;
+}
+
+
+/*
+    First entry of scheduling block b: the first row start at or after
+    entry b*MAGMA_PARILU_BLOCK. A is sorted by rows, so every block covers
+    whole rows and the L row of an entry stays in cache across the row.
+*/
+static inline magma_offset_t
+magma_zparilu_block_start(
+    const magma_z_matrix *A,
+    magma_offset_t b )
+{
+    magma_offset_t nnz = MAGMA_CSR_NNZ( *A );
+    magma_offset_t k = min( b * MAGMA_PARILU_BLOCK, nnz );
+    while ( k > 0 && k < nnz && A->rowidx[k] == A->rowidx[k-1] ) {
+        k++;
+    }
+    return k;
+}
+
 
 /***************************************************************************//**
     Purpose
     -------
     This function does one asynchronous ParILU sweep. 
     Input and output array are identical.
+
+    The entries of A are processed in blocks of whole rows which are
+    distributed dynamically over the threads. Within a block, every update
+    is immediately used by the following entries (Gauss-Seidel-like);
+    across threads, the updates become visible asynchronously.
+
     Arguments
     ---------
 
     @param[in]
     A           magma_z_matrix
-                System matrix in COO.
+                System matrix in COO, sorted by rows (CSRCOO, or CSR64
+                with row indices).
 
     @param[in]
     L           magma_z_matrix*
                 Current approximation for the lower triangular factor
-                The format is sorted CSR.
+                The format is sorted CSR or CSR64.
 
     @param[in]
     U           magma_z_matrix*
                 Current approximation for the upper triangular factor
-                The format is sorted CSC (U^T in CSR).
+                The format is sorted CSC (U^T in CSR or CSR64).
                 
     @param[in]
     queue       magma_queue_t
@@ -56,46 +124,27 @@ magma_zparilu_sweep(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
-
-
-    magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
-    int il, iu, jl, ju;
-
-    #pragma omp parallel for
-    for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
-
-        magmaDoubleComplex s, sp;
-        s =  A.val[k];
-        sp = zero;
-
-        il = L->row[i];
-        iu = U->row[j];
-
-        while (il < L->row[i+1] && iu < U->row[j+1])
-        {
-            sp = zero;
-            jl = L->col[il];
-            ju = U->col[iu];
-
-            // avoid branching
-            sp = ( jl == ju ) ? L->val[il] * U->val[iu] : sp;
-            s = ( jl == ju ) ? s-sp : s;
-            il = ( jl <= ju ) ? il+1 : il;
-            iu = ( jl >= ju ) ? iu+1 : iu;
-        }
-        // undo the last operation (it must be the last)
-        s += sp;
-        
-        if ( i > j )      // modify l entry
-            L->val[il-1] =  s / U->val[U->row[j+1]-1];
-        else {            // modify u entry
-            U->val[iu-1] = s;
+    // magma_ceildiv is magma_int_t; the count may not fit
+    magma_offset_t nblocks = ( MAGMA_CSR_NNZ( A ) + MAGMA_PARILU_BLOCK-1 ) / MAGMA_PARILU_BLOCK;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (magma_offset_t b=0; b < nblocks; b++) {
+        magma_offset_t kstart = magma_zparilu_block_start( &A, b );
+        magma_offset_t kend   = magma_zparilu_block_start( &A, b+1 );
+        for (magma_offset_t k=kstart; k < kend; k++) {
+            magma_index_t i = A.rowidx[k];
+            magma_index_t j = A.col[k];
+            magma_offset_t il, iu;
+            magmaDoubleComplex s = magma_zparilu_entry( i, j, A.val[k], L, U,
+                                                       &il, &iu );
+            if ( i > j ) {      // modify l entry
+                L->val[il-1] = s / U->val[MAGMA_CSR_ROWPTR( *U, j+1 )-1];
+            } else {            // modify u entry
+                U->val[iu-1] = s;
+            }
         }
     }
-    
+
     return info;
 }
 
@@ -106,22 +155,28 @@ magma_zparilu_sweep(
     This function does one synchronized ParILU sweep. Input and output are 
     different arrays.
 
+    All entries are computed from the values of the previous sweep
+    (Jacobi-like), the new values are written to a second buffer which is
+    swapped in at the end. The schedule is the same as in
+    magma_zparilu_sweep, and the result does not depend on it.
+
     Arguments
     ---------
 
     @param[in]
     A           magma_z_matrix
-                System matrix in COO.
+                System matrix in COO, sorted by rows (CSRCOO, or CSR64
+                with row indices).
 
     @param[in]
     L           magma_z_matrix*
                 Current approximation for the lower triangular factor
-                The format is sorted CSR.
+                The format is sorted CSR or CSR64.
 
     @param[in]
     U           magma_z_matrix*
                 Current approximation for the upper triangular factor
-                The format is sorted CSC (U^T in CSR).
+                The format is sorted CSC (U^T in CSR or CSR64).
                 
     @param[in]
     queue       magma_queue_t
@@ -139,65 +194,43 @@ magma_zparilu_sweep_sync(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
+    magma_offset_t nblocks = ( MAGMA_CSR_NNZ( A ) + MAGMA_PARILU_BLOCK-1 ) / MAGMA_PARILU_BLOCK;
+    magmaDoubleComplex *L_new_val = NULL, *U_new_val = NULL, *val_swap = NULL;
 
+    CHECK( magma_zmalloc_cpu( &L_new_val, MAGMA_CSR_NNZ( *L )));
+    CHECK( magma_zmalloc_cpu( &U_new_val, MAGMA_CSR_NNZ( *U )));
 
-    magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
-    
-    int il, iu, jl, ju;
-    
-    magmaDoubleComplex *L_new_val = NULL, *U_new_val = NULL, *val_swap = NULL;
-    
-    CHECK( magma_zmalloc_cpu( &L_new_val, L->nnz ));
-    CHECK( magma_zmalloc_cpu( &U_new_val, U->nnz ));
-    
     // we need 1 on the main diagonal of L
     #pragma omp parallel for
-    for (int k=0; k < L->num_rows; k++) {
-        L_new_val[L->row[k+1]-1] = MAGMA_Z_ONE;
+    for (magma_int_t k=0; k < L->num_rows; k++) {
+        L_new_val[MAGMA_CSR_ROWPTR( *L, k+1 )-1] = MAGMA_Z_ONE;
     }
-    
-    #pragma omp parallel for
-    for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
-        
-        magmaDoubleComplex s, sp;
-        s =  A.val[k];
-        sp = zero;
-
-        il = L->row[i];
-        iu = U->row[j];
-
-        while (il < L->row[i+1] && iu < U->row[j+1])
-        {
-            sp = zero;
-            jl = L->col[il];
-            ju = U->col[iu];
-
-            // avoid branching
-            sp = ( jl == ju ) ? L->val[il] * U->val[iu] : sp;
-            s = ( jl == ju ) ? s-sp : s;
-            il = ( jl <= ju ) ? il+1 : il;
-            iu = ( jl >= ju ) ? iu+1 : iu;
-        }
-        // undo the last operation (it must be the last)
-        s += sp;
-        
-        if ( i > j )      // modify l entry
-            L_new_val[il-1] =  s / U->val[U->row[j+1]-1];
-        else {            // modify u entry
-            U_new_val[iu-1] = s;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (magma_offset_t b=0; b < nblocks; b++) {
+        magma_offset_t kstart = magma_zparilu_block_start( &A, b );
+        magma_offset_t kend   = magma_zparilu_block_start( &A, b+1 );
+        for (magma_offset_t k=kstart; k < kend; k++) {
+            magma_index_t i = A.rowidx[k];
+            magma_index_t j = A.col[k];
+            magma_offset_t il, iu;
+            magmaDoubleComplex s = magma_zparilu_entry( i, j, A.val[k], L, U,
+                                                       &il, &iu );
+            if ( i > j ) {      // modify l entry
+                L_new_val[il-1] = s / U->val[MAGMA_CSR_ROWPTR( *U, j+1 )-1];
+            } else {            // modify u entry
+                U_new_val[iu-1] = s;
+            }
         }
     }
-    
+
     // swap old and new values
     SWAP( L_new_val, L->val );
     SWAP( U_new_val, U->val );
-    
+
 cleanup:
     magma_free_cpu( L_new_val );
     magma_free_cpu( U_new_val );
-    
+
     return info;
 }
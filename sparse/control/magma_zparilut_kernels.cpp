@@ -36,7 +36,7 @@
 
     @param[in]
     A           magma_z_matrix*
-                System matrix. The format is sorted CSR.
+                System matrix. The format is sorted CSR or CSR64.
 
     @param[in,out]
     L           magma_z_matrix*
@@ -77,9 +77,10 @@ magma_zparilut_sweep(
         if(col < row) {
             magmaDoubleComplex A_e = MAGMA_Z_ZERO;
             // check whether A contains element in this location
-            for (i = A->row[row]; i<A->row[row+1]; i++) {
-                if(A->col[i] == col) {
-                    A_e = A->val[i];
+            for (magma_offset_t k = MAGMA_CSR_ROWPTR(*A, row);
+                                k < MAGMA_CSR_ROWPTR(*A, row+1); k++) {
+                if(A->col[k] == col) {
+                    A_e = A->val[k];
                     break;
                 }
             }
@@ -125,9 +126,10 @@ magma_zparilut_sweep(
             magma_index_t col = U->rowidx[ e ];
             magmaDoubleComplex A_e = MAGMA_Z_ZERO;
             // check whether A contains element in this location
-            for (i = A->row[row]; i<A->row[row+1]; i++) {
-                if(A->col[i] == col) {
-                    A_e = A->val[i];
+            for (magma_offset_t k = MAGMA_CSR_ROWPTR(*A, row);
+                                k < MAGMA_CSR_ROWPTR(*A, row+1); k++) {
+                if(A->col[k] == col) {
+                    A_e = A->val[k];
                     break;
                 }
             }
@@ -181,7 +183,7 @@ magma_zparilut_sweep(
 
     @param[in]
     A           magma_z_matrix*
-                System matrix. The format is sorted CSR.
+                System matrix. The format is sorted CSR or CSR64.
 
     @param[in,out]
     L           magma_z_matrix*
@@ -224,9 +226,10 @@ magma_zparilut_sweep_sync(
         {   
             magmaDoubleComplex A_e = MAGMA_Z_ZERO;
             // check whether A contains element in this location
-            for (i = A->row[row]; i<A->row[row+1]; i++) {
-                if(A->col[i] == col) {
-                    A_e = A->val[i];
+            for (magma_offset_t k = MAGMA_CSR_ROWPTR(*A, row);
+                                k < MAGMA_CSR_ROWPTR(*A, row+1); k++) {
+                if(A->col[k] == col) {
+                    A_e = A->val[k];
                     break;
                 }
             }
@@ -275,9 +278,10 @@ magma_zparilut_sweep_sync(
         } else {
             magmaDoubleComplex A_e = MAGMA_Z_ZERO;
             // check whether A contains element in this location
-            for (i = A->row[row]; i<A->row[row+1]; i++) {
-                if(A->col[i] == col) {
-                    A_e = A->val[i];
+            for (magma_offset_t k = MAGMA_CSR_ROWPTR(*A, row);
+                                k < MAGMA_CSR_ROWPTR(*A, row+1); k++) {
+                if(A->col[k] == col) {
+                    A_e = A->val[k];
                     break;
                 }
             }
@@ -338,7 +342,7 @@ cleanup:
 
     @param[in]
     A           magma_z_matrix
-                System matrix A.
+                System matrix A (CSR or CSR64).
 
     @param[in]
     L           magma_z_matrix
@@ -378,10 +382,11 @@ magma_zparilut_residuals(
             magma_index_t row = R->rowidx[ e ];
             magma_index_t col = R->col[ e ];
             magmaDoubleComplex A_e = MAGMA_Z_ZERO;
-            for (i = A.row[row]; i<A.row[row+1]; i++) {
-                if(A.col[i] == col) {
-                    A_e = A.val[i];
-                    i = A.row[row+1];
+            for (magma_offset_t k = MAGMA_CSR_ROWPTR(A, row);
+                                k < MAGMA_CSR_ROWPTR(A, row+1); k++) {
+                if(A.col[k] == col) {
+                    A_e = A.val[k];
+                    break;
                 }
             }
             //now do the actual iteration
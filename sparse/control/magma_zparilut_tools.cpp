@@ -4968,7 +4968,7 @@ magma_zparilut_set_exact_thrs(
     magmaDoubleComplex *val=NULL;
     const magma_int_t incy = 1;
     const magma_int_t incx = 1;
-    magma_int_t loc_nnz;
+    magma_int_t loc_nnz = LU->nnz;
     double ratio;
     magma_int_t loc_num_rm;
     magma_int_t num_threads=1;
@@ -0,0 +1,418 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <algorithm>
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+// same parameters as the GPU implementation, see sparse/blas/magma_sampleselect.h
+#define SAMPLESELECT_SAMPLE_SIZE  1024
+#define SAMPLESELECT_TREE_HEIGHT  8
+#define SAMPLESELECT_TREE_WIDTH   (1 << SAMPLESELECT_TREE_HEIGHT)
+#define SAMPLESELECT_TREE_SIZE    (2*SAMPLESELECT_TREE_WIDTH - 1)
+
+// buckets smaller than this are searched directly
+#define SAMPLESELECT_BASECASE     1024
+
+// arrays shorter than this are processed by a single thread
+#define SAMPLESELECT_PARALLEL     16384
+
+
+/*
+    CPU version of the sample-select algorithm used by magma_zsampleselect.
+
+    The keys are the squared magnitudes. A sorted sample of the keys
+    provides SAMPLESELECT_TREE_WIDTH leaves; leaves 1..WIDTH-1 act as
+    splitters and are stored as an implicit binary search tree, so that
+    the bucket of a key is found by a fixed number of branch-free steps.
+    Each thread counts the keys of a contiguous block per bucket. The
+    bucket containing the requested rank is located by a prefix sum over
+    the totals.
+    The approximate variant stops here and returns the lower bound of that
+    bucket. The exact variant copies the bucket out, using the per-block
+    counts as write offsets, and recurses on it.
+*/
+static magma_int_t
+magma_zsampleselect_pick( magma_int_t idx, magma_int_t samplesize, magma_int_t size )
+{
+    magma_int_t stride = size / samplesize;
+    if ( stride == 0 ) {
+        return idx * size / samplesize;
+    } else {
+        return idx * stride + stride / 2;
+    }
+}
+
+
+// position in the sorted leaves of inner node idx of the search tree
+static magma_int_t
+magma_zsampleselect_tree_entry( magma_int_t idx )
+{
+    magma_int_t lvl = 0;
+    while ( (2 << lvl) <= idx + 1 ) {
+        lvl++;
+    }
+    magma_int_t step = SAMPLESELECT_TREE_WIDTH >> lvl;
+    magma_int_t lvl_idx = idx - (1 << lvl) + 1;
+    return lvl_idx * step + step / 2;
+}
+
+
+static void
+magma_zsampleselect_build_tree(
+    const double *in,
+    magma_int_t size,
+    double *tree )
+{
+    double sample[ SAMPLESELECT_SAMPLE_SIZE ];
+    double *leaves = tree + SAMPLESELECT_TREE_WIDTH - 1;
+
+    for( magma_int_t i=0; i < SAMPLESELECT_SAMPLE_SIZE; i++ ) {
+        sample[i] = in[ magma_zsampleselect_pick( i, SAMPLESELECT_SAMPLE_SIZE, size ) ];
+    }
+    std::sort( sample, sample + SAMPLESELECT_SAMPLE_SIZE );
+    for( magma_int_t i=0; i < SAMPLESELECT_TREE_WIDTH; i++ ) {
+        leaves[i] = sample[ magma_zsampleselect_pick( i, SAMPLESELECT_TREE_WIDTH,
+                                                      SAMPLESELECT_SAMPLE_SIZE ) ];
+    }
+    for( magma_int_t i=0; i < SAMPLESELECT_TREE_WIDTH - 1; i++ ) {
+        tree[i] = leaves[ magma_zsampleselect_tree_entry( i ) ];
+    }
+}
+
+
+static inline magma_int_t
+magma_zsampleselect_bucket( const double *tree, double el )
+{
+    magma_int_t i = 0;
+    for( magma_int_t lvl=0; lvl < SAMPLESELECT_TREE_HEIGHT; lvl++ ) {
+        i = 2*i + 1 + ( el >= tree[i] );
+    }
+    return i - (SAMPLESELECT_TREE_WIDTH - 1);
+}
+
+
+// per block bucket counts; the bucket of every key goes to oracles if not NULL
+static void
+magma_zsampleselect_count(
+    const double *in,
+    magma_int_t size,
+    const double *tree,
+    magma_int_t nblocks,
+    magma_int_t *counts,
+    unsigned char *oracles )
+{
+    #pragma omp parallel for schedule(static, 1)
+    for( magma_int_t b=0; b < nblocks; b++ ) {
+        magma_int_t *c = counts + b*SAMPLESELECT_TREE_WIDTH;
+        magma_int_t start = magma_int_t( int64_t(size) * b / nblocks );
+        magma_int_t end   = magma_int_t( int64_t(size) * (b+1) / nblocks );
+        for( magma_int_t i=0; i < SAMPLESELECT_TREE_WIDTH; i++ ) {
+            c[i] = 0;
+        }
+        for( magma_int_t j=start; j < end; j++ ) {
+            magma_int_t bucket = magma_zsampleselect_bucket( tree, in[j] );
+            c[ bucket ]++;
+            if ( oracles != NULL ) {
+                oracles[j] = (unsigned char) bucket;
+            }
+        }
+    }
+}
+
+
+// finds the bucket containing rank, and the number of keys in lower buckets
+static void
+magma_zsampleselect_findbucket(
+    magma_int_t nblocks,
+    const magma_int_t *counts,
+    magma_int_t rank,
+    magma_int_t *bucket,
+    magma_int_t *below,
+    magma_int_t *bucket_size )
+{
+    magma_int_t sum = 0;
+    for( magma_int_t i=0; i < SAMPLESELECT_TREE_WIDTH; i++ ) {
+        magma_int_t total = 0;
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            total += counts[ b*SAMPLESELECT_TREE_WIDTH + i ];
+        }
+        if ( rank < sum + total || i == SAMPLESELECT_TREE_WIDTH - 1 ) {
+            *bucket = i;
+            *below = sum;
+            *bucket_size = total;
+            return;
+        }
+        sum += total;
+    }
+}
+
+
+static magma_int_t
+magma_zsampleselect_realloc(
+    magma_ptr *ptr,
+    magma_int_t *size,
+    magma_int_t required_size )
+{
+    magma_int_t info = 0;
+    if ( *size < required_size ) {
+        magma_int_t newsize = required_size * 5 / 4;
+        magma_free_cpu( *ptr );
+        *ptr = NULL;
+        *size = 0;
+        CHECK( magma_malloc_cpu( ptr, newsize ));
+        *size = newsize;
+    }
+
+cleanup:
+    return info;
+}
+
+
+static magma_int_t
+magma_zsampleselect_nblocks( magma_int_t size )
+{
+    magma_int_t nblocks = 1;
+#ifdef _OPENMP
+    if ( size >= SAMPLESELECT_PARALLEL ) {
+        nblocks = omp_get_max_threads();
+    }
+#endif
+    return nblocks;
+}
+
+
+// squared magnitudes of val
+static void
+magma_zsampleselect_keys(
+    const magmaDoubleComplex *val,
+    magma_int_t size,
+    double *keys )
+{
+    #pragma omp parallel for if( size >= SAMPLESELECT_PARALLEL )
+    for( magma_int_t j=0; j < size; j++ ) {
+        double re = MAGMA_Z_REAL( val[j] );
+        double im = MAGMA_Z_IMAG( val[j] );
+        keys[j] = re*re + im*im;
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects a threshold separating the subset_size smallest
+    magnitude elements from the rest. It is the CPU counterpart of
+    magma_zsampleselect: val resides in CPU memory and the work is
+    distributed over the OpenMP threads.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution,
+                free with magma_free_cpu.
+
+    @param[in,out]
+    tmp_size    magma_int_t*
+                pointer to size of temporary storage.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t nblocks = magma_zsampleselect_nblocks( total_size );
+    magma_int_t size = total_size, rank = subset_size;
+    double tree[ SAMPLESELECT_TREE_SIZE ];
+    double *in, *out;
+    magma_int_t *counts;
+    unsigned char *oracles;
+
+    if ( subset_size < 0 || subset_size >= total_size ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    CHECK( magma_zsampleselect_realloc( tmp_ptr, tmp_size,
+               sizeof(double) * 2 * total_size
+             + sizeof(magma_int_t) * nblocks * SAMPLESELECT_TREE_WIDTH
+             + sizeof(unsigned char) * total_size ));
+    in      = (double*) *tmp_ptr;
+    out     = in + total_size;
+    counts  = (magma_int_t*) (out + total_size);
+    oracles = (unsigned char*) (counts + nblocks * SAMPLESELECT_TREE_WIDTH);
+
+    magma_zsampleselect_keys( val, total_size, in );
+
+    while ( size > SAMPLESELECT_BASECASE ) {
+        magma_int_t bucket, below, bucket_size;
+        nblocks = magma_zsampleselect_nblocks( size );
+        magma_zsampleselect_build_tree( in, size, tree );
+        magma_zsampleselect_count( in, size, tree, nblocks, counts, oracles );
+        magma_zsampleselect_findbucket( nblocks, counts, rank,
+                                        &bucket, &below, &bucket_size );
+        if ( bucket_size == size ) {
+            break;  // all keys in one bucket, e.g. many equal values
+        }
+
+        // block offsets within the bucket
+        magma_int_t sum = 0;
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            magma_int_t c = counts[ b*SAMPLESELECT_TREE_WIDTH + bucket ];
+            counts[ b*SAMPLESELECT_TREE_WIDTH + bucket ] = sum;
+            sum += c;
+        }
+        #pragma omp parallel for schedule(static, 1)
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            magma_int_t start = magma_int_t( int64_t(size) * b / nblocks );
+            magma_int_t end   = magma_int_t( int64_t(size) * (b+1) / nblocks );
+            magma_int_t p = counts[ b*SAMPLESELECT_TREE_WIDTH + bucket ];
+            for( magma_int_t j=start; j < end; j++ ) {
+                if ( oracles[j] == bucket ) {
+                    out[ p++ ] = in[j];
+                }
+            }
+        }
+        std::swap( in, out );
+        size = bucket_size;
+        rank -= below;
+    }
+
+    std::nth_element( in, in + rank, in + size );
+    *thrs = sqrt( in[ rank ] );
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects an approximate threshold separating the subset_size
+    smallest magnitude elements from the rest. It is the CPU counterpart of
+    magma_zsampleselect_approx: a single bucketing pass, the result is the
+    lower splitter of the bucket containing the subset_size-th element.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary CPU storage.
+                May be reallocated during execution,
+                free with magma_free_cpu.
+
+    @param[in,out]
+    tmp_size    magma_int_t*
+                pointer to size of temporary storage.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t nblocks = magma_zsampleselect_nblocks( total_size );
+    magma_int_t bucket, below, bucket_size;
+    double tree[ SAMPLESELECT_TREE_SIZE ];
+    double *keys;
+    magma_int_t *counts;
+
+    if ( total_size <= SAMPLESELECT_BASECASE ) {
+        return magma_zsampleselect_cpu( total_size, subset_size, val, thrs,
+                                        tmp_ptr, tmp_size, queue );
+    }
+    if ( subset_size < 0 || subset_size >= total_size ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    CHECK( magma_zsampleselect_realloc( tmp_ptr, tmp_size,
+               sizeof(double) * total_size
+             + sizeof(magma_int_t) * nblocks * SAMPLESELECT_TREE_WIDTH ));
+    keys   = (double*) *tmp_ptr;
+    counts = (magma_int_t*) (keys + total_size);
+
+    magma_zsampleselect_keys( val, total_size, keys );
+    magma_zsampleselect_build_tree( keys, total_size, tree );
+    magma_zsampleselect_count( keys, total_size, tree, nblocks, counts, NULL );
+    magma_zsampleselect_findbucket( nblocks, counts, subset_size,
+                                    &bucket, &below, &bucket_size );
+    *thrs = sqrt( tree[ SAMPLESELECT_TREE_WIDTH - 1 + bucket ] );
+
+cleanup:
+    return info;
+}
@@ -12,13 +12,10 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
-#include "magmasparse_internal.h"
+#include <algorithm>
 
+#include "magmasparse_internal.h"
 
-#define SWAP(a, b)  { tmp = val[a]; val[a] = val[b]; val[b] = tmp; }
-#define SWAPM(a, b) { tmpv = val[a]; val[a] = val[b]; val[b] = tmpv;  \
-                      tmpc = col[a]; col[a] = col[b]; col[b] = tmpc;  \
-                      tmpr = row[a]; row[a] = row[b]; row[b] = tmpr; }
 
 #define UP 0
 #define DOWN 1
@@ -327,6 +324,264 @@ cleanup:
 
 
 
+// arrays shorter than this are handled by a single thread
+#define MAGMA_ORDERSTAT_PARALLEL 16384
+// sample size used to bracket the kth element in long arrays
+#define MAGMA_ORDERSTAT_SAMPLES 1024
+// distance of the two splitters from the estimated rank within the sample
+#define MAGMA_ORDERSTAT_GAP 64
+
+
+/*
+    Selection engine behind magma_zmorderstatistics and
+    magma_zorderstatistics.
+
+    The magnitudes are computed once into an array of keys; for r=1 the keys
+    are negated so that the kth largest element becomes the kth smallest
+    key. The key of rank k is located on the keys only, then a single
+    three-way partition (below, equal to, above that key) reorders val and,
+    if present, col and row.
+
+    All passes over the arrays split them into nblocks contiguous blocks
+    which are counted and scattered independently, like magma_zbucket_cpu;
+    the counting loops are branch-free so that the compiler can vectorize
+    them.
+*/
+static magma_int_t
+magma_zorderstat_keys(
+    const magmaDoubleComplex *val,
+    magma_int_t length,
+    magma_int_t r,
+    double *key )
+{
+    magma_int_t nonfinite = 0;
+    double sign = ( r == 0 ) ? 1.0 : -1.0;
+
+    #pragma omp parallel for reduction(+:nonfinite) if( length >= MAGMA_ORDERSTAT_PARALLEL )
+    for( magma_int_t i=0; i < length; i++ ) {
+        key[i] = sign * MAGMA_Z_ABS( val[i] );
+        nonfinite += magma_z_isnan_inf( val[i] );
+    }
+    if ( nonfinite > 0 ) {
+        for( magma_int_t i=0; i < length; i++ ) {
+            if ( magma_z_isnan_inf( val[i] ) ) {
+                printf("%% error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
+                break;
+            }
+        }
+        return MAGMA_ERR_NAN;
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+// per block: number of keys below lo, in [lo, hi] and above hi
+static void
+magma_zorderstat_count(
+    magma_int_t length,
+    const double *key,
+    double lo,
+    double hi,
+    magma_int_t nblocks,
+    magma_int_t *cnt )
+{
+    #pragma omp parallel for schedule(static, 1)
+    for( magma_int_t b=0; b < nblocks; b++ ) {
+        magma_int_t start = magma_int_t( int64_t(length) * b / nblocks );
+        magma_int_t end   = magma_int_t( int64_t(length) * (b+1) / nblocks );
+        magma_int_t below = 0, above = 0;
+        for( magma_int_t j=start; j < end; j++ ) {
+            below += ( key[j] < lo );
+            above += ( key[j] > hi );
+        }
+        cnt[ 3*b   ] = below;
+        cnt[ 3*b+1 ] = end - start - below - above;
+        cnt[ 3*b+2 ] = above;
+    }
+}
+
+
+// turns the block counts into output offsets: all entries below lo,
+// then all entries in [lo, hi], then all above hi, blocks in order
+static void
+magma_zorderstat_offsets(
+    magma_int_t nblocks,
+    magma_int_t *cnt )
+{
+    magma_int_t sum = 0;
+    for( magma_int_t c=0; c < 3; c++ ) {
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            magma_int_t tmp = cnt[ 3*b+c ];
+            cnt[ 3*b+c ] = sum;
+            sum += tmp;
+        }
+    }
+}
+
+
+/*
+    Returns in kth the key of rank k.
+
+    For long arrays, two splitters are taken from a sorted pseudo-random
+    sample around the estimated position of rank k. One parallel counting
+    pass checks whether they bracket rank k; if so, only the keys between
+    them are copied out and searched. The search itself is std::nth_element,
+    an introselect with O(n) worst case behavior. If the splitters miss,
+    the whole key array is searched instead.
+*/
+static magma_int_t
+magma_zorderstat_kth(
+    magma_int_t length,
+    const double *key,
+    magma_int_t k,
+    magma_int_t nblocks,
+    magma_int_t *cnt,
+    double *kth )
+{
+    magma_int_t info = 0;
+    double *buf = NULL;
+
+    if ( length >= MAGMA_ORDERSTAT_PARALLEL ) {
+        double sample[ MAGMA_ORDERSTAT_SAMPLES ];
+        unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+        for( magma_int_t i=0; i < MAGMA_ORDERSTAT_SAMPLES; i++ ) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            sample[i] = key[ (seed >> 11) % (unsigned long long) length ];
+        }
+        std::sort( sample, sample + MAGMA_ORDERSTAT_SAMPLES );
+
+        magma_int_t pos = magma_int_t( double(k) / double(length) * MAGMA_ORDERSTAT_SAMPLES );
+        double lo = ( pos - MAGMA_ORDERSTAT_GAP <= 0 )
+                  ? -HUGE_VAL : sample[ pos - MAGMA_ORDERSTAT_GAP ];
+        double hi = ( pos + MAGMA_ORDERSTAT_GAP >= MAGMA_ORDERSTAT_SAMPLES-1 )
+                  ? HUGE_VAL : sample[ pos + MAGMA_ORDERSTAT_GAP ];
+
+        magma_zorderstat_count( length, key, lo, hi, nblocks, cnt );
+        magma_int_t below = 0, inside = 0;
+        for( magma_int_t b=0; b < nblocks; b++ ) {
+            below  += cnt[ 3*b   ];
+            inside += cnt[ 3*b+1 ];
+        }
+        if ( below <= k && k < below + inside ) {
+            magma_zorderstat_offsets( nblocks, cnt );
+            CHECK( magma_dmalloc_cpu( &buf, inside ));
+            #pragma omp parallel for schedule(static, 1)
+            for( magma_int_t b=0; b < nblocks; b++ ) {
+                magma_int_t start = magma_int_t( int64_t(length) * b / nblocks );
+                magma_int_t end   = magma_int_t( int64_t(length) * (b+1) / nblocks );
+                magma_int_t p = cnt[ 3*b+1 ] - below;
+                for( magma_int_t j=start; j < end; j++ ) {
+                    if ( key[j] >= lo && key[j] <= hi ) {
+                        buf[ p++ ] = key[j];
+                    }
+                }
+            }
+            std::nth_element( buf, buf + (k - below), buf + inside );
+            *kth = buf[ k - below ];
+            goto cleanup;
+        }
+    }
+
+    CHECK( magma_dmalloc_cpu( &buf, length ));
+    #pragma omp parallel for if( length >= MAGMA_ORDERSTAT_PARALLEL )
+    for( magma_int_t j=0; j < length; j++ ) {
+        buf[j] = key[j];
+    }
+    std::nth_element( buf, buf + k, buf + length );
+    *kth = buf[ k ];
+
+cleanup:
+    magma_free_cpu( buf );
+    return info;
+}
+
+
+// col and row may be NULL
+static magma_int_t
+magma_zorderstat_select(
+    magmaDoubleComplex *val,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_int_t length,
+    magma_int_t k,
+    magma_int_t r,
+    magmaDoubleComplex *element,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    double *key = NULL;
+    magma_int_t *cnt = NULL;
+    magmaDoubleComplex *tmpval = NULL;
+    magma_index_t *tmpcol = NULL, *tmprow = NULL;
+    magma_int_t nblocks = 1;
+    double kth;
+
+    if ( k < 0 || k >= length ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+#ifdef _OPENMP
+    if ( length >= MAGMA_ORDERSTAT_PARALLEL && ! omp_in_parallel() ) {
+        nblocks = omp_get_max_threads();
+    }
+#endif
+
+    CHECK( magma_dmalloc_cpu( &key, length ));
+    CHECK( magma_imalloc_cpu( &cnt, 3*nblocks ));
+    CHECK( magma_zorderstat_keys( val, length, r, key ));
+    CHECK( magma_zorderstat_kth( length, key, k, nblocks, cnt, &kth ));
+
+    // three-way partition around the key of rank k
+    CHECK( magma_zmalloc_cpu( &tmpval, length ));
+    if ( col != NULL ) {
+        CHECK( magma_index_malloc_cpu( &tmpcol, length ));
+    }
+    if ( row != NULL ) {
+        CHECK( magma_index_malloc_cpu( &tmprow, length ));
+    }
+    magma_zorderstat_count( length, key, kth, kth, nblocks, cnt );
+    magma_zorderstat_offsets( nblocks, cnt );
+
+    #pragma omp parallel for schedule(static, 1)
+    for( magma_int_t b=0; b < nblocks; b++ ) {
+        magma_int_t start = magma_int_t( int64_t(length) * b / nblocks );
+        magma_int_t end   = magma_int_t( int64_t(length) * (b+1) / nblocks );
+        magma_int_t *c = cnt + 3*b;
+        for( magma_int_t j=start; j < end; j++ ) {
+            magma_int_t d = c[ (key[j] >= kth) + (key[j] > kth) ]++;
+            tmpval[d] = val[j];
+            if ( col != NULL ) {
+                tmpcol[d] = col[j];
+            }
+            if ( row != NULL ) {
+                tmprow[d] = row[j];
+            }
+        }
+    }
+
+    #pragma omp parallel for if( nblocks > 1 )
+    for( magma_int_t j=0; j < length; j++ ) {
+        val[j] = tmpval[j];
+        if ( col != NULL ) {
+            col[j] = tmpcol[j];
+        }
+        if ( row != NULL ) {
+            row[j] = tmprow[j];
+        }
+    }
+    *element = val[k];
+
+cleanup:
+    magma_free_cpu( key );
+    magma_free_cpu( cnt );
+    magma_free_cpu( tmpval );
+    magma_free_cpu( tmpcol );
+    magma_free_cpu( tmprow );
+    return info;
+}
+
+
+
 /**
     Purpose
     -------
@@ -335,6 +590,11 @@ cleanup:
     such that these elements come to the front. The related arrays col and row
     are also reordered.
 
+    The magnitudes are computed once; the kth element is located by
+    sample-based splitter selection followed by introselect, and the arrays
+    are reordered by one multithreaded three-way partition. The worst case
+    complexity is O(length log length).
+
     Arguments
     ---------
 
@@ -385,64 +645,7 @@ magma_zmorderstatistics(
     magmaDoubleComplex *element,
     magma_queue_t queue )
 {
-    magma_int_t info = 0;
-    magma_int_t i, st;
-    magmaDoubleComplex tmpv;
-    magma_index_t tmpc, tmpr;
-    if( r == 0 ){
-        for ( st = i = 0; i < length - 1; i++ ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%% error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) > MAGMA_Z_ABS(val[length-1]) ){
-                continue;
-            }
-            SWAPM(i, st);
-            st++;
-        }
-
-        SWAPM(length-1, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zmorderstatistics( val, col, row, st, k, r, element, queue ));
-        }
-        else {
-             CHECK( magma_zmorderstatistics( val+st, col+st, row+st, length-st, k-st, r, element, queue ));
-        }
-    } else {
-        for ( st = i = 0; i < length - 1; i++ ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%% error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) < MAGMA_Z_ABS(val[length-1]) ){
-                continue;
-            }
-            SWAPM(i, st);
-            st++;
-        }
-
-        SWAPM(length-1, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zmorderstatistics( val, col, row, st, k, r, element, queue ));
-        }
-        else {
-            CHECK( magma_zmorderstatistics( val+st, col+st, row+st, length-st, k-st, r, element, queue ));
-        }
-    }
-
-cleanup:
-    return info;
+    return magma_zorderstat_select( val, col, row, length, k, r, element, queue );
 }
 
 
@@ -451,7 +654,9 @@ cleanup:
     Purpose
     -------
 
-    Identifies the kth smallest/largest element in an array.
+    Identifies the kth smallest/largest element in an array and reorders
+    such that these elements come to the front.
+    See magma_zmorderstatistics.
 
     Arguments
     ---------
@@ -493,64 +698,7 @@ magma_zorderstatistics(
     magmaDoubleComplex *element,
     magma_queue_t queue )
 {
-    magma_int_t info = 0;
-
-    magma_int_t i, st;
-    magmaDoubleComplex tmp;
-    if( r == 0 ){
-        for ( st = i = 0; i < length - 1; i++ ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%%error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) > MAGMA_Z_ABS(val[length-1]) ){
-                continue;
-            }
-            SWAP(i, st);
-            st++;
-        }
-
-        SWAP(length-1, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zorderstatistics( val, st, k, r, element, queue ));
-        }
-        else {
-             CHECK( magma_zorderstatistics( val+st, length-st, k-st, r, element, queue ));
-        }
-    } else {
-        for ( st = i = 0; i < length - 1; i++ ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%%error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) < MAGMA_Z_ABS(val[length-1]) ){
-                continue;
-            }
-            SWAP(i, st);
-            st++;
-        }
-
-        SWAP(length-1, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zorderstatistics( val, st, k, r, element, queue ));
-        }
-        else {
-             CHECK( magma_zorderstatistics( val+st, length-st, k-st, r, element, queue ));
-        }
-    }
-
-cleanup:
-    return info;
+    return magma_zorderstat_select( val, NULL, NULL, length, k, r, element, queue );
 }
 
 
@@ -560,7 +708,10 @@ cleanup:
     -------
 
     Approximates the k-th smallest element in an array by
-    using order-statistics with step-size inc.
+    using order-statistics with step-size inc: only the elements
+    val[0], val[inc], val[2*inc], ... are considered, and k refers to the
+    rank among those. They are reordered among their positions such that
+    the k smallest/largest come first.
 
     Arguments
     ---------
@@ -608,68 +759,30 @@ magma_zorderstatistics_inc(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magmaDoubleComplex *sub = NULL;
+    magma_int_t n;
 
-    magma_int_t i, st;
-    magmaDoubleComplex tmp;
-    if( r == 0 ){
-        for ( st = i = 0; i < length - inc; i=i+inc ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%%error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) > MAGMA_Z_ABS(val[length-inc]) ){
-                continue;
-            }
-            SWAP(i, st);
-            st=st+inc;
-        }
-
-        SWAP(length-inc, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zorderstatistics( val, st, k, r, element, queue ));
-        }
-        else {
-             CHECK( magma_zorderstatistics( val+st, length-st, k-st, r, element, queue ));
-        }
-    } else {
-        for ( st = i = 0; i < length - inc; i=i+inc ) {
-            if ( magma_z_isnan_inf( val[i]) ) {
-                printf("%%error: array contains %f + %fi.\n", MAGMA_Z_REAL(val[i]), MAGMA_Z_IMAG(val[i]) );
-                info = MAGMA_ERR_NAN;
-                goto cleanup;
-            }
-            if ( MAGMA_Z_ABS(val[i]) < MAGMA_Z_ABS(val[length-1]) ){
-                continue;
-            }
-            SWAP(i, st);
-            st=st+inc;
-        }
-
-        SWAP(length-inc, st);
-
-        if ( k == st ){
-            *element = val[st];
-        }
-        else if ( st > k ) {
-            CHECK( magma_zorderstatistics( val, st, k, r, element, queue ));
-        }
-        else {
-             CHECK( magma_zorderstatistics( val+st, length-st, k-st, r, element, queue ));
-        }
+    if ( inc < 1 || length < 1 ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    n = (length + inc - 1) / inc;
+    CHECK( magma_zmalloc_cpu( &sub, n ));
+    for( magma_int_t i=0; i < n; i++ ) {
+        sub[i] = val[ i*inc ];
+    }
+    CHECK( magma_zorderstat_select( sub, NULL, NULL, n, k, r, element, queue ));
+    for( magma_int_t i=0; i < n; i++ ) {
+        val[ i*inc ] = sub[i];
     }
 
 cleanup:
+    magma_free_cpu( sub );
     return info;
 }
 
 
 
-
 void swap(magmaDoubleComplex *a, magmaDoubleComplex *b)
 {
     magmaDoubleComplex t;
@@ -11,10 +11,12 @@
 
        Utilities for testing MAGMA-sparse.
 */
-#include <cuda_runtime_api.h>
-
 #include "magmasparse_internal.h"
 
+#ifndef MAGMA_HAVE_CPU
+#include <cuda_runtime_api.h>
+#endif
+
 #define PRECISION_z
 
 // --------------------
@@ -39,6 +41,7 @@ static const char *usage_sparse =
 "               CSR, ELL, SELLP, CUSPARSECSR, CSR5.\n"
 " --blocksize x Set a specific blocksize for SELL-P format.\n"
 " --alignment x Set a specific alignment for SELL-P format.\n"
+" --sigma x     Sort rows by length within windows of x rows (SELL-C-sigma).\n"
 " --mscale      Possibility to scale the original matrix:\n"
 "               NOSCALE   no scaling\n"
 "               UNITDIAG   symmetric scaling to unit diagonal\n"
@@ -60,7 +63,10 @@ static const char *usage_sparse =
 " --patol x     Set an absolute residual stopping criterion for the preconditioner.\n"
 "                      Corresponds to the relative fill-in in PARILUT.\n"
 " --prtol x     Set a relative residual stopping criterion for the preconditioner.\n"
-"                      Corresponds to the replacement ratio in PARILUT.\n";
+"                      Corresponds to the replacement ratio in PARILUT.\n"
+" --nrep x      Time x runs of the solver and print min, median, p95, p99, stddev,\n"
+"               and drift of the times.\n"
+" --flush x     Flush x MiB of cache before each timed run.\n";
 
 
 /**
@@ -110,10 +116,13 @@ magma_zparse_opts(
     opts->input_format = Magma_CSR;
     opts->blocksize = 32;
     opts->alignment = 1;
+    opts->sigma = 1;
     opts->output_format = Magma_CSR;
     opts->input_location = Magma_CPU;
     opts->output_location = Magma_CPU;
     opts->scaling = Magma_NOSCALE;
+    opts->nrep = 1;
+    opts->flush = 0;
     #if defined(PRECISION_z) | defined(PRECISION_d)
         opts->solver_par.atol = 1e-16;
         opts->solver_par.rtol = 1e-10;
@@ -145,8 +154,10 @@ magma_zparse_opts(
     
     printf( usage_sparse_short, argv[0] );
     
+    #ifndef MAGMA_HAVE_CPU
     int ndevices;
     cudaGetDeviceCount( &ndevices );
+    #endif
     
     int basic = 0;
 
@@ -427,6 +438,8 @@ magma_zparse_opts(
             opts->blocksize = atoi( argv[++i] );
         } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
             opts->alignment = atoi( argv[++i] );
+        } else if ( strcmp("--sigma", argv[i]) == 0 && i+1 < argc ) {
+            opts->sigma = atoi( argv[++i] );
         } else if ( strcmp("--verbose", argv[i]) == 0 && i+1 < argc ) {
             opts->solver_par.verbose = atoi( argv[++i] );
         }  else if ( strcmp("--maxiter", argv[i]) == 0 && i+1 < argc ) {
@@ -439,6 +452,10 @@ magma_zparse_opts(
             opts->solver_par.num_eigenvalues = atoi( argv[++i] );
         } else if ( strcmp("--version", argv[i]) == 0 && i+1 < argc ) {
             opts->solver_par.version = atoi( argv[++i] );
+        } else if ( strcmp("--nrep", argv[i]) == 0 && i+1 < argc ) {
+            opts->nrep = max( 1, atoi( argv[++i] ));
+        } else if ( strcmp("--flush", argv[i]) == 0 && i+1 < argc ) {
+            opts->flush = max( 0, atoi( argv[++i] ));
         }
         // ----- usage
         else if ( strcmp("-h",     argv[i]) == 0 ||
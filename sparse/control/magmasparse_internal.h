@@ -19,7 +19,9 @@ extern "C" {
 #endif
 
 
+#ifndef MAGMA_HAVE_CPU
 magma_int_t cusparse2magma_error( cusparseStatus_t status );
+#endif
 
 
 /**
@@ -56,6 +58,28 @@ magma_int_t cusparse2magma_error( cusparseStatus_t status );
     } while(0)
 
 
+/**
+    Macro rejects a matrix A in Magma_CSR64 format in routines that read the
+    32-bit nnz and row members: prints an error, sets info to
+    MAGMA_ERR_NOT_SUPPORTED, then does goto cleanup.
+    A Magma_CSR64 matrix whose nonzeros fit can be narrowed with
+    magma_zmconvert to Magma_CSR first.
+    Assumes variable info and label cleanup exist.
+    
+    @see CHECK
+    @ingroup magma_error_internal
+    ********************************************************************/
+#define CHECK_NOT_CSR64( A )                                            \
+    do {                                                                \
+        if ( (A).storage_type == Magma_CSR64 ) {                        \
+            printf("error: %s does not support Magma_CSR64 matrices;"   \
+                   " convert to Magma_CSR first.\n", __func__ );        \
+            info = MAGMA_ERR_NOT_SUPPORTED;                             \
+            goto cleanup;                                               \
+        }                                                               \
+    } while(0)
+
+
 /**
     Macro checks the return code of a cusparse function;
     if non-zero, maps the cusparse error to a magma error and sets info,
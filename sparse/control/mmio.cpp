@@ -7,6 +7,7 @@
 */
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
+#include <limits.h>
 
 int mm_read_unsymmetric_sparse(
     const char *fname, 
@@ -241,6 +242,50 @@ int mm_read_mtx_crd_size(FILE *f, magma_index_t *M, magma_index_t *N,
 }
 
 
+/* same as mm_read_mtx_crd_size, but nz may exceed the range of magma_index_t */
+int mm_read_mtx_crd_size64(FILE *f, magma_index_t *M, magma_index_t *N, 
+                                                    magma_offset_t *nz )
+{
+    magma_int_t info = 0;
+    
+    char line[MM_MAX_LINE_LENGTH];
+    int num_items_read;
+    long long m, n, z;
+
+    /* set info = null parameter values, in case we exit with errors */
+    *M = *N = 0;
+    *nz = 0;
+
+    /* now continue scanning until you reach the end-of-comments */
+    do 
+    {
+        if (fgets(line,MM_MAX_LINE_LENGTH,f) == NULL) 
+            return MM_PREMATURE_EOF;
+    }while (line[0] == '%');
+
+    /* line[] is either blank or has M,N, nz */
+    if (sscanf(line, "%lld %lld %lld", &m, &n, &z) == 3)
+        info = 0;
+        
+    else
+    do
+    { 
+        num_items_read = fscanf(f, "%lld %lld %lld", &m, &n, &z); 
+        if (num_items_read == EOF) return MM_PREMATURE_EOF;
+    }
+    while (num_items_read != 3);
+
+    /* the dimensions are still stored as magma_index_t */
+    if (m < 0 || n < 0 || z < 0 || m > INT_MAX || n > INT_MAX)
+        return MM_COULD_NOT_READ_FILE;
+
+    *M = (magma_index_t) m;
+    *N = (magma_index_t) n;
+    *nz = (magma_offset_t) z;
+    return info;
+}
+
+
 int mm_read_mtx_array_size(FILE *f, magma_index_t *M, magma_index_t *N)
 {
     magma_int_t info = 0;
@@ -24,6 +24,8 @@ void mm_snprintf_typecode( char *buffer, size_t buflen, MM_typecode matcode );
 int mm_read_banner(FILE *f, MM_typecode *matcode);
 int mm_read_mtx_crd_size(FILE *f, magma_index_t *M, magma_index_t *N,
                                                     magma_index_t *nz);
+int mm_read_mtx_crd_size64(FILE *f, magma_index_t *M, magma_index_t *N,
+                                                    magma_offset_t *nz);
 int mm_read_mtx_array_size(FILE *f, magma_index_t *M, magma_index_t *N);
 
 int mm_write_banner(FILE *f, MM_typecode matcode);
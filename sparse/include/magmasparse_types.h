@@ -45,6 +45,18 @@ extern "C"
 
 #define MAGMA_CSR5_OMEGA 32
 
+// start of row i for CPU matrices in either Magma_CSR or Magma_CSR64 format
+#define MAGMA_CSR_ROWPTR( A, i ) \
+    ( (A).storage_type == Magma_CSR64 ? (magma_offset_t) (A).row64[(i)] \
+                                      : (magma_offset_t) (A).row[(i)] )
+
+// number of nonzeros of CPU matrices in either format. A Magma_CSR64 matrix
+// keeps its count in nnz64; its nnz member holds the count only if it fits
+// into magma_int_t, and -1 otherwise. Routines that read only nnz reject
+// Magma_CSR64 matrices.
+#define MAGMA_CSR_NNZ( A ) \
+    ( (A).storage_type == Magma_CSR64 ? (A).nnz64 : (magma_offset_t) (A).nnz )
+
     typedef struct magma_z_matrix
     {
         magma_storage_t storage_type;     // matrix format - CSR, ELL, SELL-P, CSR5
@@ -73,6 +85,7 @@ extern "C"
         {
             magma_index_t *row;  // opt: row pointer CPU case
             magmaIndex_ptr drow; // opt: row pointer DEV case
+            magma_offset_t *row64; // opt: 64-bit row pointer, Magma_CSR64 CPU case
         };
         union
         {
@@ -127,6 +140,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sellp_sigma;             // opt: sorting window for SELL-C-sigma
+        magma_offset_t nnz64;                // number of nonzeros of Magma_CSR64
     } magma_z_matrix;
 
     typedef struct magma_c_matrix
@@ -157,6 +172,7 @@ extern "C"
         {
             magma_index_t *row;  // row pointer CPU case
             magmaIndex_ptr drow; // row pointer DEV case
+            magma_offset_t *row64; // opt: 64-bit row pointer, Magma_CSR64 CPU case
         };
         union
         {
@@ -211,6 +227,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sellp_sigma;             // opt: sorting window for SELL-C-sigma
+        magma_offset_t nnz64;                // number of nonzeros of Magma_CSR64
     } magma_c_matrix;
 
     typedef struct magma_d_matrix
@@ -241,6 +259,7 @@ extern "C"
         {
             magma_index_t *row;  // row pointer CPU case
             magmaIndex_ptr drow; // row pointer DEV case
+            magma_offset_t *row64; // opt: 64-bit row pointer, Magma_CSR64 CPU case
         };
         union
         {
@@ -295,6 +314,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sellp_sigma;             // opt: sorting window for SELL-C-sigma
+        magma_offset_t nnz64;                // number of nonzeros of Magma_CSR64
     } magma_d_matrix;
 
     typedef struct magma_s_matrix
@@ -325,6 +346,7 @@ extern "C"
         {
             magma_index_t *row;  // opt: row pointer CPU case
             magmaIndex_ptr drow; // opt: row pointer DEV case
+            magma_offset_t *row64; // opt: 64-bit row pointer, Magma_CSR64 CPU case
         };
         union
         {
@@ -379,6 +401,8 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sellp_sigma;             // opt: sorting window for SELL-C-sigma
+        magma_offset_t nnz64;                // number of nonzeros of Magma_CSR64
     } magma_s_matrix;
 
     // for backwards compatability, make these aliases.
@@ -546,7 +570,10 @@ extern "C"
 
     //************            preconditioner parameters       ********************//
 
-#if CUDA_VERSION >= 12000
+#if defined(MAGMA_HAVE_CPU)
+    // no cusparse; the CPU backend sets up no triangular solves
+    #define csrsm2Info_t void*
+#elif CUDA_VERSION >= 12000
     #define csrsm2Info_t int
 #endif
 
@@ -828,6 +855,9 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t sigma;      // sorting window for SELL-C-sigma
+        magma_int_t nrep;       // timed repetitions of the solve
+        magma_int_t flush;      // MiB of cache to flush before each solve, or 0
     } magma_zopts;
 
     typedef struct magma_copts
@@ -844,6 +874,9 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t sigma;      // sorting window for SELL-C-sigma
+        magma_int_t nrep;       // timed repetitions of the solve
+        magma_int_t flush;      // MiB of cache to flush before each solve, or 0
     } magma_copts;
 
     typedef struct magma_dopts
@@ -860,6 +893,9 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t sigma;      // sorting window for SELL-C-sigma
+        magma_int_t nrep;       // timed repetitions of the solve
+        magma_int_t flush;      // MiB of cache to flush before each solve, or 0
     } magma_dopts;
 
     typedef struct magma_sopts
@@ -876,6 +912,9 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t sigma;      // sorting window for SELL-C-sigma
+        magma_int_t nrep;       // timed repetitions of the solve
+        magma_int_t flush;      // MiB of cache to flush before each solve, or 0
     } magma_sopts;
 
 #ifdef __cplusplus
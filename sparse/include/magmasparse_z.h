@@ -97,6 +97,17 @@ magma_z_csr_mtx(
     const char *filename,
     magma_queue_t queue );
 
+magma_int_t
+magma_z_csr_binary(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmunmap(
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zcsrset(
     magma_int_t m,
@@ -473,6 +484,12 @@ magma_zwrite_csr_mtx(
  const char *filename,
     magma_queue_t queue );
 
+magma_int_t
+magma_zwrite_csr_binary(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zwrite_vector(
     magma_z_matrix A,
@@ -553,6 +570,11 @@ magma_zmconvert(
     magma_storage_t new_format,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmcsr5_cpu(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_queue_t queue );
 
 magma_int_t
 magma_zvinit(
@@ -1953,6 +1975,58 @@ magma_zcsr_sort(
     magma_z_matrix *A,
     magma_queue_t queue);
 
+magma_int_t
+magma_zcoo2csr_cpu(
+    magma_int_t num_rows,
+    magma_int_t nnz,
+    const magma_index_t *rowidx,
+    const magma_index_t *colidx,
+    const magmaDoubleComplex *val,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *csrval,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcsr2csc_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *val,
+    magma_index_t *colptr,
+    magma_index_t *rowind,
+    magmaDoubleComplex *cscval,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcsr_sortrows_cpu(
+    magma_int_t num_rows,
+    const magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zcsr_sort_gpu(
     magma_z_matrix *A,
@@ -2985,6 +3059,16 @@ magma_zgesellpmv(
     magmaDoubleComplex_ptr dy,
     magma_queue_t queue );
 
+magma_int_t
+magma_zgesellpmv_scatter(
+    magma_int_t m,
+    magma_int_t num_vecs,
+    magmaDoubleComplex beta,
+    magmaIndex_ptr drowidx,
+    magmaDoubleComplex_ptr dt,
+    magmaDoubleComplex_ptr dy,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zmgesellpmv(
     magma_trans_t transA,
@@ -3019,6 +3103,84 @@ magma_zmgesellpmv_blocked(
     magmaDoubleComplex_ptr dy,
     magma_queue_t queue );
 
+magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *colind,
+    magma_index_t *rowptr,
+    magma_index_t *rowidx,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *val,
+    magma_index_t *colind,
+    magma_index_t *rowptr,
+    magma_index_t *rowidx,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t p,
+    magmaDoubleComplex alpha,
+    magma_int_t sigma,
+    magma_uindex_t *tile_ptr,
+    magmaDoubleComplex *val,
+    magma_index_t *rowptr,
+    magma_index_t *colind,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
 /// @deprecated
 /// @ingroup magma_deprecated_sparse
 MAGMA_DEPRECATE("magma_zgecsr5mv is deprecated and will be removed in the next release")
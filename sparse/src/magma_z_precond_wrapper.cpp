@@ -73,20 +73,23 @@ magma_z_precond(
                 CHECK( magma_zbicgstab( A, b, x, &psolver_par, queue )); break;
         case  Magma_GMRES:
                 CHECK( magma_zfgmres( A, b, x, &psolver_par, &pprecond, queue )); break;
+        case  Magma_CGS:
+                CHECK( magma_zcgs( A, b, x, &psolver_par, queue )); break;
+        case  Magma_TFQMR:
+                CHECK( magma_ztfqmr( A, b, x, &psolver_par, queue )); break;
+        // these need GPU kernels
+        #ifndef MAGMA_HAVE_CPU
         case  Magma_JACOBI:
                 CHECK( magma_zjacobi( A, b, x, &psolver_par, queue )); break;
         case  Magma_BAITER:
                 CHECK( magma_zbaiter( A, b, x, &psolver_par, &pprecond, queue )); break;
         case  Magma_IDR:
                 CHECK( magma_zidr( A, b, x, &psolver_par, queue )); break;
-        case  Magma_CGS:
-                CHECK( magma_zcgs( A, b, x, &psolver_par, queue )); break;
         case  Magma_QMR:
                 CHECK( magma_zqmr( A, b, x, &psolver_par, queue )); break;
-        case  Magma_TFQMR:
-                CHECK( magma_ztfqmr( A, b, x, &psolver_par, queue )); break;
         case  Magma_BAITERO:
                 CHECK( magma_zbaiter_overlap( A, b, x, &psolver_par, &pprecond, queue )); break;
+        #endif
         default:
                 CHECK( magma_zcg_res( A, b, x, &psolver_par, queue )); break;
     }
@@ -145,6 +148,8 @@ magma_z_precondsetup(
     //Chronometry
     real_Double_t tempo1, tempo2;
     
+    CHECK_NOT_CSR64( A );
+
     tempo1 = magma_sync_wtime( queue );
     
     if( A.num_rows != A.num_cols ){
@@ -153,6 +158,8 @@ magma_z_precondsetup(
         precond->solver = Magma_NONE;
     } 
     
+    // the CPU backend has no preconditioner kernels
+    #ifndef MAGMA_HAVE_CPU
     if ( precond->solver == Magma_JACOBI ) {
         info = magma_zjacobisetup_diagscal( A, &(precond->d), queue );
     }
@@ -252,13 +259,16 @@ magma_z_precondsetup(
         precond->solver = Magma_PARIC; // handle as PARIC
     }
     // none case
-    else if ( precond->solver == Magma_NONE ) {
+    else
+    #endif
+    if ( precond->solver == Magma_NONE ) {
         info = MAGMA_SUCCESS;
     }
     else {
         printf( "error: preconditioner type not yet supported.\n" );
         info = MAGMA_ERR_NOT_SUPPORTED;
     }
+    #ifndef MAGMA_HAVE_CPU
     if( 
         ( solver->solver == Magma_PQMR  || 
           solver->solver == Magma_PQMRMERGE  || 
@@ -280,10 +290,12 @@ magma_z_precondsetup(
                 // info = magma_ziluisaisetup_t( A, b, precond, queue );
         }
     }
+    #endif
     
     tempo2 = magma_sync_wtime( queue );
     precond->setuptime = tempo2-tempo1;
     
+cleanup:
     return info;
 }
 
@@ -336,10 +348,13 @@ magma_z_applyprecond(
     
     magma_z_matrix tmp={Magma_CSR};
 
+    #ifndef MAGMA_HAVE_CPU
     if ( precond->solver == Magma_JACOBI ) {
         CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
     }
-    else if ( precond->solver == Magma_PASTIX ) {
+    else
+    #endif
+    if ( precond->solver == Magma_PASTIX ) {
         //CHECK( magma_zapplypastix( b, x, precond, queue ));
         info = MAGMA_ERR_NOT_SUPPORTED;
     }
@@ -428,6 +443,7 @@ magma_z_applyprecond_left(
     zopts.solver_par.rtol = 1e-10;
     
     if( trans == MagmaNoTrans ) {
+        #ifndef MAGMA_HAVE_CPU
         if ( precond->solver == Magma_JACOBI ) {
             CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
         }
@@ -473,7 +489,9 @@ magma_z_applyprecond_left(
                     precond->solver == Magma_PARILU ) ){
             magma_z_solver( precond->L, b, x, &zopts, queue );
         }
-        else if ( precond->solver == Magma_NONE ) {
+        else
+        #endif
+        if ( precond->solver == Magma_NONE ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
@@ -484,6 +502,7 @@ magma_z_applyprecond_left(
             info = MAGMA_ERR_NOT_SUPPORTED; 
         }
     } else if ( trans == MagmaTrans ){
+        #ifndef MAGMA_HAVE_CPU
         if ( precond->solver == Magma_JACOBI ) {
             CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
         }
@@ -510,7 +529,9 @@ magma_z_applyprecond_left(
                     precond->solver == Magma_PARILU ) ){
             magma_z_solver( precond->L, b, x, &zopts, queue );
         }
-        else if ( precond->solver == Magma_NONE ) {
+        else
+        #endif
+        if ( precond->solver == Magma_NONE ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
@@ -598,6 +619,7 @@ magma_z_applyprecond_right(
     zopts.solver_par.rtol = 1e-10;
     
     if( trans == MagmaNoTrans ) {
+        #ifndef MAGMA_HAVE_CPU
         if ( precond->solver == Magma_JACOBI ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
         }
@@ -643,7 +665,9 @@ magma_z_applyprecond_right(
                     precond->solver == Magma_PARILU ) ){
             magma_z_solver( precond->U, b, x, &zopts, queue );
         }
-        else if ( precond->solver == Magma_NONE ) {
+        else
+        #endif
+        if ( precond->solver == Magma_NONE ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
         }
       //  else if ( precond->solver == Magma_ISAI ) {
@@ -658,6 +682,7 @@ magma_z_applyprecond_right(
             info = MAGMA_ERR_NOT_SUPPORTED;
         }
     } else if ( trans == MagmaTrans ){
+        #ifndef MAGMA_HAVE_CPU
         if ( precond->solver == Magma_JACOBI ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
         }
@@ -685,7 +710,9 @@ magma_z_applyprecond_right(
                     precond->solver == Magma_PARILU ) ){
             magma_z_solver( precond->U, b, x, &zopts, queue );
         }
-        else if ( precond->solver == Magma_NONE ) {
+        else
+        #endif
+        if ( precond->solver == Magma_NONE ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
@@ -12,6 +12,91 @@
 #include "magmasparse_internal.h"
 
 
+#ifdef MAGMA_HAVE_CPU
+/**
+    Purpose
+    -------
+
+    Solver dispatch of the CPU backend, which has the solvers built from SpMV
+    and BLAS only. The merged solvers fuse GPU kernels; here they run as the
+    same method without merged kernels.
+
+    Arguments
+    ---------
+
+    See magma_z_solver.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+static magma_int_t
+magma_z_solver_host(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_zopts *zopts,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if( b.num_cols == 1 ){
+        switch( zopts->solver_par.solver ) {
+            case  Magma_BICG:
+                    CHECK( magma_zbicg( A, b, x, &zopts->solver_par, queue )); break;
+            case  Magma_PBICG:
+                    CHECK( magma_zpbicg( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_BICGSTAB:
+            case  Magma_BICGSTABMERGE:
+                    CHECK( magma_zbicgstab( A, b, x, &zopts->solver_par, queue )); break;
+            case  Magma_PBICGSTAB:
+            case  Magma_PBICGSTABMERGE:
+                    CHECK( magma_zpbicgstab( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_CG:
+            case  Magma_CGMERGE:
+                    CHECK( magma_zcg_res( A, b, x, &zopts->solver_par, queue )); break;
+            case  Magma_PCG:
+            case  Magma_PCGMERGE:
+                    CHECK( magma_zpcg( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_CGS:
+            case  Magma_CGSMERGE:
+                    CHECK( magma_zcgs( A, b, x, &zopts->solver_par, queue ) ); break;
+            case  Magma_PCGS:
+            case  Magma_PCGSMERGE:
+                    CHECK( magma_zpcgs( A, b, x, &zopts->solver_par, &zopts->precond_par, queue ) ); break;
+            case  Magma_TFQMR:
+            case  Magma_TFQMRMERGE:
+                    CHECK( magma_ztfqmr( A, b, x, &zopts->solver_par, queue ) ); break;
+            case  Magma_PTFQMR:
+            case  Magma_PTFQMRMERGE:
+                    CHECK( magma_zptfqmr( A, b, x, &zopts->solver_par, &zopts->precond_par, queue ) ); break;
+            case  Magma_GMRES:
+            case  Magma_PGMRES:
+                    CHECK( magma_zfgmres( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_LSQR:
+                    CHECK( magma_zlsqr( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_ITERREF:
+                    CHECK( magma_ziterref( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            default:
+                    printf("error: solver class not supported.\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED; break;
+        }
+    }
+    else {
+        switch( zopts->solver_par.solver ) {
+            case  Magma_CG:
+                    CHECK( magma_zbpcg( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_PCG:
+                    CHECK( magma_zbpcg( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            default:
+                    printf("error: only 1 RHS supported for this solver class.\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED; break;
+        }
+    }
+
+cleanup:
+    return info;
+}
+#endif
+
+
 /**
     Purpose
     -------
@@ -68,6 +153,11 @@ magma_z_solver(
         printf( "error: sparse RHS not yet supported.\n" );
         return MAGMA_ERR_NOT_SUPPORTED;
     }
+    CHECK_NOT_CSR64( A );
+
+    #ifdef MAGMA_HAVE_CPU
+    CHECK( magma_z_solver_host( A, b, x, zopts, queue ));
+    #else
     if( b.num_cols == 1 ){
         switch( zopts->solver_par.solver ) {
             case  Magma_BICG:
@@ -160,6 +250,7 @@ magma_z_solver(
                     printf("error: only 1 RHS supported for this solver class.\n"); break;
         }
     }
+    #endif
 cleanup:
     return info; 
 }
@@ -508,6 +508,7 @@ magma_zjacobisetup(
     C.memory_location = B.memory_location;
     if ( A.storage_type != Magma_CSR) {
         A_h2.alignment = A.alignment;
+        A_h2.sellp_sigma = A.sellp_sigma;
         A_h2.blocksize = A.blocksize;
         CHECK( magma_zmconvert( C, &A_h2, Magma_CSR, A_h1.storage_type, queue ));
         CHECK( magma_zmtransfer( A_h2, M, Magma_CPU, A.memory_location, queue ));
@@ -27,7 +27,12 @@
     E. Chow and A. Patel: "Fine-grained Parallel Incomplete LU Factorization", 
     SIAM Journal on Scientific Computing, 37, C169-C193 (2015). 
     
-    This is the CPU implementation of the ParILU
+    This is the CPU implementation of the ParILU.
+    For a Magma_CSR64 matrix A, the sweeps run on factors with 64-bit row
+    offsets. The triangular solves are 32 bit, so L and U are narrowed to
+    Magma_CSR afterwards; this fails with MAGMA_ERR_NOT_SUPPORTED if one of
+    them has more nonzeros than magma_index_t can address. Fill-in
+    (levels > 0) is not supported for Magma_CSR64.
 
     Arguments
     ---------
@@ -68,7 +73,15 @@ magma_zparilu_cpu(
     hAU={Magma_CSR}, hAUT={Magma_CSR}, hAtmp={Magma_CSR}, hACOO={Magma_CSR};
 
     // copy original matrix as COO to device
-    if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
+    if (A.storage_type == Magma_CSR64) {
+        // the symbolic ILU(k) is 32 bit
+        if (precond->levels > 0) {
+            printf("error: ILU(k) fill-in not supported for CSR64.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        CHECK(magma_zmtransfer(A, &hA, Magma_CPU, Magma_CPU, queue));
+    } else if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
         CHECK(magma_zmtransfer(A, &hAT, A.memory_location, Magma_CPU, queue));
         CHECK(magma_zmconvert(hAT, &hA, hAT.storage_type, Magma_CSR, queue));
         magma_zmfree(&hAT, queue);
@@ -82,14 +95,20 @@ magma_zparilu_cpu(
         magma_zmfree(&hAL, queue);
         magma_zmfree(&hAUT, queue);
     }
-    CHECK(magma_zmconvert(hA, &hACOO, hA.storage_type, Magma_CSRCOO, queue));
+    if (hA.storage_type == Magma_CSR64) {
+        // CSRCOO has 32-bit row pointers; use CSR64 with row indices
+        CHECK(magma_zmtransfer(hA, &hACOO, Magma_CPU, Magma_CPU, queue));
+        CHECK(magma_zmatrix_addrowindex(&hACOO, queue));
+    } else {
+        CHECK(magma_zmconvert(hA, &hACOO, hA.storage_type, Magma_CSRCOO, queue));
+    }
     
     //get L
     magma_zmatrix_tril(hA, &hAL, queue);
     // we need 1 on the main diagonal of L
     #pragma omp parallel for
     for (int k=0; k < hAL.num_rows; k++) {
-        hAL.val[hAL.row[k+1]-1] = MAGMA_Z_ONE;
+        hAL.val[MAGMA_CSR_ROWPTR(hAL, k+1)-1] = MAGMA_Z_ONE;
     }
     
     // get U
@@ -100,14 +119,29 @@ magma_zparilu_cpu(
     // This is the actual ParILU kernel. 
     // It can be called directly if
     // - the system matrix hACOO is available in COO format on the CPU 
-    // - hAL is the lower triangular in CSR on the CPU
+    //   (CSRCOO, or CSR64 with row indices)
+    // - hAL is the lower triangular in CSR (or CSR64) on the CPU
     // - hAU is the upper triangular in CSC on the CPU (U transpose in CSR)
     // The kernel is located in sparse/control/magma_zparilu_kernels.cpp
     //
     for (int i=0; i<precond->sweeps; i++) {
         CHECK(magma_zparilu_sweep(hACOO, &hAL, &hAU, queue));
     }
-    CHECK(magma_z_cucsrtranspose(hAU, &hAUT, queue));
+    
+    // the triangular solves are 32 bit: narrow the factors of a CSR64
+    // matrix; magma_zmconvert fails if a factor does not fit
+    if (hAL.storage_type == Magma_CSR64) {
+        CHECK(magma_zmconvert(hAL, &hAtmp, Magma_CSR64, Magma_CSR, queue));
+        magma_zmfree(&hAL, queue);
+        hAL = hAtmp;
+        hAtmp.val = NULL;
+        hAtmp.col = NULL;
+        hAtmp.row = NULL;
+        CHECK(magma_zmconvert(hAU, &hAtmp, Magma_CSR64, Magma_CSR, queue));
+        CHECK(magma_z_cucsrtranspose(hAtmp, &hAUT, queue));
+    } else {
+        CHECK(magma_z_cucsrtranspose(hAU, &hAUT, queue));
+    }
 
     CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
     CHECK(magma_zmtransfer(hAUT, &precond->U, Magma_CPU, Magma_DEV, queue));
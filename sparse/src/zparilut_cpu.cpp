@@ -11,6 +11,9 @@
 */
 
 #include "magmasparse_internal.h"
+#include "affinity.h"
+#include "trace.h"
+#include <limits.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -37,6 +40,8 @@
     sparsity pattern.
 
     This function requires OpenMP, and is only available if OpenMP is activated.
+    A Magma_CSR64 matrix A is converted to Magma_CSR; if its nonzeros do not
+    fit, MAGMA_ERR_NOT_SUPPORTED is returned before any work is done.
     
     The parameter list is:
     
@@ -91,6 +96,8 @@ magma_zparilut_cpu(
     magma_int_t num_rmL, num_rmU;
     double thrsL = 0.0;
     double thrsU = 0.0;
+    magma_int_t selecttmp_size = 0;
+    magma_ptr selecttmp_ptr = NULL;
 
     magma_int_t num_threads = 1, timing = 1; // print timing
     magma_int_t L0nnz, U0nnz;
@@ -98,9 +105,27 @@ magma_zparilut_cpu(
     #pragma omp parallel
     {
         num_threads = omp_get_max_threads();
+        trace_thread_index( "OpenMP thread", omp_get_thread_num() );
     }
     
-    CHECK(magma_zmtransfer(A, &hA, A.memory_location, Magma_CPU, queue));
+    // with $MAGMA_AFFINITY set, keep the OpenMP threads on fixed cores
+    // for all sweeps; restored in cleanup
+    magma_affinity_omp_bind();
+
+    // the factors, candidate lists and selection tools are 32 bit: a
+    // Magma_CSR64 matrix is narrowed to CSR, so its nonzeros have to fit
+    if (A.storage_type == Magma_CSR64) {
+        if (MAGMA_CSR_NNZ(A) > (magma_offset_t) INT_MAX) {
+            printf("error: ParILUT does not support CSR64 matrices with more"
+                   " than %d nonzeros (A has %lld).\n",
+                   INT_MAX, (long long) MAGMA_CSR_NNZ(A));
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        CHECK(magma_zmconvert(A, &hA, Magma_CSR64, Magma_CSR, queue));
+    } else {
+        CHECK(magma_zmtransfer(A, &hA, A.memory_location, Magma_CPU, queue));
+    }
     
     // in case using fill-in
     if (precond->levels > 0) {
@@ -131,6 +156,9 @@ magma_zparilut_cpu(
     //##########################################################################
 
     for (magma_int_t iters =0; iters<precond->sweeps; iters++) {
+        char label[ MAX_LABEL_LEN ];
+        snprintf( label, sizeof(label), "ParILUT sweep %lld", (long long) iters );
+        trace_cpu_scope span( "parilut", label );
         t_rm=0.0; t_add=0.0; t_res=0.0; t_sweep1=0.0; t_sweep2=0.0; t_cand=0.0;
         t_transpose1=0.0; t_transpose2=0.0;  t_selectrm=0.0; t_sort = 0;
         t_sort=0.0; t_nrm=0.0; t_total = 0.0;
@@ -200,14 +228,14 @@ magma_zparilut_cpu(
         CHECK(magma_zparilut_preselect(0, &L_new, &oneL, queue));
         CHECK(magma_zparilut_preselect(0, &U_new, &oneU, queue));
         if (num_rmL>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmL, 
-                &oneL, 0, &thrsL, queue));
+            CHECK(magma_zsampleselect_cpu(oneL.nnz, num_rmL, oneL.val, 
+                &thrsL, &selecttmp_ptr, &selecttmp_size, queue));
         } else {
             thrsL = 0.0;
         }
         if (num_rmU>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmU, 
-                &oneU, 0, &thrsU, queue));
+            CHECK(magma_zsampleselect_cpu(oneU.nnz, num_rmU, oneU.val, 
+                &thrsU, &selecttmp_ptr, &selecttmp_size, queue));
         } else {
             thrsU = 0.0;
         }
@@ -270,6 +298,7 @@ magma_zparilut_cpu(
     }
 
 cleanup:
+    magma_affinity_omp_restore();
     magma_zmfree(&hA, queue);
     magma_zmfree(&hAT, queue);
     magma_zmfree(&L, queue);
@@ -281,6 +310,7 @@ cleanup:
     magma_zmfree(&U_new, queue);
     magma_zmfree(&hL, queue);
     magma_zmfree(&hU, queue);
+    magma_free_cpu(selecttmp_ptr);
 #endif
     return info;
 }
@@ -494,6 +494,14 @@ if opts.nonsym:
     sizes += ['test_matrices/ani5_crop.mtx']
 #end
 
+# matrices in test_matrices, for testers that run on all of them
+test_matrices = []
+test_matrices += ['test_matrices/Trefethen_20.mtx']
+test_matrices += ['test_matrices/Trefethen_2000.mtx']
+test_matrices += ['test_matrices/Trefethen_zerodiag.mtx']
+test_matrices += ['test_matrices/ani5_crop.mtx']
+test_matrices += ['test_matrices/pores_1.mtx']
+
 
 # ----------------------------------------------------------------------
 precisions = (
@@ -594,6 +602,27 @@ if ( opts.sparse_blas):
                     tests.append( [cmd, alignment + ' ' + blocksize, size, ''] )
 
 
+# ----------------------------------------------------------------------
+# host SpMV and SpMM, also on all test matrices
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes + test_matrices:
+            for blocksize in blocksizes:
+                # precision generation
+                cmd = substitute( 'testing_zspmv_cpu', 'z', precision )
+                tests.append( [cmd, blocksize, size, ''] )
+
+
+# ----------------------------------------------------------------------
+# CSR5 build cost against SpMV savings
+if ( opts.sparse_blas):
+    for precision in opts.precisions:
+        for size in sizes + test_matrices:
+            # precision generation
+            cmd = substitute( 'testing_zcsr5_build', 'z', precision )
+            tests.append( [cmd, '', size, ''] )
+
+
 # ----------------------------------------------------------------------
 if ( opts.sparse_blas):
     for precision in opts.precisions:
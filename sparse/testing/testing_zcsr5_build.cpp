@@ -0,0 +1,221 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#include "../../control/magma_threadsetting.h"  // internal header
+
+#define PRECISION_z
+
+#define NITER 200
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Runs y = A*x NITER times after a warmup; returns seconds per product.
+*/
+static real_Double_t
+zcsr5_build_spmv_time(
+    magma_z_matrix A, magma_z_matrix x, magma_z_matrix y, magma_queue_t queue )
+{
+    magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    TESTING_CHECK( magma_z_spmv( c_one, A, x, c_zero, y, queue ));
+    real_Double_t start = magma_sync_wtime( queue );
+    for( magma_int_t j=0; j < NITER; j++ ) {
+        TESTING_CHECK( magma_z_spmv( c_one, A, x, c_zero, y, queue ));
+    }
+    return (magma_sync_wtime( queue ) - start) / NITER;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Returns sum |y - yref| / sum |yref| for vectors in CPU memory.
+*/
+static double
+zcsr5_build_error(
+    magma_int_t m, const magmaDoubleComplex *y, const magmaDoubleComplex *yref )
+{
+    double res = 0.0, ref = 0.0;
+    for( magma_int_t k=0; k < m; k++ ) {
+        res += MAGMA_Z_ABS( y[k] - yref[k] );
+        ref += MAGMA_Z_ABS( yref[k] );
+    }
+    return ref == 0 ? res : res / ref;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Prints the CSR and CSR5 SpMV times and the number of products after
+   which the CSR5 build cost is recovered.
+*/
+static void
+zcsr5_build_report(
+    const char *where, real_Double_t build,
+    real_Double_t csr, real_Double_t csr5, real_Double_t gflop )
+{
+    printf( "%% %s SpMV: CSR %.2e s (%.2f GFLOP/s), CSR5 %.2e s (%.2f GFLOP/s), ",
+            where, csr, gflop / csr, csr5, gflop / csr5 );
+    if ( csr5 < csr ) {
+        printf( "CSR5 pays off after %.0f products\n", ceil( build / (csr - csr5) ));
+    } else {
+        printf( "CSR5 does not pay off\n" );
+    }
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- micro-benchmark for the CSR5 conversion: cost of the build on the
+      host against the SpMV time saved per product, on the host and the GPU
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hA_CSR5={Magma_CSR}, hA_CSR={Magma_CSR};
+    magma_z_matrix dA={Magma_CSR}, dA_CSR5={Magma_CSR};
+    magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR}, hyref={Magma_CSR};
+    magma_z_matrix dx={Magma_CSR}, dy={Magma_CSR};
+
+    magma_int_t nbuild = 3;
+    real_Double_t build, back, transfer, csr, csr5, start;
+    double res;
+
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    double accuracy = 1e-10;
+    #if defined(PRECISION_c) || defined(PRECISION_s)
+        accuracy = 1e-4;
+    #endif
+
+    int status = 0;
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--nbuild", argv[i]) == 0 && i+1 < argc ) {
+            nbuild = max( 1, atoi( argv[++i] ));
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zcsr5_build [ --nbuild %lld ] matrices\n\n",
+            (long long) nbuild );
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        magma_int_t m = hA.num_rows;
+        magma_int_t n = hA.num_cols;
+        real_Double_t gflop = 2.0*hA.nnz/1e9;
+
+        // build, best of nbuild
+        build = INFINITY;
+        for( magma_int_t k=0; k < nbuild; k++ ) {
+            start = magma_wtime();
+            TESTING_CHECK( magma_zmconvert( hA, &hA_CSR5, Magma_CSR, Magma_CSR5, queue ));
+            build = min( build, magma_wtime() - start );
+        }
+        start = magma_wtime();
+        TESTING_CHECK( magma_zmconvert( hA_CSR5, &hA_CSR, Magma_CSR5, Magma_CSR, queue ));
+        back = magma_wtime() - start;
+        printf( "%% CSR5 build: %.2e s with %lld threads (%lld tiles of sigma %lld,"
+                " %lld empty-row offsets), back to CSR %.2e s\n",
+                build, (long long) magma_get_parallel_numthreads(),
+                (long long) hA_CSR5.csr5_p, (long long) hA_CSR5.csr5_sigma,
+                (long long) hA_CSR5.csr5_num_offsets, back );
+
+        // the round trip has to give back the matrix
+        bool same = (hA_CSR.nnz == hA.nnz);
+        for( magma_int_t k=0; same && k <= m; k++ ) {
+            same = (hA_CSR.row[k] == hA.row[k]);
+        }
+        for( magma_int_t k=0; same && k < hA.nnz; k++ ) {
+            same = (hA_CSR.col[k] == hA.col[k]
+                    && MAGMA_Z_EQUAL( hA_CSR.val[k], hA.val[k] ));
+        }
+        printf( "%% Tester CSR5 round trip:  %s\n", (same ? "ok" : "failed") );
+        status += ! same;
+        magma_zmfree( &hA_CSR, queue );
+
+        // vectors with varying entries, so layout errors show up
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, n, 1, c_zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hy, Magma_CPU, m, 1, c_zero, queue ));
+        for( magma_int_t k=0; k < n; k++ ) {
+            hx.val[k] = MAGMA_Z_MAKE( 1.0 + (k % 7), 0.5 - (k % 3) );
+        }
+
+        // SpMV on the host
+        csr  = zcsr5_build_spmv_time( hA, hx, hy, queue );
+        TESTING_CHECK( magma_zmtransfer( hy, &hyref, Magma_CPU, Magma_CPU, queue ));
+        csr5 = zcsr5_build_spmv_time( hA_CSR5, hx, hy, queue );
+        res = zcsr5_build_error( m, hy.val, hyref.val );
+        zcsr5_build_report( "CPU", build, csr, csr5, gflop );
+        printf( "%% |x-y|_F/|y| = %8.2e Tester spmv CSR5 CPU:  %s\n",
+                res, (res < accuracy ? "ok" : "failed") );
+        status += ! (res < accuracy);
+
+        // SpMV on the GPU; the transfer of the CSR5 arrays is part of the cost
+        TESTING_CHECK( magma_zmtransfer( hA, &dA, Magma_CPU, Magma_DEV, queue ));
+        TESTING_CHECK( magma_zmtransfer( hx, &dx, Magma_CPU, Magma_DEV, queue ));
+        TESTING_CHECK( magma_zmtransfer( hy, &dy, Magma_CPU, Magma_DEV, queue ));
+        start = magma_sync_wtime( queue );
+        TESTING_CHECK( magma_zmtransfer( hA_CSR5, &dA_CSR5, Magma_CPU, Magma_DEV, queue ));
+        transfer = magma_sync_wtime( queue ) - start;
+        csr  = zcsr5_build_spmv_time( dA, dx, dy, queue );
+        magma_zmfree( &hyref, queue );
+        TESTING_CHECK( magma_zmtransfer( dy, &hyref, Magma_DEV, Magma_CPU, queue ));
+        csr5 = zcsr5_build_spmv_time( dA_CSR5, dx, dy, queue );
+        magma_zmfree( &hy, queue );
+        TESTING_CHECK( magma_zmtransfer( dy, &hy, Magma_DEV, Magma_CPU, queue ));
+        res = zcsr5_build_error( m, hy.val, hyref.val );
+        zcsr5_build_report( "GPU", build + transfer, csr, csr5, gflop );
+        printf( "%% |x-y|_F/|y| = %8.2e Tester spmv CSR5 GPU:  %s\n",
+                res, (res < accuracy ? "ok" : "failed") );
+        status += ! (res < accuracy);
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hA_CSR5, queue );
+        magma_zmfree( &dA, queue );
+        magma_zmfree( &dA_CSR5, queue );
+        magma_zmfree( &hx, queue );
+        magma_zmfree( &hy, queue );
+        magma_zmfree( &hyref, queue );
+        magma_zmfree( &dx, queue );
+        magma_zmfree( &dy, queue );
+
+        printf("\n\n");
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -48,6 +48,7 @@ int main(  int argc, char** argv )
 
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
 
     while( i < argc ) {
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
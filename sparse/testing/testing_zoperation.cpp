@@ -43,6 +43,7 @@ int main(  int argc, char** argv )
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
     zopts.operation = Magma_GENERATEPREC;
 
     while( i < argc ) {
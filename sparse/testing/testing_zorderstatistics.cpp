@@ -0,0 +1,241 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+
+// includes, system
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+// the previous implementation does O(n^2) work on sorted arrays and on
+// arrays with many equal magnitudes, run it only up to this length
+#define REFERENCE_MAX 20000
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- previous magma_zmorderstatistics: Lomuto quickselect pivoting on the
+      last element, tail recursion written as a loop
+*/
+static void
+reference_zmorderstatistics(
+    magmaDoubleComplex *val,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_int_t length,
+    magma_int_t k,
+    magma_int_t r,
+    magmaDoubleComplex *element )
+{
+    magmaDoubleComplex tmpv;
+    magma_index_t tmpc, tmpr;
+    while ( true ) {
+        magma_int_t i, st;
+        for ( st = i = 0; i < length - 1; i++ ) {
+            bool skip = ( r == 0 )
+                      ? MAGMA_Z_ABS(val[i]) > MAGMA_Z_ABS(val[length-1])
+                      : MAGMA_Z_ABS(val[i]) < MAGMA_Z_ABS(val[length-1]);
+            if ( skip ) {
+                continue;
+            }
+            tmpv = val[i]; val[i] = val[st]; val[st] = tmpv;
+            tmpc = col[i]; col[i] = col[st]; col[st] = tmpc;
+            tmpr = row[i]; row[i] = row[st]; row[st] = tmpr;
+            st++;
+        }
+        tmpv = val[length-1]; val[length-1] = val[st]; val[st] = tmpv;
+        tmpc = col[length-1]; col[length-1] = col[st]; col[st] = tmpc;
+        tmpr = row[length-1]; row[length-1] = row[st]; row[st] = tmpr;
+
+        if ( k == st ) {
+            *element = val[st];
+            return;
+        }
+        else if ( st > k ) {
+            length = st;
+        }
+        else {
+            val += st; col += st; row += st;
+            length -= st;
+            k -= st;
+        }
+    }
+}
+
+
+// checks that the k entries in front are not beyond element, the rest not before
+static bool
+check_partition(
+    const magmaDoubleComplex *val,
+    magma_int_t length,
+    magma_int_t k,
+    magma_int_t r,
+    magmaDoubleComplex element )
+{
+    double e = MAGMA_Z_ABS( element );
+    for( magma_int_t i=0; i < length; i++ ) {
+        double a = MAGMA_Z_ABS( val[i] );
+        bool front = ( r == 0 ) ? a <= e : a >= e;
+        bool back  = ( r == 0 ) ? a >= e : a <= e;
+        if ( (i < k && ! front) || (i > k && ! back) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- benchmark magma_zmorderstatistics against the previous quickselect on
+      the ParILUT candidate residuals of the given matrices, unsorted and
+      sorted by magnitude
+*/
+int main(  int argc, char** argv )
+{
+    magma_int_t info = 0;
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    real_Double_t start, end, t_ref, t_new;
+    magma_z_matrix hA={Magma_CSR}, hAT={Magma_CSR}, L0={Magma_CSR}, U0={Magma_CSR},
+                   L={Magma_CSR}, U={Magma_CSR}, UT={Magma_CSR},
+                   hL={Magma_CSR}, hU={Magma_CSR};
+    magmaDoubleComplex *val=NULL, *val2=NULL, *sorted=NULL;
+    magma_index_t *col=NULL, *row=NULL, *col2=NULL, *row2=NULL;
+    magmaDoubleComplex e_ref, e_new;
+    const double fraction[] = { 0.1, 0.5, 0.9 };
+    int status = 0;
+
+    int i=1;
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        TESTING_CHECK( magma_zmscale( &hA, Magma_UNITDIAG, queue ));
+
+        // ParILUT residuals of the candidates of the first sweep
+        TESTING_CHECK( magma_zmatrix_tril( hA, &L0, queue ));
+        TESTING_CHECK( magma_zmatrix_triu( hA, &U0, queue ));
+        TESTING_CHECK( magma_zmatrix_tril( hA, &L, queue ));
+        TESTING_CHECK( magma_zmtranspose( hA, &hAT, queue ));
+        TESTING_CHECK( magma_zmatrix_tril( hAT, &U, queue ));
+        TESTING_CHECK( magma_zmatrix_addrowindex( &L, queue ));
+        TESTING_CHECK( magma_zmatrix_addrowindex( &U, queue ));
+        TESTING_CHECK( magma_zcsrcoo_transpose( U, &UT, queue ));
+        TESTING_CHECK( magma_zparilut_candidates( L0, U0, L, UT, &hL, &hU, queue ));
+        TESTING_CHECK( magma_zparilut_residuals( hA, L, U, &hL, queue ));
+
+        magma_int_t n = hL.nnz;
+        printf( "\n# matrix info: %lld-by-%lld with %lld nonzeros, %lld candidate residuals\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols,
+                (long long) hA.nnz, (long long) n );
+        if ( n < 1 ) {
+            printf( "%% no candidates, skipping.\n" );
+        }
+        else {
+            TESTING_CHECK( magma_zmalloc_cpu( &val, n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &val2, n ));
+            TESTING_CHECK( magma_zmalloc_cpu( &sorted, n ));
+            TESTING_CHECK( magma_index_malloc_cpu( &col, n ));
+            TESTING_CHECK( magma_index_malloc_cpu( &row, n ));
+            TESTING_CHECK( magma_index_malloc_cpu( &col2, n ));
+            TESTING_CHECK( magma_index_malloc_cpu( &row2, n ));
+            for( magma_int_t j=0; j < n; j++ ) {
+                sorted[j] = hL.val[j];
+            }
+            std::sort( sorted, sorted + n,
+                []( const magmaDoubleComplex& a, const magmaDoubleComplex& b )
+                { return MAGMA_Z_ABS( a ) < MAGMA_Z_ABS( b ); } );
+
+            printf( "%%  input      r         k   reference (ms)   new (ms)   speedup   check\n" );
+            printf( "%%========================================================================\n" );
+            for( int input = 0; input < 2; input++ ) {
+                const magmaDoubleComplex *src = ( input == 0 ) ? hL.val : sorted;
+                for( magma_int_t r = 0; r < 2; r++ ) {
+                    for( int f = 0; f < 3; f++ ) {
+                        magma_int_t k = magma_int_t( fraction[f] * (n-1) );
+                        bool run_ref = ( n <= REFERENCE_MAX );
+                        for( magma_int_t j=0; j < n; j++ ) {
+                            val[j] = val2[j] = src[j];
+                            col[j] = col2[j] = hL.col[j];
+                            row[j] = row2[j] = hL.rowidx[j];
+                        }
+                        t_ref = 0.0;
+                        if ( run_ref ) {
+                            start = magma_wtime();
+                            reference_zmorderstatistics( val, col, row, n, k, r, &e_ref );
+                            end = magma_wtime();
+                            t_ref = end - start;
+                        }
+                        start = magma_wtime();
+                        TESTING_CHECK( magma_zmorderstatistics( val2, col2, row2, n, k, r, &e_new, queue ));
+                        end = magma_wtime();
+                        t_new = end - start;
+
+                        bool okay = check_partition( val2, n, k, r, e_new );
+                        if ( run_ref ) {
+                            okay = okay && MAGMA_Z_ABS( e_ref ) == MAGMA_Z_ABS( e_new );
+                        }
+                        status += ! okay;
+                        if ( run_ref ) {
+                            printf( "  %-8s %3lld %10lld   %14.3f %10.3f %9.2f   %s\n",
+                                    ( input == 0 ) ? "residual" : "sorted",
+                                    (long long) r, (long long) k,
+                                    t_ref*1000, t_new*1000, t_ref/t_new,
+                                    okay ? "ok" : "failed" );
+                        } else {
+                            printf( "  %-8s %3lld %10lld   %14s %10.3f %9s   %s\n",
+                                    ( input == 0 ) ? "residual" : "sorted",
+                                    (long long) r, (long long) k,
+                                    "---", t_new*1000, "---",
+                                    okay ? "ok" : "failed" );
+                        }
+                    }
+                }
+            }
+            magma_free_cpu( val );
+            magma_free_cpu( val2 );
+            magma_free_cpu( sorted );
+            magma_free_cpu( col );
+            magma_free_cpu( row );
+            magma_free_cpu( col2 );
+            magma_free_cpu( row2 );
+        }
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hAT, queue );
+        magma_zmfree( &L0, queue );
+        magma_zmfree( &U0, queue );
+        magma_zmfree( &L, queue );
+        magma_zmfree( &U, queue );
+        magma_zmfree( &UT, queue );
+        magma_zmfree( &hL, queue );
+        magma_zmfree( &hU, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
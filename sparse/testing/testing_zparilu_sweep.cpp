@@ -0,0 +1,135 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- ILU residual ||(A - LU)|_S||_F on the sparsity pattern S of A,
+      L in CSR with unit diagonal, U in CSC
+*/
+static double
+ilu_residual(
+    magma_z_matrix A,
+    magma_z_matrix L,
+    magma_z_matrix U )
+{
+    double res = 0.0;
+    #pragma omp parallel for reduction(+:res)
+    for( magma_int_t k=0; k < A.nnz; k++ ) {
+        magma_index_t i = A.rowidx[k];
+        magma_index_t j = A.col[k];
+        magmaDoubleComplex s = A.val[k];
+        magma_index_t il = L.row[i], iu = U.row[j];
+        while ( il < L.row[i+1] && iu < U.row[j+1] ) {
+            magma_index_t jl = L.col[il];
+            magma_index_t ju = U.col[iu];
+            if ( jl == ju ) {
+                s -= L.val[il] * U.val[iu];
+            }
+            il = ( jl <= ju ) ? il+1 : il;
+            iu = ( jl >= ju ) ? iu+1 : iu;
+        }
+        res += MAGMA_Z_REAL( s * MAGMA_Z_CONJ( s ) );
+    }
+    return sqrt( res );
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- convergence of the CPU ParILU sweeps: asynchronous in-place
+      (magma_zparilu_sweep) versus synchronous double-buffered
+      (magma_zparilu_sweep_sync), --psweeps sweeps each
+*/
+int main(  int argc, char** argv )
+{
+    magma_int_t info = 0;
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magma_zopts zopts;
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    real_Double_t start, end, t_sweep;
+    magma_z_matrix hA={Magma_CSR}, hAT={Magma_CSR}, hACOO={Magma_CSR},
+                   L={Magma_CSR}, U={Magma_CSR}, L0={Magma_CSR}, U0={Magma_CSR};
+    const char *mode_name[] = { "async", "sync" };
+
+    int i=1;
+    TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+        printf( "\n%% matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        TESTING_CHECK( magma_zmscale( &hA, Magma_UNITDIAG, queue ));
+        TESTING_CHECK( magma_zmconvert( hA, &hACOO, Magma_CSR, Magma_CSRCOO, queue ));
+
+        // initial guess as in magma_zparilu_cpu: L with unit diagonal, U^T
+        TESTING_CHECK( magma_zmatrix_tril( hA, &L0, queue ));
+        for( magma_int_t k=0; k < L0.num_rows; k++ ) {
+            L0.val[ L0.row[k+1]-1 ] = MAGMA_Z_ONE;
+        }
+        TESTING_CHECK( magma_zmtranspose( hA, &hAT, queue ));
+        TESTING_CHECK( magma_zmatrix_tril( hAT, &U0, queue ));
+
+        printf( "%%  mode   sweep   ILU residual   time (ms)\n" );
+        printf( "%%=========================================\n" );
+        for( int mode=0; mode < 2; mode++ ) {
+            TESTING_CHECK( magma_zmtransfer( L0, &L, Magma_CPU, Magma_CPU, queue ));
+            TESTING_CHECK( magma_zmtransfer( U0, &U, Magma_CPU, Magma_CPU, queue ));
+            printf( "  %-5s  %5d   %.6e   %9s\n", mode_name[mode], 0,
+                    ilu_residual( hACOO, L, U ), "---" );
+            for( magma_int_t s=1; s <= zopts.precond_par.sweeps; s++ ) {
+                start = magma_wtime();
+                if ( mode == 0 ) {
+                    TESTING_CHECK( magma_zparilu_sweep( hACOO, &L, &U, queue ));
+                } else {
+                    TESTING_CHECK( magma_zparilu_sweep_sync( hACOO, &L, &U, queue ));
+                }
+                end = magma_wtime();
+                t_sweep = end - start;
+                printf( "  %-5s  %5lld   %.6e   %9.3f\n", mode_name[mode], (long long) s,
+                        ilu_residual( hACOO, L, U ), t_sweep*1000 );
+            }
+            magma_zmfree( &L, queue );
+            magma_zmfree( &U, queue );
+        }
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hAT, queue );
+        magma_zmfree( &hACOO, queue );
+        magma_zmfree( &L0, queue );
+        magma_zmfree( &U0, queue );
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return info;
+}
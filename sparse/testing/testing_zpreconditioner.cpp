@@ -48,6 +48,7 @@ int main(  int argc, char** argv )
 
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
 
     TESTING_CHECK( magma_zsolverinfo_init( &zopts.solver_par, &zopts.precond_par, queue ));
 
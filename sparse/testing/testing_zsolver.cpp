@@ -36,12 +36,14 @@ int main(  int argc, char** argv )
     
     // magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
     magma_z_matrix A={Magma_CSR}, B={Magma_CSR}, dB={Magma_CSR};
-    magma_z_matrix x={Magma_CSR}, b={Magma_CSR};
+    magma_z_matrix x={Magma_CSR}, x0={Magma_CSR}, b={Magma_CSR};
     
     int i=1;
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
+    magma_timing timing( zopts.nrep, false, size_t( zopts.flush ) * 1024 * 1024, queue );
 
     TESTING_CHECK( magma_zsolverinfo_init( &zopts.solver_par, &zopts.precond_par, queue ));
 
@@ -88,8 +90,16 @@ int main(  int argc, char** argv )
         //magma_z_spmv( one, dB, x, zero, b, queue );                 //  b = A x
         //magma_zmfree(&x, queue );
         TESTING_CHECK( magma_zvinit_rand( &x, Magma_DEV, A.num_cols, 1, queue ));
+        TESTING_CHECK( magma_zmtransfer( x, &x0, Magma_DEV, Magma_DEV, queue ));
         
-        info = magma_z_solver( dB, b, &x, &zopts, queue );
+        // each timed run starts from the same initial guess
+        timing.time(
+            [&]() {
+                magma_zcopy( x.num_rows, x0.dval, 1, x.dval, 1, queue );
+            },
+            [&]() {
+                info = magma_z_solver( dB, b, &x, &zopts, queue );
+            } );
         if( info != 0 ) {
             printf("%%error: solver returned: %s (%lld).\n",
                     magma_strerror( info ), (long long) info );
@@ -108,10 +118,12 @@ int main(  int argc, char** argv )
         printf("  %.6f  %.6f\n",
            zopts.precond_par.setuptime, zopts.precond_par.runtime );
         printf("];\n\n");
+        timing.print();
         magma_zmfree(&dB, queue );
         magma_zmfree(&B, queue );
         magma_zmfree(&A, queue );
         magma_zmfree(&x, queue );
+        magma_zmfree(&x0, queue );
         magma_zmfree(&b, queue );
         i++;
     }
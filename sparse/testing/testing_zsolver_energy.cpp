@@ -65,6 +65,7 @@ int main(  int argc, char** argv )
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &inp, queue ));
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
 
     TESTING_CHECK( magma_zsolverinfo_init( &zopts.solver_par, &zopts.precond_par, queue ));
 
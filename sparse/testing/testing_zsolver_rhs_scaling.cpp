@@ -59,6 +59,7 @@ int main(  int argc, char** argv )
     
     B.blocksize = zopts.blocksize;
     B.alignment = zopts.alignment;
+    B.sellp_sigma = zopts.sigma;
 
     // make sure preconditioner is NONE for unpreconditioned systems
     if ( zopts.solver_par.solver != Magma_PCG &&
@@ -0,0 +1,255 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magmasparse.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#define PRECISION_z
+
+#define NITER 200
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Reference Y = A*X for CSR A and num_vecs column-major vectors, serial.
+*/
+static void
+zspmv_cpu_reference(
+    magma_z_matrix A, magma_int_t num_vecs,
+    const magmaDoubleComplex *x, magmaDoubleComplex *y )
+{
+    for( magma_int_t v=0; v < num_vecs; v++ ) {
+        for( magma_int_t i=0; i < A.num_rows; i++ ) {
+            magmaDoubleComplex s = MAGMA_Z_ZERO;
+            for( magma_int_t k=A.row[i]; k < A.row[i+1]; k++ ) {
+                s += A.val[k] * x[ A.col[k] + v*A.num_cols ];
+            }
+            y[ i + v*A.num_rows ] = s;
+        }
+    }
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Runs y = A*x NITER times after a warmup; returns seconds per product.
+*/
+static real_Double_t
+zspmv_cpu_time(
+    magma_z_matrix A, magma_z_matrix x, magma_z_matrix y, magma_queue_t queue )
+{
+    magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    TESTING_CHECK( magma_z_spmv( c_one, A, x, c_zero, y, queue ));
+    real_Double_t start = magma_wtime();
+    for( magma_int_t j=0; j < NITER; j++ ) {
+        TESTING_CHECK( magma_z_spmv( c_one, A, x, c_zero, y, queue ));
+    }
+    return (magma_wtime() - start) / NITER;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Prints time, performance, and sum |y - yref| / sum |yref|;
+   returns 1 if the check failed. With row_major, y is stored row-major.
+*/
+static int
+zspmv_cpu_report(
+    const char *name, real_Double_t time, real_Double_t gflop,
+    magma_int_t m, magma_int_t num_vecs, bool row_major,
+    const magmaDoubleComplex *y, const magmaDoubleComplex *yref,
+    double accuracy )
+{
+    double res = 0.0, ref = 0.0;
+    for( magma_int_t v=0; v < num_vecs; v++ ) {
+        for( magma_int_t i=0; i < m; i++ ) {
+            magmaDoubleComplex yi = row_major ? y[ i*num_vecs + v ] : y[ i + v*m ];
+            res += MAGMA_Z_ABS( yi - yref[ i + v*m ] );
+            ref += MAGMA_Z_ABS( yref[ i + v*m ] );
+        }
+    }
+    res = ref == 0 ? res : res / ref;
+    bool okay = (res < accuracy);
+    printf( "%% > MAGMA: %.2e seconds %.2e GFLOP/s    (%s).\n",
+            time, okay ? gflop / time : 0.0, name );
+    printf( "%% |x-y|_F/|y| = %8.2e Tester spmv CPU %s:  %s\n",
+            res, name, (okay ? "ok" : "failed") );
+    return ! okay;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   Prints the padding overhead of a SELLP matrix converted from A.
+*/
+static void
+zspmv_cpu_padding(
+    const char *name, magma_z_matrix A, magma_z_matrix B )
+{
+    printf( "%% %s padding: %lld stored entries for %lld nonzeros (%.2fx), max row %lld\n",
+            name, (long long) B.nnz, (long long) A.nnz,
+            A.nnz == 0 ? 1.0 : double( B.nnz ) / A.nnz, (long long) B.max_nnz_row );
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- testing sparse matrix vector product on the CPU
+*/
+int main(  int argc, char** argv )
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+    magma_queue_t queue=NULL;
+    magma_queue_create( 0, &queue );
+
+    magma_z_matrix hA={Magma_CSR}, hA_SELLP={Magma_CSR}, hA_SELLCS={Magma_CSR};
+    magma_z_matrix hA_CSR5={Magma_CSR};
+    magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR}, hX={Magma_CSR}, hY={Magma_CSR};
+    magmaDoubleComplex *yref=NULL;
+
+    hA_SELLP.blocksize = 8;
+    hA_SELLP.alignment = 1;
+    magma_int_t sigma = 256;
+    magma_int_t num_vecs = 4;
+    real_Double_t time;
+
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    double accuracy = 1e-8;
+    #if defined(PRECISION_c) || defined(PRECISION_s)
+        accuracy = 1e-4;
+    #endif
+
+    int status = 0;
+    magma_int_t i;
+    for( i = 1; i < argc; ++i ) {
+        if ( strcmp("--blocksize", argv[i]) == 0 && i+1 < argc ) {
+            hA_SELLP.blocksize = atoi( argv[++i] );
+        } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
+            hA_SELLP.alignment = atoi( argv[++i] );
+        } else if ( strcmp("--sigma", argv[i]) == 0 && i+1 < argc ) {
+            sigma = atoi( argv[++i] );
+        } else if ( strcmp("--num_vecs", argv[i]) == 0 && i+1 < argc ) {
+            num_vecs = atoi( argv[++i] );
+        } else
+            break;
+    }
+    printf( "\n%% #    usage: ./run_zspmv_cpu"
+            " [ --blocksize %lld --alignment %lld (for SELLP) --sigma %lld (for SELL-C-sigma)"
+            " --num_vecs %lld ] matrices\n\n",
+            (long long) hA_SELLP.blocksize, (long long) hA_SELLP.alignment,
+            (long long) sigma, (long long) num_vecs );
+    hA_SELLCS.blocksize   = hA_SELLP.blocksize;
+    hA_SELLCS.alignment   = hA_SELLP.alignment;
+    hA_SELLCS.sellp_sigma = sigma;
+
+    while( i < argc ) {
+        if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
+            i++;
+            magma_int_t laplace_size = atoi( argv[i] );
+            TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else {                        // file-matrix test
+            TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
+        }
+
+        printf( "\n%% # matrix info: %lld-by-%lld with %lld nonzeros\n\n",
+                (long long) hA.num_rows, (long long) hA.num_cols, (long long) hA.nnz );
+
+        magma_int_t m = hA.num_rows;
+        magma_int_t n = hA.num_cols;
+        real_Double_t gflop = 2.0*hA.nnz/1e9;
+
+        // vectors with varying entries, so layout errors show up
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, n, 1, c_zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hy, Magma_CPU, m, 1, c_zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hX, Magma_CPU, n, num_vecs, c_zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hY, Magma_CPU, m, num_vecs, c_zero, queue ));
+        TESTING_CHECK( magma_zmalloc_cpu( &yref, m*num_vecs ));
+        for( magma_int_t k=0; k < n*num_vecs; k++ ) {
+            hX.val[k] = MAGMA_Z_MAKE( 1.0 + (k % 7), 0.5 - (k % 3) );
+        }
+        for( magma_int_t k=0; k < n; k++ ) {
+            hx.val[k] = hX.val[k];
+        }
+        zspmv_cpu_reference( hA, num_vecs, hX.val, yref );
+
+        // CSR
+        time = zspmv_cpu_time( hA, hx, hy, queue );
+        status += zspmv_cpu_report( "CSR", time, gflop, m, 1, false,
+                                    hy.val, yref, accuracy );
+
+        // SELLP
+        TESTING_CHECK( magma_zmconvert( hA, &hA_SELLP, Magma_CSR, Magma_SELLP, queue ));
+        time = zspmv_cpu_time( hA_SELLP, hx, hy, queue );
+        status += zspmv_cpu_report( "SELLP", time, gflop, m, 1, false,
+                                    hy.val, yref, accuracy );
+        zspmv_cpu_padding( "SELLP", hA, hA_SELLP );
+
+        // SELL-C-sigma, rows sorted by length within windows of sigma rows
+        TESTING_CHECK( magma_zmconvert( hA, &hA_SELLCS, Magma_CSR, Magma_SELLP, queue ));
+        time = zspmv_cpu_time( hA_SELLCS, hx, hy, queue );
+        status += zspmv_cpu_report( "SELL-C-sigma", time, gflop, m, 1, false,
+                                    hy.val, yref, accuracy );
+        zspmv_cpu_padding( "SELL-C-sigma", hA, hA_SELLCS );
+
+        // CSR5
+        TESTING_CHECK( magma_zmconvert( hA, &hA_CSR5, Magma_CSR, Magma_CSR5, queue ));
+        time = zspmv_cpu_time( hA_CSR5, hx, hy, queue );
+        status += zspmv_cpu_report( "CSR5", time, gflop, m, 1, false,
+                                    hy.val, yref, accuracy );
+        magma_zmfree( &hA_CSR5, queue );
+
+        // SpMM, CSR with column-major vectors
+        time = zspmv_cpu_time( hA, hX, hY, queue );
+        status += zspmv_cpu_report( "CSR SpMM", time, gflop*num_vecs, m, num_vecs, false,
+                                    hY.val, yref, accuracy );
+
+        // SpMM, SELLP with row-major vectors
+        for( magma_int_t v=0; v < num_vecs; v++ ) {
+            for( magma_int_t k=0; k < n; k++ ) {
+                hX.val[ k*num_vecs + v ] = MAGMA_Z_MAKE( 1.0 + ((k + v*n) % 7),
+                                                         0.5 - ((k + v*n) % 3) );
+            }
+        }
+        hX.major = MagmaRowMajor;
+        hY.major = MagmaRowMajor;
+        time = zspmv_cpu_time( hA_SELLP, hX, hY, queue );
+        status += zspmv_cpu_report( "SELLP SpMM", time, gflop*num_vecs, m, num_vecs, true,
+                                    hY.val, yref, accuracy );
+        time = zspmv_cpu_time( hA_SELLCS, hX, hY, queue );
+        status += zspmv_cpu_report( "SELL-C-sigma SpMM", time, gflop*num_vecs, m, num_vecs, true,
+                                    hY.val, yref, accuracy );
+        magma_zmfree( &hA_SELLP, queue );
+        magma_zmfree( &hA_SELLCS, queue );
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( &hx, queue );
+        magma_zmfree( &hy, queue );
+        magma_zmfree( &hX, queue );
+        magma_zmfree( &hY, queue );
+        magma_free_cpu( yref );
+        yref = NULL;
+
+        printf("\n\n");
+        i++;
+    }
+
+    magma_queue_destroy( queue );
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
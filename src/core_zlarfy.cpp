@@ -12,6 +12,120 @@
 #include "magma_internal.h"
 #include "magma_bulge.h"
 
+#define COMPLEX
+
+
+/******************************************************************************/
+// Panel of four columns of the Hermitian matrix-vector product in magma_zlarfy:
+// w(i) += sum_k A(i,k) vj(k), and s(k) = sum_i conj(A(i,k)) vi(i),
+// for the m rows of A below the diagonal block of columns j:j+3.
+static inline void
+magma_zlarfy_hemv4(
+    magma_int_t m, const magmaDoubleComplex *A, magma_int_t lda,
+    const magmaDoubleComplex *vj, const magmaDoubleComplex *vi,
+    magmaDoubleComplex *w, magmaDoubleComplex *s)
+{
+    const magmaDoubleComplex *A0 = A, *A1 = A + lda, *A2 = A + 2*lda, *A3 = A + 3*lda;
+    magma_int_t i;
+#ifdef COMPLEX
+    const double v0r = MAGMA_Z_REAL( vj[0] ), v0i = MAGMA_Z_IMAG( vj[0] );
+    const double v1r = MAGMA_Z_REAL( vj[1] ), v1i = MAGMA_Z_IMAG( vj[1] );
+    const double v2r = MAGMA_Z_REAL( vj[2] ), v2i = MAGMA_Z_IMAG( vj[2] );
+    const double v3r = MAGMA_Z_REAL( vj[3] ), v3i = MAGMA_Z_IMAG( vj[3] );
+    double s0r = 0, s0i = 0, s1r = 0, s1i = 0, s2r = 0, s2i = 0, s3r = 0, s3i = 0;
+
+    // real arithmetic, so the compiler can vectorize the reductions
+    #pragma omp simd reduction(+:s0r,s0i,s1r,s1i,s2r,s2i,s3r,s3i)
+    for (i = 0; i < m; i++) {
+        const double a0r = MAGMA_Z_REAL( A0[i] ), a0i = MAGMA_Z_IMAG( A0[i] );
+        const double a1r = MAGMA_Z_REAL( A1[i] ), a1i = MAGMA_Z_IMAG( A1[i] );
+        const double a2r = MAGMA_Z_REAL( A2[i] ), a2i = MAGMA_Z_IMAG( A2[i] );
+        const double a3r = MAGMA_Z_REAL( A3[i] ), a3i = MAGMA_Z_IMAG( A3[i] );
+        const double xr  = MAGMA_Z_REAL( vi[i] ), xi  = MAGMA_Z_IMAG( vi[i] );
+        w[i] = MAGMA_Z_MAKE(
+            MAGMA_Z_REAL( w[i] ) + (a0r*v0r - a0i*v0i) + (a1r*v1r - a1i*v1i)
+                                 + (a2r*v2r - a2i*v2i) + (a3r*v3r - a3i*v3i),
+            MAGMA_Z_IMAG( w[i] ) + (a0r*v0i + a0i*v0r) + (a1r*v1i + a1i*v1r)
+                                 + (a2r*v2i + a2i*v2r) + (a3r*v3i + a3i*v3r) );
+        s0r += a0r*xr + a0i*xi;  s0i += a0r*xi - a0i*xr;
+        s1r += a1r*xr + a1i*xi;  s1i += a1r*xi - a1i*xr;
+        s2r += a2r*xr + a2i*xi;  s2i += a2r*xi - a2i*xr;
+        s3r += a3r*xr + a3i*xi;  s3i += a3r*xi - a3i*xr;
+    }
+    s[0] = MAGMA_Z_MAKE( s0r, s0i );
+    s[1] = MAGMA_Z_MAKE( s1r, s1i );
+    s[2] = MAGMA_Z_MAKE( s2r, s2i );
+    s[3] = MAGMA_Z_MAKE( s3r, s3i );
+#else
+    const magmaDoubleComplex v0 = vj[0], v1 = vj[1], v2 = vj[2], v3 = vj[3];
+    magmaDoubleComplex s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    #pragma omp simd reduction(+:s0,s1,s2,s3)
+    for (i = 0; i < m; i++) {
+        w[i] += A0[i]*v0 + A1[i]*v1 + A2[i]*v2 + A3[i]*v3;
+        s0 += A0[i]*vi[i];
+        s1 += A1[i]*vi[i];
+        s2 += A2[i]*vi[i];
+        s3 += A3[i]*vi[i];
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+#endif
+}
+
+
+/******************************************************************************/
+// Panel of four columns of the Hermitian rank-2 update in magma_zlarfy:
+// A(i,k) -= wi(i) conj(vj(k)) + vi(i) conj(wj(k)),
+// for the m rows of A below the diagonal block of columns j:j+3.
+static inline void
+magma_zlarfy_her24(
+    magma_int_t m, magmaDoubleComplex *A, magma_int_t lda,
+    const magmaDoubleComplex *wj, const magmaDoubleComplex *vj,
+    const magmaDoubleComplex *wi, const magmaDoubleComplex *vi)
+{
+    magmaDoubleComplex *A0 = A, *A1 = A + lda, *A2 = A + 2*lda, *A3 = A + 3*lda;
+    magma_int_t i;
+#ifdef COMPLEX
+    const double w0r = MAGMA_Z_REAL( wj[0] ), w0i = MAGMA_Z_IMAG( wj[0] );
+    const double w1r = MAGMA_Z_REAL( wj[1] ), w1i = MAGMA_Z_IMAG( wj[1] );
+    const double w2r = MAGMA_Z_REAL( wj[2] ), w2i = MAGMA_Z_IMAG( wj[2] );
+    const double w3r = MAGMA_Z_REAL( wj[3] ), w3i = MAGMA_Z_IMAG( wj[3] );
+    const double v0r = MAGMA_Z_REAL( vj[0] ), v0i = MAGMA_Z_IMAG( vj[0] );
+    const double v1r = MAGMA_Z_REAL( vj[1] ), v1i = MAGMA_Z_IMAG( vj[1] );
+    const double v2r = MAGMA_Z_REAL( vj[2] ), v2i = MAGMA_Z_IMAG( vj[2] );
+    const double v3r = MAGMA_Z_REAL( vj[3] ), v3i = MAGMA_Z_IMAG( vj[3] );
+
+    #pragma omp simd
+    for (i = 0; i < m; i++) {
+        const double xr = MAGMA_Z_REAL( wi[i] ), xi = MAGMA_Z_IMAG( wi[i] );
+        const double yr = MAGMA_Z_REAL( vi[i] ), yi = MAGMA_Z_IMAG( vi[i] );
+        A0[i] = MAGMA_Z_MAKE( MAGMA_Z_REAL( A0[i] ) - (xr*v0r + xi*v0i) - (yr*w0r + yi*w0i),
+                              MAGMA_Z_IMAG( A0[i] ) - (xi*v0r - xr*v0i) - (yi*w0r - yr*w0i) );
+        A1[i] = MAGMA_Z_MAKE( MAGMA_Z_REAL( A1[i] ) - (xr*v1r + xi*v1i) - (yr*w1r + yi*w1i),
+                              MAGMA_Z_IMAG( A1[i] ) - (xi*v1r - xr*v1i) - (yi*w1r - yr*w1i) );
+        A2[i] = MAGMA_Z_MAKE( MAGMA_Z_REAL( A2[i] ) - (xr*v2r + xi*v2i) - (yr*w2r + yi*w2i),
+                              MAGMA_Z_IMAG( A2[i] ) - (xi*v2r - xr*v2i) - (yi*w2r - yr*w2i) );
+        A3[i] = MAGMA_Z_MAKE( MAGMA_Z_REAL( A3[i] ) - (xr*v3r + xi*v3i) - (yr*w3r + yi*w3i),
+                              MAGMA_Z_IMAG( A3[i] ) - (xi*v3r - xr*v3i) - (yi*w3r - yr*w3i) );
+    }
+#else
+    const magmaDoubleComplex w0 = wj[0], w1 = wj[1], w2 = wj[2], w3 = wj[3];
+    const magmaDoubleComplex v0 = vj[0], v1 = vj[1], v2 = vj[2], v3 = vj[3];
+
+    #pragma omp simd
+    for (i = 0; i < m; i++) {
+        A0[i] -= wi[i]*v0 + vi[i]*w0;
+        A1[i] -= wi[i]*v1 + vi[i]*w1;
+        A2[i] -= wi[i]*v2 + vi[i]*w2;
+        A3[i] -= wi[i]*v3 + vi[i]*w3;
+    }
+#endif
+}
+
+
 /***************************************************************************//**
  *
  * @ingroup magma_larfy
@@ -59,31 +173,80 @@ magma_zlarfy(
 {
     /*
     work (workspace) double complex array, dimension n
+
+    Computes the same as
+        zhemv ( X = tau A V ), zdotc, zaxpy ( W = X - 1/2 tau (X'V) V ), zher2 ( A -= W V' + V W' )
+    but fused into one pass over the lower triangle of A for the zhemv and
+    one for the zher2. Both passes do four columns at a time, so every
+    element of work and V is loaded once per four columns, with loops the
+    compiler can vectorize.
     */
 
-    const magma_int_t ione = 1;
-    const magmaDoubleComplex c_zero   =  MAGMA_Z_ZERO;
-    const magmaDoubleComplex c_neg_one=  MAGMA_Z_NEG_ONE;
-    const magmaDoubleComplex c_half   =  MAGMA_Z_HALF;
-    magmaDoubleComplex dtmp;
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_half = MAGMA_Z_HALF;
+    const magmaDoubleComplex tau    = *TAU;
+    magmaDoubleComplex dtmp, s, s4[4];
+    magma_int_t i, j, jj, jb;
 
-    /* X = AVtau */
-    blasf77_zhemv("L",&n, TAU, A, &lda, V, &ione, &c_zero, work, &ione);
+    #define A(i_,j_) A[ (i_) + (j_)*lda ]
 
-    /* compute dtmp= X'*V */
-    dtmp = magma_cblas_zdotc(n, work, ione, V, ione);
-    /*
+    /* X = A V (tau applied below) */
+    for (i = 0; i < n; i++) {
+        work[i] = c_zero;
+    }
+    for (j = 0; j < n; j += 4) {
+        jb = min( 4, n-j );
+        /* triangle on the diagonal */
+        for (jj = j; jj < j+jb; jj++) {
+            s = MAGMA_Z_REAL( A(jj,jj) ) * V[jj];
+            for (i = jj+1; i < j+jb; i++) {
+                work[i] += A(i,jj) * V[jj];
+                s       += MAGMA_Z_CONJ( A(i,jj) ) * V[i];
+            }
+            work[jj] += s;
+        }
+        if (jb < 4) {
+            break;
+        }
+        /* rows below, four columns at a time */
+        magma_zlarfy_hemv4( n-j-4, &A(j+4,j), lda, &V[j], &V[j+4], &work[j+4], s4 );
+        work[j]   += s4[0];
+        work[j+1] += s4[1];
+        work[j+2] += s4[2];
+        work[j+3] += s4[3];
+    }
+
+    /* X = tau X and dtmp = X'*V */
     dtmp = c_zero;
-    for (magma_int_t j = 0; j < n; j++)
-        dtmp = dtmp + MAGMA_Z_CONJ(work[j]) * V[j];
-    */
+    for (i = 0; i < n; i++) {
+        work[i] = tau * work[i];
+        dtmp += MAGMA_Z_CONJ( work[i] ) * V[i];
+    }
 
-    /* compute 1/2 X'*V*t = 1/2*dtmp*tau  */
-    dtmp = -dtmp * c_half * (*TAU);
+    /* W = X - 1/2 X'V tau V */
+    dtmp = -dtmp * c_half * tau;
+    for (i = 0; i < n; i++) {
+        work[i] += dtmp * V[i];
+    }
 
-    /* compute W=X-1/2VX'Vt = X - dtmp*V */
-    blasf77_zaxpy(&n, &dtmp, V, &ione, work, &ione);
+    /* A = A - W V' - V W', the diagonal stays real */
+    for (j = 0; j < n; j += 4) {
+        jb = min( 4, n-j );
+        /* triangle on the diagonal */
+        for (jj = j; jj < j+jb; jj++) {
+            const magmaDoubleComplex cw = MAGMA_Z_CONJ( work[jj] );
+            const magmaDoubleComplex cv = MAGMA_Z_CONJ( V[jj] );
+            A(jj,jj) = MAGMA_Z_MAKE( MAGMA_Z_REAL( A(jj,jj) ) - 2*MAGMA_Z_REAL( work[jj]*cv ), 0. );
+            for (i = jj+1; i < j+jb; i++) {
+                A(i,jj) -= work[i]*cv + V[i]*cw;
+            }
+        }
+        if (jb < 4) {
+            break;
+        }
+        /* rows below, four columns at a time */
+        magma_zlarfy_her24( n-j-4, &A(j+4,j), lda, &work[j], &V[j], &work[j+4], &V[j+4] );
+    }
 
-    /* performs the symmetric rank 2 operation A := alpha*x*y' + alpha*y*x' + A */
-    blasf77_zher2("L", &n, &c_neg_one, work, &ione, V, &ione, A, &lda);
+    #undef A
 }
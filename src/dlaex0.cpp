@@ -9,9 +9,191 @@
        
        @precisions normal d -> s
 */
-#include "magma_internal.h"
+#include <vector>
+
+#include "thread_queue.hpp"
 #include "magma_timer.h"
 
+#include "magma_internal.h"  // after thread_queue.hpp, so max, min are defined
+#include "affinity.h"
+
+
+/******************************************************************************/
+// Shared state of the divide and conquer tree of magma_dlaex0.
+// A task on rows and columns [a, a+m) uses only
+//     work [ (4+n)*a       : (4+n)*(a+m)       ),
+//     iwork[ 4*a           : 4*(a+m)           ),
+//     dwork[ 3*(n/2+1)*a   : 3*(n/2+1)*(a+m)   ),
+// which covers the workspace of magma_dlaex1 for a merge of size m,
+// so tasks on disjoint ranges can run concurrently.
+class magma_dlaex0_tree
+{
+public:
+    magma_dlaex0_tree( magma_int_t in_n, double *in_d, double *in_e,
+                       double *in_Q, magma_int_t in_ldq,
+                       double *in_work, magma_int_t *in_iwork,
+                       magmaDouble_ptr in_dwork, magma_int_t in_indxq,
+                       magma_range_t in_range, double in_vl, double in_vu,
+                       magma_int_t in_il, magma_int_t in_iu ):
+        n( in_n ), d( in_d ), e( in_e ), Q( in_Q ), ldq( in_ldq ),
+        work( in_work ), iwork( in_iwork ), dwork( in_dwork ), indxq( in_indxq ),
+        range( in_range ), vl( in_vl ), vu( in_vu ), il( in_il ), iu( in_iu )
+    {
+        magma_getdevice( &cdev );
+        pthread_mutex_init( &mutex, NULL );
+    }
+
+    ~magma_dlaex0_tree()
+    {
+        for (size_t i = 0; i < queues.size(); ++i)
+            magma_queue_destroy( queues[i] );
+        pthread_mutex_destroy( &mutex );
+    }
+
+    // Returns an unused queue, creating one if needed.
+    magma_queue_t get_queue()
+    {
+        magma_queue_t queue = NULL;
+        pthread_mutex_lock( &mutex );
+        if ( ! free_queues.empty() ) {
+            queue = free_queues.back();
+            free_queues.pop_back();
+        }
+        pthread_mutex_unlock( &mutex );
+        if ( queue == NULL ) {
+            magma_queue_create( cdev, &queue );
+            pthread_mutex_lock( &mutex );
+            queues.push_back( queue );
+            pthread_mutex_unlock( &mutex );
+        }
+        return queue;
+    }
+
+    void release_queue( magma_queue_t queue )
+    {
+        pthread_mutex_lock( &mutex );
+        free_queues.push_back( queue );
+        pthread_mutex_unlock( &mutex );
+    }
+
+    magma_int_t n;
+    double *d, *e, *Q;
+    magma_int_t ldq;
+    double *work;
+    magma_int_t *iwork;
+    magmaDouble_ptr dwork;
+    magma_int_t indxq;
+    magma_range_t range;
+    double vl, vu;
+    magma_int_t il, iu;
+
+private:
+    magma_device_t cdev;
+    pthread_mutex_t mutex;                   ///< mutex lock for queues, free_queues
+    std::vector< magma_queue_t > queues;     ///< all queues created
+    std::vector< magma_queue_t > free_queues;
+};
+
+
+#define Q(i_,j_) (Q + (i_) + (j_)*ldq)
+
+
+/******************************************************************************/
+// Solves the eigenproblem of a leaf of the tree with DSTEQR.
+class magma_dlaex0_leaf_task: public magma_task
+{
+public:
+    magma_dlaex0_leaf_task( magma_dlaex0_tree *tree, magma_int_t submat,
+                            magma_int_t matsiz, magma_int_t *info ):
+        m_tree( tree ), m_submat( submat ), m_matsiz( matsiz ), m_info( info )
+    {}
+
+    virtual void run()
+    {
+        magma_dlaex0_tree& t = *m_tree;
+        magma_int_t n = t.n, ldq = t.ldq;
+        double *Q = t.Q;
+        double *work = t.work + (4 + n)*m_submat;
+
+        magma_int_t omp_nthread = magma_get_omp_numthreads();
+        magma_set_omp_numthreads( 1 );
+        lapackf77_dsteqr("I", &m_matsiz, &t.d[m_submat], &t.e[m_submat],
+                         Q(m_submat, m_submat), &ldq, work, m_info);  // change to edc?
+        magma_set_omp_numthreads( omp_nthread );
+        if (*m_info != 0) {
+            printf("info: %lld\n, submat: %lld\n", (long long) *m_info, (long long) m_submat );
+            *m_info = (m_submat+1)*(n+1) + m_submat + m_matsiz;
+            printf("info: %lld\n", (long long) *m_info );
+            return;
+        }
+        for (magma_int_t j = 0; j < m_matsiz; ++j)
+            t.iwork[t.indxq + m_submat + j] = j+1;
+    }
+
+private:
+    magma_dlaex0_tree *m_tree;
+    magma_int_t m_submat, m_matsiz;
+    magma_int_t *m_info;
+};
+
+
+/******************************************************************************/
+// Merges the eigensystems of two adjacent submatrices with DLAEX1,
+// using nthread OpenMP threads for the secular equation in DLAEX3 and for
+// the CPU dgemm updates by the (OpenMP) BLAS. With $MAGMA_AFFINITY set, the
+// threads of DLAEX3 bind to placement slots first, ..., first + nthread - 1,
+// so concurrent merges use disjoint CPUs.
+class magma_dlaex0_merge_task: public magma_task
+{
+public:
+    magma_dlaex0_merge_task( magma_dlaex0_tree *tree, magma_int_t submat,
+                             magma_int_t matsiz, magma_int_t msd2,
+                             magma_int_t first, magma_int_t nthread,
+                             const magma_int_t *child_info, magma_int_t *info ):
+        m_tree( tree ), m_submat( submat ), m_matsiz( matsiz ), m_msd2( msd2 ),
+        m_first( first ), m_nthread( nthread ), m_child_info( child_info ),
+        m_info( info )
+    {}
+
+    virtual void run()
+    {
+        magma_dlaex0_tree& t = *m_tree;
+        magma_int_t n = t.n, ldq = t.ldq;
+        double *Q = t.Q;
+
+        *m_info = 0;
+        if (m_child_info[0] != 0 || m_child_info[1] != 0)
+            return;  // a child failed, which is reported instead
+
+        // DLAEX1 is used only for the full eigensystem of a tridiagonal
+        // matrix.
+        // We need all the eigenvectors if it is not last step
+        magma_range_t range2 = (m_matsiz == n ? t.range : MagmaRangeAll);
+
+        magma_int_t omp_nthread = magma_get_omp_numthreads();
+        magma_set_omp_numthreads( m_nthread );
+        affinity_team team( m_first, m_nthread );
+        magma_queue_t queue = t.get_queue();
+        magma_dlaex1(m_matsiz, &t.d[m_submat], Q(m_submat, m_submat), ldq,
+                     &t.iwork[t.indxq+m_submat], t.e[m_submat+m_msd2-1], m_msd2,
+                     t.work + (4 + n)*m_submat, t.iwork + 4*m_submat,
+                     t.dwork + 3*(n/2 + 1)*m_submat, queue,
+                     range2, t.vl, t.vu, t.il, t.iu, m_info);
+        t.release_queue( queue );
+        magma_set_omp_numthreads( omp_nthread );
+
+        if (*m_info != 0)
+            *m_info = (m_submat+1)*(n+1) + m_submat + m_matsiz;
+    }
+
+private:
+    magma_dlaex0_tree *m_tree;
+    magma_int_t m_submat, m_matsiz, m_msd2, m_first, m_nthread;
+    const magma_int_t *m_child_info;
+    magma_int_t *m_info;
+};
+
+
 /***************************************************************************//**
     Purpose
     -------
@@ -107,12 +289,9 @@ magma_dlaex0(
     magma_int_t il, magma_int_t iu,
     magma_int_t *info)
 {
-#define Q(i_,j_) (Q + (i_) + (j_)*ldq)
-
     magma_int_t ione = 1;
-    magma_range_t range2;
-    magma_int_t curlvl, i, indxq;
-    magma_int_t j, k, matsiz, msd2, smlsiz;
+    magma_int_t i, indxq;
+    magma_int_t j, lvl, smlsiz;
     magma_int_t submat, subpbs, tlvls;
 
 
@@ -132,11 +311,6 @@ magma_dlaex0(
     if (n == 0)
         return *info;
 
-    magma_queue_t queue;
-    magma_device_t cdev;
-    magma_getdevice( &cdev );
-    magma_queue_create( cdev, &queue );
-
     smlsiz = magma_get_smlsize_divideconquer();
 
     // Determine the size and placement of the submatrices, and save in
@@ -165,84 +339,93 @@ magma_dlaex0(
 
     indxq = 4*n + 3;
 
+    // Boundaries of the nodes of the tree, level by level from the leaves:
+    // node j of level lvl covers rows and columns [bound[j], bound[j+1]),
+    // with bound = bounds[ lvl ]. Kept outside IWORK, which the merges use.
+    std::vector< std::vector< magma_int_t > > bounds( tlvls+1 );
+    bounds[0].resize( subpbs+1 );
+    bounds[0][0] = 0;
+    for (i = 0; i < subpbs; ++i)
+        bounds[0][i+1] = iwork[i];
+    for (lvl = 1; lvl <= tlvls; ++lvl) {
+        magma_int_t nnode = subpbs >> lvl;
+        bounds[lvl].resize( nnode+1 );
+        for (i = 0; i <= nnode; ++i)
+            bounds[lvl][i] = bounds[lvl-1][2*i];
+    }
+
     // Solve each submatrix eigenproblem at the bottom of the divide and
-    // conquer tree.
+    // conquer tree, then successively merge eigensystems of adjacent
+    // submatrices into eigensystem for the corresponding larger matrix.
+    // Leaves and merges are tasks; a merge depends on its two children,
+    // so independent leaves and sibling merges run concurrently. A merge
+    // on a level with nnode merges gets nthread/nnode threads.
+    // With one thread, the tasks run in the order of the serial algorithm.
+    // Either way every task does the same operations on the same data as
+    // the serial algorithm, so the result is the same.
+    magma_int_t nthread = magma_get_parallel_numthreads();
+    magma_dlaex0_tree tree( n, d, e, Q, ldq, work, iwork, dwork, indxq,
+                            range, vl, vu, il, iu );
+    std::vector< std::vector< magma_int_t > > node_info( tlvls+1 );
+    std::vector< std::vector< magma_task_handle > > handles( tlvls+1 );
+    magma_thread_queue queue;
+    if (nthread > 1 && subpbs > 1) {
+        queue.launch( nthread );
+    }
+
     //magma_timer_t time=0;
     //timer_start( time );
-
-    for (i = 0; i < subpbs; ++i) {
-        if (i == 0) {
-            submat = 0;
-            matsiz = iwork[0];
-        } else {
-            submat = iwork[i-1];
-            matsiz = iwork[i] - iwork[i-1];
-        }
-        lapackf77_dsteqr("I", &matsiz, &d[submat], &e[submat],
-                         Q(submat, submat), &ldq, work, info);  // change to edc?
-        if (*info != 0) {
-            printf("info: %lld\n, submat: %lld\n", (long long) *info, (long long) submat );
-            *info = (submat+1)*(n+1) + submat + matsiz;
-            printf("info: %lld\n", (long long) *info );
-            return *info;
-        }
-        k = 1;
-        for (j = submat; j < iwork[i]; ++j) {
-            iwork[indxq+j] = k;
-            ++k;
+    for (lvl = 0; lvl <= tlvls; ++lvl) {
+        magma_int_t nnode = subpbs >> lvl;
+        const magma_int_t *bound = &bounds[lvl][0];
+        node_info[lvl].assign( nnode, 0 );
+        handles[lvl].resize( nnode );
+        for (i = 0; i < nnode; ++i) {
+            magma_int_t start  = bound[i];
+            magma_int_t matsiz = bound[i+1] - bound[i];
+            magma_task *task;
+            if (lvl == 0) {
+                task = new magma_dlaex0_leaf_task( &tree, start, matsiz,
+                                                   &node_info[0][i] );
+            }
+            else {
+                // Merge lower order eigensystems (of size MSD2 and
+                // MATSIZ - MSD2) into an eigensystem of size MATSIZ.
+                magma_int_t msd2 = bounds[lvl-1][2*i+1] - start;
+                magma_int_t merge_nthread = max( 1, nthread / nnode );
+                task = new magma_dlaex0_merge_task(
+                    &tree, start, matsiz, msd2, i*merge_nthread, merge_nthread,
+                    &node_info[lvl-1][2*i], &node_info[lvl][i] );
+            }
+            if (nthread > 1 && subpbs > 1) {
+                if (lvl == 0)
+                    handles[0][i] = queue.push_task( task );
+                else
+                    handles[lvl][i] = queue.push_task( task, &handles[lvl-1][2*i], 2 );
+            }
+            else {
+                task->run();
+                delete task;
+            }
         }
     }
-
+    queue.quit();
     //timer_stop( time );
-    //timer_printf( "  for: dsteqr = %6.2f\n", time );
-    
-    // Successively merge eigensystems of adjacent submatrices
-    // into eigensystem for the corresponding larger matrix.
-    curlvl = 1;
-    while (subpbs > 1) {
-        //timer_start( time );
-        
-        for (i=0; i < subpbs-1; i += 2) {
-            if (i == 0) {
-                submat = 0;
-                matsiz = iwork[1];
-                msd2 = iwork[0];
-            } else {
-                submat = iwork[i-1];
-                matsiz = iwork[i+1] - iwork[i-1];
-                msd2 = matsiz / 2;
-            }
+    //timer_printf( "  for: dsteqr and merges = %6.2f\n", time );
 
-            // Merge lower order eigensystems (of size MSD2 and MATSIZ - MSD2)
-            // into an eigensystem of size MATSIZ.
-            // DLAEX1 is used only for the full eigensystem of a tridiagonal
-            // matrix.
-            if (matsiz == n)
-                range2 = range;
-            else
-                // We need all the eigenvectors if it is not last step
-                range2 = MagmaRangeAll;
-
-            magma_dlaex1(matsiz, &d[submat], Q(submat, submat), ldq,
-                         &iwork[indxq+submat], e[submat+msd2-1], msd2,
-                         work, &iwork[subpbs], dwork, queue,
-                         range2, vl, vu, il, iu, info);
-
-            if (*info != 0) {
-                *info = (submat+1)*(n+1) + submat + matsiz;
+    // Report the first failure in the order of the serial algorithm.
+    for (lvl = 0; lvl <= tlvls; ++lvl) {
+        for (i = 0; i < (subpbs >> lvl); ++i) {
+            if (node_info[lvl][i] != 0) {
+                *info = node_info[lvl][i];
                 return *info;
             }
-            iwork[i/2]= iwork[i+1];
         }
-        subpbs /= 2;
-        ++curlvl;
-        
-        //timer_stop( time );
-        //timer_printf("%lld: time: %6.2f\n", (long long) curlvl, time );
     }
 
     // Re-merge the eigenvalues/vectors which were deflated at the final
     // merge step.
+    #pragma omp parallel for private(j)
     for (i = 0; i < n; ++i) {
         j = iwork[indxq+i] - 1;
         work[i] = d[j];
@@ -251,7 +434,5 @@ magma_dlaex0(
     blasf77_dcopy(&n, work, &ione, d, &ione);
     lapackf77_dlacpy( "A", &n, &n, &work[n], &n, Q, &ldq );
 
-    magma_queue_destroy( queue );
-
     return *info;
 } /* magma_dlaex0 */
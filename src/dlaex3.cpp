@@ -15,7 +15,9 @@
 #endif
 
 #include "magma_internal.h"
+#include "trace.h"
 #include "magma_timer.h"
+#include "affinity.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -319,11 +321,26 @@ magma_dlaex3(
     //magma_timer_t time = 0;
     //timer_start( time );
 
+    // bind the OpenMP threads if $MAGMA_AFFINITY is set, restoring their
+    // affinity at the end of the region. Concurrent merges (dlaex0) bind
+    // within the slots of their task; a one-thread team or a nested region
+    // keeps the placement of the caller.
+    int  team_first   = affinity_team::first();
+    int  team_nthread = affinity_team::nthread();
+    bool team_bind    = ! omp_in_parallel();
+
     #pragma omp parallel private(i, j, tmp, temp)
     {
         magma_int_t tid     = omp_get_thread_num();
         magma_int_t nthread = omp_get_num_threads();
 
+        affinity_bind* binding = NULL;
+        if ( team_bind && nthread > 1 ) {
+            int nslot = (team_nthread > 0 ? team_nthread : nthread);
+            binding = new affinity_bind( team_first + tid % nslot,
+                                         team_first + nslot, false );
+        }
+
         magma_int_t ibegin = ( tid    * k) / nthread; // start index of local loop
         magma_int_t iend   = ((tid+1) * k) / nthread; // end   index of local loop
         magma_int_t ik     = iend - ibegin;           // number of local indices
@@ -331,6 +348,8 @@ magma_dlaex3(
         for (i = ibegin; i < iend; ++i)
             dlamda[i] = lapackf77_dlamc3(&dlamda[i], &dlamda[i]) - dlamda[i];
 
+        trace_thread_index( "OpenMP thread", tid );
+        trace_cpu_start( "laex3", "secular equation" );
         for (j = ibegin; j < iend; ++j) {
             magma_int_t tmpp = j+1;
             magma_int_t iinfo = 0;
@@ -342,6 +361,7 @@ magma_dlaex3(
                 break;
             }
         }
+        trace_cpu_end();
 
         #pragma omp barrier
 
@@ -417,6 +437,7 @@ magma_dlaex3(
                 }
 
                 // Compute eigenvectors of the modified rank-1 modification.
+                trace_cpu_start( "laex3", "eigenvectors" );
                 for (j = ibegin; j < iend; ++j) {
                     for (i = 0; i < k; ++i)
                         s[tid*k + i] = w[i] / *Q(i,j);
@@ -426,8 +447,10 @@ magma_dlaex3(
                         *Q(i,j) = s[tid*k + iii] / temp;
                     }
                 }
+                trace_cpu_end();
             }
         }
+        delete binding;
     }  // end omp parallel
     if (*info != 0)
         return *info;
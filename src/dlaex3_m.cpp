@@ -14,6 +14,7 @@
 #endif
 
 #include "magma_internal.h"
+#include "trace.h"
 #include "magma_timer.h"
 
 #ifdef __cplusplus
@@ -354,6 +355,8 @@ magma_dlaex3_m(
         for (i = ib; i < ie; ++i)
             dlamda[i]=lapackf77_dlamc3(&dlamda[i], &dlamda[i]) - dlamda[i];
 
+        trace_thread_index( "OpenMP thread", id );
+        trace_cpu_start( "laex3", "secular equation" );
         for (j = ib; j < ie; ++j) {
             magma_int_t tmpp=j+1;
             magma_int_t iinfo = 0;
@@ -365,6 +368,7 @@ magma_dlaex3_m(
                 break;
             }
         }
+        trace_cpu_end();
 
         #pragma omp barrier
 
@@ -440,6 +444,7 @@ magma_dlaex3_m(
                 }
 
                 // Compute eigenvectors of the modified rank-1 modification.
+                trace_cpu_start( "laex3", "eigenvectors" );
                 for (j = ib; j < ie; ++j) {
                     for (i = 0; i < k; ++i)
                         s[id*k + i] = w[i] / *Q(i,j);
@@ -449,6 +454,7 @@ magma_dlaex3_m(
                         *Q(i,j) = s[id*k + iii] / temp;
                     }
                 }
+                trace_cpu_end();
             }
         }
     }  // end omp parallel
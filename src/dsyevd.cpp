@@ -274,6 +274,7 @@ magma_dsyevd(
 
     timer_stop( time );
     timer_printf( "time dsytrd = %6.2f\n", time );
+    timer_record( "dsyevd", "dsytrd", time );
 
     /* For eigenvalues only, call DSTERF.  For eigenvectors, first call
        DSTEDC to generate the eigenvector matrix, WORK(INDWRK), of the
@@ -284,6 +285,7 @@ magma_dsyevd(
         lapackf77_dsterf( &n, w, &work[inde], info );
         timer_stop( time );
         timer_printf( "time dsterf = %6.2f\n", time );
+        timer_record( "dsyevd", "dsterf", time );
     }
     else {
         timer_start( time );
@@ -302,6 +304,7 @@ magma_dsyevd(
 
         timer_stop( time );
         timer_printf( "time dstedx = %6.2f\n", time );
+        timer_record( "dsyevd", "dstedx", time );
         timer_start( time );
 
         magma_dormtr( MagmaLeft, uplo, MagmaNoTrans, n, n, A, lda, &work[indtau],
@@ -311,6 +314,7 @@ magma_dsyevd(
 
         timer_stop( time );
         timer_printf( "time dormtr + copy = %6.2f\n", time );
+        timer_record( "dsyevd", "dormtr", time );
     }
 
     /* If matrix was scaled, then rescale eigenvalues appropriately. */
@@ -10,6 +10,8 @@
 
        @precisions normal d -> s
 */
+#include <vector>
+
 #include "thread_queue.hpp"
 #include "magma_timer.h"
 
@@ -17,6 +19,32 @@
 
 #define REAL
 
+// ---------------------------------------------
+// adds time t to sum, which tasks on several threads update.
+// If timers are off, does nothing.
+static inline void magma_dtrevc3_timer_add(
+    std::atomic< magma_timer_t >* sum, magma_timer_t t )
+{
+    if ( timer_enabled() && sum != NULL ) {
+        magma_timer_t old = sum->load();
+        while ( ! sum->compare_exchange_weak( old, old + t )) {}
+    }
+}
+
+
+// ---------------------------------------------
+// records a nonzero info from a task in iinfo, keeping the first one,
+// so dtrevc3_mt can return it after the tasks complete.
+static inline void magma_dtrevc3_info_set(
+    std::atomic< magma_int_t >* iinfo, magma_int_t info )
+{
+    magma_int_t zero = 0;
+    if ( info != 0 ) {
+        iinfo->compare_exchange_strong( zero, info );
+    }
+}
+
+
 // ---------------------------------------------
 // stores arguments and executes call to dlaqtrsd (on CPU)
 class magma_dlaqtrsd_task: public magma_task
@@ -26,7 +54,8 @@ public:
         magma_trans_t in_trans, magma_int_t in_n,
         const double *in_T, magma_int_t in_ldt,
         double       *in_x, magma_int_t in_incx,
-        const double *in_cnorm
+        const double *in_cnorm,
+        std::atomic< magma_int_t >* in_iinfo
     ):
         trans( in_trans ),
         n    ( in_n     ),
@@ -34,16 +63,15 @@ public:
         ldt  ( in_ldt   ),
         x    ( in_x     ),
         incx ( in_incx  ),
-        cnorm( in_cnorm )
+        cnorm( in_cnorm ),
+        iinfo( in_iinfo )
     {}
     
     virtual void run()
     {
         magma_int_t info = 0;
         magma_dlaqtrsd( trans, n, T, ldt, x, incx, cnorm, &info );
-        if ( info != 0 ) {
-            fprintf( stderr, "dlaqtrsd info %lld\n", (long long) info );
-        }
+        magma_dtrevc3_info_set( iinfo, info );
     }
     
 private:
@@ -54,6 +82,7 @@ private:
     double       *x;
     magma_int_t   incx;
     const double *cnorm;
+    std::atomic< magma_int_t >* iinfo;
 };
 
 
@@ -71,7 +100,8 @@ public:
         const double *in_A, magma_int_t in_lda,
         const double *in_B, magma_int_t in_ldb,
         double  in_beta,
-        double *in_C, magma_int_t in_ldc
+        double *in_C, magma_int_t in_ldc,
+        std::atomic< magma_timer_t >* in_time_sum = NULL
     ):
         transA( in_transA ),
         transB( in_transB ),
@@ -85,13 +115,17 @@ public:
         ldb   ( in_ldb    ),
         beta  ( in_beta   ),
         C     ( in_C      ),
-        ldc   ( in_ldc    )
+        ldc   ( in_ldc    ),
+        time_sum( in_time_sum )
     {}
     
     virtual void run()
     {
+        magma_timer_t time=0;
+        timer_start( time );
         blasf77_dgemm( lapack_trans_const(transA), lapack_trans_const(transB),
                        &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc );
+        magma_dtrevc3_timer_add( time_sum, timer_stop( time ));
     }
     
 private:
@@ -108,6 +142,140 @@ private:
     double        beta;
     double       *C;
     magma_int_t   ldc;
+    std::atomic< magma_timer_t >* time_sum;
+};
+
+
+// ---------------------------------------------
+// solves for eigenvector ki with dlaqtrsd (on CPU), and zeros the rest of
+// its ncol columns (2 for a complex eigenvector), as the unblocked code does
+// in the master thread. x points to row 0 of the columns, with leading
+// dimension n.
+// For trans = MagmaNoTrans (right), solves for x(0:ki,:), zeros x(ki+1:n-1,:).
+// For trans = MagmaTrans   (left),  solves for x(ki:n-1,:), zeros x(0:ki-1,:).
+class magma_dtrevc3_solve_task: public magma_task
+{
+public:
+    magma_dtrevc3_solve_task(
+        magma_trans_t in_trans, magma_int_t in_n, magma_int_t in_ki,
+        magma_int_t in_ncol,
+        const double *in_T, magma_int_t in_ldt,
+        double       *in_x,
+        const double *in_cnorm,
+        std::atomic< magma_int_t >* in_iinfo,
+        std::atomic< magma_timer_t >* in_time_sum
+    ):
+        trans( in_trans ),
+        n    ( in_n     ),
+        ki   ( in_ki    ),
+        ncol ( in_ncol  ),
+        T    ( in_T     ),
+        ldt  ( in_ldt   ),
+        x    ( in_x     ),
+        cnorm( in_cnorm ),
+        iinfo( in_iinfo ),
+        time_sum( in_time_sum )
+    {}
+    
+    virtual void run()
+    {
+        magma_timer_t time=0;
+        magma_int_t info = 0;
+        magma_int_t j, k;
+        
+        timer_start( time );
+        if ( trans == MagmaNoTrans ) {
+            magma_dlaqtrsd( MagmaNoTrans, ki+1, T, ldt, x, n, cnorm, &info );
+            for( j=0; j < ncol; ++j ) {
+                for( k=ki + 1; k < n; ++k ) {
+                    x[ k + j*n ] = 0;
+                }
+            }
+        }
+        else {
+            magma_dlaqtrsd( MagmaTrans, n-ki, &T[ ki + ki*ldt ], ldt,
+                            &x[ki], n, &cnorm[ki], &info );
+            for( j=0; j < ncol; ++j ) {
+                for( k=0; k < ki; ++k ) {
+                    x[ k + j*n ] = 0;
+                }
+            }
+        }
+        magma_dtrevc3_info_set( iinfo, info );
+        magma_dtrevc3_timer_add( time_sum, timer_stop( time ));
+    }
+    
+private:
+    magma_trans_t trans;
+    magma_int_t   n;
+    magma_int_t   ki;
+    magma_int_t   ncol;
+    const double *T;
+    magma_int_t   ldt;
+    double       *x;
+    const double *cnorm;
+    std::atomic< magma_int_t >* iinfo;
+    std::atomic< magma_timer_t >* time_sum;
+};
+
+
+// ---------------------------------------------
+// normalizes back-transformed eigenvector y so that the element of largest
+// magnitude has magnitude 1, and copies it to v (on CPU).
+// A complex eigenvector has ncol = 2 columns, real and imaginary parts,
+// and is normalized by max |re| + |im|.
+class magma_dtrevc3_normalize_task: public magma_task
+{
+public:
+    magma_dtrevc3_normalize_task(
+        magma_int_t in_n, magma_int_t in_ncol,
+        double *in_y,
+        double *in_v, magma_int_t in_ldv,
+        std::atomic< magma_timer_t >* in_time_sum
+    ):
+        n    ( in_n     ),
+        ncol ( in_ncol  ),
+        y    ( in_y     ),
+        v    ( in_v     ),
+        ldv  ( in_ldv   ),
+        time_sum( in_time_sum )
+    {}
+    
+    virtual void run()
+    {
+        const magma_int_t ione = 1;
+        magma_timer_t time=0;
+        double emax, remax;
+        magma_int_t ii, j;
+        
+        timer_start( time );
+        if ( ncol == 1 ) {
+            // real eigenvector
+            ii = blasf77_idamax( &n, y, &ione ) - 1;  // subtract 1; ii is 0-based
+            remax = 1. / fabs( y[ii] );
+        }
+        else {
+            // conjugate pair
+            emax = 0;
+            for( ii=0; ii < n; ++ii ) {
+                emax = max( emax, fabs( y[ii] ) + fabs( y[ii + n] ) );
+            }
+            remax = 1. / emax;
+        }
+        for( j=0; j < ncol; ++j ) {
+            blasf77_dscal( &n, &remax, &y[ j*n ], &ione );
+            blasf77_dcopy( &n, &y[ j*n ], &ione, &v[ j*ldv ], &ione );
+        }
+        magma_dtrevc3_timer_add( time_sum, timer_stop( time ));
+    }
+    
+private:
+    magma_int_t   n;
+    magma_int_t   ncol;
+    double       *y;
+    double       *v;
+    magma_int_t   ldv;
+    std::atomic< magma_timer_t >* time_sum;
 };
 
 
@@ -135,7 +303,11 @@ private:
     left eigenvectors of A.
 
     This uses a Level 3 BLAS version of the back transformation.
-    This uses a multi-threaded (mt) implementation.
+    This uses a multi-threaded (mt) implementation: the triangular solves
+    for a block of eigenvectors run in parallel, and the back-transformation
+    of each block is split into several gemm tasks. With enough workspace,
+    the solves for the next block overlap the back-transformation of the
+    current block.
 
     Arguments
     ---------
@@ -241,12 +413,15 @@ private:
     lwork    INTEGER
              The dimension of array work. lwork >= max(1,3*n).
              For optimum performance, lwork >= (1 + 2*nb)*n, where nb is
-             the optimal blocksize.
+             the optimal blocksize. When back-transforming
+             (howmany = MagmaBacktransVec), lwork >= (1 + 3*nb)*n
+             overlaps the triangular solves with the back-transformation.
 
     @param[out]
     info     INTEGER
        -     = 0:  successful exit
-       -     < 0:  if info = -i, the i-th argument had an illegal value
+       -     < 0:  if info = -i, the i-th argument had an illegal value,
+                   or a triangular solve (dlaqtrsd) returned info = -i
 
     Further Details
     ---------------
@@ -291,6 +466,7 @@ magma_int_t magma_dtrevc3_mt(
     magma_int_t allv, bothv, leftv, over, pair, rightv, somev;
     magma_int_t i, ii, ip, is, j, k, ki, ki2,
                 iv, n2, nb, nb2, version;
+    magma_int_t nxbuf, xbuf, xoff, yoff;
     double emax, remax;
     
     // .. Local Arrays ..
@@ -374,13 +550,19 @@ magma_int_t magma_dtrevc3_mt(
     
     // Use blocked version (2) if sufficient workspace.
     // Requires 1 vector for 1-norms, and 2*nb vectors for x and Q*x.
+    // If back-transforming with 3*nb vectors, x is double buffered (nxbuf = 2),
+    // so the solves for the next block can run during the gemm of this block.
     // Zero-out the workspace to avoid potential NaN propagation.
     nb = 2;
+    nxbuf = 1;
+    if ( over && lwork >= n + 3*n*nbmin ) {
+        nxbuf = 2;
+    }
     if ( lwork >= n + 2*n*nbmin ) {
         version = 2;
-        nb = (lwork - n) / (2*n);
+        nb = (lwork - n) / ((1 + nxbuf)*n);
         nb = min( nb, nbmax );
-        nb2 = 1 + 2*nb;
+        nb2 = 1 + (1 + nxbuf)*nb;
         lapackf77_dlaset( "F", &n, &nb2, &c_zero, &c_zero, work, &n );
     }
     else {
@@ -397,7 +579,7 @@ magma_int_t magma_dtrevc3_mt(
         }
     }
         
-    // launch threads -- each single-threaded MKL
+    // use nthread threads of the shared pool -- each single-threaded MKL
     magma_int_t nthread = magma_get_parallel_numthreads();
     magma_int_t lapack_nthread = magma_get_lapack_numthreads();
     magma_set_lapack_numthreads( 1 );
@@ -412,8 +594,23 @@ magma_int_t magma_dtrevc3_mt(
         gemm_nb += 32;
     }
     
-    magma_timer_t time_total=0, time_trsv=0, time_gemm=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
+    magma_timer_t time_total=0, time_trsv=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
     timer_start( time_total );
+    
+    // Blocked version of back-transform is pipelined through task dependencies
+    // instead of syncs: the solves of a block wait for the gemm of the last block
+    // that used the same x buffer; the gemm waits for the solves of its block
+    // and for the previous block's normalize tasks to release Q*x.
+    // Columns 1:nb of work are x buffer 0, nb+1:2*nb x buffer 1 (if nxbuf = 2),
+    // and the last nb columns Q*x. Tasks sum their time per phase; with
+    // overlap, these are thread-seconds rather than elapsed time.
+    std::vector< magma_task_handle > solve_tasks, normalize_tasks, gemm_tasks, deps;
+    std::vector< magma_task_handle > xbuf_tasks[2];
+    std::atomic< magma_timer_t > time_trsv_task( 0 ), time_gemm_task( 0 ), time_norm_task( 0 );
+    std::atomic< magma_int_t > iinfo( 0 );
+    xbuf = 0;
+    xoff = 0;
+    yoff = nxbuf*nb;
 
     // Index ip is used to specify the real or complex eigenvalue:
     // ip =  0, real eigenvalue (wr),
@@ -469,13 +666,87 @@ magma_int_t magma_dtrevc3_mt(
                 }
             }
 
+            if ( over && version == 2 ) {
+                // ------------------------------------------------------------
+                // version 2: blocked back-transform, pipelined.
+                // Task solves for vector ki and zeros below it.
+                // For complex case, ki2 includes both vectors (ki-1 and ki)
+                if ( ip == 0 ) {
+                    ki2 = ki;
+                    iscomplex[ iv ] = ip;
+                }
+                else {
+                    ki2 = ki - 1;
+                    iscomplex[ iv-1 ] = -ip;
+                    iscomplex[ iv   ] =  ip;
+                    iv -= 1;
+                }
+                solve_tasks.push_back( queue.push_task(
+                    new magma_dtrevc3_solve_task(
+                        MagmaNoTrans, n, ki, (ip == 0 ? 1 : 2), T(0,0), ldt,
+                        work(0,xoff+iv), work(0,0), &iinfo, &time_trsv_task ),
+                    xbuf_tasks[xbuf].data(), xbuf_tasks[xbuf].size() ));
+
+                // Columns iv:nb of x buffer are valid vectors.
+                // When the number of vectors stored reaches nb-1 or nb,
+                // or if this was last vector, do the GEMM
+                if ( (iv <= 2) || (ki2 == 0) ) {
+                    nb2 = nb-iv+1;
+                    n2  = ki2+nb-iv+1;
+                    
+                    // split gemm into multiple tasks, each doing one block row
+                    deps = solve_tasks;
+                    deps.insert( deps.end(), normalize_tasks.begin(), normalize_tasks.end() );
+                    gemm_tasks.clear();
+                    for( i=0; i < n; i += gemm_nb ) {
+                        magma_int_t ib = min( gemm_nb, n-i );
+                        gemm_tasks.push_back( queue.push_task(
+                            new dgemm_task(
+                                MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
+                                VR(i,0), ldvr,
+                                work(0,xoff+iv), n, c_zero,
+                                work(i,yoff+iv), n, &time_gemm_task ),
+                            deps.data(), deps.size() ));
+                    }
+
+                    // normalize vectors and copy to VR;
+                    // a conjugate pair (iscomplex 1, -1) is one task
+                    // TODO if somev, should copy vectors individually to correct location.
+                    normalize_tasks.clear();
+                    for( k=iv; k <= nb; ++k ) {
+                        if ( iscomplex[k] >= 0 ) {
+                            normalize_tasks.push_back( queue.push_task(
+                                new magma_dtrevc3_normalize_task(
+                                    n, (iscomplex[k] == 0 ? 1 : 2), work(0,yoff+k),
+                                    VR(0,ki2+k-iv), ldvr, &time_norm_task ),
+                                gemm_tasks.data(), gemm_tasks.size() ));
+                        }
+                    }
+
+                    // next block uses the other x buffer
+                    xbuf_tasks[xbuf] = gemm_tasks;
+                    solve_tasks.clear();
+                    xbuf = (xbuf + 1) % nxbuf;
+                    xoff = xbuf*nb;
+                    iv = nb;
+                }
+                else {
+                    iv -= 1;
+                }
+                is -= 1;
+                if ( ip != 0 ) {
+                    is -= 1;
+                }
+                continue;
+            }
+
             if ( ip == 0 ) {
                 // ------------------------------------------------------------
                 // Real right eigenvector
                 // Solve upper quasi-triangular system:
                 // [ T(0:ki-1,0:ki-1) - wr ]*X = -T(0:ki-1,ki)
                 queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv), n, work(0,0) ));
+                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv), n, work(0,0), &iinfo ));
                 
                 // Copy the vector x or Q*x to VR and normalize.
                 if ( ! over ) {
@@ -512,16 +783,6 @@ magma_int_t magma_dtrevc3_mt(
                     blasf77_dscal( &n, &remax, VR(0,ki), &ione );
                     timer_start( time_trsv );
                 }
-                else if ( version == 2 ) {
-                    // ------------------------------
-                    // version 2: back-transform block of vectors with GEMM
-                    // zero out below vector
-                    for( k=ki + 1; k < n; ++k ) {
-                        *work(k,iv) = c_zero;
-                    }
-                    iscomplex[ iv ] = ip;
-                    // back-transform and normalization is done below
-                }
             }  // end real eigenvector
             else {
                 // ------------------------------------------------------------
@@ -529,7 +790,7 @@ magma_int_t magma_dtrevc3_mt(
                 // Solve upper quasi-triangular system:
                 // [ T(0:ki-2,0:ki-2) - (wr+i*wi) ]*x = u
                 queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv-1), n, work(0,0) ));
+                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv-1), n, work(0,0), &iinfo ));
 
                 // Copy the vector x or Q*x to VR and normalize.
                 if ( ! over ) {
@@ -585,88 +846,8 @@ magma_int_t magma_dtrevc3_mt(
                     blasf77_dscal( &n, &remax, VR(0,ki  ), &ione );
                     timer_start( time_trsv );
                 }
-                else if ( version == 2 ) {
-                    // ------------------------------
-                    // version 2: back-transform block of vectors with GEMM
-                    // zero out below vector
-                    for( k=ki + 1; k < n; ++k ) {
-                        *work(k,iv-1) = c_zero;
-                        *work(k,iv  ) = c_zero;
-                    }
-                    iscomplex[ iv-1 ] = -ip;
-                    iscomplex[ iv   ] =  ip;
-                    iv -= 1;
-                    // back-transform and normalization is done below
-                }
             }  // end real or complex vector
 
-            if ( version == 2 ) {
-                // ------------------------------------------------------------
-                // Blocked version of back-transform
-                // For complex case, ki2 includes both vectors (ki-1 and ki)
-                if ( ip == 0 ) {
-                    ki2 = ki;
-                }
-                else {
-                    ki2 = ki - 1;
-                }
-
-                // Columns iv:nb of work are valid vectors.
-                // When the number of vectors stored reaches nb-1 or nb,
-                // or if this was last vector, do the GEMM
-                if ( (iv <= 2) || (ki2 == 0) ) {
-                    queue.sync();
-                    time_trsv_sum += timer_stop( time_trsv );
-                    timer_start( time_gemm );
-                    nb2 = nb-iv+1;
-                    n2  = ki2+nb-iv+1;
-                    
-                    // split gemm into multiple tasks, each doing one block row
-                    for( i=0; i < n; i += gemm_nb ) {
-                        magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new dgemm_task(
-                            MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
-                            VR(i,0), ldvr,
-                            work(0,iv), n, c_zero,
-                            work(i,nb+iv), n ));
-                    }
-                    queue.sync();
-                    time_gemm_sum += timer_stop( time_gemm );
-
-                    // normalize vectors
-                    // TODO if somev, should copy vectors individually to correct location.
-                    for( k=iv; k <= nb; ++k ) {
-                        if ( iscomplex[k] == 0 ) {
-                            // real eigenvector
-                            ii = blasf77_idamax( &n, work(0,nb+k), &ione ) - 1;  // subtract 1; ii is 0-based
-                            remax = c_one / fabs( *work(ii,nb+k) );
-                        }
-                        else if ( iscomplex[k] == 1 ) {
-                            // first eigenvector of conjugate pair
-                            emax = c_zero;
-                            for( ii=0; ii < n; ++ii ) {
-                                emax = max( emax, fabs( *work(ii,nb+k  ) )
-                                                + fabs( *work(ii,nb+k+1) ) );
-                            }
-                            remax = c_one / emax;
-                        // else if iscomplex[k] == -1
-                        //     second eigenvector of conjugate pair
-                        //     reuse same remax as previous k
-                        }
-                        blasf77_dscal( &n, &remax, work(0,nb+k), &ione );
-                    }
-                    nb2 = nb-iv+1;
-                    lapackf77_dlacpy( "F", &n, &nb2,
-                                      work(0,nb+iv), &n,
-                                      VR(0,ki2), &ldvr );
-                    iv = nb;
-                    timer_start( time_trsv );
-                }
-                else {
-                    iv -= 1;
-                }
-            }  // end blocked back-transform
-
             is -= 1;
             if ( ip != 0 ) {
                 is -= 1;
@@ -674,10 +855,6 @@ magma_int_t magma_dtrevc3_mt(
         }
     }
     timer_stop( time_trsv );
-    
-    timer_stop( time_total );
-    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, total %.4f\n",
-                  time_trsv_sum, time_gemm_sum, time_gemv_sum, time_total );
 
     if ( leftv ) {
         // ============================================================
@@ -716,13 +893,85 @@ magma_int_t magma_dtrevc3_mt(
                 }
             }
     
+            if ( over && version == 2 ) {
+                // ------------------------------------------------------------
+                // version 2: blocked back-transform, pipelined.
+                // Task solves for vector ki and zeros above it.
+                // For complex case, (ki2+1) includes both vectors (ki+1) and (ki+2)
+                solve_tasks.push_back( queue.push_task(
+                    new magma_dtrevc3_solve_task(
+                        MagmaTrans, n, ki, (ip == 0 ? 1 : 2), T(0,0), ldt,
+                        work(0,xoff+iv), work(0,0), &iinfo, &time_trsv_task ),
+                    xbuf_tasks[xbuf].data(), xbuf_tasks[xbuf].size() ));
+                if ( ip == 0 ) {
+                    ki2 = ki;
+                    iscomplex[ iv ] = ip;
+                }
+                else {
+                    ki2 = ki + 1;
+                    iscomplex[ iv   ] =  ip;
+                    iscomplex[ iv+1 ] = -ip;
+                    iv += 1;
+                }
+    
+                // Columns 1:iv of x buffer are valid vectors.
+                // When the number of vectors stored reaches nb-1 or nb,
+                // or if this was last vector, do the GEMM
+                if ( (iv >= nb-1) || (ki2 == n-1) ) {
+                    n2 = n-(ki2+1)+iv;
+                    
+                    // split gemm into multiple tasks, each doing one block row
+                    deps = solve_tasks;
+                    deps.insert( deps.end(), normalize_tasks.begin(), normalize_tasks.end() );
+                    gemm_tasks.clear();
+                    for( i=0; i < n; i += gemm_nb ) {
+                        magma_int_t ib = min( gemm_nb, n-i );
+                        gemm_tasks.push_back( queue.push_task(
+                            new dgemm_task(
+                                MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
+                                VL(i,ki2-iv+1), ldvl,
+                                work(ki2-iv+1,xoff+1), n, c_zero,
+                                work(i,yoff+1), n, &time_gemm_task ),
+                            deps.data(), deps.size() ));
+                    }
+                    
+                    // normalize vectors and copy to VL;
+                    // a conjugate pair (iscomplex 1, -1) is one task
+                    normalize_tasks.clear();
+                    for( k=1; k <= iv; ++k ) {
+                        if ( iscomplex[k] >= 0 ) {
+                            normalize_tasks.push_back( queue.push_task(
+                                new magma_dtrevc3_normalize_task(
+                                    n, (iscomplex[k] == 0 ? 1 : 2), work(0,yoff+k),
+                                    VL(0,ki2-iv+k), ldvl, &time_norm_task ),
+                                gemm_tasks.data(), gemm_tasks.size() ));
+                        }
+                    }
+                    
+                    // next block uses the other x buffer
+                    xbuf_tasks[xbuf] = gemm_tasks;
+                    solve_tasks.clear();
+                    xbuf = (xbuf + 1) % nxbuf;
+                    xoff = xbuf*nb;
+                    iv = 1;
+                }
+                else {
+                    iv += 1;
+                }
+                is += 1;
+                if ( ip != 0 ) {
+                    is += 1;
+                }
+                continue;
+            }
+    
             if ( ip == 0 ) {
                 // ------------------------------------------------------------
                 // Real left eigenvector
                 // Solve transposed quasi-triangular system:
                 // [ T(ki+1:n,ki+1:n) - wr ]**T * X = -T(ki+1:n,ki)
                 queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0) ));
+                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0), &iinfo ));
     
                 // Copy the vector x or Q*x to VL and normalize.
                 if ( ! over ) {
@@ -755,17 +1004,6 @@ magma_int_t magma_dtrevc3_mt(
                     remax = c_one / fabs( *VL(ii,ki) );
                     blasf77_dscal( &n, &remax, VL(0,ki), &ione );
                 }
-                else if ( version == 2 ) {
-                    // ------------------------------
-                    // version 2: back-transform block of vectors with GEMM
-                    // zero out above vector
-                    // could go from (ki+1)-NV+1 to ki
-                    for( k=0; k < ki; ++k ) {
-                        *work(k,iv) = c_zero;
-                    }
-                    iscomplex[ iv ] = ip;
-                    // back-transform and normalization is done below
-                }
             }  // end real eigenvector
             else {
                 // ------------------------------------------------------------
@@ -773,7 +1011,7 @@ magma_int_t magma_dtrevc3_mt(
                 // Solve transposed quasi-triangular system:
                 // [ T(ki+2:n,ki+2:n)**T - (wr-i*wi) ]*X = V
                 queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0) ));
+                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0), &iinfo ));
     
                 // Copy the vector x or Q*x to VL and normalize.
                 if ( ! over ) {
@@ -825,81 +1063,8 @@ magma_int_t magma_dtrevc3_mt(
                     blasf77_dscal( &n, &remax, VL(0,ki  ), &ione );
                     blasf77_dscal( &n, &remax, VL(0,ki+1), &ione );
                 }
-                else if ( version == 2 ) {
-                    // ------------------------------
-                    // version 2: back-transform block of vectors with GEMM
-                    // zero out above vector
-                    // could go from (ki+1)-NV+1 to ki
-                    for( k=0; k < ki; ++k ) {
-                        *work(k,iv  ) = c_zero;
-                        *work(k,iv+1) = c_zero;
-                    }
-                    iscomplex[ iv   ] =  ip;
-                    iscomplex[ iv+1 ] = -ip;
-                    iv += 1;
-                    // back-transform and normalization is done below
-                }
             }  // end real or complex eigenvector
     
-            if ( version == 2 ) {
-                // -------------------------------------------------
-                // Blocked version of back-transform
-                // For complex case, (ki2+1) includes both vectors (ki+1) and (ki+2)
-                if ( ip == 0 ) {
-                    ki2 = ki;
-                }
-                else {
-                    ki2 = ki + 1;
-                }
-    
-                // Columns 1:iv of work are valid vectors.
-                // When the number of vectors stored reaches nb-1 or nb,
-                // or if this was last vector, do the GEMM
-                if ( (iv >= nb-1) || (ki2 == n-1) ) {
-                    queue.sync();
-                    n2 = n-(ki2+1)+iv;
-                    
-                    // split gemm into multiple tasks, each doing one block row
-                    for( i=0; i < n; i += gemm_nb ) {
-                        magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new dgemm_task(
-                            MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
-                            VL(i,ki2-iv+1), ldvl,
-                            work(ki2-iv+1,1), n, c_zero,
-                            work(i,nb+1), n ));
-                    }
-                    queue.sync();
-                    // normalize vectors
-                    for( k=1; k <= iv; ++k ) {
-                        if ( iscomplex[k] == 0 ) {
-                            // real eigenvector
-                            ii = blasf77_idamax( &n, work(0,nb+k), &ione ) - 1;  // subtract 1; ii is 0-based
-                            remax = c_one / fabs( *work(ii,nb+k) );
-                        }
-                        else if ( iscomplex[k] == 1) {
-                            // first eigenvector of conjugate pair
-                            emax = c_zero;
-                            for( ii=0; ii < n; ++ii ) {
-                                emax = max( emax, fabs( *work(ii,nb+k  ) )
-                                                + fabs( *work(ii,nb+k+1) ) );
-                            }
-                            remax = c_one / emax;
-                        // else if iscomplex[k] == -1
-                        //     second eigenvector of conjugate pair
-                        //     reuse same remax as previous k
-                        }
-                        blasf77_dscal( &n, &remax, work(0,nb+k), &ione );
-                    }
-                    lapackf77_dlacpy( "F", &n, &iv,
-                                      work(0,nb+1), &n,
-                                      VL(0,ki2-iv+1), &ldvl );
-                    iv = 1;
-                }
-                else {
-                    iv += 1;
-                }
-            } // blocked back-transform
-    
             is += 1;
             if ( ip != 0 ) {
                 is += 1;
@@ -907,9 +1072,24 @@ magma_int_t magma_dtrevc3_mt(
         }
     }
     
-    // close down threads
+    // wait for remaining tasks; pool threads stay alive for the next call
     queue.quit();
     magma_set_lapack_numthreads( lapack_nthread );
+    if ( iinfo.load() != 0 ) {
+        *info = iinfo.load();
+    }
+    
+    timer_stop( time_total );
+    time_trsv_sum += time_trsv_task.load();
+    time_gemm_sum += time_gemm_task.load();
+    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, normalize %.4f, total %.4f\n",
+                  time_trsv_sum, time_gemm_sum, time_gemv_sum,
+                  time_norm_task.load(), time_total );
+    timer_record( "dtrevc3_mt", "trsv",      time_trsv_sum );
+    timer_record( "dtrevc3_mt", "gemm",      time_gemm_sum );
+    timer_record( "dtrevc3_mt", "gemv",      time_gemv_sum );
+    timer_record( "dtrevc3_mt", "normalize", time_norm_task.load() );
+    timer_record( "dtrevc3_mt", "total",     time_total );
     
     return *info;
 }  // end of DTREVC3
@@ -16,6 +16,13 @@
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
 
+#ifndef MAGMA_NOAFFINITY
+#include "affinity.h"
+#endif
+
+#include "trace.h"
+#include "magma_timer.h"
+
 #define COMPLEX
 
 static void *magma_zapplyQ_parallel_section(void *arg);
@@ -253,9 +260,7 @@ static void *magma_zapplyQ_parallel_section(void *arg)
 
     magma_int_t info;
 
-    #ifdef ENABLE_TIMER
-    real_Double_t timeQcpu=0.0, timeQgpu=0.0;
-    #endif
+    magma_timer_t timeQcpu=0, timeQgpu=0;
 
     magma_int_t n_cpu = ne - n_gpu;
 
@@ -269,76 +274,61 @@ static void *magma_zapplyQ_parallel_section(void *arg)
     affinity_set print_set;
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
-    cpu_set_t old_set, new_set;
-
-    //store current affinity
-    CPU_ZERO(&old_set);
-    sched_getaffinity( 0, sizeof(old_set), &old_set);
-    //set new affinity
-    // bind threads
-    CPU_ZERO(&new_set);
-    CPU_SET(my_core_id, &new_set);
-    sched_setaffinity( 0, sizeof(new_set), &new_set);
+    // bind threads, following the placement policy of $MAGMA_AFFINITY;
+    // the previous affinity is restored when binding goes out of scope
+    affinity_bind binding( my_core_id, allcores_num );
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
 #endif
 #endif
 
+    trace_thread_index( "apply Q2", my_core_id );
+
     if (my_core_id == 0) {
         //=============================================
         //   on GPU on thread 0:
         //    - apply V2*Z(:,1:N_GPU)
         //=============================================
-        #ifdef ENABLE_TIMER
-        timeQgpu = magma_wtime();
-        #endif
+        timer_start( timeQgpu );
         magma_queue_t queue;
         magma_device_t cdev;
         magma_getdevice( &cdev );
         magma_queue_create( cdev, &queue );
 
         magma_zsetmatrix( n, n_gpu, E, lde, dE, ldde, queue );
+        trace_cpu_start( "applyQ", "apply Q2 on GPU" );
         magma_zbulge_applyQ_v2(MagmaLeft, n_gpu, n, nb, Vblksiz, dE, ldde, V, ldv, T, ldt, &info);
+        trace_cpu_end();
 
         magma_queue_destroy( queue );
         
-        #ifdef ENABLE_TIMER
-        timeQgpu = magma_wtime()-timeQgpu;
-        printf("  Finish Q2_GPU GGG timing= %f\n", timeQgpu);
-        #endif
+        timer_stop( timeQgpu );
+        timer_record( "zbulge_back", "apply Q2 gpu", timeQgpu );
+        timer_printf("  Finish Q2_GPU GGG timing= %f\n", timeQgpu);
     } else {
         //=============================================
         //   on CPU on threads 1:allcores_num-1:
         //    - apply V2*Z(:,N_GPU+1:NE)
         //=============================================
-        #ifdef ENABLE_TIMER
         if (my_core_id == 1)
-            timeQcpu = magma_wtime();
-        #endif
+            timer_start( timeQcpu );
 
         magma_int_t n_loc = magma_ceildiv(n_cpu, allcores_num-1);
         magmaDoubleComplex* E_loc = E + (n_gpu+ n_loc * (my_core_id-1))*lde;
         n_loc = min(n_loc,n_cpu - n_loc * (my_core_id-1));
 
+        trace_cpu_start( "applyQ", "apply Q2 on CPU" );
         magma_ztile_bulge_applyQ(my_core_id, MagmaLeft, n_loc, n, nb, Vblksiz, E_loc, lde, V, ldv, TAU, T, ldt);
+        trace_cpu_end();
         pthread_barrier_wait(barrier);
 
-        #ifdef ENABLE_TIMER
         if (my_core_id == 1) {
-            timeQcpu = magma_wtime()-timeQcpu;
-            printf("  Finish Q2_CPU CCC timing= %f\n", timeQcpu);
+            timer_stop( timeQcpu );
+            timer_record( "zbulge_back", "apply Q2 cpu", timeQcpu );
+            timer_printf("  Finish Q2_CPU CCC timing= %f\n", timeQcpu);
         }
-        #endif
     } // END if my_core_id
 
-#ifndef MAGMA_NOAFFINITY
-    //restore old affinity
-    sched_setaffinity(0, sizeof(old_set), &old_set);
-#ifdef PRINTAFFINITY
-    print_set.print_affinity(my_core_id, "restored_affinity");
-#endif
-#endif
-
     return 0;
 }
 
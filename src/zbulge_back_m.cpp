@@ -20,6 +20,9 @@
 #include "affinity.h"
 #endif
 
+#include "trace.h"
+#include "magma_timer.h"
+
 
 #define COMPLEX
 
@@ -238,9 +241,7 @@ static void *magma_zapplyQ_m_parallel_section(void *arg)
 
     magma_int_t info;
 
-    #ifdef ENABLE_TIMER
-    real_Double_t timeQcpu=0.0, timeQgpu=0.0;
-    #endif
+    magma_timer_t timeQcpu=0, timeQgpu=0;
 
     magma_int_t n_cpu = ne - n_gpu;
 
@@ -254,77 +255,54 @@ static void *magma_zapplyQ_m_parallel_section(void *arg)
     affinity_set print_set;
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
-    affinity_set original_set;
-    affinity_set new_set(my_core_id);
-    magma_int_t check  = 0;
-    magma_int_t check2 = 0;
-    // bind threads
-    check = original_set.get_affinity();
-    if (check == 0) {
-        check2 = new_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (single cpu)\n");
-    }
-    else {
-        printf("Error in sched_getaffinity\n");
-    }
+    // bind threads, following the placement policy of $MAGMA_AFFINITY;
+    // the previous affinity is restored when binding goes out of scope
+    affinity_bind binding( my_core_id, allcores_num );
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
 #endif
 #endif
 
+    trace_thread_index( "apply Q2", my_core_id );
+
     if (my_core_id == 0) {
         //=============================================
         //   on GPU on thread 0:
         //    - apply V2*Z(:,1:N_GPU)
         //=============================================
-        #ifdef ENABLE_TIMER
-        timeQgpu = magma_wtime();
-        #endif
+        timer_start( timeQgpu );
 
+        trace_cpu_start( "applyQ", "apply Q2 on GPU" );
         magma_zbulge_applyQ_v2_m(ngpu, MagmaLeft, n_gpu, n, nb, Vblksiz, E, lde, V, ldv, T, ldt, &info);
+        trace_cpu_end();
 
-        #ifdef ENABLE_TIMER
-        timeQgpu = magma_wtime()-timeQgpu;
-        printf("  Finish Q2_GPU GGG timing= %f\n", timeQgpu);
-        #endif
+        timer_stop( timeQgpu );
+        timer_record( "zbulge_back_m", "apply Q2 gpu", timeQgpu );
+        timer_printf("  Finish Q2_GPU GGG timing= %f\n", timeQgpu);
     } else {
         //=============================================
         //   on CPU on threads 1:allcores_num-1:
         //    - apply V2*Z(:,N_GPU+1:NE)
         //=============================================
-        #ifdef ENABLE_TIMER
         if (my_core_id == 1)
-            timeQcpu = magma_wtime();
-        #endif
+            timer_start( timeQcpu );
 
         magma_int_t n_loc = magma_ceildiv(n_cpu, allcores_num-1);
         magmaDoubleComplex* E_loc = E + (n_gpu+ n_loc * (my_core_id-1))*lde;
         n_loc = min(n_loc,n_cpu - n_loc * (my_core_id-1));
 
+        trace_cpu_start( "applyQ", "apply Q2 on CPU" );
         magma_ztile_bulge_applyQ(my_core_id, MagmaLeft, n_loc, n, nb, Vblksiz, E_loc, lde, V, ldv, TAU, T, ldt);
+        trace_cpu_end();
         pthread_barrier_wait(barrier);
 
-        #ifdef ENABLE_TIMER
         if (my_core_id == 1) {
-            timeQcpu = magma_wtime()-timeQcpu;
-            printf("  Finish Q2_CPU CCC timing= %f\n", timeQcpu);
+            timer_stop( timeQcpu );
+            timer_record( "zbulge_back_m", "apply Q2 cpu", timeQcpu );
+            timer_printf("  Finish Q2_CPU CCC timing= %f\n", timeQcpu);
         }
-        #endif
     } // END if my_core_id
 
-#ifndef MAGMA_NOAFFINITY
-    // unbind threads
-    if (check == 0) {
-        check2 = original_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (restore cpu list)\n");
-    }
-#ifdef PRINTAFFINITY
-    print_set.print_affinity(my_core_id, "restored_affinity");
-#endif
-#endif
-
     return 0;
 }
 
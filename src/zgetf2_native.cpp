@@ -84,6 +84,8 @@ magma_zgetf2_native_blocked(
     return 0;
 }
 
+// the fused panel kernels exist only on GPUs
+#if defined(MAGMA_HAVE_CUDA) || defined(MAGMA_HAVE_HIP)
 magma_int_t
 magma_zgetf2_native_recursive(
     magma_int_t m, magma_int_t n,
@@ -182,6 +184,8 @@ magma_zgetf2_native_recursive(
 
     return 0;
 }
+#endif // MAGMA_HAVE_CUDA || MAGMA_HAVE_HIP
+
 /***************************************************************************//**
     Purpose
     -------
@@ -168,7 +168,7 @@ magma_zgetrf2_mgpu(
         /* workspaces */
         d_panel[d] = &(d_lAP[d][h*nb*maxm]);   /* temporary panel storage */
     }
-    trace_init( 1, ngpu, 2, (magma_queue_t *)queues );
+    trace_init( ngpu, 2, (magma_queue_t *)queues );
 
     /* start sending the panel to cpu */
     nb0 = min(mindim, nb);
@@ -200,12 +200,12 @@ magma_zgetrf2_mgpu(
         magma_queue_sync( queues[id][1] );
         
         /* j-th panel factorization */
-        trace_cpu_start( 0, "getrf", "getrf" );
+        trace_cpu_start( "getrf", "getrf" );
         lapackf77_zgetrf( &rows, &nb, W(j), &ldw, ipiv+j*nb, &iinfo);
         if ( (*info == 0) && (iinfo > 0) ) {
             *info = iinfo + j*nb;
         }
-        trace_cpu_end( 0 );
+        trace_cpu_end();
         
         /* start sending the panel to all the gpus */
         d = (j+1) % ngpu;
@@ -452,7 +452,7 @@ magma_zgetrf2_mgpu(
     } /* if ( nb0 > 0 ) */
     
     /* clean up */
-    trace_finalize( "zgetrf_mgpu.svg","trace.css" );
+    trace_finalize();
     for( d=0; d < ngpu; d++ ) {
         magma_setdevice(d);
         magma_queue_sync( queues[d][0] );
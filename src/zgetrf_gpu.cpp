@@ -13,6 +13,43 @@
 
 */
 #include "magma_internal.h"
+#include "trace.h"
+#include "magma_timer.h"
+
+#define MAGMA_COMPLEX
+
+// flops of an m-by-n-by-k gemm, for the trace's flops counter;
+// a trsm with an m-by-n right-hand side is half of gemm( m, n, n )
+static double zgetrf_gemm_flops( magma_int_t m, magma_int_t n, magma_int_t k )
+{
+    #ifdef MAGMA_COMPLEX
+    return 8. * m * n * k;
+    #else
+    return 2. * m * n * k;
+    #endif
+}
+
+// adds the GPU time of a step's updates on queues[1] to time, waiting for them:
+// events[0:1] bracket the trailing update, if the step had one;
+// events[2:3] bracket the next panel update.
+// If timers were off when events were created (NULL), does nothing.
+static void zgetrf_timer_update( magma_event_t* events, bool trailing, magma_timer_t& time )
+{
+    if ( events[0] != NULL ) {
+        if ( trailing ) {
+            time += 1e-3 * magma_event_elapsed( events[0], events[1] );
+        }
+        time += 1e-3 * magma_event_elapsed( events[2], events[3] );
+    }
+}
+
+// records event in queue, if timers created it
+static void zgetrf_timer_event( magma_event_t event, magma_queue_t queue )
+{
+    if ( event != NULL ) {
+        magma_event_record( event, queue );
+    }
+}
 
 /***************************************************************************//**
     Purpose
@@ -327,17 +364,36 @@ magma_zgetrf_expert_gpu_work(
         magma_queue_wait_event( queues[1], events[0] );
     }
 
+    trace_init( 1, 2, queues );
+
+    // phases, for magma_timer_query; see control/magma_timer.cpp
+    magma_timer_t time_panel=0, time_update=0, time_transfer=0, time_wait=0, time;
+    magma_flops_t count_panel=0, count;
+    magma_event_t update_events[4] = { NULL, NULL, NULL, NULL };
+    if ( timer_enabled() ) {
+        for( i=0; i < 4; ++i ) {
+            magma_event_create( &update_events[i] );
+        }
+    }
+
     // main loop
     for( j=0; j < minmn-nb; j += nb ) {
         // get j-th panel from device
         magmablas_ztranspose( nb, m-j, dAT(j,j), lddat, dAP(0,0), maxm, queues[1] );
+        timer_start( time );
         magma_queue_sync( queues[1] );  // wait for transpose
+        time_wait += timer_stop( time );
+        if ( j > 0 ) {
+            zgetrf_timer_update( update_events, j > nb, time_update );
+        }
 
         if (mode == MagmaHybrid) {
             magma_zgetmatrix_async( m-j, nb, dAP(0,0), maxm, work, ldwork, queues[0] );
         }
 
         if ( j > 0 ) {
+            trace_gpu_start( 0, 1, "gemm", "trailing update" );
+            zgetrf_timer_event( update_events[0], queues[1] );
             magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
                          n-(j+nb), nb,
                          c_one, dAT(j-nb, j-nb), lddat,
@@ -347,13 +403,26 @@ magma_zgetrf_expert_gpu_work(
                          c_neg_one, dAT(j-nb, j+nb), lddat,
                                     dAT(j,    j-nb), lddat,
                          c_one,     dAT(j,    j+nb), lddat, queues[1] );
+            zgetrf_timer_event( update_events[1], queues[1] );
+            trace_gpu_end( 0, 1 );
+            trace_counter( "flops", zgetrf_gemm_flops( n-(j+nb), m-j, nb )
+                                    + zgetrf_gemm_flops( n-(j+nb), nb, nb ) / 2 );
         }
 
         rows = m - j;
         if (mode == MagmaHybrid) {
             // do the cpu part
+            timer_start( time );
             magma_queue_sync( queues[0] );  // wait to get work
+            time_transfer += timer_stop( time );
+
+            trace_cpu_start( "getrf", "panel" );
+            timer_start( time );
+            flops_start( count );
             lapackf77_zgetrf( &rows, &nb, work, &ldwork, ipiv+j, &iinfo );
+            count_panel += flops_stop( count );
+            time_panel += timer_stop( time );
+            trace_cpu_end();
             if ( *info == 0 && iinfo > 0 )
                 *info = iinfo + j;
 
@@ -365,17 +434,23 @@ magma_zgetrf_expert_gpu_work(
             }
             magmablas_zlaswp( n, dAT(0,0), lddat, j + 1, j + nb, ipiv, 1, queues[1] );
 
+            timer_start( time );
             magma_queue_sync( queues[0] );  // wait to set dAP
+            time_transfer += timer_stop( time );
         }
         else {
             // do the panel on the GPU
+            trace_gpu_start( 0, 0, "getrf", "panel" );
             magma_zgetrf_recpanel_native( rows, nb, recnb, dAP(0,0), maxm, dipiv+j, dipivinfo, dinfo, j, events, queues[0], queues[1]);
             adjust_ipiv( dipiv+j, nb, j, queues[0]);
+            trace_gpu_end( 0, 0 );
             #ifdef SWP_CHUNK
             magma_igetvector_async( nb, dipiv+j, 1, ipiv+j, 1, queues[0] );
             #endif
 
+            timer_start( time );
             magma_queue_sync( queues[0] );  // wait for the pivot
+            time_wait += timer_stop( time );
             #ifdef SWP_CHUNK
             magmablas_zlaswp( n, dAT(0,0), lddat, j + 1, j + nb, ipiv, 1, queues[1] );
             #else
@@ -385,6 +460,8 @@ magma_zgetrf_expert_gpu_work(
         magmablas_ztranspose( m-j, nb, dAP(0,0), maxm, dAT(j,j), lddat, queues[1] );
 
         // do the small non-parallel computations (next panel update)
+        trace_gpu_start( 0, 1, "gemm", "next panel update" );
+        zgetrf_timer_event( update_events[2], queues[1] );
         if ( j + nb < minmn - nb ) {
             magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
                          nb, nb,
@@ -407,6 +484,15 @@ magma_zgetrf_expert_gpu_work(
                                     dAT(j+nb, j   ), lddat,
                          c_one,     dAT(j+nb, j+nb), lddat, queues[1] );
         }
+        zgetrf_timer_event( update_events[3], queues[1] );
+        trace_gpu_end( 0, 1 );
+        magma_int_t nupdate = ( j + nb < minmn - nb ? nb : n-(j+nb) );
+        trace_counter( "flops", zgetrf_gemm_flops( nupdate, m-(j+nb), nb )
+                                + zgetrf_gemm_flops( nupdate, nb, nb ) / 2 );
+    }
+
+    if ( j > 0 ) {
+        zgetrf_timer_update( update_events, j > nb, time_update );
     }
 
     jb = min( m-j, n-j );
@@ -415,10 +501,16 @@ magma_zgetrf_expert_gpu_work(
 
         magmablas_ztranspose( jb, rows, dAT(j,j), lddat, dAP(0,0), maxm, queues[1] );
         if (mode == MagmaHybrid) {
+            timer_start( time );
             magma_zgetmatrix( rows, jb, dAP(0,0), maxm, work, ldwork, queues[1] );
+            time_transfer += timer_stop( time );
 
             // do the cpu part
+            timer_start( time );
+            flops_start( count );
             lapackf77_zgetrf( &rows, &jb, work, &ldwork, ipiv+j, &iinfo );
+            count_panel += flops_stop( count );
+            time_panel += timer_stop( time );
             if ( *info == 0 && iinfo > 0 )
                 *info = iinfo + j;
 
@@ -428,7 +520,9 @@ magma_zgetrf_expert_gpu_work(
             magmablas_zlaswp( n, dAT(0,0), lddat, j + 1, j + jb, ipiv, 1, queues[1] );
 
             // send j-th panel to device
+            timer_start( time );
             magma_zsetmatrix( rows, jb, work, ldwork, dAP(0,0), maxm, queues[1] );
+            time_transfer += timer_stop( time );
         }
         else {
             magma_zgetrf_recpanel_native( rows, jb, recnb, dAP(0,0), maxm, dipiv+j, dipivinfo, dinfo, j, events, queues[1], queues[0]);
@@ -465,6 +559,20 @@ magma_zgetrf_expert_gpu_work(
         magmablas_ztranspose( n, m, dAT(0,0), lddat, dA(0,0), ldda, queues[1] );
     }
 
+    for( i=0; i < 4; ++i ) {
+        if ( update_events[i] != NULL ) {
+            magma_event_destroy( update_events[i] );
+        }
+    }
+    // the panel is on the CPU only in hybrid mode
+    if ( mode == MagmaHybrid ) {
+        timer_record( "zgetrf_gpu", "panel",    time_panel, count_panel );
+        timer_record( "zgetrf_gpu", "transfer", time_transfer );
+    }
+    timer_record( "zgetrf_gpu", "update",   time_update );
+    timer_record( "zgetrf_gpu", "cpu wait", time_wait );
+
+    trace_finalize();
     return *info;
 } /* magma_zgetrf_expert_gpu_work */
 
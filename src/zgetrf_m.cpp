@@ -375,6 +375,8 @@ magma_zgetrf_m(
             }
             time_get += timer_stop( time );
         } /* end of for */
+        timer_record( "zgetrf_m", "transfer", time_set + time_get );
+        timer_record( "zgetrf_m", "factor",   time_comp );
     
         //timer_stop( time_total );
         //flops = FLOPS_ZGETRF( m, n ) / 1e9;
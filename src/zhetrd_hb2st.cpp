@@ -12,6 +12,9 @@
        @precisions normal z -> s d c
 
 */
+#include <atomic>
+#include <new>
+
 #include "magma_internal.h"
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
@@ -20,8 +23,27 @@
 #include "affinity.h"
 #endif
 
+#include "trace.h"
+#include "magma_timer.h"
+
 #define COMPLEX
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define magma_cpu_relax() __builtin_ia32_pause()
+#else
+#define magma_cpu_relax() ((void) 0)
+#endif
+
+
+/******************************************************************************/
+// Progress of the bulge chasing: flag m holds the last sweep done by task m.
+// Each flag has its own cache line, so threads spinning on one flag do not
+// slow down the thread setting the next one.
+struct magma_bulge_flag {
+    std::atomic< magma_int_t > sweep;
+    char pad[ 64 - sizeof(std::atomic< magma_int_t >) ];
+};
+
 static void *magma_zhetrd_hb2st_parallel_section(void *arg);
 
 static void magma_ztile_bulge_parallel(
@@ -29,8 +51,8 @@ static void magma_ztile_bulge_parallel(
     magmaDoubleComplex *A, magma_int_t lda,
     magmaDoubleComplex *V, magma_int_t ldv,
     magmaDoubleComplex *TAU, magma_int_t n, magma_int_t nb, magma_int_t nbtiles,
-    magma_int_t grsiz, magma_int_t Vblksiz, magma_int_t wantz, 
-    volatile magma_int_t *prog, pthread_barrier_t* myptbarrier);
+    magma_int_t grsiz, magma_int_t colblktile, magma_int_t Vblksiz, magma_int_t wantz,
+    magma_bulge_flag *prog, pthread_barrier_t* myptbarrier);
 
 static void magma_ztile_bulge_computeT_parallel(
     magma_int_t my_core_id, magma_int_t cores_num,
@@ -46,6 +68,7 @@ typedef struct magma_zbulge_data_s {
     magma_int_t nb;
     magma_int_t nbtiles;
     magma_int_t grsiz;
+    magma_int_t colblktile;
     magma_int_t Vblksiz;
     magma_int_t wantz;
     magmaDoubleComplex* A;
@@ -55,7 +78,7 @@ typedef struct magma_zbulge_data_s {
     magmaDoubleComplex* TAU;
     magmaDoubleComplex* T;
     magma_int_t ldt;
-    volatile magma_int_t *prog;
+    magma_bulge_flag *prog;
     pthread_barrier_t myptbarrier;
 } magma_zbulge_data;
 
@@ -64,17 +87,18 @@ typedef struct magma_zbulge_data_s {
 void magma_zbulge_data_init(
     magma_zbulge_data *zbulge_data_S,
     magma_int_t threads_num, magma_int_t n, magma_int_t nb, magma_int_t nbtiles,
-    magma_int_t grsiz, magma_int_t Vblksiz, magma_int_t wantz,
+    magma_int_t grsiz, magma_int_t colblktile, magma_int_t Vblksiz, magma_int_t wantz,
     magmaDoubleComplex *A, magma_int_t lda,
     magmaDoubleComplex *V, magma_int_t ldv, magmaDoubleComplex *TAU,
     magmaDoubleComplex *T, magma_int_t ldt,
-    volatile magma_int_t* prog)
+    magma_bulge_flag* prog)
 {
     zbulge_data_S->threads_num = threads_num;
     zbulge_data_S->n = n;
     zbulge_data_S->nb = nb;
     zbulge_data_S->nbtiles = nbtiles;
     zbulge_data_S->grsiz = grsiz;
+    zbulge_data_S->colblktile = colblktile;
     zbulge_data_S->Vblksiz = Vblksiz;
     zbulge_data_S->wantz = wantz;
     zbulge_data_S->A = A;
@@ -192,9 +216,7 @@ magma_zhetrd_hb2st(
     magmaDoubleComplex *V, magma_int_t ldv, magmaDoubleComplex *TAU,
     magma_int_t wantz, magmaDoubleComplex *T, magma_int_t ldt)
 {
-    #ifdef ENABLE_TIMER
-    real_Double_t timeblg=0.0;
-    #endif
+    magma_timer_t timeblg=0;
 
     magma_int_t parallel_threads = magma_get_parallel_numthreads();
     magma_int_t mklth   = magma_get_lapack_numthreads();
@@ -211,11 +233,21 @@ magma_zhetrd_hb2st(
     memset(TAU, 0, sizTAU2*sizeof(magmaDoubleComplex));
     memset(V,   0, sizV2*sizeof(magmaDoubleComplex));
 
+    // on-host tuned thread count and tiles per core, if any;
+    // 0 means use the heuristic
+    magma_int_t tuned_Vblksiz, colblktile = 0, tuned_threads = 0;
+    magma_bulge_get_tuning( "zhetrd_hb2st", n, nb, &tuned_Vblksiz, &colblktile, &tuned_threads );
+    if (tuned_threads > 0)
+        parallel_threads = min( parallel_threads, tuned_threads );
+
     magma_int_t INgrsiz=1;
     magma_int_t nbtiles = magma_ceildiv(n, nb);
-    volatile magma_int_t* prog;
-    magma_malloc_cpu((void**) &prog, (2*nbtiles+parallel_threads+10)*sizeof(magma_int_t));
-    memset((void *) prog, 0, (2*nbtiles+parallel_threads+10)*sizeof(magma_int_t));
+    magma_int_t nflag = 2*nbtiles+parallel_threads+10;
+    magma_bulge_flag* prog;
+    magma_malloc_cpu((void**) &prog, nflag*sizeof(magma_bulge_flag));
+    for (magma_int_t i=0; i < nflag; i++) {
+        new (&prog[i].sweep) std::atomic< magma_int_t >( 0 );
+    }
 
     magma_zbulge_id_data* arg;
     magma_malloc_cpu((void**) &arg, parallel_threads*sizeof(magma_zbulge_id_data));
@@ -225,7 +257,7 @@ magma_zhetrd_hb2st(
     pthread_attr_t thread_attr;
 
     magma_zbulge_data data_bulge;
-    magma_zbulge_data_init(&data_bulge, parallel_threads, n, nb, nbtiles, INgrsiz, Vblksiz, wantz,
+    magma_zbulge_data_init(&data_bulge, parallel_threads, n, nb, nbtiles, INgrsiz, colblktile, Vblksiz, wantz,
                                  A, lda, V, ldv, TAU, T, ldt, prog);
 
     // Set one thread per core
@@ -234,9 +266,7 @@ magma_zhetrd_hb2st(
     pthread_setconcurrency( (unsigned)parallel_threads );
 
     //timing
-    #ifdef ENABLE_TIMER
-    timeblg = magma_wtime();
-    #endif
+    timer_start( timeblg );
 
     // Launch threads
     for (magma_int_t thread = 1; thread < parallel_threads; thread++) {
@@ -253,10 +283,9 @@ magma_zhetrd_hb2st(
     }
 
     // timing
-    #ifdef ENABLE_TIMER
-    timeblg = magma_wtime()-timeblg;
-    printf("  time BULGE+T = %f\n", timeblg);
-    #endif
+    timer_stop( timeblg );
+    timer_record( "zhetrd_hb2st", "bulge+T", timeblg );
+    timer_printf("  time BULGE+T = %f\n", timeblg);
 
     magma_free_cpu(thread_id);
     magma_free_cpu(arg);
@@ -327,6 +356,7 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     magma_int_t nb             = data -> nb;
     magma_int_t nbtiles        = data -> nbtiles;
     magma_int_t grsiz          = data -> grsiz;
+    magma_int_t colblktile     = data -> colblktile;
     magma_int_t Vblksiz        = data -> Vblksiz;
     magma_int_t wantz          = data -> wantz;
     magmaDoubleComplex *A      = data -> A;
@@ -336,15 +366,13 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     magmaDoubleComplex *TAU    = data -> TAU;
     magmaDoubleComplex *T      = data -> T;
     magma_int_t ldt            = data -> ldt;
-    volatile magma_int_t* prog = data -> prog;
+    magma_bulge_flag* prog     = data -> prog;
 
     pthread_barrier_t* myptbarrier = &(data -> myptbarrier);
 
     //magma_int_t sys_corenbr    = 1;
 
-    #ifdef ENABLE_TIMER
-    real_Double_t timeB=0.0, timeT=0.0;
-    #endif
+    magma_timer_t timeB=0, timeT=0;
 
     // with MKL and when using omp_set_num_threads instead of mkl_set_num_threads
     // it need that all threads setting it to 1.
@@ -371,25 +399,16 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     affinity_set print_set;
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
-    affinity_set original_set;
-    affinity_set new_set(my_core_id);
-    magma_int_t check  = 0;
-    magma_int_t check2 = 0;
-    // bind threads
-    check = original_set.get_affinity();
-    if (check == 0) {
-        check2 = new_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (single cpu)\n");
-    }
-    else {
-        printf("Error in sched_getaffinity\n");
-    }
+    // bind threads, following the placement policy of $MAGMA_AFFINITY;
+    // the previous affinity is restored when binding goes out of scope
+    affinity_bind binding( my_core_id, allcores_num );
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
 #endif
 #endif
 
+    trace_thread_index( "bulge chasing", my_core_id );
+
     /* compute the Q1 overlapped with the bulge chasing+T.
     * if all_cores_num=1 it call Q1 on GPU and then bulgechasing.
     * otherwise the first thread run Q1 on GPU and
@@ -398,130 +417,80 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     //=========================
     //    bulge chasing
     //=========================
-    #ifdef ENABLE_TIMER
     if (my_core_id == 0)
-        timeB = magma_wtime();
-    #endif
+        timer_start( timeB );
 
-    magma_ztile_bulge_parallel(my_core_id, allcores_num, A, lda, V, ldv, TAU, n, nb, nbtiles, grsiz, Vblksiz, wantz, prog, myptbarrier);
+    trace_cpu_start( "bulge", "bulge chasing" );
+    magma_ztile_bulge_parallel(my_core_id, allcores_num, A, lda, V, ldv, TAU, n, nb, nbtiles, grsiz, colblktile, Vblksiz, wantz, prog, myptbarrier);
+    trace_cpu_end();
     if (allcores_num > 1) pthread_barrier_wait(myptbarrier);
 
-    #ifdef ENABLE_TIMER
     if (my_core_id == 0) {
-        timeB = magma_wtime()-timeB;
-        printf("  Finish BULGE   timing= %f\n", timeB);
+        timer_stop( timeB );
+        timer_record( "zhetrd_hb2st", "bulge chasing", timeB );
+        timer_printf("  Finish BULGE   timing= %f\n", timeB);
     }
-    #endif
 
     //=========================
     // compute the T's to be used when applying Q2
     //=========================
     if ( wantz > 0 ) {
-        #ifdef ENABLE_TIMER
         if (my_core_id == 0)
-            timeT = magma_wtime();
-        #endif
+            timer_start( timeT );
        
+        trace_cpu_start( "bulge", "compute T" );
         magma_ztile_bulge_computeT_parallel(my_core_id, allcores_num, V, ldv, TAU, T, ldt, n, nb, Vblksiz);
+        trace_cpu_end();
         if (allcores_num > 1) pthread_barrier_wait(myptbarrier);
        
-        #ifdef ENABLE_TIMER
         if (my_core_id == 0) {
-            timeT = magma_wtime()-timeT;
-            printf("  Finish T's     timing= %f\n", timeT);
+            timer_stop( timeT );
+            timer_record( "zhetrd_hb2st", "compute T", timeT );
+            timer_printf("  Finish T's     timing= %f\n", timeT);
         }
-        #endif
     }
 
-#ifndef MAGMA_NOAFFINITY
-    // unbind threads
-    if (check == 0) {
-        check2 = original_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (restore cpu list)\n");
+    return 0;
+}
+
+
+/******************************************************************************/
+// Waits until task m has done sweep val. The acquire load pairs with the
+// release store in myss_cond_set, so the task's updates of A, V, TAU are
+// visible once the flag is seen. Spins on the core, and only yields it
+// after a while, for when there are more threads than cores.
+static inline void
+myss_cond_wait( magma_bulge_flag *prog, magma_int_t m, magma_int_t val )
+{
+    magma_int_t spin = 0;
+    while (prog[m].sweep.load( std::memory_order_acquire ) < val) {
+        if (++spin < 64) {
+            magma_cpu_relax();
+        }
+        else {
+            magma_yield();
+        }
     }
-#ifdef PRINTAFFINITY
-    print_set.print_affinity(my_core_id, "restored_affinity");
-#endif
-#endif
+}
 
-    return 0;
+static inline void
+myss_cond_set( magma_bulge_flag *prog, magma_int_t m, magma_int_t val )
+{
+    prog[m].sweep.store( val, std::memory_order_release );
 }
 
 
 /******************************************************************************/
-#define expertmyss_cond_wait(m, n, val) \
-do { \
-    while (prog[(m)] != (val)) { \
-        magma_yield(); \
-    } \
-    for (kk=0; kk < 100; kk++) { \
-        __asm__ volatile ("nop;" :::); \
-    } \
-} while(0)
-
-// __asm__ volatile ("" ::: "memory") is a compiler fence (but not a hardware memory fence),
-// to prohibit load/store reordering across that point.
-// However, inline assemble (asm) isn't available on Microsoft VS x64.
-#define expertmyss_cond_set(m, n, val) \
-do { \
-    prog[(m)*(64/sizeof(magma_int_t))] = (val); \
-    __asm__ volatile ("" ::: "memory"); \
-} while(0)
-
-#define expertmyss_init(m, n, init_val) \
-do { \
-    if (my_core_id == 0) { \
-        magma_malloc_cpu((void**) &prog, ( (m)*(64/sizeof(int)) ) * sizeof(magma_int_t)); \
-        memset((magma_int_t*)prog, 0, (m)*(64/sizeof(magma_int_t))); \
-    } \
-    pthread_barrier_init(&myptbarrier, NULL, cores_num); \
-    pthread_barrier_wait(&myptbarrier); \
-    barrier(my_core_id, cores_num); \
-} while(0)
-
-#define expertmyss_finalize() \
-do { \
-    pthread_barrier_wait(&myptbarrier); \
-    pthread_barrier_destroy(&myptbarrier); \
-    barrier(my_core_id, cores_num); \
-    if (my_core_id == 0) { \
-        magma_free_cpu((void *) prog); \
-    } \
-} while(0)
-
-
-
-// see also __asm__ volatile ("" ::: "memory") in expertmyss_cond_set above
-#define myss_cond_set(m, n, val) \
-do { \
-    prog[(m)] = (val); \
-} while(0)
-
-#define myss_cond_wait(m, n, val) \
-do { \
-    while (prog[(m)] != (val)) \
-    { \
-        magma_yield(); \
-    } \
-} while(0)
-
-#define myss_init(m, n, init_val) \
-do { \
-    if (my_core_id == 0) { \
-        magma_malloc_cpu((void**) &prog,  (m) * sizeof(magma_int_t)); \
-        memset((magma_int_t*)prog, 0, (m)); \
-    } \
-    pthread_barrier_wait(myptbarrier); \
-} while(0)
-
-#define myss_finalize() \
-do { \
-    pthread_barrier_wait(myptbarrier); \
-    if (my_core_id == 0) { \
-        magma_free_cpu((void *) prog); \
-    } \
-} while(0)
+// Size of the L2 cache of one core in bytes; 256 KiB if unknown.
+static size_t
+magma_bulge_l2_size()
+{
+    long l2 = 0;
+    #ifdef _SC_LEVEL2_CACHE_SIZE
+    l2 = sysconf( _SC_LEVEL2_CACHE_SIZE );
+    #endif
+    return (l2 > 0 ? size_t(l2) : 256*1024);
+}
 
 
 /******************************************************************************/
@@ -530,8 +499,8 @@ static void magma_ztile_bulge_parallel(
     magmaDoubleComplex *A, magma_int_t lda,
     magmaDoubleComplex *V, magma_int_t ldv,
     magmaDoubleComplex *TAU, magma_int_t n, magma_int_t nb, magma_int_t nbtiles,
-    magma_int_t grsiz, magma_int_t Vblksiz, magma_int_t wantz, 
-    volatile magma_int_t *prog, pthread_barrier_t* myptbarrier)
+    magma_int_t grsiz, magma_int_t colblktile, magma_int_t Vblksiz, magma_int_t wantz,
+    magma_bulge_flag *prog, pthread_barrier_t* myptbarrier)
 {
     magma_int_t sweepid, myid, shift, stt, st, ed, stind, edind;
     magma_int_t blklastind, colpt;
@@ -539,7 +508,7 @@ static void magma_ztile_bulge_parallel(
     magma_int_t i, j, m, k;
     magma_int_t thgrsiz, thgrnb, thgrid, thed;
     magma_int_t coreid;
-    magma_int_t colblktile, maxrequiredcores, colpercore, allcoresnb;
+    magma_int_t maxrequiredcores, colpercore, allcoresnb;
     magmaDoubleComplex *work;
 
     if (n <= 0)
@@ -569,10 +538,16 @@ static void magma_ztile_bulge_parallel(
         shift = 3; /* it was 5 before see above for explanation*/
     }
 
-    if ( grsiz == 1 )
-        colblktile = 1;
-    else
-        colblktile = grsiz/2;
+    /* Each core owns groups of colblktile consecutive tiles of the band,
+     * and every sweep passes through them. Size the group so that its part
+     * of the band fits into L2, so consecutive sweeps find it in cache
+     * instead of moving it between cores, but keep enough groups for all
+     * cores. An on-host tuned colblktile > 0 is used as is. */
+    if (colblktile <= 0) {
+        colblktile = magma_int_t( magma_bulge_l2_size() / (nb*lda*sizeof(magmaDoubleComplex)) );
+        colblktile = min( colblktile, nbtiles/cores_num );
+    }
+    colblktile = max( 1, min( colblktile, nbtiles ));
 
     maxrequiredcores = max( nbtiles/colblktile, 1 );
     colpercore = colblktile*nb;
@@ -629,26 +604,26 @@ static void magma_ztile_bulge_parallel(
 
                         if (my_core_id == coreid) {
                             if (myid == 1) {
-                                myss_cond_wait(myid+shift-1, 0, sweepid-1);
+                                myss_cond_wait( prog, myid+shift-1, sweepid-1 );
                                 magma_zhbtype1cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
-                                myss_cond_set(myid, 0, sweepid);
+                                myss_cond_set( prog, myid, sweepid );
 
                                 if (blklastind >= (n-1)) {
                                     for (j = 1; j <= shift; j++)
-                                        myss_cond_set(myid+j, 0, sweepid);
+                                        myss_cond_set( prog, myid+j, sweepid );
                                 }
                             } else {
-                                myss_cond_wait(myid-1,       0, sweepid);
-                                myss_cond_wait(myid+shift-1, 0, sweepid-1);
+                                myss_cond_wait( prog, myid-1,       sweepid );
+                                myss_cond_wait( prog, myid+shift-1, sweepid-1 );
                                 if (myid%2 == 0) {
                                     magma_zhbtype2cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
                                 } else {
                                     magma_zhbtype3cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
                                 }
-                                myss_cond_set(myid, 0, sweepid);
+                                myss_cond_set( prog, myid, sweepid );
                                 if (blklastind >= (n-1)) {
                                     for (j = 1; j <= shift+allcoresnb; j++)
-                                        myss_cond_set(myid+j, 0, sweepid);
+                                        myss_cond_set( prog, myid+j, sweepid );
                                 }
                             } /* END if myid == 1 */
                         } /* END if my_core_id == coreid */
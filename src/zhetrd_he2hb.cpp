@@ -220,16 +220,14 @@ magma_zhetrd_he2hb(
     magmaDoubleComplex *dwork = dA + n*ldda;
     magmaDoubleComplex *dW    = dwork + nb*ldda;
 
-    #ifdef TRACING
     char buf[80];
-    #endif
     magma_queue_t queues[2];
     magma_device_t cdev;
     magma_getdevice( &cdev );
     magma_queue_create( cdev, &queues[0] );
     magma_queue_create( cdev, &queues[1] );
     
-    trace_init( 1, 1, 3, queues );
+    trace_init( 1, 2, queues );
 
     lwork -= nb*nb;
     magmaDoubleComplex *hT = work + lwork;
@@ -242,6 +240,7 @@ magma_zhetrd_he2hb(
 
     if (upper) {
         printf("ZHETRD_HE2HB is not yet implemented for upper matrix storage. Exit.\n");
+        trace_finalize();
         return MAGMA_ERR_NOT_IMPLEMENTED;
     } else {
         /* Copy the matrix to the GPU */
@@ -279,16 +278,16 @@ magma_zhetrd_he2hb(
                                         A ( i, i), lda, queues[1] );
                 trace_gpu_end( 0, 1 );
 
-                trace_gpu_start( 0, 2, "her2k", "her2k" );
+                trace_gpu_start( 0, 0, "her2k", "her2k" );
                 magma_zher2k( MagmaLower, MagmaNoTrans, pm_old-pn_old, pn_old, c_neg_one,
                      dA(indi_old+pn_old, indj_old), ldda,
                      dW + pn_old,            pm_old, d_one,
                      dA(indi_old+pn_old, indi_old+pn_old), ldda, queues[0] );
-                trace_gpu_end( 0, 2 );
+                trace_gpu_end( 0, 0 );
 
-                trace_cpu_start( 0, "sync", "sync on 1" );
+                trace_cpu_start( "sync", "sync on 1" );
                 magma_queue_sync( queues[1] );
-                trace_cpu_end( 0 );
+                trace_cpu_end();
                 magma_zq_to_panel(MagmaUpper, pn-1, A(i, i+1), lda, work);
             }
 
@@ -296,10 +295,8 @@ magma_zhetrd_he2hb(
                QR factorization on a panel starting nb off of the diagonal.
                Prepare the V and T matrices.
                ==========================================================  */
-            #ifdef TRACING
             snprintf( buf, sizeof(buf), "panel %lld", (long long) i );
-            #endif
-            trace_cpu_start( 0, "geqrf", buf );
+            trace_cpu_start( "geqrf", buf );
             lapackf77_zgeqrf(&pm, &pn, A(indi, indj), &lda,
                        tau_ref(i), work, &lwork, info);
             
@@ -312,7 +309,7 @@ magma_zhetrd_he2hb(
             /* Prepare V - put 0s in the upper triangular part of the panel
                (and 1s on the diagonal), temporaly storing the original in work */
             magma_zpanel_to_q(MagmaUpper, pk, A(indi, indj), lda, work);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
 
             /* Send V from the CPU to the GPU */
             trace_gpu_start( 0, 0, "set", "set V and T" );
@@ -332,49 +329,49 @@ magma_zhetrd_he2hb(
                2. W = X - 0.5* V * (T' * (V' * X))
                ==========================================================  */
             /* dwork = V T */
-            trace_cpu_start( 0, "sync", "sync on 0" );
+            trace_cpu_start( "sync", "sync on 0" );
             // this sync is done here to be sure that the copy has been finished
             // because below we made a restore magma_zq_to_panel and this restore need
             // to ensure that the copy has been finished. we did it here to allow
             // overlapp of restore with next gemm and symm.
             magma_queue_sync( queues[0] );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             
-            trace_gpu_start( 0, 2, "gemm", "work = V*T" );
+            trace_gpu_start( 0, 0, "gemm", "work = V*T" );
             magma_zgemm( MagmaNoTrans, MagmaNoTrans, pm, pk, pk,
                         c_one, dA(indi, indj), ldda,
                         dT(i), lddt,
                         c_zero, dwork, pm, queues[0] );
-            trace_gpu_end( 0, 2 );
+            trace_gpu_end( 0, 0 );
             
             /* dW = X = A*V*T. dW = A*dwork */
-            trace_gpu_start( 0, 2, "hemm", "X = A*work" );
+            trace_gpu_start( 0, 0, "hemm", "X = A*work" );
             magma_zhemm( MagmaLeft, uplo, pm, pk,
                         c_one, dA(indi, indi), ldda,
                         dwork, pm,
                         c_zero, dW, pm, queues[0] );
-            trace_gpu_end( 0, 2 );
+            trace_gpu_end( 0, 0 );
             /* restore the panel */
             magma_zq_to_panel(MagmaUpper, pk, A(indi, indj), lda, work);
             
             /* dwork = V*T already ==> dwork' = T'*V'
              * compute T'*V'*X ==> dwork'*W ==>
              * dwork + pm*nb = ((T' * V') * X) = dwork' * X = dwork' * W */
-            trace_gpu_start( 0, 2, "gemm", "work = T'*V'*X" );
+            trace_gpu_start( 0, 0, "gemm", "work = T'*V'*X" );
             magma_zgemm( MagmaConjTrans, MagmaNoTrans, pk, pk, pm,
                         c_one, dwork, pm,
                         dW, pm,
                         c_zero, dwork + pm*nb, nb, queues[0] );
-            trace_gpu_end( 0, 2 );
+            trace_gpu_end( 0, 0 );
             
             /* W = X - 0.5 * V * T'*V'*X
              *   = X - 0.5 * V * (dwork + pm*nb) = W - 0.5 * V * (dwork + pm*nb) */
-            trace_gpu_start( 0, 2, "gemm", "W = X - 0.5*V*(T'*V'*X)" );
+            trace_gpu_start( 0, 0, "gemm", "W = X - 0.5*V*(T'*V'*X)" );
             magma_zgemm( MagmaNoTrans, MagmaNoTrans, pm, pk, pk,
                         c_neg_half, dA(indi, indj), ldda,
                         dwork + pm*nb, nb,
                         c_one,     dW, pm, queues[0] );
-            trace_gpu_end( 0, 2 );
+            trace_gpu_end( 0, 0 );
 
             /* ==========================================================
                Update the unreduced submatrix A(i+ib:n,i+ib:n), using
@@ -383,29 +380,29 @@ magma_zhetrd_he2hb(
             if (i + nb <= n-nb) {
                 // There would be next iteration;
                 // do lookahead - update the next panel
-                trace_gpu_start( 0, 2, "gemm", "gemm 4 next panel left" );
+                trace_gpu_start( 0, 0, "gemm", "gemm 4 next panel left" );
                 magma_zgemm( MagmaNoTrans, MagmaConjTrans, pm, pn, pn, c_neg_one,
                             dA(indi, indj), ldda,
                             dW,                 pm, c_one,
                             dA(indi, indi), ldda, queues[0] );
-                trace_gpu_end( 0, 2 );
+                trace_gpu_end( 0, 0 );
             
-                trace_gpu_start( 0, 2, "gemm", "gemm 5 next panel right" );
+                trace_gpu_start( 0, 0, "gemm", "gemm 5 next panel right" );
                 magma_zgemm( MagmaNoTrans, MagmaConjTrans, pm, pn, pn, c_neg_one,
                             dW,                 pm,
                             dA(indi, indj), ldda, c_one,
                             dA(indi, indi), ldda, queues[0] );
-                trace_gpu_end( 0, 2 );
+                trace_gpu_end( 0, 0 );
                 magma_event_record(Pupdate_event, queues[0]);
             }
             else {
                 /* no look-ahead as this is last iteration */
-                trace_gpu_start( 0, 2, "her2k", "her2k last iteration" );
+                trace_gpu_start( 0, 0, "her2k", "her2k last iteration" );
                 magma_zher2k( MagmaLower, MagmaNoTrans, pk, pk, c_neg_one,
                              dA(indi, indj), ldda,
                              dW,                 pm, d_one,
                              dA(indi, indi), ldda, queues[0] );
-                trace_gpu_end( 0, 2 );
+                trace_gpu_end( 0, 0 );
             }
             
             indi_old = indi;
@@ -418,16 +415,16 @@ magma_zhetrd_he2hb(
         pk = min(pm,pn);
         if (1 <= n-nb) {
             magma_zpanel_to_q(MagmaUpper, pk-1, A(n-pk+1, n-pk+2), lda, work);
-            trace_gpu_start( 0, 2, "get", "get last block" );
+            trace_gpu_start( 0, 0, "get", "get last block" );
             magma_zgetmatrix( pk, pk,
                               dA(n-pk+1, n-pk+1), ldda,
                               A(n-pk+1, n-pk+1),  lda, queues[0] );
-            trace_gpu_end( 0, 2 );
+            trace_gpu_end( 0, 0 );
             magma_zq_to_panel(MagmaUpper, pk-1, A(n-pk+1, n-pk+2), lda, work);
         }
     }// end of LOWER
     
-    trace_finalize( "zhetrd_he2hb.svg", "trace.css" );
+    trace_finalize();
 
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
@@ -274,6 +274,9 @@ magma_zhetrd_mgpu(
     else
         nx = 512;
 
+    // queues has 10 columns, of which nqueue are used
+    trace_init( ngpu, 10, (magma_queue_t *)queues );
+
     if (upper) {
         /* Copy the matrix to the GPU */
         if (1 <= n-nx) {
@@ -357,7 +360,6 @@ magma_zhetrd_mgpu(
         }
     }
     else {
-        trace_init( 1, ngpu, nqueue, (magma_queue_t *)queues );
         /* Copy the matrix to the GPU */
         if (1 <= n-nx) {
             magma_zhtodhe( ngpu, uplo, n, nb, A, lda, dA, ldda, queues, &iinfo );
@@ -466,7 +468,7 @@ magma_zhetrd_mgpu(
     magma_event_destroy( stop  );
     #endif
 
-    trace_finalize( "zhetrd.svg", "trace.css" );
+    trace_finalize();
     
     #ifdef PROFILE_SY2RK
     printf( " n=%lld nb=%lld\n", (long long) n, (long long) nb );
@@ -158,7 +158,7 @@ magma_zhetrf(
     magma_queue_create( cdev, &queues[0] );
     magma_queue_create( cdev, &queues[1] );
     magma_event_create( &event );
-    trace_init( 1, 1, 2, queues );
+    trace_init( 1, 2, queues );
 
     /* copy matrix to GPU */
     trace_gpu_start( 0, 0, "set", "setA" );
@@ -256,7 +256,7 @@ magma_zhetrf(
         }
     }
 
-    trace_finalize( "zhetrf.svg", "trace.css" );
+    trace_finalize();
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
     magma_event_destroy( event );
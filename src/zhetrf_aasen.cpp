@@ -185,7 +185,7 @@ magma_zhetrf_aasen(magma_uplo_t uplo, magma_int_t cpu_panel, magma_int_t n,
         ipiv[j] = j+1;
     }
 
-    trace_init( 1, 1, num_queues, queues );
+    trace_init( 1, num_queues, queues );
     //if (nb <= 1 || nb >= n) {
     //    lapackf77_zpotrf(uplo_, &n, A, &lda, info);
     //} else 
@@ -358,13 +358,13 @@ magma_zhetrf_aasen(magma_uplo_t uplo, magma_int_t cpu_panel, magma_int_t n,
                                                  A(j+1,j), lda, queues[0] );
                         // panel factorization on CPU
                         magma_queue_sync( queues[0] );
-                        trace_cpu_start( 0, "getrf", "getrf" );
+                        trace_cpu_start( "getrf", "getrf" );
                         lapackf77_zgetrf( &ib, &jb, A(j+1,j), &lda, &ipiv[(1+j)*nb], &iinfo);
                         if (iinfo != 0) {
                             printf( " zgetrf failed with %lld\n", (long long) iinfo );
                             // TODO handle error
                         }
-                        trace_cpu_end( 0 );
+                        trace_cpu_end();
                         // copy to GPU (all columns, not just L part)
                         magma_zsetmatrix_async( ib, jb, A(j+1,j), lda, dA(j+1,j), ldda,
                                                 queues[0]);
@@ -461,7 +461,7 @@ magma_zhetrf_aasen(magma_uplo_t uplo, magma_int_t cpu_panel, magma_int_t n,
         magma_queue_destroy( queues[i] );
         magma_event_destroy( events[i] );
     }
-    trace_finalize( "zhetrf.svg", "trace.css" );
+    trace_finalize();
 
     magma_free(dA_array);
     magma_free(dipiv_array);
@@ -157,7 +157,7 @@ magma_zhetrf_gpu(
     magma_queue_t queues[2];
     magma_queue_create( cdev, &queues[0] );
     magma_queue_create( cdev, &queues[1] );
-    trace_init( 1, 1, 2, queues );
+    trace_init( 1, 2, queues );
 
     if ( upper ) {
         /* Factorize A as U*D*U' using the upper triangle of A
@@ -227,7 +227,7 @@ magma_zhetrf_gpu(
         }
     }
 
-    trace_finalize( "zhetrf.svg", "trace.css" );
+    trace_finalize();
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
     magma_queue_destroy( queues[0] );
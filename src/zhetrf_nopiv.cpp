@@ -127,7 +127,7 @@ magma_zhetrf_nopiv(
     magma_queue_create( cdev, &queues[0] );
     magma_queue_create( cdev, &queues[1] );
     magma_event_create( &event );
-    trace_init( 1, 1, 2, queues );
+    trace_init( 1, 2, queues );
 
     /* Use hybrid blocked code. */
     if (upper) {
@@ -155,9 +155,9 @@ magma_zhetrf_nopiv(
             
             // factorize the diagonal block
             magma_queue_sync(queues[1]);
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zhetrf_nopiv_cpu( MagmaUpper, jb, ib, A(j, j), lda, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -232,9 +232,9 @@ magma_zhetrf_nopiv(
             
             // factorize the diagonal block
             magma_queue_sync(queues[1]);
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zhetrf_nopiv_cpu( MagmaLower, jb, ib, A(j, j), lda, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -286,7 +286,7 @@ magma_zhetrf_nopiv(
         }
     }
     
-    trace_finalize( "zhetrf.svg","trace.css" );
+    trace_finalize();
     magma_queue_destroy(queues[0]);
     magma_queue_destroy(queues[1]);
     magma_event_destroy( event );
@@ -6,373 +6,278 @@
        @date
 
        @precisions normal z -> s d c
- 
+
 */
 #include "magma_internal.h"
 
 #define COMPLEX
 
-// TODO convert to usual (A + (i) + (j)*lda), i.e., returns pointer?
-#define  A(i, j) ( A[(j)*lda  + (i)])
-#define  C(i, j) ( C[(j)*ldc  + (i)])
-#define  D(i)    ( D[(i)*incD] )
+#define A(i, j) (A + (i) + (j)*lda)
+
+// Below this order, the factorization runs on one thread with the
+// multithreaded BLAS; above, the blocks are distributed to OpenMP threads.
+#define MAGMA_ZHETRF_NOPIV_CPU_NTHREAD_MIN 256
 
 
 /******************************************************************************/
-// TODO: change alpha and beta to be double, per BLAS, instead of double-complex
-// trailing submatrix update with inner-blocking
-magma_int_t zherk_d(
-    magma_uplo_t uplo, magma_int_t m, magma_int_t n,
-    magmaDoubleComplex alpha, magmaDoubleComplex *A, magma_int_t lda,
-    magmaDoubleComplex beta,  magmaDoubleComplex *C, magma_int_t ldc,
-    magmaDoubleComplex *D, magma_int_t incD)
+// Unblocked LDL^H of the n-by-n block with rank-1 updates.
+// Returns 0, or k if the k-th pivot is (nearly) zero.
+static magma_int_t
+zhetrf_nopiv_cpu_unblocked(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda )
 {
-    magma_int_t i, j, k;
-    magmaDoubleComplex *Aik;
-    magmaDoubleComplex *Dkk;
-    magmaDoubleComplex *Akj;
-
-    /* Check input arguments */
-    magma_int_t info = 0;
-    if ((uplo != MagmaLower) && (uplo != MagmaUpper)) {
-        info = -1;
-    }
-    if (m < 0) {
-        info = -3;
-    }
-    if (n < 0) {
-        info = -4;
-    }
-    if ((lda < max(1, m)) && (m > 0)) {
-        info = -7;
-    }
-    if ((ldc < max(1, m)) && (m > 0)) {
-        info = -10;
-    }
-    if ( incD < 0 ) {
-        info = -12;
-    }
-    if (info != 0) {
-        magma_xerbla( __func__, -(info) );
-        return info;
-    }
+    const magma_int_t ione = 1;
+    const double eps = lapackf77_dlamch("Epsilon");
 
-    /* Quick return */
-    if (m == 0 || n == 0 ||
-        ((alpha == 0.0 || m == 0) && beta == 1.0) ) {
-        return info;
-    }
+    for (magma_int_t k=0; k < n; k++) {
+        double alpha = MAGMA_Z_REAL( *A(k,k) );
+        if ( fabs(alpha) < eps ) {
+            return k+1;
+        }
+        *A(k,k) = MAGMA_Z_MAKE( alpha, 0.0 );
 
-    if ( uplo == MagmaLower ) {
-        for (j=0; j < m; j++) {
-            for (i=j; i < m; i++) {
-                magmaDoubleComplex tmp = MAGMA_Z_ZERO;
-                Aik = A+i;
-                Dkk = D;
-                Akj = A+j;
-                for (k=0; k < n; k++) {
-                    tmp = tmp + (*Aik) * (*Dkk) * conj( *Akj );
-                    Aik += lda;
-                    Dkk += incD;
-                    Akj += lda;
-                }
-                C(i, j) = beta * C(i, j) + alpha * tmp;
-            }
+        magma_int_t m = n - k - 1;
+        if ( m == 0 ) {
+            break;
         }
-    }
-    else {
-        for (j=0; j < m; j++) {
-            for (i=0; i <= j; i++) {
-                magmaDoubleComplex tmp = MAGMA_Z_ZERO;
-                for (k=0; k < n; k++) {
-                    tmp = tmp + A(i, k) * D( k ) * conj( A(k, j) );
-                }
-                C(i, j) = beta * C(i, j) + alpha * tmp;
-            }
+        double rcp = 1.0 / alpha;
+        double neg_alpha = -alpha;
+        if ( uplo == MagmaLower ) {
+            // L(k+1:n,k) = A(k+1:n,k) / d_k;  A22 -= d_k * l * l^H
+            blasf77_zdscal( &m, &rcp, A(k+1,k), &ione );
+            blasf77_zher( MagmaLowerStr, &m, &neg_alpha, A(k+1,k), &ione,
+                          A(k+1,k+1), &lda );
+        }
+        else {
+            // U(k,k+1:n) = A(k,k+1:n) / d_k;  A22 -= d_k * u^H * u
+            blasf77_zdscal( &m, &rcp, A(k,k+1), &lda );
+            #ifdef COMPLEX
+            lapackf77_zlacgv( &m, A(k,k+1), &lda );
+            #endif
+            blasf77_zher( MagmaUpperStr, &m, &neg_alpha, A(k,k+1), &lda,
+                          A(k+1,k+1), &lda );
+            #ifdef COMPLEX
+            lapackf77_zlacgv( &m, A(k,k+1), &lda );
+            #endif
         }
     }
-    return info;
+    return 0;
 }
 
 
 /******************************************************************************/
-// TODO: change alpha and beta to be double, per BLAS, instead of double-complex
-// trailing submatrix update with inner-blocking, using workshpace that
-// stores D*L'
-magma_int_t zherk_d_workspace(
-    magma_uplo_t uplo, magma_int_t n, magma_int_t k,
-    magmaDoubleComplex alpha, magmaDoubleComplex *A, magma_int_t lda,
-    magmaDoubleComplex beta,  magmaDoubleComplex *C, magma_int_t ldc,
-    magmaDoubleComplex *work, magma_int_t ldw)
+// Recursive LDL^H of the n-by-n block. The block is split in halves until
+// it has at most ib columns. After factoring A11, the off-diagonal block is
+// solved with the unit triangle of A11, and in the same pass its D-scaled
+// (conjugate) transpose is saved in the opposite triangle, so the trailing
+// update A22 -= L21 * (D1 * L21^H) is a plain gemm restricted to the
+// referenced triangle of A22. The trsm, scaling, and update are split into
+// blocks of rows (or columns) that run on nthread OpenMP threads.
+// Returns 0, or k if the k-th pivot is (nearly) zero.
+static magma_int_t
+zhetrf_nopiv_cpu_recursive(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t ib,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magma_int_t nthread )
 {
-    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
-    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
-
-    /* Check input arguments */
-    magma_int_t info = 0;
-    if ((uplo != MagmaLower) && (uplo != MagmaUpper)) {
-        info = -1;
-    }
-    if (n < 0) {
-        info = -2;
-    }
-    if (k < 0) {
-        info = -3;
-    }
-    if ((lda < max(1,n)) && (n > 0)) {
-        info = -6;
-    }
-    if ((ldc < max(1,n)) && (n > 0)) {
-        info = -9;
-    }
-    if (info != 0) {
-        magma_xerbla( __func__, -(info) );
-        return info;
-    }
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
 
-    /* Quick return */
-    if (n == 0 || k == 0 ||
-        ((alpha == 0.0 || k == 0) && beta == 1.0) ) {
-        return info;
-    }
-
-    if ( uplo == MagmaLower ) {
-        blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr,
-                       &n, &n, &k,
-                       &c_neg_one, A,    &lda,
-                                   work, &ldw,
-                       &c_one,     C,    &ldc );
-    }
-    else {
-        blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr,
-                       &n, &n, &k,
-                       &c_neg_one, work, &ldw,
-                                   A,    &lda,
-                       &c_one,     C,    &ldc );
+    if ( n <= ib ) {
+        return zhetrf_nopiv_cpu_unblocked( uplo, n, A, lda );
     }
-    return info;
-}
 
+    // split at a multiple of ib, so the leaves have ib columns
+    magma_int_t n1 = magma_ceildiv( n, 2*ib )*ib;
+    magma_int_t n2 = n - n1;
 
-/******************************************************************************/
-// diagonal factorization with inner-block
-magma_int_t zhetrf_diag_nopiv(
-    magma_uplo_t uplo, magma_int_t n,
-    magmaDoubleComplex *A, magma_int_t lda)
-{
-    const magma_int_t ione = 1;
-    const double d_one = 1.0;
-    
-    /* Check input arguments */
-    magma_int_t info = 0;
-    if (lda < n) {
-        info = -4;
+    magma_int_t iinfo = zhetrf_nopiv_cpu_recursive( uplo, n1, ib, A, lda, nthread );
+    if ( iinfo != 0 ) {
+        return iinfo;
     }
-    if (info != 0) {
-        magma_xerbla( __func__, -(info) );
-        return info;
-    }
-
-    /* Quick return */
-    if (n == 1)
-        return info;
 
-    magmaDoubleComplex *Ak1k = NULL;
-    magmaDoubleComplex *Akk = NULL;
-    double alpha;
+    // block size so each thread gets about 2 blocks
+    magma_int_t nb = min( n2, max( ib, magma_roundup( magma_ceildiv( n2, 2*nthread ), 16 )));
+    magma_int_t nblock = magma_ceildiv( n2, nb );
 
     if ( uplo == MagmaLower ) {
-        /* Diagonal element */
-        Akk  = A;
-
-        /* Pointer on first extra diagonal element */
-        Ak1k = A + 1;
-
-        for (magma_int_t k=n-1; k > 0; k--) {
-            alpha = MAGMA_Z_REAL( *Akk );
-            if ( fabs(alpha) < lapackf77_dlamch("Epsilon") ) {
-                info = k;
-                return info;
-            }
-            *Akk = MAGMA_Z_MAKE(alpha, 0.0);
-
-            // scale off-diagonals
-            alpha = d_one / alpha;
-            blasf77_zdscal(&k, &alpha, Ak1k, &ione);
-
-            // update remaining
-            alpha = - MAGMA_Z_REAL( *Akk );
-            blasf77_zher(MagmaLowerStr, &k,
-                         &alpha, Ak1k, &ione, Ak1k + lda, &lda);
-
-            /* Move to next diagonal element */
-            if (k > 1) { 
-                Ak1k += lda;
-                Akk = Ak1k;
-                Ak1k++;
+        // A21 = L21 * D1 * L11^H, solve for L21 * D1, keep its conjugate
+        // transpose D1 * L21^H in A12, and divide by D1
+        #pragma omp parallel for schedule(static) num_threads(nthread)
+        for (magma_int_t ibl=0; ibl < nblock; ibl++) {
+            magma_int_t i  = n1 + ibl*nb;
+            magma_int_t mb = min( nb, n - i );
+            blasf77_ztrsm( MagmaRightStr, MagmaLowerStr, MagmaConjTransStr, MagmaUnitStr,
+                           &mb, &n1, &c_one, A(0,0), &lda, A(i,0), &lda );
+            for (magma_int_t k=0; k < n1; k++) {
+                double rcp = 1.0 / MAGMA_Z_REAL( *A(k,k) );
+                for (magma_int_t ii=i; ii < i + mb; ii++) {
+                    *A(k,ii) = MAGMA_Z_CONJ( *A(ii,k) );
+                    *A(ii,k) = *A(ii,k) * rcp;
+                }
             }
         }
-    } else {
-        /* Diagonal element */
-        Akk  = A;
-
-        /* Pointer on first extra diagonal element */
-        Ak1k = A + lda;
-
-        for (magma_int_t k=n-1; k > 0; k--) {
-            alpha = MAGMA_Z_REAL( *Akk );
-            if ( fabs(alpha) < lapackf77_dlamch("Epsilon") ) {
-                info = k;
-                return info;
-            }
-            *Akk = MAGMA_Z_MAKE(alpha, 0.0);
 
-            // scale off-diagonals
-            alpha = d_one / alpha;
-            blasf77_zdscal(&k, &alpha, Ak1k, &lda);
-
-            // update remaining
-            alpha = - MAGMA_Z_REAL( *Akk );
-
-            #ifdef COMPLEX
-            lapackf77_zlacgv(&k, Ak1k, &lda);
-            #endif
-            blasf77_zher(MagmaUpperStr, &k,
-                         &alpha, Ak1k, &lda, Ak1k + 1, &lda);
-            #ifdef COMPLEX
-            lapackf77_zlacgv(&k, Ak1k, &lda);
-            #endif
-
-            /* Move to next diagonal element */
-            if (k > 1) {
-                Ak1k ++;
-                Akk = Ak1k;
-                Ak1k += lda;
+        // A22 -= L21 * (D1 * L21^H), lower triangle by block columns;
+        // the strictly upper part of the diagonal blocks is also
+        // overwritten, which is workspace anyway
+        #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+        for (magma_int_t jbl=0; jbl < nblock; jbl++) {
+            magma_int_t j  = n1 + jbl*nb;
+            magma_int_t jb = min( nb, n - j );
+            magma_int_t mb = n - j;
+            blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &mb, &jb, &n1,
+                           &c_neg_one, A(j,0), &lda,
+                                       A(0,j), &lda,
+                           &c_one,     A(j,j), &lda );
+        }
+    }
+    else {
+        // A12 = U11^H * D1 * U12, solve for D1 * U12, keep its conjugate
+        // transpose U12^H * D1 in A21, and divide by D1
+        #pragma omp parallel for schedule(static) num_threads(nthread)
+        for (magma_int_t jbl=0; jbl < nblock; jbl++) {
+            magma_int_t j  = n1 + jbl*nb;
+            magma_int_t jb = min( nb, n - j );
+            blasf77_ztrsm( MagmaLeftStr, MagmaUpperStr, MagmaConjTransStr, MagmaUnitStr,
+                           &n1, &jb, &c_one, A(0,0), &lda, A(0,j), &lda );
+            for (magma_int_t jj=j; jj < j + jb; jj++) {
+                for (magma_int_t k=0; k < n1; k++) {
+                    double rcp = 1.0 / MAGMA_Z_REAL( *A(k,k) );
+                    *A(jj,k) = MAGMA_Z_CONJ( *A(k,jj) );
+                    *A(k,jj) = *A(k,jj) * rcp;
+                }
             }
         }
+
+        // A22 -= (U12^H * D1) * U12, upper triangle by block columns
+        #pragma omp parallel for schedule(dynamic) num_threads(nthread)
+        for (magma_int_t jbl=nblock-1; jbl >= 0; jbl--) {
+            magma_int_t j  = n1 + jbl*nb;
+            magma_int_t jb = min( nb, n - j );
+            magma_int_t mb = j + jb - n1;
+            blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &mb, &jb, &n1,
+                           &c_neg_one, A(n1,0), &lda,
+                                       A(0,j),  &lda,
+                           &c_one,     A(n1,j), &lda );
+        }
     }
-    return info;
+
+    iinfo = zhetrf_nopiv_cpu_recursive( uplo, n2, ib, A(n1,n1), lda, nthread );
+    if ( iinfo != 0 ) {
+        return iinfo + n1;
+    }
+    return 0;
 }
 
 
-/******************************************************************************/
-// main routine
+/***************************************************************************//**
+    Purpose
+    -------
+    ZHETRF_NOPIV_CPU computes the LDL^H factorization of a complex Hermitian
+    matrix A without pivoting, on the CPU. It is used for the diagonal
+    blocks of magma_zhetrf_nopiv and magma_zhetrf_nopiv_gpu.
+
+    The factorization has the form
+        A = U^H * D * U,  if UPLO = MagmaUpper, or
+        A = L   * D * L^H, if UPLO = MagmaLower,
+    where U is a unit upper triangular matrix, L is unit lower triangular,
+    and D is diagonal.
+
+    The factorization is recursive: the matrix is split in halves down to
+    blocks of IB columns, which are factored with rank-1 updates. The D
+    scaling is fused into the solve of the off-diagonal block, so the
+    trailing update is one gemm per block column. For N >= 256, the blocks
+    of the solve and update are distributed over
+    magma_get_parallel_numthreads() OpenMP threads, each calling
+    single-threaded BLAS.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of A is stored;
+      -     = MagmaLower:  Lower triangle of A is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix A.  N >= 0.
+
+    @param[in]
+    ib      INTEGER
+            The block size of the unblocked factorization at the leaves of
+            the recursion.  IB >= 1.
+
+    @param[in,out]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            On entry, the Hermitian matrix A. If UPLO = MagmaUpper, the leading
+            N-by-N upper triangular part of A contains the upper
+            triangular part of the matrix A. If UPLO = MagmaLower, the
+            leading N-by-N lower triangular part of A contains the lower
+            triangular part of the matrix A.
+    \n
+            On exit, if INFO = 0, the factor U or L and D from the
+            factorization, with D on the diagonal. The opposite triangle is
+            used as workspace and is overwritten.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i, the i-th pivot D(i,i) is smaller than
+                  epsilon in magnitude, and the factorization could not
+                  be completed.
+
+    @ingroup magma_hetrf_nopiv
+*******************************************************************************/
 extern "C" magma_int_t
 magma_zhetrf_nopiv_cpu(
     magma_uplo_t uplo, magma_int_t n, magma_int_t ib,
     magmaDoubleComplex *A, magma_int_t lda,
     magma_int_t *info)
 {
-    magma_int_t ione = 1;
-    double alpha;
-    double d_one = 1.0;
-    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
-    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
-
     /* Check input arguments */
     *info = 0;
-    if (lda < n) {
+    if (uplo != MagmaUpper && uplo != MagmaLower) {
         *info = -1;
+    } else if (n < 0) {
+        *info = -2;
+    } else if (ib < 1) {
+        *info = -3;
+    } else if (lda < max(1,n)) {
+        *info = -5;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
         return *info;
     }
 
     /* Quick return */
-    if (n == 1) {
+    if (n == 0) {
         return *info;
     }
 
-    if ( uplo == MagmaLower ) {
-        for (magma_int_t i = 0; i < n; i += ib) {
-            magma_int_t sb = min(n-i, ib);
-
-            /* Factorize the diagonal block */
-            *info = zhetrf_diag_nopiv(uplo, sb, &A(i, i), lda);
-            if (*info != 0) return *info;
-
-            if ( i + sb < n ) {
-                magma_int_t height = n - i - sb;
-
-                /* Solve the lower panel ( L21*D11 )*/
-                blasf77_ztrsm(
-                    MagmaRightStr, MagmaLowerStr,
-                    MagmaConjTransStr, MagmaUnitStr,
-                    &height, &sb,
-                    &c_one, &A(i, i),    &lda,
-                            &A(i+sb, i), &lda);
-
-                /* Scale the block to divide by D */
-                for (magma_int_t k=0; k < sb; k++) {
-                    #define ZHERK_D_WORKSPACE
-                    #ifdef ZHERK_D_WORKSPACE
-                    for (magma_int_t ii=i+sb; ii < n; ii++) {
-                        A(i+k, ii) = MAGMA_Z_CONJ( A(ii, i+k) );
-                    }
-                    #endif
-                    alpha = d_one / MAGMA_Z_REAL(A(i+k, i+k));
-                    blasf77_zdscal(&height, &alpha, &A(i+sb, i+k), &ione);
-                    A(i+k, i+k) = MAGMA_Z_MAKE(MAGMA_Z_REAL(A(i+k, i+k)), 0.0);
-                }
-
-                /* Update the trailing submatrix A22 = A22 - A21 * D11 * A21' */
-                #ifdef ZHERK_D_WORKSPACE
-                zherk_d_workspace( MagmaLower, height, sb,
-                                   c_neg_one, &A(i+sb, i),    lda,    // A21
-                                   c_one,     &A(i+sb, i+sb), lda,    // A22
-                                              &A(i, i+sb),    lda );  // workspace, I am writing on upper part :)
-                #else
-                zherk_d( MagmaLower, height, sb,
-                         c_neg_one, &A(i+sb, i),    lda,      // A21
-                         c_one,     &A(i+sb, i+sb), lda,      // A22
-                                    &A(i, i),       lda+1 );  // D11
-                #endif
-            }
-        }
-    } else {
-        for (magma_int_t i = 0; i < n; i += ib) {
-            magma_int_t sb = min(n-i, ib);
-
-            /* Factorize the diagonal block */
-            *info = zhetrf_diag_nopiv(uplo, sb, &A(i, i), lda);
-            if (*info != 0) return *info;
-
-            if ( i + sb < n ) {
-                magma_int_t height = n - i - sb;
-
-                /* Solve the lower panel ( L21*D11 )*/
-                blasf77_ztrsm(
-                    MagmaLeftStr, MagmaUpperStr,
-                    MagmaConjTransStr, MagmaUnitStr,
-                    &sb, &height,
-                    &c_one, &A(i, i),    &lda,
-                            &A(i, i+sb), &lda);
-
-                /* Scale the block to divide by D */
-                for (magma_int_t k=0; k < sb; k++) {
-                    #define ZHERK_D_WORKSPACE
-                    #ifdef ZHERK_D_WORKSPACE
-                    for (magma_int_t ii=i+sb; ii < n; ii++) {
-                        A(ii, i+k) = MAGMA_Z_CONJ( A(i+k, ii) );
-                    }
-                    #endif
-                    alpha = d_one / MAGMA_Z_REAL(A(i+k, i+k));
-                    blasf77_zdscal(&height, &alpha, &A(i+k, i+sb), &lda);
-                    A(i+k, i+k) = MAGMA_Z_MAKE(MAGMA_Z_REAL(A(i+k, i+k)), 0.0);
-                }
-
-                /* Update the trailing submatrix A22 = A22 - A21 * D11 * A21' */
-                #ifdef ZHERK_D_WORKSPACE
-                zherk_d_workspace( MagmaUpper, height, sb,
-                                   c_neg_one, &A(i, i+sb),    lda,    // A21
-                                   c_one,     &A(i+sb, i+sb), lda,    // A22
-                                              &A(i+sb, i),    lda );  // workspace, I am writing on upper part :)
-                #else
-                zherk_d( MagmaUpper, height, sb,
-                         c_neg_one, &A(i, i+sb),    lda,      // A21
-                         c_one,     &A(i+sb, i+sb), lda,      // A22
-                                    &A(i, i),       lda+1 );  // D11
-                #endif
-            }
-        }
+    magma_int_t nthread = 1;
+    #ifdef _OPENMP
+    if ( n >= MAGMA_ZHETRF_NOPIV_CPU_NTHREAD_MIN ) {
+        nthread = magma_get_parallel_numthreads();
+    }
+    #endif
+
+    if ( nthread > 1 ) {
+        // each thread calls single-threaded BLAS
+        magma_int_t lapack_nthread = magma_get_lapack_numthreads();
+        magma_set_lapack_numthreads( 1 );
+        *info = zhetrf_nopiv_cpu_recursive( uplo, n, ib, A, lda, nthread );
+        magma_set_lapack_numthreads( lapack_nthread );
+    }
+    else {
+        *info = zhetrf_nopiv_cpu_recursive( uplo, n, ib, A, lda, 1 );
     }
 
     return *info;
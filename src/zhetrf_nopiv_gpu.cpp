@@ -117,7 +117,6 @@ magma_zhetrf_nopiv_gpu(
     magma_queue_create( cdev, &queue[0] );
     magma_queue_create( cdev, &queue[1] );
     magma_event_create( &event );
-    trace_init( 1, 1, 2, queue );
 
     // CPU workspace
     magmaDoubleComplex *A;
@@ -132,6 +131,7 @@ magma_zhetrf_nopiv_gpu(
         *info = MAGMA_ERR_DEVICE_ALLOC;
         return *info;
     }
+    trace_init( 1, 2, queue );
 
     /* Use hybrid blocked code. */
     if (upper) {
@@ -150,9 +150,9 @@ magma_zhetrf_nopiv_gpu(
 
             // factorize the diagonal block
             magma_queue_sync( queue[1] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zhetrf_nopiv_cpu( MagmaUpper, jb, ib, A(j, j), nb, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -211,9 +211,9 @@ magma_zhetrf_nopiv_gpu(
             
             // factorize the diagonal block
             magma_queue_sync( queue[1] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zhetrf_nopiv_cpu( MagmaLower, jb, ib, A(j, j), nb, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -258,7 +258,7 @@ magma_zhetrf_nopiv_gpu(
         }
     }
     
-    trace_finalize( "zhetrf.svg","trace.css" );
+    trace_finalize();
     magma_queue_destroy( queue[0] );
     magma_queue_destroy( queue[1] );
     magma_event_destroy( event );
@@ -362,7 +362,7 @@ magma_zlatrd_mgpu(
             n_i = n - i;
             //idw = ((offset+i)/nb)%ngpu;
             if ( i > 0 ) {
-                trace_cpu_start( 0, "gemv", "gemv" );
+                trace_cpu_start( "gemv", "gemv" );
                 magmaDoubleComplex wii = -conj( *W(i, i-1) );
                 blasf77_zaxpy( &n_i, &wii, A(i, i-1), &ione, A(i, i), &ione );
 
@@ -373,12 +373,12 @@ magma_zlatrd_mgpu(
             if (i < n-1) {
                 /* Generate elementary reflector H(i) to annihilate A(i+2:n,i) */
                 n_i_1 = n - i - 1;
-                trace_cpu_start( 0, "larfg", "larfg" );
+                trace_cpu_start( "larfg", "larfg" );
                 alpha = *A(i+1, i);
                 lapackf77_zlarfg( &n_i_1, &alpha, A(min(i+2,n-1), i), &ione, &tau[i] );
                 e[i] = MAGMA_Z_REAL( alpha );
                 *A(i+1,i) = MAGMA_Z_ONE;
-                trace_cpu_end( 0 );
+                trace_cpu_end();
 
                 /* Compute W(i+1:n,i) */
                 // TODO Previously, this set dx2[id] = dW1(id, 0, i)-offset; and used dx2 in zhemv.
@@ -394,7 +394,7 @@ magma_zlatrd_mgpu(
                     A(i+1, i), 1, c_zero, W(i+1, i), 1,
                     hwork, lhwork, dwork, ldwork, ngpu, nb0, queues );
                 
-                trace_cpu_start( 0, "gemv", "gemv" );
+                trace_cpu_start( "gemv", "gemv" );
                 blasf77_zgemv( MagmaConjTransStr, &n_i_1, &i, &c_one,
                                W(i+1, 0), &ldw,
                                A(i+1, i), &ione, &c_zero,
@@ -409,11 +409,11 @@ magma_zlatrd_mgpu(
                                A(i+1, 0), &lda,
                                A(i+1, i), &ione, &c_zero,
                                W(0,   i), &ione );
-                trace_cpu_end( 0 );
+                trace_cpu_end();
 
                 /* overlap update */
                 if ( i > 0 && i+1 < n ) {
-                    trace_cpu_start( 0, "gemv", "gemv" );
+                    trace_cpu_start( "gemv", "gemv" );
                     #ifdef COMPLEX
                     lapackf77_zlacgv( &i, W(i+1, 0), &ldw );
                     #endif
@@ -432,7 +432,7 @@ magma_zlatrd_mgpu(
                     #ifdef COMPLEX
                     lapackf77_zlacgv( &i, A(i+1, 0), &lda );
                     #endif
-                    trace_cpu_end( 0 );
+                    trace_cpu_end();
                 }
 
                 // synchronize to get zhemv result W(i+1, i)
@@ -441,7 +441,7 @@ magma_zlatrd_mgpu(
                     A(i+1, i), 1, c_zero, W(i+1, i), 1,
                     hwork, lhwork, dwork, ldwork, ngpu, nb0, queues );
                 
-                trace_cpu_start( 0, "axpy", "axpy" );
+                trace_cpu_start( "axpy", "axpy" );
                 if (i != 0) {
                     blasf77_zaxpy( &n_i_1, &c_one, f, &ione, W(i+1, i), &ione );
                 }
@@ -455,7 +455,7 @@ magma_zlatrd_mgpu(
                 value = magma_cblas_zdotc( n_i_1, W(i+1,i), ione, A(i+1,i), ione );
                 alpha = tau[i] * -0.5f * value;
                 blasf77_zaxpy( &n_i_1, &alpha, A(i+1, i), &ione, W(i+1,i), &ione );
-                trace_cpu_end( 0 );
+                trace_cpu_end();
                 for( dev=0; dev < ngpu; dev++ ) {
                     magma_setdevice( dev );
                     magma_zsetvector_async( n, W(0,i), 1, dW(dev, 0, i), 1, queues[dev] );
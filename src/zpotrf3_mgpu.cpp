@@ -14,7 +14,8 @@
 #define PRECISION_z
 
 /* === Define what BLAS to use ============================================ */
-#if defined(PRECISION_s) || defined(PRECISION_d)
+// the CPU backend has no magmablas_ztrsm_work; use magma_ztrsm
+#if (defined(PRECISION_s) || defined(PRECISION_d)) && ! defined(MAGMA_HAVE_CPU)
 #define ZTRSM_WORK
 //#undef  magma_ztrsm
 //#define magma_ztrsm magmablas_ztrsm
@@ -220,7 +221,7 @@ magma_zpotrf3_mgpu(
     }
 
     /* == initialize the trace */
-    trace_init( 1, ngpu, 3, (magma_queue_t *)queues );
+    trace_init( ngpu, 3, (magma_queue_t *)queues );
 
     if (upper) {
         /* ---------------------------------------------- */
@@ -293,9 +294,9 @@ magma_zpotrf3_mgpu(
             /* wait for panel and factorize it on cpu */
             magma_setdevice(id);
             magma_queue_sync( queues[id][stream1] );
-            trace_cpu_start( 0, "getrf", "getrf" );
+            trace_cpu_start( "getrf", "getrf" );
             lapackf77_zpotrf(MagmaUpperStr, &jb, Aup(j,j), &lda, info);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -750,7 +751,7 @@ magma_zpotrf3_mgpu(
     } /* end of else not upper */
 
     /* == finalize the trace == */
-    trace_finalize( "zpotrf.svg", "trace.css" );
+    trace_finalize();
     for( d=0; d < ngpu; d++ ) {
         magma_setdevice(d);
         for( j=0; j < 3; j++ ) {
@@ -116,7 +116,6 @@ magma_zsytrf_nopiv_gpu(
     magma_queue_create( cdev, &queues[0] );
     magma_queue_create( cdev, &queues[1] );
     magma_event_create( &event );
-    trace_init( 1, 1, 2, queues );
 
     // CPU workspace
     magmaDoubleComplex *A;
@@ -131,6 +130,7 @@ magma_zsytrf_nopiv_gpu(
         *info = MAGMA_ERR_DEVICE_ALLOC;
         return *info;
     }
+    trace_init( 1, 2, queues );
 
     /* Use hybrid blocked code. */
     if (upper) {
@@ -148,9 +148,9 @@ magma_zsytrf_nopiv_gpu(
 
             // factorize the diagonal block
             magma_queue_sync( queues[1] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zsytrf_nopiv_cpu( MagmaUpper, jb, ib, A(j, j), nb, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -206,9 +206,9 @@ magma_zsytrf_nopiv_gpu(
             
             // factorize the diagonal block
             magma_queue_sync( queues[1] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             magma_zsytrf_nopiv_cpu( MagmaLower, jb, ib, A(j, j), nb, info );
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -251,7 +251,7 @@ magma_zsytrf_nopiv_gpu(
         }
     }
     
-    trace_finalize( "zhetrf.svg","trace.css" );
+    trace_finalize();
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
     magma_queue_destroy( queues[0] );
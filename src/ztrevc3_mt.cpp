@@ -10,6 +10,8 @@
        
        @precisions normal z -> c
 */
+#include <vector>
+
 #include "thread_queue.hpp"
 #include "magma_timer.h"
 
@@ -17,6 +19,32 @@
 
 #define COMPLEX
 
+// ---------------------------------------------
+// adds time t to sum, which tasks on several threads update.
+// If timers are off, does nothing.
+static inline void magma_ztrevc3_timer_add(
+    std::atomic< magma_timer_t >* sum, magma_timer_t t )
+{
+    if ( timer_enabled() && sum != NULL ) {
+        magma_timer_t old = sum->load();
+        while ( ! sum->compare_exchange_weak( old, old + t )) {}
+    }
+}
+
+
+// ---------------------------------------------
+// records a nonzero info from a task in iinfo, keeping the first one,
+// so ztrevc3_mt can return it after the tasks complete.
+static inline void magma_ztrevc3_info_set(
+    std::atomic< magma_int_t >* iinfo, magma_int_t info )
+{
+    magma_int_t zero = 0;
+    if ( info != 0 ) {
+        iinfo->compare_exchange_strong( zero, info );
+    }
+}
+
+
 // ---------------------------------------------
 // stores arguments and executes call to zlatrsd (on CPU)
 class magma_zlatrsd_task: public magma_task
@@ -29,7 +57,8 @@ public:
         magmaDoubleComplex  in_lambda,
         magmaDoubleComplex *in_x, //magma_int_t in_incx,
         magmaDoubleComplex *in_scale,
-        double *in_cnorm
+        double *in_cnorm,
+        std::atomic< magma_int_t >* in_iinfo
     ):
         uplo  ( in_uplo   ),
         trans ( in_trans  ),
@@ -42,7 +71,8 @@ public:
         x     ( in_x      ),
         //incx  ( in_incx   ),
         scale ( in_scale  ),
-        cnorm ( in_cnorm  )
+        cnorm ( in_cnorm  ),
+        iinfo ( in_iinfo  )
     {}
     
     virtual void run()
@@ -55,9 +85,7 @@ public:
         magma_zlatrsd( uplo, trans, diag, normin, n,
                        T, ldt, lambda, x, &s, cnorm, &info );
         *scale = MAGMA_Z_MAKE( s, 0 );
-        if ( info != 0 ) {
-            fprintf( stderr, "zlatrsd info %lld\n", (long long) info );
-        }
+        magma_ztrevc3_info_set( iinfo, info );
     }
     
 private:
@@ -73,6 +101,7 @@ private:
     magmaDoubleComplex *scale;
     //magma_int_t   incx;
     double *cnorm;
+    std::atomic< magma_int_t >* iinfo;
 };
 
 
@@ -90,7 +119,8 @@ public:
         const magmaDoubleComplex *in_A, magma_int_t in_lda,
         const magmaDoubleComplex *in_B, magma_int_t in_ldb,
         magmaDoubleComplex  in_beta,
-        magmaDoubleComplex *in_C, magma_int_t in_ldc
+        magmaDoubleComplex *in_C, magma_int_t in_ldc,
+        std::atomic< magma_timer_t >* in_time_sum = NULL
     ):
         transA( in_transA ),
         transB( in_transB ),
@@ -104,13 +134,17 @@ public:
         ldb   ( in_ldb    ),
         beta  ( in_beta   ),
         C     ( in_C      ),
-        ldc   ( in_ldc    )
+        ldc   ( in_ldc    ),
+        time_sum( in_time_sum )
     {}
     
     virtual void run()
     {
+        magma_timer_t time=0;
+        timer_start( time );
         blasf77_zgemm( lapack_trans_const(transA), lapack_trans_const(transB),
                        &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc );
+        magma_ztrevc3_timer_add( time_sum, timer_stop( time ));
     }
     
 private:
@@ -127,6 +161,131 @@ private:
     magmaDoubleComplex        beta;
     magmaDoubleComplex       *C;
     magma_int_t   ldc;
+    std::atomic< magma_timer_t >* time_sum;
+};
+
+
+// ---------------------------------------------
+// forms the right-hand side for eigenvector ki in x and solves for it
+// with zlatrsd (on CPU), as the unblocked code does in the master thread.
+// For side = MagmaRight, x = [ -T(0:ki-1,ki); 1; 0 ], and solves
+//     [ T(0:ki-1,0:ki-1) - T(ki,ki) ]*X = scale*x(0:ki-1).
+// For side = MagmaLeft,  x = [ 0; 1; -T(ki,ki+1:n-1)**H ], and solves
+//     [ T(ki+1:n-1,ki+1:n-1) - T(ki,ki) ]**H * X = scale*x(ki+1:n-1).
+// scale is stored in x(ki).
+class magma_ztrevc3_solve_task: public magma_task
+{
+public:
+    magma_ztrevc3_solve_task(
+        magma_side_t in_side, magma_int_t in_n, magma_int_t in_ki,
+        const magmaDoubleComplex *in_T, magma_int_t in_ldt,
+        magmaDoubleComplex *in_x,
+        double *in_cnorm,
+        std::atomic< magma_int_t >* in_iinfo,
+        std::atomic< magma_timer_t >* in_time_sum
+    ):
+        side  ( in_side   ),
+        n     ( in_n      ),
+        ki    ( in_ki     ),
+        T     ( in_T      ),
+        ldt   ( in_ldt    ),
+        x     ( in_x      ),
+        cnorm ( in_cnorm  ),
+        iinfo ( in_iinfo  ),
+        time_sum( in_time_sum )
+    {}
+    
+    virtual void run()
+    {
+        const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+        const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+        magma_timer_t time=0;
+        magma_int_t info = 0;
+        magma_int_t k, n2;
+        double s;
+        
+        timer_start( time );
+        x[ki] = c_one;
+        if ( side == MagmaRight ) {
+            for( k=0; k < ki; ++k ) {
+                x[k] = -T[ k + ki*ldt ];
+            }
+            for( k=ki+1; k < n; ++k ) {
+                x[k] = c_zero;
+            }
+            if ( ki > 0 ) {
+                magma_zlatrsd( MagmaUpper, MagmaNoTrans, MagmaNonUnit, MagmaTrue,
+                               ki, T, ldt, T[ ki + ki*ldt ], x, &s, cnorm, &info );
+                x[ki] = MAGMA_Z_MAKE( s, 0 );
+            }
+        }
+        else {
+            for( k=0; k < ki; ++k ) {
+                x[k] = c_zero;
+            }
+            for( k=ki+1; k < n; ++k ) {
+                x[k] = -MAGMA_Z_CONJ( T[ ki + k*ldt ] );
+            }
+            if ( ki < n-1 ) {
+                n2 = n-ki-1;
+                magma_zlatrsd( MagmaUpper, MagmaConjTrans, MagmaNonUnit, MagmaTrue,
+                               n2, &T[ (ki+1) + (ki+1)*ldt ], ldt, T[ ki + ki*ldt ],
+                               &x[ki+1], &s, cnorm, &info );
+                x[ki] = MAGMA_Z_MAKE( s, 0 );
+            }
+        }
+        magma_ztrevc3_info_set( iinfo, info );
+        magma_ztrevc3_timer_add( time_sum, timer_stop( time ));
+    }
+    
+private:
+    magma_side_t  side;
+    magma_int_t   n;
+    magma_int_t   ki;
+    const magmaDoubleComplex *T;
+    magma_int_t   ldt;
+    magmaDoubleComplex *x;
+    double *cnorm;
+    std::atomic< magma_int_t >* iinfo;
+    std::atomic< magma_timer_t >* time_sum;
+};
+
+
+// ---------------------------------------------
+// normalizes back-transformed vector y so that the element of largest
+// magnitude has magnitude 1, and copies it to v (on CPU)
+class magma_ztrevc3_normalize_task: public magma_task
+{
+public:
+    magma_ztrevc3_normalize_task(
+        magma_int_t in_n,
+        magmaDoubleComplex *in_y,
+        magmaDoubleComplex *in_v,
+        std::atomic< magma_timer_t >* in_time_sum
+    ):
+        n     ( in_n      ),
+        y     ( in_y      ),
+        v     ( in_v      ),
+        time_sum( in_time_sum )
+    {}
+    
+    virtual void run()
+    {
+        const magma_int_t ione = 1;
+        magma_timer_t time=0;
+        timer_start( time );
+        magma_int_t ii = blasf77_izamax( &n, y, &ione ) - 1;
+        double remax = 1. / MAGMA_Z_ABS1( y[ii] );
+        blasf77_zdscal( &n, &remax, y, &ione );
+        blasf77_zcopy( &n, y, &ione, v, &ione );
+        magma_ztrevc3_timer_add( time_sum, timer_stop( time ));
+    }
+    
+private:
+    magma_int_t   n;
+    magmaDoubleComplex *y;
+    magmaDoubleComplex *v;
+    std::atomic< magma_timer_t >* time_sum;
 };
 
 
@@ -154,7 +313,11 @@ private:
     left eigenvectors of A.
 
     This uses a Level 3 BLAS version of the back transformation.
-    This uses a multi-threaded (mt) implementation.
+    This uses a multi-threaded (mt) implementation: the triangular solves
+    for a block of eigenvectors run in parallel, and the back-transformation
+    of each block is split into several gemm tasks. With enough workspace,
+    the solves for the next block overlap the back-transformation of the
+    current block.
 
     Arguments
     ---------
@@ -247,7 +410,9 @@ private:
     lwork    INTEGER
              The dimension of array work. lwork >= max(1,2*n).
              For optimum performance, lwork >= (1 + 2*nb)*n, where nb is
-             the optimal blocksize.
+             the optimal blocksize. When back-transforming
+             (howmany = MagmaBacktransVec), lwork >= (1 + 3*nb)*n
+             overlaps the triangular solves with the back-transformation.
 
     @param[out]
     rwork    double array, dimension (n)
@@ -255,7 +420,8 @@ private:
     @param[out]
     info     INTEGER
        -     = 0:  successful exit
-       -     < 0:  if info = -i, the i-th argument had an illegal value
+       -     < 0:  if info = -i, the i-th argument had an illegal value,
+                   or a triangular solve (zlatrsd) returned info = -i
 
     Further Details
     ---------------
@@ -298,6 +464,7 @@ magma_int_t magma_ztrevc3_mt(
     // .. Local Scalars ..
     magma_int_t            allv, bothv, leftv, over, rightv, somev;
     magma_int_t            i, ii, is, j, k, ki, iv, n2, nb, nb2, version;
+    magma_int_t            nxbuf, xbuf, xoff, yoff;
     double                 ovfl, remax, unfl;  //smlnum, smin, ulp
     
     // Decode and test the input parameters
@@ -353,14 +520,20 @@ magma_int_t magma_ztrevc3_mt(
     
     // Use blocked version (2) if sufficient workspace.
     // Requires 1 vector to save diagonal elements, and 2*nb vectors for x and Q*x.
+    // If back-transforming with 3*nb vectors, x is double buffered (nxbuf = 2),
+    // so the solves for the next block can run during the gemm of this block.
     // (Compared to dtrevc3, rwork stores 1-norms.)
     // Zero-out the workspace to avoid potential NaN propagation.
     nb = 2;
+    nxbuf = 1;
+    if ( over && lwork >= n + 3*n*nbmin ) {
+        nxbuf = 2;
+    }
     if ( lwork >= n + 2*n*nbmin ) {
         version = 2;
-        nb = (lwork - n) / (2*n);
+        nb = (lwork - n) / ((1 + nxbuf)*n);
         nb = min( nb, nbmax );
-        nb2 = 1 + 2*nb;
+        nb2 = 1 + (1 + nxbuf)*nb;
         lapackf77_zlaset( "F", &n, &nb2, &c_zero, &c_zero, work, &n );
     }
     else {
@@ -386,7 +559,7 @@ magma_int_t magma_ztrevc3_mt(
         rwork[j] = magma_cblas_dzasum( j, T(0,j), ione );
     }
 
-    // launch threads -- each single-threaded MKL
+    // use nthread threads of the shared pool -- each single-threaded MKL
     magma_int_t nthread = magma_get_parallel_numthreads();
     magma_int_t lapack_nthread = magma_get_lapack_numthreads();
     magma_set_lapack_numthreads( 1 );
@@ -401,8 +574,23 @@ magma_int_t magma_ztrevc3_mt(
         gemm_nb += 32;
     }
     
-    magma_timer_t time_total=0, time_trsv=0, time_gemm=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
+    magma_timer_t time_total=0, time_trsv=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
     timer_start( time_total );
+    
+    // Blocked version of back-transform is pipelined through task dependencies
+    // instead of syncs: the solves of a block wait for the gemm of the last block
+    // that used the same x buffer; the gemm waits for the solves of its block
+    // and for the previous block's normalize tasks to release Q*x.
+    // Columns 1:nb of work are x buffer 0, nb+1:2*nb x buffer 1 (if nxbuf = 2),
+    // and the last nb columns Q*x. Tasks sum their time per phase; with
+    // overlap, these are thread-seconds rather than elapsed time.
+    std::vector< magma_task_handle > solve_tasks, normalize_tasks, gemm_tasks, deps;
+    std::vector< magma_task_handle > xbuf_tasks[2];
+    std::atomic< magma_timer_t > time_trsv_task( 0 ), time_gemm_task( 0 ), time_norm_task( 0 );
+    std::atomic< magma_int_t > iinfo( 0 );
+    xbuf = 0;
+    xoff = 0;
+    yoff = nxbuf*nb;
 
     if ( rightv ) {
         // ============================================================
@@ -426,6 +614,62 @@ magma_int_t magma_ztrevc3_mt(
             }
             //smin = max( ulp*MAGMA_Z_ABS1( *T(ki,ki) ), smlnum );
 
+            if ( over && version == 2 ) {
+                // ------------------------------
+                // version 2: blocked back-transform, pipelined.
+                // Task forms the right-hand side and solves for vector ki.
+                solve_tasks.push_back( queue.push_task(
+                    new magma_ztrevc3_solve_task(
+                        MagmaRight, n, ki, T, ldt, work(0,xoff+iv), rwork,
+                        &iinfo, &time_trsv_task ),
+                    xbuf_tasks[xbuf].data(), xbuf_tasks[xbuf].size() ));
+
+                // Columns iv:nb of x buffer are valid vectors.
+                // When the number of vectors stored reaches nb,
+                // or if this was last vector, do the GEMM
+                if ( (iv == 1) || (ki == 0) ) {
+                    nb2 = nb-iv+1;
+                    n2  = ki+nb-iv+1;
+                    
+                    // split gemm into multiple tasks, each doing one block row
+                    deps = solve_tasks;
+                    deps.insert( deps.end(), normalize_tasks.begin(), normalize_tasks.end() );
+                    gemm_tasks.clear();
+                    for( i=0; i < n; i += gemm_nb ) {
+                        magma_int_t ib = min( gemm_nb, n-i );
+                        gemm_tasks.push_back( queue.push_task(
+                            new zgemm_task(
+                                MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
+                                VR(i,0), ldvr,
+                                work(0,xoff+iv), n, c_zero,
+                                work(i,yoff+iv), n, &time_gemm_task ),
+                            deps.data(), deps.size() ));
+                    }
+                    
+                    // normalize vectors and copy to VR
+                    // TODO if somev, should copy vectors individually to correct location.
+                    normalize_tasks.clear();
+                    for( k = iv; k <= nb; ++k ) {
+                        normalize_tasks.push_back( queue.push_task(
+                            new magma_ztrevc3_normalize_task(
+                                n, work(0,yoff+k), VR(0,ki+k-iv), &time_norm_task ),
+                            gemm_tasks.data(), gemm_tasks.size() ));
+                    }
+                    
+                    // next block uses the other x buffer
+                    xbuf_tasks[xbuf] = gemm_tasks;
+                    solve_tasks.clear();
+                    xbuf = (xbuf + 1) % nxbuf;
+                    xoff = xbuf*nb;
+                    iv = nb;
+                }
+                else {
+                    iv -= 1;
+                }
+                is -= 1;
+                continue;
+            }
+
             // --------------------------------------------------------
             // Complex right eigenvector
             *work(ki,iv) = c_one;
@@ -441,7 +685,7 @@ magma_int_t magma_ztrevc3_mt(
                 queue.push_task( new magma_zlatrsd_task(
                     MagmaUpper, MagmaNoTrans, MagmaNonUnit, MagmaTrue,
                     ki, T, ldt, *T(ki,ki),
-                    work(0,iv), work(ki,iv), rwork ));
+                    work(0,iv), work(ki,iv), rwork, &iinfo ));
             }
 
             // Copy the vector x or Q*x to VR and normalize.
@@ -478,60 +722,11 @@ magma_int_t magma_ztrevc3_mt(
                 blasf77_zdscal( &n, &remax, VR(0,ki), &ione );
                 timer_start( time_trsv );
             }
-            else if ( version == 2 ) {
-                // ------------------------------
-                // version 2: back-transform block of vectors with GEMM
-                // zero out below vector
-                for( k=ki+1; k < n; ++k ) {
-                    *work(k,iv) = c_zero;
-                }
-
-                // Columns iv:nb of work are valid vectors.
-                // When the number of vectors stored reaches nb,
-                // or if this was last vector, do the GEMM
-                if ( (iv == 1) || (ki == 0) ) {
-                    queue.sync();
-                    time_trsv_sum += timer_stop( time_trsv );
-                    timer_start( time_gemm );
-                    nb2 = nb-iv+1;
-                    n2  = ki+nb-iv+1;
-                    
-                    // split gemm into multiple tasks, each doing one block row
-                    for( i=0; i < n; i += gemm_nb ) {
-                        magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new zgemm_task(
-                            MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
-                            VR(i,0), ldvr,
-                            work(0,iv   ), n, c_zero,
-                            work(i,nb+iv), n ));
-                    }
-                    queue.sync();
-                    time_gemm_sum += timer_stop( time_gemm );
-                    
-                    // normalize vectors
-                    // TODO if somev, should copy vectors individually to correct location.
-                    for( k = iv; k <= nb; ++k ) {
-                        ii = blasf77_izamax( &n, work(0,nb+k), &ione ) - 1;
-                        remax = 1. / MAGMA_Z_ABS1( *work(ii,nb+k) );
-                        blasf77_zdscal( &n, &remax, work(0,nb+k), &ione );
-                    }
-                    lapackf77_zlacpy( "F", &n, &nb2, work(0,nb+iv), &n, VR(0,ki), &ldvr );
-                    iv = nb;
-                    timer_start( time_trsv );
-                }
-                else {
-                    iv -= 1;
-                }
-            } // blocked back-transform
 
             is -= 1;
         }
     }
     timer_stop( time_trsv );
-    
-    timer_stop( time_total );
-    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, total %.4f\n",
-                  time_trsv_sum, time_gemm_sum, time_gemv_sum, time_total );
 
     if ( leftv ) {
         // ============================================================
@@ -550,6 +745,60 @@ magma_int_t magma_ztrevc3_mt(
             }
             //smin = max( ulp*MAGMA_Z_ABS1( *T(ki,ki) ), smlnum );
         
+            if ( over && version == 2 ) {
+                // ------------------------------
+                // version 2: blocked back-transform, pipelined.
+                // Task forms the right-hand side and solves for vector ki.
+                solve_tasks.push_back( queue.push_task(
+                    new magma_ztrevc3_solve_task(
+                        MagmaLeft, n, ki, T, ldt, work(0,xoff+iv), rwork,
+                        &iinfo, &time_trsv_task ),
+                    xbuf_tasks[xbuf].data(), xbuf_tasks[xbuf].size() ));
+        
+                // Columns 1:iv of x buffer are valid vectors.
+                // When the number of vectors stored reaches nb,
+                // or if this was last vector, do the GEMM
+                if ( (iv == nb) || (ki == n-1) ) {
+                    n2 = n-(ki+1)+iv;
+                    
+                    // split gemm into multiple tasks, each doing one block row
+                    deps = solve_tasks;
+                    deps.insert( deps.end(), normalize_tasks.begin(), normalize_tasks.end() );
+                    gemm_tasks.clear();
+                    for( i=0; i < n; i += gemm_nb ) {
+                        magma_int_t ib = min( gemm_nb, n-i );
+                        gemm_tasks.push_back( queue.push_task(
+                            new zgemm_task(
+                                MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
+                                VL(i,ki-iv+1), ldvl,
+                                work(ki-iv+1,xoff+1), n, c_zero,
+                                work(i,yoff+1), n, &time_gemm_task ),
+                            deps.data(), deps.size() ));
+                    }
+                    
+                    // normalize vectors and copy to VL
+                    normalize_tasks.clear();
+                    for( k=1; k <= iv; ++k ) {
+                        normalize_tasks.push_back( queue.push_task(
+                            new magma_ztrevc3_normalize_task(
+                                n, work(0,yoff+k), VL(0,ki-iv+k), &time_norm_task ),
+                            gemm_tasks.data(), gemm_tasks.size() ));
+                    }
+                    
+                    // next block uses the other x buffer
+                    xbuf_tasks[xbuf] = gemm_tasks;
+                    solve_tasks.clear();
+                    xbuf = (xbuf + 1) % nxbuf;
+                    xoff = xbuf*nb;
+                    iv = 1;
+                }
+                else {
+                    iv += 1;
+                }
+                is += 1;
+                continue;
+            }
+        
             // --------------------------------------------------------
             // Complex left eigenvector
             *work(ki,iv) = c_one;
@@ -567,7 +816,7 @@ magma_int_t magma_ztrevc3_mt(
                 queue.push_task( new magma_zlatrsd_task(
                     MagmaUpper, MagmaConjTrans, MagmaNonUnit, MagmaTrue,
                     n2, T(ki+1,ki+1), ldt, *T(ki,ki),
-                    work(ki+1,iv), work(ki,iv), rwork ));
+                    work(ki+1,iv), work(ki,iv), rwork, &iinfo ));
             }
             
             // Copy the vector x or Q*x to VL and normalize.
@@ -601,53 +850,29 @@ magma_int_t magma_ztrevc3_mt(
                 remax = 1. / MAGMA_Z_ABS1( *VL(ii,ki) );
                 blasf77_zdscal( &n, &remax, VL(0,ki), &ione );
             }
-            else if ( version == 2 ) {
-                // ------------------------------
-                // version 2: back-transform block of vectors with GEMM
-                // zero out above vector
-                // could go from (ki+1)-NV+1 to ki
-                for( k=0; k < ki; ++k ) {
-                    *work(k,iv) = c_zero;
-                }
-        
-                // Columns 1:iv of work are valid vectors.
-                // When the number of vectors stored reaches nb,
-                // or if this was last vector, do the GEMM
-                if ( (iv == nb) || (ki == n-1) ) {
-                    queue.sync();
-                    n2 = n-(ki+1)+iv;
-                    
-                    // split gemm into multiple tasks, each doing one block row
-                    for( i=0; i < n; i += gemm_nb ) {
-                        magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new zgemm_task(
-                            MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
-                            VL(i,ki-iv+1), ldvl,
-                            work(ki-iv+1,1), n, c_zero,
-                            work(i,nb+1), n ));
-                    }
-                    queue.sync();
-                    // normalize vectors
-                    for( k=1; k <= iv; ++k ) {
-                        ii = blasf77_izamax( &n, work(0,nb+k), &ione ) - 1;
-                        remax = 1. / MAGMA_Z_ABS1( *work(ii,nb+k) );
-                        blasf77_zdscal( &n, &remax, work(0,nb+k), &ione );
-                    }
-                    lapackf77_zlacpy( "F", &n, &iv, work(0,nb+1), &n, VL(0,ki-iv+1), &ldvl );
-                    iv = 1;
-                }
-                else {
-                    iv += 1;
-                }
-            } // blocked back-transform
         
             is += 1;
         }
     }
     
-    // close down threads
+    // wait for remaining tasks; pool threads stay alive for the next call
     queue.quit();
     magma_set_lapack_numthreads( lapack_nthread );
+    if ( iinfo.load() != 0 ) {
+        *info = iinfo.load();
+    }
+    
+    timer_stop( time_total );
+    time_trsv_sum += time_trsv_task.load();
+    time_gemm_sum += time_gemm_task.load();
+    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, normalize %.4f, total %.4f\n",
+                  time_trsv_sum, time_gemm_sum, time_gemv_sum,
+                  time_norm_task.load(), time_total );
+    timer_record( "ztrevc3_mt", "trsv",      time_trsv_sum );
+    timer_record( "ztrevc3_mt", "gemm",      time_gemm_sum );
+    timer_record( "ztrevc3_mt", "gemv",      time_gemv_sum );
+    timer_record( "ztrevc3_mt", "normalize", time_norm_task.load() );
+    timer_record( "ztrevc3_mt", "total",     time_total );
     
     return *info;
 }  // End of ZTREVC
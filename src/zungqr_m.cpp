@@ -165,8 +165,6 @@ magma_zungqr_m(
         magma_queue_create( d, &queues[d] );
     }
     
-    trace_init( 1, ngpu, 1, queues );
-    
     // first kk columns are handled by blocked method.
     // ki is start of 2nd-to-last block
     if ((nb > 1) && (nb < k)) {
@@ -187,13 +185,15 @@ magma_zungqr_m(
         *info = MAGMA_ERR_HOST_ALLOC;
         goto cleanup;
     }
+    trace_init( ngpu, 1, queues );
+
     magmaDoubleComplex *work_T, *work_V;
     work_T = work + n*nb;
     work_V = work + n*nb + nb*nb;
 
     // Use unblocked code for the last or only block.
     if (kk < n) {
-        trace_cpu_start( 0, "ungqr", "ungqr last block" );
+        trace_cpu_start( "ungqr", "ungqr last block" );
         m_kk = m - kk;
         n_kk = n - kk;
         k_kk = k - kk;
@@ -229,7 +229,7 @@ magma_zungqr_m(
                 magmablas_zlaset( MagmaFull, kk, jb, c_zero, c_zero, dA(d, 0, di), ldda, queues[d] );
             }
         }
-        trace_cpu_end( 0 );
+        trace_cpu_end();
     }
 
     if (kk > 0) {
@@ -284,16 +284,12 @@ magma_zungqr_m(
         }
         
         // copy result back to CPU
-        trace_cpu_start( 0, "get", "get A" );
+        trace_cpu_start( "get", "get A" );
         magma_zgetmatrix_1D_col_bcyclic( ngpu, m, n, nb, dA, ldda, A, lda, queues );
-        trace_cpu_end( 0 );
+        trace_cpu_end();
     }
     
-    #ifdef TRACING
-    char name[80];
-    snprintf( name, sizeof(name), "zungqr-n%lld-ngpu%lld.svg", (long long) m, (long long) ngpu );
-    trace_finalize( name, "trace.css" );
-    #endif
+    trace_finalize();
     
 cleanup:
     for( d = 0; d < ngpu; ++d ) {
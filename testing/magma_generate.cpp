@@ -10,6 +10,7 @@
        Test matrix generation.
 */
 
+#include <cstdint>
 #include <exception>
 #include <string>
 #include <vector>
@@ -20,6 +21,7 @@
 #include "magma_operators.h"
 
 #include "magma_matrix.hpp"
+#include "../control/magma_threadsetting.h"  // internal header
 
 // last (defines macros that conflict with std headers)
 #include "testings.h"
@@ -98,6 +100,240 @@ inline bool contains( std::string const &str, std::string const &pattern )
 }
 
 
+/******************************************************************************/
+// Counter-based random numbers: Philox4x32-10.
+// See: Salmon, Moraes, Dror, and Shaw, Parallel random numbers: as easy as
+// 1, 2, 3, SC 2011.
+// Entry (i,j) of a random matrix depends only on the key and on (i,j),
+// so any tile can be generated independently, by any thread, in any order,
+// and the matrix does not depend on lda or on the number of threads.
+struct magma_philox_t
+{
+    uint32_t v[4];
+};
+
+inline magma_philox_t magma_philox( uint64_t key, uint64_t i, uint64_t j )
+{
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;  // multipliers
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;  // Weyl key increments
+
+    uint32_t c0 = uint32_t( i ), c1 = uint32_t( i >> 32 );
+    uint32_t c2 = uint32_t( j ), c3 = uint32_t( j >> 32 );
+    uint32_t k0 = uint32_t( key ), k1 = uint32_t( key >> 32 );
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = uint64_t( M0 ) * c0;
+        uint64_t p1 = uint64_t( M1 ) * c2;
+        c0 = uint32_t( p1 >> 32 ) ^ c1 ^ k0;
+        c1 = uint32_t( p1 );
+        c2 = uint32_t( p0 >> 32 ) ^ c3 ^ k1;
+        c3 = uint32_t( p0 );
+        k0 += W0;
+        k1 += W1;
+    }
+    magma_philox_t r = {{ c0, c1, c2, c3 }};
+    return r;
+}
+
+/******************************************************************************/
+// uniform on (0, 1), from the high bits of (hi, lo); never 0, so log is safe
+template< typename real_t >
+inline real_t magma_philox_uniform( uint32_t hi, uint32_t lo );
+
+template<>
+inline float magma_philox_uniform( uint32_t hi, uint32_t lo )
+{
+    return ((hi >> 8) + 0.5f) * (1.0f / 16777216.0f);  // 2^24
+}
+
+template<>
+inline double magma_philox_uniform( uint32_t hi, uint32_t lo )
+{
+    uint64_t bits = (uint64_t( hi ) << 32) | lo;
+    return ((bits >> 11) + 0.5) * (1.0 / 9007199254740992.0);  // 2^53
+}
+
+/******************************************************************************/
+// Returns a Philox key made from the LAPACK seed, and advances the seed,
+// so consecutive calls get different streams, as consecutive larnv calls do.
+inline uint64_t magma_generate_key( magma_int_t iseed[4] )
+{
+    uint64_t key = 0;
+    for (int k = 0; k < 4; ++k) {
+        key = (key << 12) | (iseed[k] & 4095);
+    }
+    magma_philox_t r = magma_philox( ~key, 0, 0 );
+    iseed[0] =  r.v[0]        & 4095;
+    iseed[1] = (r.v[0] >> 12) & 4095;
+    iseed[2] =  r.v[1]        & 4095;
+    iseed[3] = ((r.v[1] >> 12) & 4095) | 1;  // larnv requires iseed[3] odd
+    return key;
+}
+
+/******************************************************************************/
+// Sets the mb-by-nb tile of A starting at entry (i0, j0) to random entries
+// with distribution idist, as in larnv, times scale. Entry (i,j) is
+// determined by key, i, and j alone.
+template< typename FloatT >
+void magma_generate_rand_tile(
+    magma_int_t idist, uint64_t key,
+    typename blas::traits<FloatT>::real_t scale,
+    magma_int_t i0, magma_int_t j0, magma_int_t mb, magma_int_t nb,
+    FloatT* A, magma_int_t lda )
+{
+    typedef typename blas::traits<FloatT>::real_t real_t;
+    const real_t twopi = 2 * 3.1415926535897932384626433832795;
+
+    for (magma_int_t j = 0; j < nb; ++j) {
+        FloatT* Aj = A + j*size_t(lda);
+        for (magma_int_t i = 0; i < mb; ++i) {
+            magma_philox_t r = magma_philox( key, i0 + i, j0 + j );
+            real_t u1 = magma_philox_uniform<real_t>( r.v[0], r.v[1] );
+            real_t u2 = magma_philox_uniform<real_t>( r.v[2], r.v[3] );
+            real_t re, im;
+            if (idist == idist_rand) {
+                re = u1;
+                im = u2;
+            }
+            else if (idist == idist_rands) {
+                re = 2*u1 - 1;
+                im = 2*u2 - 1;
+            }
+            else {
+                // Box-Muller
+                real_t rho = sqrt( -2 * log( u1 ));
+                re = rho * cos( twopi * u2 );
+                im = rho * sin( twopi * u2 );
+            }
+            Aj[ i ] = blas::traits<FloatT>::make( scale * re, scale * im );
+        }
+    }
+}
+
+/******************************************************************************/
+// Sets the m-by-n matrix A to random entries, as larnv on each column,
+// times scale, with a new key from iseed; tiles are generated in parallel.
+template< typename FloatT >
+void magma_generate_rand(
+    magma_int_t idist, magma_int_t iseed[4],
+    typename blas::traits<FloatT>::real_t scale,
+    Matrix<FloatT>& A )
+{
+    const magma_int_t nb = 256;
+    uint64_t key = magma_generate_key( iseed );
+    magma_int_t mt = magma_ceildiv( A.m, nb );
+    magma_int_t nt = magma_ceildiv( A.n, nb );
+    FloatT* A0 = A(0,0);
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (magma_int_t jt = 0; jt < nt; ++jt) {
+        for (magma_int_t it = 0; it < mt; ++it) {
+            magma_int_t i0 = it*nb;
+            magma_int_t j0 = jt*nb;
+            magma_generate_rand_tile( idist, key, scale,
+                                      i0, j0, min( nb, A.m - i0 ), min( nb, A.n - j0 ),
+                                      A0 + i0 + j0*size_t(A.ld), A.ld );
+        }
+    }
+}
+
+/******************************************************************************/
+// Sets A to offdiag, with diag on the diagonal, as laset( "general", ... ),
+// one column per thread at a time.
+template< typename FloatT >
+void magma_generate_laset( FloatT offdiag, FloatT diag, Matrix<FloatT>& A )
+{
+    FloatT* A0 = A(0,0);
+
+    #pragma omp parallel for schedule(static)
+    for (magma_int_t j = 0; j < A.n; ++j) {
+        FloatT* Aj = A0 + j*size_t(A.ld);
+        for (magma_int_t i = 0; i < A.m; ++i) {
+            Aj[ i ] = offdiag;
+        }
+        if (j < A.m) {
+            Aj[ j ] = diag;
+        }
+    }
+}
+
+/******************************************************************************/
+// Makes each column j of the random matrix V into a Householder vector of
+// length nq - j, as in geqrf but without updating the trailing columns,
+// so the columns are independent.
+template< typename FloatT >
+void magma_generate_householder(
+    magma_int_t nq, magma_int_t k, Matrix<FloatT>& V, Vector<FloatT>& tau )
+{
+    #pragma omp parallel for schedule(static)
+    for (magma_int_t j = 0; j < k; ++j) {
+        lapack::larfg( nq - j, V(j,j), V(j+1,j), 1, tau(j) );
+    }
+}
+
+/******************************************************************************/
+// Applies Q = H(1) ... H(k), with Householder vectors in V and tau, as
+// A = Q*A for side "Left" or A = A*Q^H for side "Right", like unmqr.
+// The triangular factors T of all blocks of reflectors are formed first;
+// then each thread applies all blocks to its own slice of columns (Left)
+// or rows (Right) of A, with no synchronization between blocks.
+template< typename FloatT >
+void magma_generate_unmqr(
+    const char* side, magma_int_t k,
+    Matrix<FloatT>& V, Vector<FloatT>& tau, Matrix<FloatT>& A )
+{
+    const magma_int_t nb = 64;
+    bool left = (*side == 'l' || *side == 'L');
+    magma_int_t nq = (left ? A.m : A.n);  // order of Q
+    magma_int_t nc = (left ? A.n : A.m);  // size of A split among threads
+    magma_int_t nblocks = magma_ceildiv( k, nb );
+    if (nc == 0 || k == 0) {
+        return;
+    }
+
+    // each thread calls a single-threaded BLAS
+    magma_int_t nthreads = magma_get_parallel_numthreads();
+    magma_int_t lapack_nthreads = magma_get_lapack_numthreads();
+    magma_set_lapack_numthreads( 1 );
+
+    Matrix<FloatT> T( nb, k );
+    #pragma omp parallel for schedule(dynamic) num_threads( nthreads )
+    for (magma_int_t b = 0; b < nblocks; ++b) {
+        magma_int_t j  = b*nb;
+        magma_int_t kb = min( nb, k - j );
+        lapack::larft( "Forward", "Columnwise", nq - j, kb,
+                       V(j,j), V.ld, tau(j), T(0,j), T.ld );
+    }
+
+    magma_int_t slice  = magma_ceildiv( nc, nthreads );
+    magma_int_t nslice = magma_ceildiv( nc, slice );
+    FloatT* A0 = A(0,0);
+
+    #pragma omp parallel for schedule(static) num_threads( nthreads )
+    for (magma_int_t s = 0; s < nslice; ++s) {
+        magma_int_t c0 = s*slice;
+        magma_int_t cb = min( slice, nc - c0 );
+        Vector<FloatT> work( cb*nb );
+        // Q = Q_1 ... Q_nblocks; both Q*A and A*Q^H apply the last block first
+        for (magma_int_t b = nblocks-1; b >= 0; --b) {
+            magma_int_t j  = b*nb;
+            magma_int_t kb = min( nb, k - j );
+            if (left) {
+                lapack::larfb( "Left", "NoTrans", "Forward", "Columnwise",
+                               nq - j, cb, kb, V(j,j), V.ld, T(0,j), T.ld,
+                               A0 + j + c0*size_t(A.ld), A.ld, work(0), cb );
+            }
+            else {
+                lapack::larfb( "Right", "ConjTrans", "Forward", "Columnwise",
+                               cb, nq - j, kb, V(j,j), V.ld, T(0,j), T.ld,
+                               A0 + c0 + j*size_t(A.ld), A.ld, work(0), cb );
+            }
+        }
+    }
+
+    magma_set_lapack_numthreads( lapack_nthreads );
+}
+
+
 /******************************************************************************/
 template< typename FloatT >
 void magma_generate_sigma(
@@ -205,15 +441,16 @@ void magma_generate_sigma(
 
     if (rand_sign) {
         // apply random signs
+        uint64_t key = magma_generate_key( opts.iseed );
         for (magma_int_t i = 0; i < minmn; ++i) {
-            if (rand() > RAND_MAX/2) {
+            if (magma_philox( key, i, 0 ).v[0] & 1) {
                 sigma[i] = -sigma[i];
             }
         }
     }
 
     // copy sigma => A
-    lapack::laset( "general", A.m, A.n, c_zero, c_zero, A(0,0), A.ld );
+    magma_generate_laset( c_zero, c_zero, A );
     for (magma_int_t i = 0; i < minmn; ++i) {
         *A(i,i) = blas::traits<FloatT>::make( sigma[i], 0 );
     }
@@ -291,32 +528,13 @@ void magma_generate_svd(
     typedef typename blas::traits<FloatT>::real_t real_t;
 
     // locals
-    FloatT tmp;
     magma_int_t m = A.m;
     magma_int_t n = A.n;
     magma_int_t maxmn = max( m, n );
     magma_int_t minmn = min( m, n );
-    magma_int_t sizeU;
-    magma_int_t info = 0;
     Matrix<FloatT> U( maxmn, minmn );
     Vector<FloatT> tau( minmn );
 
-    // query for workspace
-    magma_int_t lwork = -1;
-    lapack::unmqr( "Left", "NoTrans", A.m, A.n, minmn,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   &tmp, lwork, &info );
-    assert( info == 0 );
-    lwork = magma_int_t( real( tmp ));
-    magma_int_t lwork2 = -1;
-    lapack::unmqr( "Right", "ConjTrans", A.m, A.n, minmn,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   &tmp, lwork2, &info );
-    assert( info == 0 );
-    lwork2 = magma_int_t( real( tmp ));
-    lwork = max( lwork, lwork2 );
-    Vector<FloatT> work( lwork );
-
     // ----------
     magma_generate_sigma( opts, dist, false, cond, sigma_max, A, sigma );
 
@@ -335,31 +553,18 @@ void magma_generate_svd(
     // random U, m-by-minmn
     // just make each random column into a Householder vector;
     // no need to update subsequent columns (as in geqrf).
-    sizeU = U.size();
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
-    for (magma_int_t j = 0; j < minmn; ++j) {
-        magma_int_t mj = m - j;
-        lapack::larfg( mj, U(j,j), U(j+1,j), 1, tau(j) );
-    }
+    magma_generate_rand( idist_randn, opts.iseed, real_t(1), U );
+    magma_generate_householder( m, minmn, U, tau );
 
     // A = U*A
-    lapack::unmqr( "Left", "NoTrans", A.m, A.n, minmn,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   work(0), lwork, &info );
-    assert( info == 0 );
+    magma_generate_unmqr( "Left", minmn, U, tau, A );
 
     // random V, n-by-minmn (stored column-wise in U)
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
-    for (magma_int_t j = 0; j < minmn; ++j) {
-        magma_int_t nj = n - j;
-        lapack::larfg( nj, U(j,j), U(j+1,j), 1, tau(j) );
-    }
+    magma_generate_rand( idist_randn, opts.iseed, real_t(1), U );
+    magma_generate_householder( n, minmn, U, tau );
 
     // A = A*V^H
-    lapack::unmqr( "Right", "ConjTrans", A.m, A.n, minmn,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   work(0), lwork, &info );
-    assert( info == 0 );
+    magma_generate_unmqr( "Right", minmn, U, tau, A );
 
     if (condD != 1) {
         // A = A*W, W orthogonal, such that A has unit column norms
@@ -381,6 +586,7 @@ void magma_generate_svd(
             }
             printf( " ];\n" );
         }
+        #pragma omp parallel for schedule(static)
         for (magma_int_t j = 0; j < A.n; ++j) {
             for (magma_int_t i = 0; i < A.m; ++i) {
                 *A(i,j) = *A(i,j) * D[j];
@@ -406,53 +612,24 @@ void magma_generate_heev(
     assert( A.m == A.n );
 
     // locals
-    FloatT tmp;
     magma_int_t n = A.n;
-    magma_int_t sizeU;
-    magma_int_t info = 0;
     Matrix<FloatT> U( n, n );
     Vector<FloatT> tau( n );
 
-    // query for workspace
-    magma_int_t lwork = -1;
-    lapack::unmqr( "Left", "NoTrans", n, n, n,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   &tmp, lwork, &info );
-    assert( info == 0 );
-    lwork = magma_int_t( real( tmp ));
-    magma_int_t lwork2 = -1;
-    lapack::unmqr( "Right", "ConjTrans", n, n, n,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   &tmp, lwork2, &info );
-    assert( info == 0 );
-    lwork2 = magma_int_t( real( tmp ));
-    lwork = max( lwork, lwork2 );
-    Vector<FloatT> work( lwork );
-
     // ----------
     magma_generate_sigma( opts, dist, rand_sign, cond, sigma_max, A, sigma );
 
     // random U, n-by-n
     // just make each random column into a Householder vector;
     // no need to update subsequent columns (as in geqrf).
-    sizeU = U.size();
-    lapack::larnv( idist_randn, opts.iseed, sizeU, U(0,0) );
-    for (magma_int_t j = 0; j < n; ++j) {
-        magma_int_t nj = n - j;
-        lapack::larfg( nj, U(j,j), U(j+1,j), 1, tau(j) );
-    }
+    magma_generate_rand( idist_randn, opts.iseed, real_t(1), U );
+    magma_generate_householder( n, n, U, tau );
 
     // A = U*A
-    lapack::unmqr( "Left", "NoTrans", n, n, n,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   work(0), lwork, &info );
-    assert( info == 0 );
+    magma_generate_unmqr( "Left", n, U, tau, A );
 
     // A = A*U^H
-    lapack::unmqr( "Right", "ConjTrans", n, n, n,
-                   U(0,0), U.ld, tau(0), A(0,0), A.ld,
-                   work(0), lwork, &info );
-    assert( info == 0 );
+    magma_generate_unmqr( "Right", n, U, tau, A );
 
     // make diagonal real
     // usually LAPACK ignores imaginary part anyway, but Matlab doesn't
@@ -468,6 +645,7 @@ void magma_generate_heev(
         for (magma_int_t i = 0; i < n; ++i) {
             D[i] = exp( D[i] * range );
         }
+        #pragma omp parallel for schedule(static)
         for (magma_int_t j = 0; j < n; ++j) {
             for (magma_int_t i = 0; i < n; ++i) {
                 *A(i,j) = *A(i,j) * D[i] * D[j];
@@ -584,6 +762,11 @@ void magma_generate_geevx(
 
     [2] For randn, $Expected( \log( cond ) ) = \log( 4.65 n )$ [Edelman, 1988].
 
+    Random entries, and the random orthogonal matrices, come from the
+    counter-based Philox generator, keyed by opts.iseed: entry (i,j) depends
+    only on the seed and on (i,j). Tiles are generated in parallel, and the
+    matrix is the same for any lda and number of threads.
+
 
     [%] optional distribution suffix for Sigma or Lambda
     ----------------------------
@@ -776,16 +959,16 @@ void magma_generate_matrix(
     // ----- generate matrix
     switch (type) {
         case MatrixType::zero:
-            lapack::laset( "general", A.m, A.n, c_zero, c_zero, A(0,0), A.ld );
+            magma_generate_laset( c_zero, c_zero, A );
             lapack::laset( "general", sigma.n, 1, d_zero, d_zero, sigma(0), sigma.n );
             break;
 
         case MatrixType::ones:
-            lapack::laset( "general", A.m, A.n, c_one, c_one, A(0,0), A.ld );
+            magma_generate_laset( c_one, c_one, A );
             break;
 
         case MatrixType::identity:
-            lapack::laset( "general", A.m, A.n, c_zero, c_one, A(0,0), A.ld );
+            magma_generate_laset( c_zero, c_one, A );
             lapack::laset( "general", sigma.n, 1, d_one, d_one, sigma(0), sigma.n );
             break;
 
@@ -798,7 +981,7 @@ void magma_generate_matrix(
 
         case MatrixType::kronecker: {
             FloatT diag = blas::traits<FloatT>::make( 1 + A.m / cond, 0 );
-            lapack::laset( "general", A.m, A.n, c_one, diag, A(0,0), A.ld );
+            magma_generate_laset( c_one, diag, A );
             break;
         }
 
@@ -806,12 +989,7 @@ void magma_generate_matrix(
         case MatrixType::rands:
         case MatrixType::randn: {
             magma_int_t idist = (magma_int_t) type;
-            magma_int_t sizeA = A.ld * A.n;
-            lapack::larnv( idist, opts.iseed, sizeA, A(0,0) );
-            if (sigma_max != 1) {
-                FloatT scale = blas::traits<FloatT>::make( sigma_max, 0 );
-                blas::scal( sizeA, scale, A(0,0), 1 );
-            }
+            magma_generate_rand( idist, opts.iseed, sigma_max, A );
             break;
         }
 
@@ -842,7 +1020,9 @@ void magma_generate_matrix(
 
     if (contains( name, "_dominant" )) {
         // make diagonally dominant; strict unless diagonal has zeros
-        for (int i = 0; i < minmn; ++i) {
+        // row and column i don't contain other diagonal entries
+        #pragma omp parallel for schedule(static)
+        for (magma_int_t i = 0; i < minmn; ++i) {
             real_t sum = max( blas::asum( A.m, A(0,i), 1    ),    // i-th col
                               blas::asum( A.n, A(i,0), A.ld ) );  // i-th row
             *A(i,i) = blas::traits<FloatT>::make( sum, 0 );
@@ -420,6 +420,104 @@ inline void larfg(
 }
 
 
+// -----------------------------------------------------------------------------
+inline void larft(
+    const char* direct, const char* storev,
+    magma_int_t n, magma_int_t k,
+    float* V,   magma_int_t ldv,
+    float* tau,
+    float* T,   magma_int_t ldt )
+{
+    lapackf77_slarft( direct, storev, &n, &k, V, &ldv, tau, T, &ldt );
+}
+
+inline void larft(
+    const char* direct, const char* storev,
+    magma_int_t n, magma_int_t k,
+    double* V,   magma_int_t ldv,
+    double* tau,
+    double* T,   magma_int_t ldt )
+{
+    lapackf77_dlarft( direct, storev, &n, &k, V, &ldv, tau, T, &ldt );
+}
+
+inline void larft(
+    const char* direct, const char* storev,
+    magma_int_t n, magma_int_t k,
+    magmaFloatComplex* V,   magma_int_t ldv,
+    magmaFloatComplex* tau,
+    magmaFloatComplex* T,   magma_int_t ldt )
+{
+    lapackf77_clarft( direct, storev, &n, &k, V, &ldv, tau, T, &ldt );
+}
+
+inline void larft(
+    const char* direct, const char* storev,
+    magma_int_t n, magma_int_t k,
+    magmaDoubleComplex* V,   magma_int_t ldv,
+    magmaDoubleComplex* tau,
+    magmaDoubleComplex* T,   magma_int_t ldt )
+{
+    lapackf77_zlarft( direct, storev, &n, &k, V, &ldv, tau, T, &ldt );
+}
+
+
+// -----------------------------------------------------------------------------
+inline void larfb(
+    const char* side, const char* trans, const char* direct, const char* storev,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    float* V,    magma_int_t ldv,
+    float* T,    magma_int_t ldt,
+    float* C,    magma_int_t ldc,
+    float* work, magma_int_t ldwork )
+{
+    if (*trans == 'c' || *trans == 'C') {
+        trans = "T";
+    }
+    lapackf77_slarfb( side, trans, direct, storev, &m, &n, &k,
+                      V, &ldv, T, &ldt, C, &ldc, work, &ldwork );
+}
+
+inline void larfb(
+    const char* side, const char* trans, const char* direct, const char* storev,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    double* V,    magma_int_t ldv,
+    double* T,    magma_int_t ldt,
+    double* C,    magma_int_t ldc,
+    double* work, magma_int_t ldwork )
+{
+    if (*trans == 'c' || *trans == 'C') {
+        trans = "T";
+    }
+    lapackf77_dlarfb( side, trans, direct, storev, &m, &n, &k,
+                      V, &ldv, T, &ldt, C, &ldc, work, &ldwork );
+}
+
+inline void larfb(
+    const char* side, const char* trans, const char* direct, const char* storev,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    magmaFloatComplex* V,    magma_int_t ldv,
+    magmaFloatComplex* T,    magma_int_t ldt,
+    magmaFloatComplex* C,    magma_int_t ldc,
+    magmaFloatComplex* work, magma_int_t ldwork )
+{
+    lapackf77_clarfb( side, trans, direct, storev, &m, &n, &k,
+                      V, &ldv, T, &ldt, C, &ldc, work, &ldwork );
+}
+
+inline void larfb(
+    const char* side, const char* trans, const char* direct, const char* storev,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    magmaDoubleComplex* V,    magma_int_t ldv,
+    magmaDoubleComplex* T,    magma_int_t ldt,
+    magmaDoubleComplex* C,    magma_int_t ldc,
+    magmaDoubleComplex* work, magma_int_t ldwork )
+{
+    lapackf77_zlarfb( side, trans, direct, storev, &m, &n, &k,
+                      V, &ldv, T, &ldt, C, &ldc, work, &ldwork );
+}
+
+
 // -----------------------------------------------------------------------------
 inline void laset(
     const char* uplo, magma_int_t m, magma_int_t n,
@@ -0,0 +1,189 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       Timing harness for the testers: repetitions, cache flushing,
+       and statistics of the samples.
+*/
+#include <algorithm>
+
+#include "magma_v2.h"
+#include "testings.h"
+
+
+// -----------------------------------------------------------------------------
+// relative change of median beyond which samples are considered drifting
+static const double drift_threshold = 0.05;
+
+
+// -----------------------------------------------------------------------------
+// median of sorted x[ begin : end-1 ]
+static double median_sorted( const std::vector<double>& x, size_t begin, size_t end )
+{
+    size_t n = end - begin;
+    if (n == 0) {
+        return NAN;
+    }
+    size_t mid = begin + n/2;
+    return (n % 2 == 1 ? x[ mid ] : 0.5*(x[ mid-1 ] + x[ mid ]));
+}
+
+
+// -----------------------------------------------------------------------------
+// median of x[ begin : end-1 ], unsorted
+static double median_range( const std::vector<double>& x, size_t begin, size_t end )
+{
+    std::vector<double> y( x.begin() + begin, x.begin() + end );
+    std::sort( y.begin(), y.end() );
+    return median_sorted( y, 0, y.size() );
+}
+
+
+// -----------------------------------------------------------------------------
+// nearest-rank percentile, 0 < p <= 1, of sorted x
+static double percentile_sorted( const std::vector<double>& x, double p )
+{
+    if (x.empty()) {
+        return NAN;
+    }
+    size_t rank = size_t( std::ceil( p * x.size() ));
+    return x[ max( rank, size_t(1) ) - 1 ];
+}
+
+
+/***************************************************************************//**
+    Timing harness with explicit settings, e.g., for the sparse testers,
+    which don't use magma_opts.
+
+    @param[in] nrep     Number of timed repetitions, >= 1.
+    @param[in] warmup   Whether to do one untimed run first.
+    @param[in] flush    If > 0, flush this many bytes of cache before each run.
+    @param[in] queue    If not NULL, synchronize queue before reading the
+                        clock (magma_sync_wtime); otherwise use magma_wtime.
+*******************************************************************************/
+magma_timing::magma_timing(
+    magma_int_t nrep, bool warmup, size_t flush, magma_queue_t queue )
+    : nrep( max( nrep, magma_int_t(1) )),
+      warmup( warmup ),
+      flush( flush ),
+      queue( queue )
+{
+    clear();
+}
+
+
+/***************************************************************************//**
+    Timing harness with settings from the command line:
+    --nrep, --[no]warmup, and --[no]flush with --cache.
+*******************************************************************************/
+magma_timing::magma_timing( const magma_opts& opts, magma_queue_t queue )
+    : nrep( opts.nrep ),
+      warmup( opts.warmup ),
+      flush( opts.flush ? size_t( opts.cache ) : 0 ),
+      queue( queue )
+{
+    clear();
+}
+
+
+// -----------------------------------------------------------------------------
+void magma_timing::clear()
+{
+    samples.clear();
+    min = median = p95 = p99 = max = mean = stddev = drift = NAN;
+    drifting = false;
+}
+
+
+// -----------------------------------------------------------------------------
+double magma_timing::wtime() const
+{
+    return (queue != NULL ? magma_sync_wtime( queue ) : magma_wtime());
+}
+
+
+// -----------------------------------------------------------------------------
+// flush cache, if requested, before a timed run
+void magma_timing::flush_cache() const
+{
+    if (flush > 0) {
+        magma_flush_cache( flush );
+    }
+}
+
+
+/***************************************************************************//**
+    Computes statistics of the samples. Percentiles use the nearest rank;
+    stddev is the sample standard deviation.
+
+    Drift compares the median of the first and last thirds of the samples,
+    in order of execution. It is flagged when they differ by more than 5%
+    and the median of the middle third lies between them, i.e., the times
+    trend steadily up (e.g., thermal throttling) or down (e.g., the clock
+    ramping up), rather than having a few outliers.
+*******************************************************************************/
+void magma_timing::compute()
+{
+    size_t n = samples.size();
+    if (n == 0) {
+        clear();
+        return;
+    }
+
+    std::vector<double> sorted( samples );
+    std::sort( sorted.begin(), sorted.end() );
+    min    = sorted.front();
+    max    = sorted.back();
+    median = median_sorted( sorted, 0, n );
+    p95    = percentile_sorted( sorted, 0.95 );
+    p99    = percentile_sorted( sorted, 0.99 );
+
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += samples[i];
+    }
+    mean = sum / n;
+    double ss = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ss += (samples[i] - mean) * (samples[i] - mean);
+    }
+    stddev = (n > 1 ? std::sqrt( ss / (n - 1) ) : 0.);
+
+    drift = NAN;
+    drifting = false;
+    if (n >= 6) {
+        size_t third = n / 3;
+        double first  = median_range( samples, 0, third );
+        double middle = median_range( samples, third, n - third );
+        double last   = median_range( samples, n - third, n );
+        if (first > 0) {
+            drift = (last - first) / first;
+            drifting = std::abs( drift ) > drift_threshold
+                       && ((first <= middle && middle <= last) ||
+                           (first >= middle && middle >= last));
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    Prints statistics as a comment line, if there was more than one
+    repetition, with a warning if the times drifted.
+*******************************************************************************/
+void magma_timing::print() const
+{
+    if (samples.size() <= 1) {
+        return;
+    }
+    printf( "%%   time (s) over %lld runs%s: min %.4e, median %.4e, p95 %.4e, p99 %.4e, stddev %.2e (%.1f%%)",
+            (long long) samples.size(), (flush > 0 ? ", cold cache" : ""),
+            min, median, p95, p99, stddev, (mean > 0 ? 100*stddev/mean : 0.) );
+    if (drifting) {
+        printf( ", drift %+.1f%%: warning, times trend %s; thermal or frequency scaling?",
+                100*drift, (drift > 0 ? "up" : "down") );
+    }
+    printf( "\n" );
+}
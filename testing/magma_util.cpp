@@ -18,6 +18,12 @@
 #include <omp.h>
 #endif
 
+#if defined( _WIN32 ) || defined( _WIN64 )
+#include <io.h>      // dup, dup2
+#else
+#include <unistd.h>  // dup, dup2
+#endif
+
 #include "magma_v2.h"
 #include "testings.h"
 
@@ -37,6 +43,9 @@
 #elif defined(MAGMA_HAVE_HIP)
     const char* g_platform_str = "HIPBLAS";
 
+#elif defined(MAGMA_HAVE_CPU)
+    const char* g_platform_str = "CPU BLAS";
+
 #else
     #error "unknown platform"
 #endif
@@ -113,6 +122,10 @@ const char *usage =
 "                   (Some testers take --ngpu -1 to run the multi-GPU code with 1 GPU.\n"
 "  --nsub x         Number of submatrices, default 1.\n"
 "  --niter x        Number of iterations to repeat each test, default 1.\n"
+"  --nrep x         Number of timed runs of the routine in each test, default 1; with nrep > 1,\n"
+"                   testers that support it print min, median, p95, p99, stddev, and drift\n"
+"                   of the times, and report the median.\n"
+"  --[no]flush      Whether to flush the cache (size set by --cache) before each timed run.\n"
 "  --nthread x      Number of CPU threads for some experimental codes, default 1.\n"
 "                   (For most testers, set $OMP_NUM_THREADS or $MKL_NUM_THREADS\n"
 "                    to control the number of CPU threads.)\n"
@@ -154,6 +167,12 @@ const char *usage =
 "  --cond   kA      where applicable, condition number for test matrix, default sqrt( 1/eps ); see magma_generate_matrix.\n"
 "  --condD  kD      where applicable, condition number for scaling test matrix, default 1; see magma_generate_matrix.\n"
 "\n"
+"  --format [text*|csv|json]  csv or json also prints one record per test with routine, precision,\n"
+"                   m, n, k, nb, nthread, version, time, Gflop/s, error, and status, in testers that support it,\n"
+"                   and nrep and the min, p95, p99, stddev, and drift of the times (see --nrep).\n"
+"                   Without --output, records go to stdout and the text output goes to stderr.\n"
+"  --output file    append the csv or json records to file; the text output stays on stdout.\n"
+"\n"
 "                   * default values\n";
 
 
@@ -173,6 +192,7 @@ magma_opts::magma_opts( magma_opts_t flag )
     this->ngpu     = magma_num_gpus();
     this->nsub     = 1;
     this->niter    = 1;
+    this->nrep     = 1;
     this->nthread  = 1;
     this->offset   = 0;
     this->itype    = 1;
@@ -194,6 +214,7 @@ magma_opts::magma_opts( magma_opts_t flag )
     this->magma     = true;
     this->lapack    = (getenv("MAGMA_RUN_LAPACK")     != NULL);
     this->warmup    = (getenv("MAGMA_WARMUP")         != NULL);
+    this->flush     = false;
 
     this->uplo      = MagmaLower;      // potrf, etc.
     this->transA    = MagmaNoTrans;    // gemm, etc.
@@ -213,6 +234,9 @@ magma_opts::magma_opts( magma_opts_t flag )
     this->iseed[2]  = 0;
     this->iseed[3]  = 1;
 
+    this->format    = MagmaFormatText;
+    this->output    = NULL;
+
     if ( flag == MagmaOptsBatched ) {
         // 32, 64, ..., 512
         this->default_nstart = 32;
@@ -412,6 +436,11 @@ void magma_opts::parse_opts( int argc, char** argv )
             magma_assert( this->niter > 0,
                           "error: --niter %s is invalid; ensure niter > 0.\n", argv[i] );
         }
+        else if ( strcmp("--nrep",    argv[i]) == 0 && i+1 < argc ) {
+            this->nrep = atoi( argv[++i] );
+            magma_assert( this->nrep > 0,
+                          "error: --nrep %s is invalid; ensure nrep > 0.\n", argv[i] );
+        }
         else if ( strcmp("--nthread", argv[i]) == 0 && i+1 < argc ) {
             this->nthread = atoi( argv[++i] );
             magma_assert( this->nthread > 0,
@@ -505,6 +534,9 @@ void magma_opts::parse_opts( int argc, char** argv )
         else if ( strcmp("--warmup",   argv[i]) == 0 ) { this->warmup = true;  }
         else if ( strcmp("--nowarmup", argv[i]) == 0 ) { this->warmup = false; }
 
+        else if ( strcmp("--flush",    argv[i]) == 0 ) { this->flush  = true;  }
+        else if ( strcmp("--noflush",  argv[i]) == 0 ) { this->flush  = false; }
+
         //else if ( strcmp("--all",      argv[i]) == 0 ) { this->all    = true;  }
         //else if ( strcmp("--notall",   argv[i]) == 0 ) { this->all    = false; }
 
@@ -614,6 +646,23 @@ void magma_opts::parse_opts( int argc, char** argv )
                           "error: --condD %s is invalid; ensure condD >= 1.\n", argv[i] );
         }
 
+        // ----- machine-readable output
+        else if ( strcmp("--format", argv[i]) == 0 && i+1 < argc ) {
+            i += 1;
+            if      ( strcmp( argv[i], "text" ) == 0 ) { this->format = MagmaFormatText; }
+            else if ( strcmp( argv[i], "csv"  ) == 0 ) { this->format = MagmaFormatCSV;  }
+            else if ( strcmp( argv[i], "json" ) == 0 ) { this->format = MagmaFormatJSON; }
+            else {
+                magma_assert( false, "error: --format '%s' is invalid; use text, csv, or json.\n", argv[i] );
+            }
+        }
+        else if ( strcmp("--output", argv[i]) == 0 && i+1 < argc ) {
+            i += 1;
+            this->output = fopen( argv[i], "a" );
+            magma_assert( this->output != NULL,
+                          "error: --output %s: cannot open: %s.\n", argv[i], strerror( errno ));
+        }
+
         // ----- usage
         else if ( strcmp("-h",     argv[i]) == 0 ||
                   strcmp("--help", argv[i]) == 0 ) {
@@ -650,6 +699,33 @@ void magma_opts::parse_opts( int argc, char** argv )
     }
     assert( this->ntest <= MAX_NTEST );
 
+    // records go to --output, else to stdout, with text moved to stderr
+    if ( this->format == MagmaFormatText ) {
+        if ( this->output != NULL ) {
+            fclose( this->output );
+            this->output = NULL;
+        }
+    }
+    else {
+        // csv header, unless appending to a file that has one
+        bool header = true;
+        if ( this->output == NULL ) {
+            fflush( stdout );
+            this->output = fdopen( dup( fileno( stdout )), "w" );
+            dup2( fileno( stderr ), fileno( stdout ));
+            setvbuf( stdout, NULL, _IOLBF, BUFSIZ );
+        }
+        else {
+            fseek( this->output, 0, SEEK_END );
+            header = (ftell( this->output ) == 0);
+        }
+        if ( this->format == MagmaFormatCSV && header ) {
+            fprintf( this->output, "routine,precision,m,n,k,nb,nthread,version,"
+                                   "time,gflops,error,status,"
+                                   "nrep,time_min,time_p95,time_p99,time_stddev,drift\n" );
+        }
+    }
+
     #if defined(MAGMA_HAVE_CUDA) || defined(MAGMA_HAVE_HIP)
     magma_setdevice( this->device );
     #endif
@@ -668,6 +744,8 @@ void magma_opts::parse_opts( int argc, char** argv )
     #elif defined(MAGMA_HAVE_CUDA)
         // handle for directly calling cublas
         this->handle = magma_queue_get_cublas_handle( this->queue );
+    #elif defined(MAGMA_HAVE_CPU)
+        // no vendor BLAS handle; queues execute host BLAS
     #else
         #error "unknown platform"
     #endif
@@ -675,6 +753,103 @@ void magma_opts::parse_opts( int argc, char** argv )
 // end parse_opts
 
 
+// -----------------------------------------------------------------------------
+// Formats x using fmt, or as null if x is not finite.
+static void format_value(
+    char* buf, size_t len, const char* fmt, double x, const char* null )
+{
+    if ( std::isfinite( x )) {
+        snprintf( buf, len, fmt, x );
+    }
+    else {
+        snprintf( buf, len, "%s", null );
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// Prints one test result as a record in the --format output, csv or json.
+// routine is the name with precision, e.g., "zgetrf_gpu"; pass NaN as error
+// if the result was not checked. Does nothing for text, the default, where
+// testers print their own tables.
+void magma_opts::record(
+    const char* routine,
+    magma_int_t m, magma_int_t n, magma_int_t k, magma_int_t nb,
+    double time, double gflops, double error, bool okay,
+    const magma_timing* timing )
+{
+    if ( this->format == MagmaFormatText || this->output == NULL ) {
+        return;
+    }
+
+    magma_int_t major, minor, micro;
+    magma_version( &major, &minor, &micro );
+    char version[ 64 ];
+    snprintf( version, sizeof(version), "%lld.%lld.%lld",
+              (long long) major, (long long) minor, (long long) micro );
+
+    // non-finite values (e.g., unchecked error) are empty in csv, null in json
+    const char* null = (this->format == MagmaFormatCSV ? "" : "null");
+    char s_time[ 32 ], s_gflops[ 32 ], s_error[ 32 ], s_status[ 32 ];
+    format_value( s_time,   sizeof(s_time),   "%.6e", time,   null );
+    format_value( s_gflops, sizeof(s_gflops), "%.4f", gflops, null );
+    format_value( s_error,  sizeof(s_error),  "%.2e", error,  null );
+
+    // without timing statistics, time was a single run
+    magma_int_t nrep = 1;
+    double t_min = time, t_p95 = time, t_p99 = time, t_stddev = NAN, drift = NAN;
+    if ( timing != NULL && ! timing->samples.empty() ) {
+        nrep     = timing->samples.size();
+        t_min    = timing->min;
+        t_p95    = timing->p95;
+        t_p99    = timing->p99;
+        t_stddev = timing->stddev;
+        drift    = timing->drift;
+    }
+    char s_min[ 32 ], s_p95[ 32 ], s_p99[ 32 ], s_stddev[ 32 ], s_drift[ 32 ];
+    format_value( s_min,    sizeof(s_min),    "%.6e", t_min,    null );
+    format_value( s_p95,    sizeof(s_p95),    "%.6e", t_p95,    null );
+    format_value( s_p99,    sizeof(s_p99),    "%.6e", t_p99,    null );
+    format_value( s_stddev, sizeof(s_stddev), "%.6e", t_stddev, null );
+    format_value( s_drift,  sizeof(s_drift),  "%.4f", drift,    null );
+
+    if ( std::isnan( error )) {
+        snprintf( s_status, sizeof(s_status), "%s", null );
+    }
+    else if ( this->format == MagmaFormatCSV ) {
+        snprintf( s_status, sizeof(s_status), "%s", (okay ? "ok" : "failed") );
+    }
+    else {
+        snprintf( s_status, sizeof(s_status), "\"%s\"", (okay ? "ok" : "failed") );
+    }
+
+    if ( this->format == MagmaFormatCSV ) {
+        fprintf( this->output, "%s,%c,%lld,%lld,%lld,%lld,%lld,%s,%s,%s,%s,%s,"
+                               "%lld,%s,%s,%s,%s,%s\n",
+                 routine, routine[0],
+                 (long long) m, (long long) n, (long long) k, (long long) nb,
+                 (long long) magma_get_parallel_numthreads(), version,
+                 s_time, s_gflops, s_error, s_status,
+                 (long long) nrep, s_min, s_p95, s_p99, s_stddev, s_drift );
+    }
+    else {
+        fprintf( this->output,
+                 "{\"routine\": \"%s\", \"precision\": \"%c\", "
+                 "\"m\": %lld, \"n\": %lld, \"k\": %lld, \"nb\": %lld, "
+                 "\"nthread\": %lld, \"version\": \"%s\", "
+                 "\"time\": %s, \"gflops\": %s, \"error\": %s, \"status\": %s, "
+                 "\"nrep\": %lld, \"time_min\": %s, \"time_p95\": %s, \"time_p99\": %s, "
+                 "\"time_stddev\": %s, \"drift\": %s}\n",
+                 routine, routine[0],
+                 (long long) m, (long long) n, (long long) k, (long long) nb,
+                 (long long) magma_get_parallel_numthreads(), version,
+                 s_time, s_gflops, s_error, s_status,
+                 (long long) nrep, s_min, s_p95, s_p99, s_stddev, s_drift );
+    }
+    fflush( this->output );
+}
+
+
 // -----------------------------------------------------------------------------
 void magma_opts::get_range(
     magma_int_t n, magma_range_t* range,
@@ -725,6 +900,17 @@ void magma_opts::get_range(
 // -----------------------------------------------------------------------------
 void magma_opts::cleanup()
 {
+    // phase breakdown of routines, with $MAGMA_TIMER=on
+    if ( magma_timer_get_mode() != MagmaTimerOff && magma_timer_count() > 0 ) {
+        printf( "\n" );
+        magma_timer_print();
+    }
+
+    if ( this->output != NULL ) {
+        fclose( this->output );
+        this->output = NULL;
+    }
+
     this->queue = NULL;
     magma_queue_destroy( this->queues2[0] );
     magma_queue_destroy( this->queues2[1] );
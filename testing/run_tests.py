@@ -201,6 +201,27 @@
 #       ########################################################################################################################
 #       other (lines that did not get matched):              0 commands,      0 tests
 #
+# Performance history
+# -------------------
+# The --history option saves a record of each test (routine, precision, sizes,
+# nb, nthread, MAGMA version, time, Gflop/s, error, status) in a local database,
+# using the testers' --format json output. The database is SQLite, or CSV if
+# its name ends in .csv. Each run is stored under --label, by default the date
+# and time. With --baseline, Gflop/s of each test is compared to the same
+# command and sizes in the run with that label; tests slower by more than
+# --threshold percent (default 10) are listed as regressions, and the script
+# exits with status 1. For repeated runs (--niter), the best Gflop/s is used.
+# Currently the LU, Cholesky, and QR testers (getrf, gesv, potrf, posv, geqrf)
+# write records. With --nrep, testers that support it time that many runs of
+# each test, optionally with the cache flushed before each (--flush), and
+# report the median time; the history also keeps the min, p95, p99, stddev,
+# and drift of the times.
+# For example, to check a new version against the current one:
+#
+#       ./run_tests.py --lu --chol -l --history perf.db --label 2.9.0 > base.txt
+#       (upgrade, re-compile)
+#       ./run_tests.py --lu --chol -l --history perf.db --label new --baseline 2.9.0 > new.txt
+#
 # The --dev option sets which GPU device to use.
 #
 # By default, a wide range of sizes and shapes (square, tall, wide) are tested,
@@ -210,9 +231,13 @@
 # testers accept --ngpu -1 to test the multi-GPU code on a single GPU.
 # (Using --ngpu 1 will usually invoke the single-GPU code.)
 
+import csv
+import json
 import os
 import re
+import sqlite3
 import sys
+import tempfile
 import time
 
 import subprocess
@@ -228,8 +253,14 @@ parser.add_option(      '--tol',        action='store',      help='set tolerance
 parser.add_option(      '--dev',        action='store',      help='set GPU device to use')
 parser.add_option(      '--batch',      action='store',      help='batch count for batched tests', default='100')
 parser.add_option(      '--niter',      action='store',      help='number of iterations to repeat', default='1')
+parser.add_option(      '--nrep',       action='store',      help='number of timed runs per test, in testers that support it', default='1')
+parser.add_option(      '--flush',      action='store_true', help='flush cache before each timed run, in testers that support it')
 parser.add_option(      '--ngpu',       action='store',      help='number of GPUs for multi-GPU tests; add --mgpu to run only multi-GPU tests', default='2')
 parser.add_option(      '--interactive',action='store_true', help='stop between tests')
+parser.add_option(      '--history',    action='store',      help='save performance records in given SQLite database, or CSV file if name ends in .csv')
+parser.add_option(      '--label',      action='store',      help='label of this run in the history; default is date and time')
+parser.add_option(      '--baseline',   action='store',      help='compare performance to run with given label in the history')
+parser.add_option(      '--threshold',  action='store',      help='slowdown in percent versus baseline to report as regression', default='10')
 
 # options to specify sizes
 parser.add_option(      '--xsmall',     action='store_true', help='run extra small tests, N=25:100:25, 32:128:32')
@@ -795,6 +826,8 @@ hesv = (
 	# no-pivot LDLt, CPU interface
 	('testing_zhetrf', '-L --version 3 -c2',  n,    ''),
 	('testing_zhetrf', '-U --version 3 -c2',  n,    ''),
+	('testing_zhetrf_nopiv_cpu',    '-L -c',  n,    ''),
+	('testing_zhetrf_nopiv_cpu',    '-U -c',  n,    ''),
 
 	# no-pivot LDLt, GPU interface
 	('testing_zhetrf', '-L --version 4 -c2',  n,    ''),
@@ -975,6 +1008,8 @@ syev = (
 	# ----------
 	# symmetric eigenvalues, 2-stage
 	# TODO test with --fraction < 1; checks don't seem to work.
+	('testing_zhetrd_hb2st',    '--nthread 4 -JN -c',        n,    ''),
+	('testing_zhetrd_hb2st',    '--nthread 4 -JV -c',        n,    ''),
 	('testing_zheevdx_2stage',  '--fraction 1.0 -L -JN -c',  n,    ''),
 	('testing_zheevdx_2stage',  '--fraction 1.0 -L -JV -c',  n,    ''),
 	('#testing_zheevdx_2stage', '--fraction 1.0 -U -JN -c',  n,    'upper not implemented'),
@@ -1705,6 +1740,107 @@ def run( cmd ):
 # end
 
 
+# ----------------------------------------------------------------------
+# performance history, for --history and --baseline
+history_fields = (
+	'label', 'date', 'command', 'routine', 'precision', 'm', 'n', 'k',
+	'nb', 'nthread', 'version', 'time', 'gflops', 'error', 'status',
+	'nrep', 'time_min', 'time_p95', 'time_p99', 'time_stddev', 'drift'
+)
+
+# ----------
+# appends records (list of dicts) to history file, SQLite or CSV
+def history_save( filename, records ):
+	if (filename.endswith( '.csv' )):
+		# keep the columns of an existing file, in its order
+		fields = history_fields
+		header = (not os.path.exists( filename ) or os.path.getsize( filename ) == 0)
+		if (not header):
+			with open( filename, newline='' ) as f:
+				fields = next( csv.reader( f ))
+		missing = [ field for field in history_fields if (field not in fields) ]
+		if (missing):
+			# add columns missing from an older file: rewrite it with the
+			# union of columns, with the new columns empty in old rows
+			with open( filename, newline='' ) as f:
+				old = list( csv.DictReader( f ))
+			fields = fields + missing
+			tmp = filename + '.tmp'
+			with open( tmp, 'w', newline='' ) as f:
+				writer = csv.DictWriter( f, fieldnames=fields, extrasaction='ignore' )
+				writer.writeheader()
+				writer.writerows( old )
+			os.replace( tmp, filename )
+		with open( filename, 'a', newline='' ) as f:
+			writer = csv.DictWriter( f, fieldnames=fields, extrasaction='ignore' )
+			if (header):
+				writer.writeheader()
+			writer.writerows( records )
+	else:
+		db = sqlite3.connect( filename )
+		db.execute( 'create table if not exists results ('
+		            + ', '.join( history_fields ) + ')' )
+		# add columns missing from an older database
+		columns = [ row[1] for row in db.execute( 'pragma table_info( results )' ) ]
+		for field in history_fields:
+			if (field not in columns):
+				db.execute( 'alter table results add column ' + field )
+		db.executemany( 'insert into results (' + ', '.join( history_fields ) + ') values ('
+		                + ', '.join( ['?'] * len( history_fields )) + ')',
+		                [[ r.get( field ) for field in history_fields ] for r in records] )
+		db.commit()
+		db.close()
+# end
+
+# ----------
+# returns records (list of dicts) with given label from history file
+def history_load( filename, label ):
+	if (not os.path.exists( filename )):
+		return []
+	if (filename.endswith( '.csv' )):
+		with open( filename, newline='' ) as f:
+			return [ r for r in csv.DictReader( f ) if r['label'] == label ]
+	else:
+		db = sqlite3.connect( filename )
+		db.row_factory = sqlite3.Row
+		try:
+			rows = db.execute( 'select * from results where label = ?', (label,) ).fetchall()
+		except sqlite3.OperationalError:
+			rows = []  # no results table yet
+		db.close()
+		return [ dict( r ) for r in rows ]
+# end
+
+# ----------
+# returns dict of best Gflop/s for each (command, m, n, k)
+def history_best( records ):
+	best = {}
+	for r in records:
+		if (r['gflops'] in (None, '')):
+			continue
+		key = (r['command'], int( r['m'] ), int( r['n'] ), int( r['k'] ))
+		best[ key ] = max( best.get( key, 0. ), float( r['gflops'] ))
+	return best
+# end
+
+# ----------
+# compares records to baseline records.
+# returns list (ncompared, regressions), where regressions is a list of
+# (key, baseline Gflop/s, Gflop/s) slower than baseline by more than threshold percent.
+def history_compare( baseline, records, threshold ):
+	base = history_best( baseline )
+	cur  = history_best( records )
+	ncompared = 0
+	regressions = []
+	for key in sorted( cur.keys() ):
+		if (key in base):
+			ncompared += 1
+			if (cur[ key ] < base[ key ] * (1 - threshold/100.)):
+				regressions.append( (key, base[ key ], cur[ key ]) )
+	return (ncompared, regressions)
+# end
+
+
 # ----------------------------------------------------------------------
 ntest  = 0
 nokay  = 0
@@ -1728,6 +1864,25 @@ if (opts.dev is not None):
 if (int(opts.niter) != 1):
 	global_options += ' --niter ' + opts.niter + ' '
 
+if (int(opts.nrep) != 1):
+	global_options += ' --nrep ' + opts.nrep + ' '
+
+if (opts.flush):
+	global_options += ' --flush '
+
+# testers append json records to record_file, which is read after each test
+records = []
+record_file = None
+run_date = time.strftime( '%Y-%m-%d %H:%M:%S' )
+run_label = opts.label or run_date
+if (opts.history):
+	(fd, record_file) = tempfile.mkstemp( prefix='magma_records_', suffix='.json' )
+	os.close( fd )
+	global_options += ' --format json --output ' + record_file + ' '
+elif (opts.baseline):
+	print( '--baseline requires --history', file=sys.stderr )
+	sys.exit( 1 )
+
 last_cmd = None
 
 for test in tests:
@@ -1798,10 +1953,26 @@ for test in tests:
 				break
 			# end
 
+			if (record_file):
+				open( record_file, 'w' ).close()  # truncate
+
 			t = time.time()
 			(okay, fail, error, status) = run( cmd_args )
 			t = time.time() - t
 
+			if (record_file):
+				with open( record_file ) as f:
+					for line in f:
+						try:
+							r = json.loads( line )
+						except ValueError:
+							continue  # partial line, e.g., after a crash
+						r['label']   = run_label
+						r['date']    = run_date
+						r['command'] = cmd_opts
+						records.append( r )
+			# end
+
 			# count stats
 			ntest  += 1
 			nokay  += okay
@@ -1856,6 +2027,30 @@ else:
 	msg += 'routines with failures:\n    ' + '\n    '.join( f ) + '\n'
 # end
 
+# save and compare performance
+nregress = 0
+if (opts.history):
+	os.remove( record_file )
+	if (opts.baseline):
+		baseline = history_load( opts.history, opts.baseline )
+	history_save( opts.history, records )
+	msg += '%5d performance records saved in %s with label "%s"\n' % (len( records ), opts.history, run_label)
+
+	if (opts.baseline):
+		threshold = float( opts.threshold )
+		(ncompared, regressions) = history_compare( baseline, records, threshold )
+		nregress = len( regressions )
+		msg += '%5d tests compared to baseline "%s": %d regressions (slower by > %g%%)\n' % (
+		       ncompared, opts.baseline, nregress, threshold)
+		for ((cmd, m, n, k), base, cur) in regressions:
+			msg += '    %-40s %6d %6d %6d   %9.2f -> %9.2f Gflop/s  (%+.1f%%)\n' % (
+			       cmd, m, n, k, base, cur, 100.*(cur - base)/base)
+	# end
+# end
+
 if (output_to_file):
 	sys.stderr.write( msg )  # to console
 sys.stdout.write( msg )  # to file
+
+if (nregress > 0):
+	sys.exit( 1 )
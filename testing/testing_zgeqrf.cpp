@@ -40,6 +40,7 @@ int main( int argc, char** argv)
     
     magma_opts opts;
     opts.parse_opts( argc, argv );
+    magma_timing timing( opts );
 
     int status = 0;
     double tol = opts.tolerance * lapackf77_dlamch("E");
@@ -72,19 +73,17 @@ int main( int argc, char** argv)
             
             /* Initialize the matrix */
             magma_generate_matrix( opts, M, N, h_A, lda );
-            lapackf77_zlacpy( MagmaFullStr, &M, &N, h_A, &lda, h_R, &lda );
-            
-            if ( opts.warmup ) {
-                magma_zgeqrf( M, N, h_R, lda, tau, h_work, lwork, &info );
-                lapackf77_zlacpy( MagmaFullStr, &M, &N, h_A, &lda, h_R, &lda );
-            }
 
             /* ====================================================================
                Performs operation using MAGMA
                =================================================================== */
-            gpu_time = magma_wtime();
-            magma_zgeqrf( M, N, h_R, lda, tau, h_work, lwork, &info );
-            gpu_time = magma_wtime() - gpu_time;
+            gpu_time = timing.time(
+                [&]() {
+                    lapackf77_zlacpy( MagmaFullStr, &M, &N, h_A, &lda, h_R, &lda );
+                },
+                [&]() {
+                    magma_zgeqrf( M, N, h_R, lda, tau, h_work, lwork, &info );
+                } );
             gpu_perf = gflops / gpu_time;
             if (info != 0) {
                 printf("magma_zgeqrf returned error %lld: %s.\n",
@@ -159,14 +158,18 @@ int main( int argc, char** argv)
                 printf("  ---   (  ---  )" );
             }
             printf( "   %7.2f (%7.2f)   ", gpu_perf, gpu_time );
+            bool okay = true;
             if ( opts.check ) {
-                bool okay = (error < tol && error2 < tol);
+                okay = (error < tol && error2 < tol);
                 status += ! okay;
                 printf( "%11.2e   %11.2e   %s\n", error, error2, (okay ? "ok" : "failed") );
             }
             else {
                 printf( "    ---\n" );
             }
+            timing.print();
+            opts.record( "zgeqrf", M, N, 0, nb, gpu_time, gpu_perf,
+                         (opts.check ? max( error, error2 ) : MAGMA_D_NAN), okay, &timing );
             
             magma_free_cpu( tau    );
             magma_free_cpu( h_A    );
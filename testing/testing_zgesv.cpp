@@ -144,6 +144,8 @@ int main(int argc, char **argv)
                         (long long) N, (long long) nrhs, gpu_perf, gpu_time,
                         error, (okay ? "ok" : "failed"));
             }
+            opts.record( "zgesv", N, N, nrhs, magma_get_zgetrf_nb( N, N ),
+                         gpu_time, gpu_perf, error, okay );
             
             magma_free_cpu( h_A  );
             magma_free_cpu( h_LU );
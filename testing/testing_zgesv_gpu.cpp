@@ -127,6 +127,8 @@ int main(int argc, char **argv)
                         (long long) N, (long long) nrhs, gpu_perf, gpu_time,
                         error, (error < tol ? "ok" : "failed"));
             }
+            opts.record( "zgesv_gpu", N, N, nrhs, magma_get_zgetrf_nb( N, N ),
+                         gpu_time, gpu_perf, error, (error < tol) );
             
             magma_free_cpu( h_A );
             magma_free_cpu( h_B );
@@ -176,6 +176,7 @@ int main( int argc, char** argv)
     
     magma_opts opts;
     opts.parse_opts( argc, argv );
+    magma_timing timing( opts );
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
 
@@ -218,25 +219,27 @@ int main( int argc, char** argv)
             /* ====================================================================
                Performs operation using MAGMA
                =================================================================== */
-            init_matrix( opts, M, N, h_A, lda );
-            if ( opts.version == 2 || opts.version == 3 ) {
-                // no pivoting versions, so set ipiv to identity
-                for (magma_int_t i=0; i < min_mn; ++i ) {
-                    ipiv[i] = i+1;
-                }
-            }
-            
-            gpu_time = magma_wtime();
-            if ( opts.version == 1 ) {
-                magma_zgetrf( M, N, h_A, lda, ipiv, &info );
-            }
-            else if ( opts.version == 2 ) {
-                magma_zgetrf_nopiv( M, N, h_A, lda, &info );
-            }
-            else if ( opts.version == 3 ) {
-                magma_zgetf2_nopiv( M, N, h_A, lda, &info );
-            }
-            gpu_time = magma_wtime() - gpu_time;
+            gpu_time = timing.time(
+                [&]() {
+                    init_matrix( opts, M, N, h_A, lda );
+                    if ( opts.version == 2 || opts.version == 3 ) {
+                        // no pivoting versions, so set ipiv to identity
+                        for (magma_int_t i=0; i < min_mn; ++i ) {
+                            ipiv[i] = i+1;
+                        }
+                    }
+                },
+                [&]() {
+                    if ( opts.version == 1 ) {
+                        magma_zgetrf( M, N, h_A, lda, ipiv, &info );
+                    }
+                    else if ( opts.version == 2 ) {
+                        magma_zgetrf_nopiv( M, N, h_A, lda, &info );
+                    }
+                    else if ( opts.version == 3 ) {
+                        magma_zgetf2_nopiv( M, N, h_A, lda, &info );
+                    }
+                } );
             gpu_perf = gflops / gpu_time;
             if (info != 0) {
                 printf("magma_zgetrf returned error %lld: %s.\n",
@@ -265,8 +268,12 @@ int main( int argc, char** argv)
                 status += ! (error < tol);
             }
             else {
+                error = MAGMA_D_NAN;
                 printf("     ---   \n");
             }
+            timing.print();
+            opts.record( "zgetrf", M, N, 0, magma_get_zgetrf_nb( M, N ),
+                         gpu_time, gpu_perf, error, (error < tol), &timing );
             
             magma_free_cpu( ipiv );
             magma_free_pinned( h_A  );
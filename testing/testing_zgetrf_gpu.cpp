@@ -329,8 +329,14 @@ int main( int argc, char** argv)
                 status += ! (error < tol);
             }
             else {
+                error = MAGMA_D_NAN;
                 printf("     ---  \n");
             }
+            opts.record( "zgetrf_gpu", M, N, 0,
+                         (opts.version == 3 || opts.version == 5
+                             ? magma_get_zgetrf_native_nb( M, N )
+                             : magma_get_zgetrf_nb( M, N )),
+                         gpu_time, gpu_perf, error, (error < tol) );
 
             magma_free_cpu( ipiv );
             magma_free_cpu( h_A );
@@ -54,6 +54,7 @@ int main( int argc, char** argv)
 
     magma_opts opts;
     opts.parse_opts( argc, argv );
+    magma_timing timing( opts );
 
     // checking NoVec requires LAPACK
     opts.lapack |= (opts.check && opts.jobz == MagmaNoVec);
@@ -174,99 +175,102 @@ int main( int argc, char** argv)
             
             /* Initialize the matrix */
             magma_generate_matrix( opts, N, N, h_A, lda );
-            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
             
             /* ====================================================================
                Performs operation using MAGMA
                =================================================================== */
-            gpu_time = magma_wtime();
-            if (opts.version == 1) {
-                if (opts.ngpu == 1) {
-                    magma_zheevd( opts.jobz, opts.uplo,
-                                  N, h_R, lda, w1,
-                                  h_work, lwork,
-                                  #ifdef COMPLEX
-                                  rwork, lrwork,
-                                  #endif
-                                  iwork, liwork,
-                                  &info );
-                }
-                else {
-                    //printf( "magma_zheevd_m, ngpu %lld (%lld)\n", (long long) opts.ngpu, (long long) abs_ngpu );
-                    magma_zheevd_m( abs_ngpu, opts.jobz, opts.uplo,
-                                    N, h_R, lda, w1,
-                                    h_work, lwork,
-                                    #ifdef COMPLEX
-                                    rwork, lrwork,
-                                    #endif
-                                    iwork, liwork,
-                                    &info );
-                }
-            }
-            else if ( opts.version == 2 ) {  // version 2: zheevdx computes selected eigenvalues/vectors
-                if (opts.ngpu == 1) {
-                    magma_zheevdx( opts.jobz, range, opts.uplo,
-                                   N, h_R, lda,
-                                   vl, vu, il, iu,
-                                   &Nfound, w1,
-                                   h_work, lwork,
-                                   #ifdef COMPLEX
-                                   rwork, lrwork,
-                                   #endif
-                                   iwork, liwork,
-                                   &info );
-                }
-                else {
-                    //printf( "magma_zheevdx_m, ngpu %lld (%lld)\n", (long long) opts.ngpu, (long long) abs_ngpu );
-                    magma_zheevdx_m( abs_ngpu, opts.jobz, range, opts.uplo,
-                                     N, h_R, lda,
-                                     vl, vu, il, iu,
-                                     &Nfound, w1,
-                                     h_work, lwork,
-                                     #ifdef COMPLEX
-                                     rwork, lrwork,
-                                     #endif
-                                     iwork, liwork,
-                                     &info );
-                }
-                //printf( "il %lld, iu %lld, Nfound %lld\n", (long long) il, (long long) iu, (long long) Nfound );
-            }
-            else if ( opts.version == 3 ) {  // version 3: MRRR, computes selected eigenvalues/vectors
-                // only complex version available
-                #ifdef COMPLEX
-                magma_zheevr( opts.jobz, range, opts.uplo,
-                              N, h_R, lda,
-                              vl, vu, il, iu, abstol,
-                              &Nfound, w1,
-                              h_Z, lda, isuppz,
-                              h_work, lwork,
-                              #ifdef COMPLEX
-                              rwork, lrwork,
-                              #endif
-                              iwork, liwork,
-                              &info );
-                lapackf77_zlacpy( "Full", &N, &N, h_Z, &lda, h_R, &lda );
-                #endif
-            }
-            else if ( opts.version == 4 ) {  // version 3: zheevx (QR iteration), computes selected eigenvalues/vectors
-                // only complex version available
-                #ifdef COMPLEX
-                magma_zheevx( opts.jobz, range, opts.uplo,
-                              N, h_R, lda,
-                              vl, vu, il, iu, abstol,
-                              &Nfound, w1,
-                              h_Z, lda,
-                              h_work, lwork,
-                              #ifdef COMPLEX
-                              rwork, /*lrwork,*/
-                              #endif
-                              iwork, /*liwork,*/
-                              ifail,
-                              &info );
-                lapackf77_zlacpy( "Full", &N, &N, h_Z, &lda, h_R, &lda );
-                #endif
-            }
-            gpu_time = magma_wtime() - gpu_time;
+            gpu_time = timing.time(
+                [&]() {
+                    lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+                },
+                [&]() {
+                    if (opts.version == 1) {
+                        if (opts.ngpu == 1) {
+                            magma_zheevd( opts.jobz, opts.uplo,
+                                          N, h_R, lda, w1,
+                                          h_work, lwork,
+                                          #ifdef COMPLEX
+                                          rwork, lrwork,
+                                          #endif
+                                          iwork, liwork,
+                                          &info );
+                        }
+                        else {
+                            //printf( "magma_zheevd_m, ngpu %lld (%lld)\n", (long long) opts.ngpu, (long long) abs_ngpu );
+                            magma_zheevd_m( abs_ngpu, opts.jobz, opts.uplo,
+                                            N, h_R, lda, w1,
+                                            h_work, lwork,
+                                            #ifdef COMPLEX
+                                            rwork, lrwork,
+                                            #endif
+                                            iwork, liwork,
+                                            &info );
+                        }
+                    }
+                    else if ( opts.version == 2 ) {  // version 2: zheevdx computes selected eigenvalues/vectors
+                        if (opts.ngpu == 1) {
+                            magma_zheevdx( opts.jobz, range, opts.uplo,
+                                           N, h_R, lda,
+                                           vl, vu, il, iu,
+                                           &Nfound, w1,
+                                           h_work, lwork,
+                                           #ifdef COMPLEX
+                                           rwork, lrwork,
+                                           #endif
+                                           iwork, liwork,
+                                           &info );
+                        }
+                        else {
+                            //printf( "magma_zheevdx_m, ngpu %lld (%lld)\n", (long long) opts.ngpu, (long long) abs_ngpu );
+                            magma_zheevdx_m( abs_ngpu, opts.jobz, range, opts.uplo,
+                                             N, h_R, lda,
+                                             vl, vu, il, iu,
+                                             &Nfound, w1,
+                                             h_work, lwork,
+                                             #ifdef COMPLEX
+                                             rwork, lrwork,
+                                             #endif
+                                             iwork, liwork,
+                                             &info );
+                        }
+                        //printf( "il %lld, iu %lld, Nfound %lld\n", (long long) il, (long long) iu, (long long) Nfound );
+                    }
+                    else if ( opts.version == 3 ) {  // version 3: MRRR, computes selected eigenvalues/vectors
+                        // only complex version available
+                        #ifdef COMPLEX
+                        magma_zheevr( opts.jobz, range, opts.uplo,
+                                      N, h_R, lda,
+                                      vl, vu, il, iu, abstol,
+                                      &Nfound, w1,
+                                      h_Z, lda, isuppz,
+                                      h_work, lwork,
+                                      #ifdef COMPLEX
+                                      rwork, lrwork,
+                                      #endif
+                                      iwork, liwork,
+                                      &info );
+                        lapackf77_zlacpy( "Full", &N, &N, h_Z, &lda, h_R, &lda );
+                        #endif
+                    }
+                    else if ( opts.version == 4 ) {  // version 3: zheevx (QR iteration), computes selected eigenvalues/vectors
+                        // only complex version available
+                        #ifdef COMPLEX
+                        magma_zheevx( opts.jobz, range, opts.uplo,
+                                      N, h_R, lda,
+                                      vl, vu, il, iu, abstol,
+                                      &Nfound, w1,
+                                      h_Z, lda,
+                                      h_work, lwork,
+                                      #ifdef COMPLEX
+                                      rwork, /*lrwork,*/
+                                      #endif
+                                      iwork, /*liwork,*/
+                                      ifail,
+                                      &info );
+                        lapackf77_zlacpy( "Full", &N, &N, h_Z, &lda, h_R, &lda );
+                        #endif
+                    }
+                } );
             if (info != 0) {
                 printf("magma_zheevd returned error %lld: %s.\n",
                        (long long) info, magma_strerror( info ));
@@ -423,6 +427,7 @@ int main( int argc, char** argv)
             }
             printf("   %s\n", (okay ? "ok" : "failed"));
             status += ! okay;
+            timing.print();
             
             magma_free_cpu( h_A   );
             magma_free_cpu( w1    );
@@ -0,0 +1,182 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_bulge.h"
+#include "testings.h"
+#include "../control/magma_threadsetting.h"  // internal header
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zhetrd_hb2st, the CPU bulge chasing of the 2-stage reduction
+      (stage 2, band to tridiagonal). Reports the stage-2 time for each N,
+      nb, and for 1, 2, 4, ..., --nthread threads.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    real_Double_t cpu_time;
+    magmaDoubleComplex *h_B, *h_A2, *h_AB, *V2, *TAU2, *T2, *h_work;
+    double *D, *E, *Dref, *Eref;
+    double error, dnorm;
+    magma_int_t N, nb, lda2, ldab, Vblksiz, ldv, ldt, blkcnt, sizTAU2, sizT2, sizV2;
+    magma_int_t j, len, info;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+    magma_int_t wantz = (opts.jobz == MagmaVec);
+
+    // thread counts 1, 2, 4, ..., up to --nthread
+    magma_int_t max_threads = max( 1, opts.nthread );
+    magma_int_t omp_threads = magma_get_omp_numthreads();
+    if ( getenv( "MAGMA_NUM_THREADS" ) != NULL ) {
+        printf("%% warning: $MAGMA_NUM_THREADS overrides the thread counts below\n");
+    }
+
+    printf("%% jobz = %s; thread counts 1 to %lld (--nthread)\n",
+           lapack_vec_const(opts.jobz), (long long) max_threads );
+    printf("%%   N    nb  threads   CPU Time (sec)   |D - D_lapack| / (|D| N)\n");
+    printf("%%=================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N  = opts.nsize[itest];
+            nb = (opts.nb > 0 ? opts.nb : magma_get_zbulge_nb( N, max_threads ));
+            if ( nb >= N ) {
+                printf("%5lld %5lld   skipping because nb >= N\n",
+                       (long long) N, (long long) nb );
+                continue;
+            }
+
+            magma_bulge_getlwstg1( N, nb, &lda2 );
+            Vblksiz = magma_get_zbulge_vblksiz( N, nb, max_threads );
+            ldv     = nb + Vblksiz;
+            ldt     = Vblksiz;
+            magma_zbulge_getstg2size( N, nb, wantz, Vblksiz, ldv, ldt,
+                                      &blkcnt, &sizTAU2, &sizT2, &sizV2 );
+            ldab = nb + 1;
+
+            TESTING_CHECK( magma_zmalloc_cpu( &h_B,    lda2*N  ));
+            TESTING_CHECK( magma_zmalloc_cpu( &h_A2,   lda2*N  ));
+            TESTING_CHECK( magma_zmalloc_cpu( &V2,     sizV2   ));
+            TESTING_CHECK( magma_zmalloc_cpu( &TAU2,   sizTAU2 ));
+            TESTING_CHECK( magma_zmalloc_cpu( &T2,     max( 1, sizT2 )));
+            TESTING_CHECK( magma_dmalloc_cpu( &D,      N       ));
+            TESTING_CHECK( magma_dmalloc_cpu( &E,      N       ));
+
+            /* Initialize a random Hermitian band matrix, lower band storage
+             * as used by zheevdx_2stage: A(j+k, j) is h_B[k + j*lda2] */
+            memset( h_B, 0, lda2*N*sizeof(magmaDoubleComplex) );
+            for( j = 0; j < N; ++j ) {
+                len = min( nb+1, N-j );
+                lapackf77_zlarnv( &ione, ISEED, &len, &h_B[j*lda2] );
+                h_B[j*lda2] = MAGMA_Z_MAKE( MAGMA_Z_REAL( h_B[j*lda2] ), 0. );
+            }
+
+            /* ====================================================================
+               Reference eigenvalues using LAPACK zhbtrd and dsterf
+               =================================================================== */
+            Dref = NULL;
+            if ( opts.check ) {
+                TESTING_CHECK( magma_zmalloc_cpu( &h_AB,   ldab*N ));
+                TESTING_CHECK( magma_zmalloc_cpu( &h_work, N      ));
+                TESTING_CHECK( magma_dmalloc_cpu( &Dref,   N      ));
+                TESTING_CHECK( magma_dmalloc_cpu( &Eref,   N      ));
+                lapackf77_zlacpy( MagmaFullStr, &ldab, &N, h_B, &lda2, h_AB, &ldab );
+                lapackf77_zhbtrd( "N", "L", &N, &nb, h_AB, &ldab, Dref, Eref,
+                                  NULL, &ione, h_work, &info );
+                if (info != 0) {
+                    printf("lapackf77_zhbtrd returned error %lld: %s.\n",
+                           (long long) info, magma_strerror( info ));
+                }
+                lapackf77_dsterf( &N, Dref, Eref, &info );
+                magma_free_cpu( h_AB   );
+                magma_free_cpu( h_work );
+                magma_free_cpu( Eref   );
+            }
+
+            magma_int_t threads = 1;
+            while( true ) {
+                // zhetrd_hb2st takes its thread count from
+                // magma_get_parallel_numthreads, i.e., the OpenMP team size
+                magma_set_omp_numthreads( threads );
+
+                /* ====================================================================
+                   Performs operation using MAGMA
+                   =================================================================== */
+                lapackf77_zlacpy( MagmaFullStr, &lda2, &N, h_B, &lda2, h_A2, &lda2 );
+                cpu_time = magma_wtime();
+                magma_zhetrd_hb2st( MagmaLower, N, nb, Vblksiz, h_A2, lda2, D, E,
+                                    V2, ldv, TAU2, wantz, T2, ldt );
+                cpu_time = magma_wtime() - cpu_time;
+
+                printf("%5lld %5lld  %7lld   %10.4f       ",
+                       (long long) N, (long long) nb, (long long) threads, cpu_time );
+
+                /* =====================================================================
+                   Check the eigenvalues of the tridiagonal matrix
+                   =================================================================== */
+                if ( opts.check ) {
+                    lapackf77_dsterf( &N, D, E, &info );
+                    error = 0.;
+                    dnorm = 0.;
+                    for( j = 0; j < N; ++j ) {
+                        error = max( error, fabs( D[j] - Dref[j] ));
+                        dnorm = max( dnorm, fabs( Dref[j] ));
+                    }
+                    error /= dnorm * N;
+                    bool okay = (error < tol);
+                    status += ! okay;
+                    printf("%8.2e   %s\n", error, (okay ? "ok" : "failed"));
+                }
+                else {
+                    printf("     ---\n");
+                }
+
+                if ( threads >= max_threads ) {
+                    break;
+                }
+                threads = min( 2*threads, max_threads );
+            }
+            magma_set_omp_numthreads( omp_threads );
+
+            magma_free_cpu( h_B  );
+            magma_free_cpu( h_A2 );
+            magma_free_cpu( V2   );
+            magma_free_cpu( TAU2 );
+            magma_free_cpu( T2   );
+            magma_free_cpu( D    );
+            magma_free_cpu( E    );
+            magma_free_cpu( Dref );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,230 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_bulge.h"
+#include "testings.h"
+#include "../control/magma_threadsetting.h"  // internal header
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Times one zhetrd_hb2st call with the given stage-2 parameters, which are
+      entered in the tuning table so zhetrd_hb2st picks them up.
+      Returns the minimum time over niter runs.
+*/
+static double
+time_hb2st(
+    magma_int_t N, magma_int_t nb, magma_int_t wantz, magma_int_t niter,
+    magma_int_t Vblksiz, magma_int_t colblktile, magma_int_t nthread,
+    magmaDoubleComplex *h_B, magmaDoubleComplex *h_A2, magma_int_t lda2,
+    double *D, double *E )
+{
+    magmaDoubleComplex *V2, *TAU2, *T2;
+    magma_int_t ldv, ldt, blkcnt, sizTAU2, sizT2, sizV2;
+    double best = -1;
+
+    magma_bulge_set_tuning( "zhetrd_hb2st", N, nb, Vblksiz, colblktile, nthread, 0. );
+
+    ldv = nb + Vblksiz;
+    ldt = Vblksiz;
+    magma_zbulge_getstg2size( N, nb, wantz, Vblksiz, ldv, ldt,
+                              &blkcnt, &sizTAU2, &sizT2, &sizV2 );
+    TESTING_CHECK( magma_zmalloc_cpu( &V2,   sizV2   ));
+    TESTING_CHECK( magma_zmalloc_cpu( &TAU2, sizTAU2 ));
+    TESTING_CHECK( magma_zmalloc_cpu( &T2,   max( 1, sizT2 )));
+
+    for( magma_int_t iter = 0; iter < niter; ++iter ) {
+        lapackf77_zlacpy( MagmaFullStr, &lda2, &N, h_B, &lda2, h_A2, &lda2 );
+        double time = magma_wtime();
+        magma_zhetrd_hb2st( MagmaLower, N, nb, Vblksiz, h_A2, lda2, D, E,
+                            V2, ldv, TAU2, wantz, T2, ldt );
+        time = magma_wtime() - time;
+        if ( best < 0 || time < best ) {
+            best = time;
+        }
+    }
+
+    printf("%5lld %5lld  %7lld  %10lld  %7lld   %10.4f\n",
+           (long long) N, (long long) nb, (long long) Vblksiz,
+           (long long) colblktile, (long long) nthread, best );
+    fflush( stdout );
+
+    magma_free_cpu( V2   );
+    magma_free_cpu( TAU2 );
+    magma_free_cpu( T2   );
+    return best;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- On-host tuning of zhetrd_hb2st, the CPU bulge chasing of the 2-stage
+      eigensolvers. For each N, it sweeps the number of threads (up to
+      --nthread), Vblksiz, and the number of consecutive tiles per core
+      (colblktile) by coordinate descent, keeping the fastest of --niter runs.
+      The best parameters are written to the file named by $MAGMA_BULGE_TUNING
+      (default magma_bulge_tuning.txt), merged with the entries already there.
+      Point $MAGMA_BULGE_TUNING at that file to use it at runtime;
+      magma_get_zbulge_vblksiz and magma_zhetrd_hb2st then consult it
+      and fall back to their heuristics for N and nb not in it.
+      nb is not tuned since it also drives stage 1 on the GPU; use --nb
+      to tune for a given nb.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    magmaDoubleComplex *h_B, *h_A2;
+    double *D, *E;
+    magma_int_t N, nb, lda2, j, len;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    int status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    magma_int_t wantz = (opts.jobz == MagmaVec);
+    magma_int_t max_threads = max( 1, opts.nthread );
+
+    const char* filename = getenv( "MAGMA_BULGE_TUNING" );
+    if ( filename == NULL || filename[0] == '\0' ) {
+        filename = "magma_bulge_tuning.txt";
+    }
+
+    // zhetrd_hb2st caps the tuned thread count by
+    // magma_get_parallel_numthreads, i.e., the OpenMP team size
+    magma_int_t omp_threads = magma_get_omp_numthreads();
+    magma_set_omp_numthreads( max_threads );
+    if ( getenv( "MAGMA_NUM_THREADS" ) != NULL ) {
+        printf("%% warning: $MAGMA_NUM_THREADS caps the thread counts below\n");
+    }
+
+    printf("%% jobz = %s; up to %lld threads (--nthread); tuning file %s\n",
+           lapack_vec_const(opts.jobz), (long long) max_threads, filename );
+    printf("%%   N    nb  Vblksiz  colblktile  threads   CPU Time (sec)\n");
+    printf("%%==========================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        N  = opts.nsize[itest];
+        nb = (opts.nb > 0 ? opts.nb : magma_get_zbulge_nb( N, max_threads ));
+        if ( nb >= N ) {
+            printf("%5lld %5lld   skipping because nb >= N\n",
+                   (long long) N, (long long) nb );
+            continue;
+        }
+        magma_int_t nbtiles = magma_ceildiv( N, nb );
+
+        magma_bulge_getlwstg1( N, nb, &lda2 );
+        TESTING_CHECK( magma_zmalloc_cpu( &h_B,  lda2*N ));
+        TESTING_CHECK( magma_zmalloc_cpu( &h_A2, lda2*N ));
+        TESTING_CHECK( magma_dmalloc_cpu( &D,    N      ));
+        TESTING_CHECK( magma_dmalloc_cpu( &E,    N      ));
+
+        /* Initialize a random Hermitian band matrix, lower band storage */
+        memset( h_B, 0, lda2*N*sizeof(magmaDoubleComplex) );
+        for( j = 0; j < N; ++j ) {
+            len = min( nb+1, N-j );
+            lapackf77_zlarnv( &ione, ISEED, &len, &h_B[j*lda2] );
+            h_B[j*lda2] = MAGMA_Z_MAKE( MAGMA_Z_REAL( h_B[j*lda2] ), 0. );
+        }
+
+        // start from the current lookup, i.e., a previous tuning or the heuristics
+        magma_int_t best_Vblksiz    = magma_get_zbulge_vblksiz( N, nb, max_threads );
+        magma_int_t best_colblktile = 0;
+        magma_int_t best_nthread    = max_threads;
+        double best_time = time_hb2st( N, nb, wantz, opts.niter,
+                                       best_Vblksiz, best_colblktile, best_nthread,
+                                       h_B, h_A2, lda2, D, E );
+
+        // coordinate descent over threads, Vblksiz, colblktile,
+        // until a round brings no improvement
+        for( int round = 0; round < 3; ++round ) {
+            bool improved = false;
+            double time;
+
+            for( magma_int_t th = 1; true; th = min( 2*th, max_threads ) ) {
+                if ( th != best_nthread ) {
+                    time = time_hb2st( N, nb, wantz, opts.niter,
+                                       best_Vblksiz, best_colblktile, th,
+                                       h_B, h_A2, lda2, D, E );
+                    if ( time < best_time ) {
+                        best_time = time;  best_nthread = th;  improved = true;
+                    }
+                }
+                if ( th >= max_threads ) {
+                    break;
+                }
+            }
+
+            // Vblksiz matters only for the Householder blocks kept for Q2
+            if ( wantz ) {
+                for( magma_int_t vb = 8; vb <= min( nb, 128 ); vb *= 2 ) {
+                    if ( vb == best_Vblksiz ) continue;
+                    time = time_hb2st( N, nb, wantz, opts.niter,
+                                       vb, best_colblktile, best_nthread,
+                                       h_B, h_A2, lda2, D, E );
+                    if ( time < best_time ) {
+                        best_time = time;  best_Vblksiz = vb;  improved = true;
+                    }
+                }
+            }
+
+            // 0 is the L2 cache based heuristic
+            for( magma_int_t ct = 0; ct <= nbtiles/best_nthread; ct = max( 1, 2*ct ) ) {
+                if ( ct == best_colblktile ) continue;
+                time = time_hb2st( N, nb, wantz, opts.niter,
+                                   best_Vblksiz, ct, best_nthread,
+                                   h_B, h_A2, lda2, D, E );
+                if ( time < best_time ) {
+                    best_time = time;  best_colblktile = ct;  improved = true;
+                }
+            }
+
+            if ( ! improved ) {
+                break;
+            }
+        }
+
+        // without vectors Vblksiz was not tuned; leave it to the heuristic
+        if ( ! wantz ) {
+            best_Vblksiz = 0;
+        }
+        magma_bulge_set_tuning( "zhetrd_hb2st", N, nb, best_Vblksiz, best_colblktile,
+                                best_nthread, best_time );
+        printf("%5lld %5lld  %7lld  %10lld  %7lld   %10.4f   best\n\n",
+               (long long) N, (long long) nb, (long long) best_Vblksiz,
+               (long long) best_colblktile, (long long) best_nthread, best_time );
+
+        magma_free_cpu( h_B  );
+        magma_free_cpu( h_A2 );
+        magma_free_cpu( D    );
+        magma_free_cpu( E    );
+        fflush( stdout );
+    }
+    magma_set_omp_numthreads( omp_threads );
+
+    if ( magma_bulge_write_tuning( filename ) != MAGMA_SUCCESS ) {
+        printf("cannot write tuning file %s\n", filename );
+        status = 1;
+    }
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -0,0 +1,286 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "flops.h"
+#include "magma_v2.h"
+#include "magma_lapack.h"
+#include "magma_operators.h"
+#include "testings.h"
+
+#define COMPLEX
+
+#define A(i, j) (A + (i) + (j)*lda)
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Previous magma_zhetrf_nopiv_cpu, for comparison: blocks of ib columns,
+      the diagonal block factored with rank-1 updates on one thread, and the
+      trailing update as a full square gemm.
+*/
+static magma_int_t
+zhetrf_nopiv_cpu_ref(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t ib,
+    magmaDoubleComplex *A, magma_int_t lda )
+{
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    const magma_int_t ione = 1;
+    const double eps = lapackf77_dlamch("Epsilon");
+    bool lower = (uplo == MagmaLower);
+
+    for (magma_int_t i = 0; i < n; i += ib) {
+        magma_int_t sb = min( n-i, ib );
+
+        // factorize the diagonal block
+        for (magma_int_t k = i; k < i + sb; k++) {
+            double alpha = MAGMA_Z_REAL( *A(k,k) );
+            if ( fabs(alpha) < eps ) {
+                return k+1;
+            }
+            *A(k,k) = MAGMA_Z_MAKE( alpha, 0. );
+            magma_int_t m = i + sb - k - 1;
+            if ( m == 0 ) continue;
+            double rcp = 1. / alpha, neg_alpha = -alpha;
+            if ( lower ) {
+                blasf77_zdscal( &m, &rcp, A(k+1,k), &ione );
+                blasf77_zher( MagmaLowerStr, &m, &neg_alpha, A(k+1,k), &ione, A(k+1,k+1), &lda );
+            }
+            else {
+                blasf77_zdscal( &m, &rcp, A(k,k+1), &lda );
+                #ifdef COMPLEX
+                lapackf77_zlacgv( &m, A(k,k+1), &lda );
+                #endif
+                blasf77_zher( MagmaUpperStr, &m, &neg_alpha, A(k,k+1), &lda, A(k+1,k+1), &lda );
+                #ifdef COMPLEX
+                lapackf77_zlacgv( &m, A(k,k+1), &lda );
+                #endif
+            }
+        }
+        if ( i + sb >= n ) break;
+
+        magma_int_t height = n - i - sb;
+        if ( lower ) {
+            blasf77_ztrsm( MagmaRightStr, MagmaLowerStr, MagmaConjTransStr, MagmaUnitStr,
+                           &height, &sb, &c_one, A(i,i), &lda, A(i+sb,i), &lda );
+            for (magma_int_t k = 0; k < sb; k++) {
+                for (magma_int_t ii = i+sb; ii < n; ii++) {
+                    *A(i+k,ii) = MAGMA_Z_CONJ( *A(ii,i+k) );
+                }
+                double rcp = 1. / MAGMA_Z_REAL( *A(i+k,i+k) );
+                blasf77_zdscal( &height, &rcp, A(i+sb,i+k), &ione );
+            }
+            blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &height, &height, &sb,
+                           &c_neg_one, A(i+sb,i), &lda, A(i,i+sb), &lda,
+                           &c_one, A(i+sb,i+sb), &lda );
+        }
+        else {
+            blasf77_ztrsm( MagmaLeftStr, MagmaUpperStr, MagmaConjTransStr, MagmaUnitStr,
+                           &sb, &height, &c_one, A(i,i), &lda, A(i,i+sb), &lda );
+            for (magma_int_t k = 0; k < sb; k++) {
+                for (magma_int_t ii = i+sb; ii < n; ii++) {
+                    *A(ii,i+k) = MAGMA_Z_CONJ( *A(i+k,ii) );
+                }
+                double rcp = 1. / MAGMA_Z_REAL( *A(i+k,i+k) );
+                blasf77_zdscal( &height, &rcp, A(i+k,i+sb), &lda );
+            }
+            blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &height, &height, &sb,
+                           &c_neg_one, A(i+sb,i), &lda, A(i,i+sb), &lda,
+                           &c_one, A(i+sb,i+sb), &lda );
+        }
+    }
+    return 0;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Returns ||A - L D L^H||_F / (N ||A||_F), or ||A - U^H D U||_F / (N ||A||_F),
+      with the factors in LD and A Hermitian, given by its uplo triangle.
+*/
+static double
+get_residual(
+    magma_uplo_t uplo, magma_int_t N,
+    magmaDoubleComplex *A,  magma_int_t lda,
+    magmaDoubleComplex *LD, magma_int_t ldl )
+{
+    const magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magmaDoubleComplex *L, *W, *R;
+    double work[1];
+    magma_int_t n2 = N*N;
+
+    TESTING_CHECK( magma_zmalloc_cpu( &L, n2 ));
+    TESTING_CHECK( magma_zmalloc_cpu( &W, n2 ));
+    TESTING_CHECK( magma_zmalloc_cpu( &R, n2 ));
+
+    // L unit lower triangular, the conjugate transpose of U for upper
+    lapackf77_zlaset( MagmaFullStr, &N, &N, &c_zero, &c_one, L, &N );
+    for (magma_int_t j = 0; j < N; j++) {
+        for (magma_int_t i = j+1; i < N; i++) {
+            L[i + j*N] = (uplo == MagmaLower ? LD[i + j*ldl] : MAGMA_Z_CONJ( LD[j + i*ldl] ));
+        }
+    }
+    // W = L D
+    for (magma_int_t j = 0; j < N; j++) {
+        for (magma_int_t i = 0; i < N; i++) {
+            W[i + j*N] = L[i + j*N] * MAGMA_Z_REAL( LD[j + j*ldl] );
+        }
+    }
+    // R = full Hermitian A
+    for (magma_int_t j = 0; j < N; j++) {
+        for (magma_int_t i = j; i < N; i++) {
+            magmaDoubleComplex aij = (uplo == MagmaLower ? A[i + j*lda] : MAGMA_Z_CONJ( A[j + i*lda] ));
+            R[i + j*N] = aij;
+            R[j + i*N] = MAGMA_Z_CONJ( aij );
+        }
+        R[j + j*N] = MAGMA_Z_MAKE( MAGMA_Z_REAL( R[j + j*N] ), 0. );
+    }
+    double Anorm = lapackf77_zlange( "F", &N, &N, R, &N, work );
+    blasf77_zgemm( MagmaNoTransStr, MagmaConjTransStr, &N, &N, &N,
+                   &c_neg_one, W, &N, L, &N, &c_one, R, &N );
+    double error = lapackf77_zlange( "F", &N, &N, R, &N, work ) / (N * Anorm);
+
+    magma_free_cpu( L );
+    magma_free_cpu( W );
+    magma_free_cpu( R );
+    return error;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zhetrf_nopiv_cpu, the CPU LDL^H without pivoting used for the
+      diagonal blocks of zhetrf_nopiv. Compares it with the previous blocked
+      implementation and, with --lapack, LAPACK's zhetrf (with pivoting).
+      --nb sets the inner block size ib (default 32).
+*/
+int main( int argc, char** argv)
+{
+    TESTING_CHECK( magma_init() );
+    magma_print_environment();
+
+    real_Double_t   gflops, magma_perf, magma_time, ref_perf, ref_time, cpu_perf, cpu_time;
+    magmaDoubleComplex *h_A, *h_R, *work, wquery;
+    magma_int_t N, n2, lda, ib, lwork, info;
+    magma_int_t *ipiv;
+    double error, ref_error;
+    int status = 0;
+
+    magma_opts opts;
+    opts.matrix = "rand_dominant";  // default, no pivoting needed
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+    ib = (opts.nb > 0 ? opts.nb : 32);
+
+    printf("%% uplo = %s, ib = %lld\n",
+           lapack_uplo_const(opts.uplo), (long long) ib );
+    printf("%%   N   MAGMA Gflop/s (sec)   previous Gflop/s (sec)   LAPACK Gflop/s (sec)   |A - LDL^H| / (N |A|)  previous\n");
+    printf("%%======================================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N      = opts.nsize[itest];
+            lda    = N;
+            n2     = lda*N;
+            gflops = FLOPS_ZPOTRF( N ) / 1e9;
+
+            TESTING_CHECK( magma_zmalloc_cpu( &h_A,  n2 ));
+            TESTING_CHECK( magma_zmalloc_cpu( &h_R,  n2 ));
+            TESTING_CHECK( magma_imalloc_cpu( &ipiv, N  ));
+
+            magma_generate_matrix( opts, N, N, h_A, lda );
+
+            /* ====================================================================
+               Performs operation using MAGMA
+               =================================================================== */
+            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+            magma_time = magma_wtime();
+            magma_zhetrf_nopiv_cpu( opts.uplo, N, ib, h_R, lda, &info );
+            magma_time = magma_wtime() - magma_time;
+            magma_perf = gflops / magma_time;
+            if (info != 0) {
+                printf("magma_zhetrf_nopiv_cpu returned error %lld: %s.\n",
+                       (long long) info, magma_strerror( info ));
+            }
+            error = (opts.check ? get_residual( opts.uplo, N, h_A, lda, h_R, lda ) : 0.);
+
+            /* ====================================================================
+               Performs operation using the previous implementation
+               =================================================================== */
+            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+            ref_time = magma_wtime();
+            info = zhetrf_nopiv_cpu_ref( opts.uplo, N, ib, h_R, lda );
+            ref_time = magma_wtime() - ref_time;
+            ref_perf = gflops / ref_time;
+            if (info != 0) {
+                printf("previous zhetrf_nopiv_cpu returned error %lld.\n", (long long) info );
+            }
+            ref_error = (opts.check ? get_residual( opts.uplo, N, h_A, lda, h_R, lda ) : 0.);
+
+            /* =====================================================================
+               Performs operation using LAPACK, with pivoting
+               =================================================================== */
+            cpu_perf = cpu_time = 0;
+            if ( opts.lapack ) {
+                lwork = -1;
+                lapackf77_zhetrf( lapack_uplo_const(opts.uplo), &N, h_R, &lda, ipiv,
+                                  &wquery, &lwork, &info );
+                lwork = magma_int_t( MAGMA_Z_REAL( wquery ));
+                TESTING_CHECK( magma_zmalloc_cpu( &work, max( 1, lwork )));
+                lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+                cpu_time = magma_wtime();
+                lapackf77_zhetrf( lapack_uplo_const(opts.uplo), &N, h_R, &lda, ipiv,
+                                  work, &lwork, &info );
+                cpu_time = magma_wtime() - cpu_time;
+                cpu_perf = gflops / cpu_time;
+                if (info != 0) {
+                    printf("lapackf77_zhetrf returned error %lld: %s.\n",
+                           (long long) info, magma_strerror( info ));
+                }
+                magma_free_cpu( work );
+            }
+
+            printf("%5lld   %7.2f (%7.2f)        %7.2f (%7.2f)        ",
+                   (long long) N, magma_perf, magma_time, ref_perf, ref_time );
+            if ( opts.lapack ) {
+                printf("%7.2f (%7.2f)   ", cpu_perf, cpu_time );
+            }
+            else {
+                printf("  ---   (  ---  )   ");
+            }
+            if ( opts.check ) {
+                bool okay = (error < tol);
+                status += ! okay;
+                printf("%8.2e            %8.2e   %s\n", error, ref_error, (okay ? "ok" : "failed"));
+            }
+            else {
+                printf("  ---\n");
+            }
+
+            magma_free_cpu( h_A  );
+            magma_free_cpu( h_R  );
+            magma_free_cpu( ipiv );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    opts.cleanup();
+    TESTING_CHECK( magma_finalize() );
+    return status;
+}
@@ -137,6 +137,8 @@ int main( int argc, char** argv)
                         (long long) N, (long long) opts.nrhs, gpu_perf, gpu_time,
                         error, (error < tol ? "ok" : "failed"));
             }
+            opts.record( "zposv", N, N, opts.nrhs, magma_get_zpotrf_nb( N ),
+                         gpu_time, gpu_perf, error, (error < tol) );
             
             magma_free_cpu( h_A );
             magma_free_cpu( h_R );
@@ -48,6 +48,7 @@ int main( int argc, char** argv)
     opts.matrix = "rand_dominant";  // default
     opts.parse_opts( argc, argv );
     opts.lapack |= opts.check;  // check (-c) implies lapack (-l)
+    magma_timing timing( opts );
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
     
@@ -67,7 +68,6 @@ int main( int argc, char** argv)
             
             /* Initialize the matrix */
             magma_generate_matrix( opts, N, N, h_A, lda, sigma );
-            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
             if (opts.verbose) {
                 printf( "A = " ); magma_zprint( N, N, h_A, lda );
             }
@@ -75,10 +75,13 @@ int main( int argc, char** argv)
             /* ====================================================================
                Performs operation using MAGMA
                =================================================================== */
+            auto copy_A = [&]() {
+                lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+            };
             if (opts.version == 1) {
-                gpu_time = magma_wtime();
-                magma_zpotrf( opts.uplo, N, h_R, lda, &info );
-                gpu_time = magma_wtime() - gpu_time;
+                gpu_time = timing.time( copy_A, [&]() {
+                    magma_zpotrf( opts.uplo, N, h_R, lda, &info );
+                } );
             } 
             else {
                 magmaDoubleComplex_ptr dA = NULL;
@@ -92,9 +95,9 @@ int main( int argc, char** argv)
                 magma_queue_create( cdev, &queues[0] );
                 magma_queue_create( cdev, &queues[1] );
                 
-                gpu_time = magma_wtime();
-                magma_zpotrf_expert(opts.uplo, N, h_R, lda, dA, ldda, &info, queues );
-                gpu_time = magma_wtime() - gpu_time;
+                gpu_time = timing.time( copy_A, [&]() {
+                    magma_zpotrf_expert(opts.uplo, N, h_R, lda, dA, ldda, &info, queues );
+                } );
 
                 magma_queue_destroy( queues[0] );
                 magma_queue_destroy( queues[1] );
@@ -141,9 +144,13 @@ int main( int argc, char** argv)
                 status += ! (error < tol);
             }
             else {
+                error = MAGMA_D_NAN;
                 printf("%5lld     ---   (  ---  )   %7.2f (%7.2f)     ---  \n",
                        (long long) N, gpu_perf, gpu_time );
             }
+            timing.print();
+            opts.record( "zpotrf", N, N, 0, magma_get_zpotrf_nb( N ),
+                         gpu_time, gpu_perf, error, (error < tol), &timing );
             magma_free_cpu( h_A );
             magma_free_cpu( sigma );
             magma_free_pinned( h_R );
@@ -179,9 +179,12 @@ int main( int argc, char** argv)
                 status += ! (error < tol);
             }
             else {
+                error = MAGMA_D_NAN;
                 printf("%5lld     ---   (  ---  )   %7.2f (%7.2f)     ---  \n",
                        (long long) N, gpu_perf, gpu_time );
             }
+            opts.record( "zpotrf_gpu", N, N, 0, magma_get_zpotrf_nb( N ),
+                         gpu_time, gpu_perf, error, (error < tol) );
             magma_free_cpu( h_A );
             magma_free_cpu( sigma );
             magma_free_pinned( h_R );
@@ -163,6 +163,14 @@ typedef enum {
     MagmaSVD_max
 } magma_svd_work_t;
 
+typedef enum {
+    MagmaFormatText,
+    MagmaFormatCSV,
+    MagmaFormatJSON
+} magma_format_t;
+
+class magma_timing;
+
 class magma_opts
 {
 public:
@@ -181,6 +189,13 @@ public:
                     float* vl, float* vu,
                     magma_int_t* il, magma_int_t* iu );
 
+    // print one test result as a csv or json record (--format)
+    // with timing, also records nrep and the min, p95, p99, stddev, and drift of the times
+    void record( const char* routine,
+                 magma_int_t m, magma_int_t n, magma_int_t k, magma_int_t nb,
+                 double time, double gflops, double error, bool okay,
+                 const magma_timing* timing=NULL );
+
     // deallocate queues, etc.
     void cleanup();
 
@@ -209,6 +224,7 @@ public:
     magma_int_t ngpu;
     magma_int_t nsub;
     magma_int_t niter;
+    magma_int_t nrep;
     magma_int_t nthread;
     magma_int_t offset;
     magma_int_t itype;     // hegvd: problem type
@@ -230,6 +246,7 @@ public:
     bool magma;
     bool lapack;
     bool warmup;
+    bool flush;
 
     // lapack options
     magma_uplo_t    uplo;
@@ -252,6 +269,10 @@ public:
     double      condD;
     magma_int_t iseed[4];
 
+    // machine-readable test results (--format, --output)
+    magma_format_t format;
+    FILE*          output;
+
     // queue for default device
     magma_queue_t   queue;
     magma_queue_t   queues2[3];  // 2 queues + 1 extra NULL entry to catch errors
@@ -264,6 +285,70 @@ public:
     #endif
 };
 
+/***************************************************************************//**
+ * Timing harness. time() runs setup(), untimed, then run(), timed, nrep times
+ * (--nrep), optionally after one untimed warmup (--warmup) and with the cache
+ * flushed before each run (--flush, --cache). It keeps statistics of the
+ * samples, including drift of the times over the runs, e.g., from thermal or
+ * frequency scaling, and returns the median time. See magma_timing.cpp.
+ *
+ * Example:
+ *     magma_timing timing( opts );
+ *     gpu_time = timing.time(
+ *         [&]() { lapackf77_zlacpy( "Full", &N, &N, h_A, &lda, h_R, &lda ); },
+ *         [&]() { magma_zpotrf( opts.uplo, N, h_R, lda, &info ); } );
+ *     ...
+ *     timing.print();
+ */
+class magma_timing
+{
+public:
+    magma_timing( magma_int_t nrep=1, bool warmup=false, size_t flush=0,
+                  magma_queue_t queue=NULL );
+
+    magma_timing( const magma_opts& opts, magma_queue_t queue=NULL );
+
+    template< typename Setup, typename Run >
+    double time( Setup setup, Run run )
+    {
+        clear();
+        if (warmup) {
+            setup();
+            run();
+        }
+        for (magma_int_t rep = 0; rep < nrep; ++rep) {
+            setup();
+            flush_cache();
+            double t = wtime();
+            run();
+            samples.push_back( wtime() - t );
+        }
+        compute();
+        return median;
+    }
+
+    // print statistics, if nrep > 1
+    void print() const;
+
+    // settings
+    magma_int_t   nrep;
+    bool          warmup;
+    size_t        flush;     // bytes to flush, or 0
+    magma_queue_t queue;     // queue to sync, or NULL
+
+    // samples in order of execution, and their statistics
+    std::vector< double > samples;
+    double min, median, p95, p99, max, mean, stddev;
+    double drift;            // relative change of median from first to last third of runs
+    bool   drifting;         // whether drift exceeds 5% with a steady trend
+
+private:
+    void clear();
+    void compute();
+    void flush_cache() const;
+    double wtime() const;
+};
+
 extern const char* g_platform_str;
 
 // -----------------------------------------------------------------------------
@@ -22,6 +22,7 @@ exclude = (
 	'testing_auxiliary',
 	'testing_blas_z',
 	'testing_dgeev',  # handled by zgeev
+	'testing_zhetrd_hb2st_tune',  # on-host tuner, not a test
 	'testing_z',
 )
 